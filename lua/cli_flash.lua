@@ -47,6 +47,7 @@ erase       [p][t][o] dev [offset] size        Erase area or whole flash
 verify      [p][t][o] dev [offset]      file   Byte-by-byte compare
 verify_hash [p][t][o] dev [offset]      file   Quick compare using checksums
 hash        [p][t][o] dev [offset] size        Compute SHA1
+bench       [p][t][o] dev [offset] size [json] Measure the link and flash speed
 info        [p][t][o]                          Show busses/units/chip selects
 detect      [p][t][o] dev                      Check if flash is recognized
 test        [p][t][o] dev                      Test flasher
@@ -65,9 +66,11 @@ t:    -t plugin_type
       select plugin type
       example: -t romloader_jtag
 
-o:    [-jtag_khz frequency] [-jtag_reset mode]
+o:    [-jtag_khz frequency] [-jtag_reset mode] [-virtual_spi_flash spec]
       -jtag_khz: override JTAG frequency
       -jtag_reset: hard(default)/soft/attach
+      -virtual_spi_flash: add a flash to the virtual target
+                          unit:chip_select:device[:size][:file]
 
 dev:  -b bus [-u unit -cs chip_select]
       select flash device
@@ -80,6 +83,11 @@ size: -l length
       number of bytes to read/erase/hash
       read/erase: 0xffffffff = from offset to end of chip
 
+json: --json file [--min_time seconds]
+      write the benchmark report to a file, default is the console
+      the link tests run for min_time seconds, default is 2
+      The benchmark overwrites the area in the flash.
+
 
 Limitations:
 
@@ -220,6 +228,12 @@ local function addJtagKhzArg(tParserCommand)
       :convert(tonumber)
 end
 
+local function addVirtualSpiFlashArg(tParserCommand)
+    tParserCommand:option('--virtual_spi_flash', 'Add a simulated SPI flash to the virtual target romloader_virtual_0. The format is unit:chip_select:device[:size][:file], the device is a flash from spi_flash_types.xml or a JEDEC ID, e.g. 0:0:W25Q32::flash.bin or 0:0:ef4016:0x400000')
+      :target('astrVirtualSpiFlashes')
+      :count('*')
+end
+
 local function addJtagResetArg(tParserCommand)
     local tOption = tParserCommand:option(
       '--jtag_reset',
@@ -228,6 +242,24 @@ local function addJtagResetArg(tParserCommand)
     tOption.choices = {"hard", "soft", "attach" }
 end
 
+local function addKeepResidentArg(tParserCommand)
+    tParserCommand:flag('--keep_resident')
+            :description('Keep the flasher in the netX RAM. Skip the download and the detection if the same flasher and the same device are still there from an earlier call.')
+            :target('bKeepResident'):default(false)
+end
+
+local function addAutoEraseArg(tParserCommand)
+    tParserCommand:flag('--auto_erase')
+            :description('Internal flash only: erase only the blocks which need it while flashing instead of erasing the complete area first.')
+            :target('bAutoErase'):default(false)
+end
+
+local function addStripeArg(tParserCommand)
+    tParserCommand:option('--stripe')
+            :description('SPI only: combine the flash with a second identical flash at UNIT:CHIP_SELECT. The pages alternate between both flashes.')
+            :target('strStripe')
+end
+
 -- #Todo choose a better name
 local function addNoSfdp(tParserCommand)
     tParserCommand:flag('--no_sfdp')
@@ -300,12 +332,16 @@ addFilePathArg(tParserCommandFlash)
 addBusOptionArg(tParserCommandFlash)
 addUnitOptionArg(tParserCommandFlash)
 addChipSelectOptionArg(tParserCommandFlash)
+addStripeArg(tParserCommandFlash)
 addStartOffsetArg(tParserCommandFlash)
 -- optional_args = {"p", "t", "jf", "jr"}
 addPluginNameArg(tParserCommandFlash)
 addPluginTypeArg(tParserCommandFlash)
 addJtagResetArg(tParserCommandFlash)
 addJtagKhzArg(tParserCommandFlash)
+addVirtualSpiFlashArg(tParserCommandFlash)
+addKeepResidentArg(tParserCommandFlash)
+addAutoEraseArg(tParserCommandFlash)
 addSecureArgs(tParserCommandFlash)
 
 -- 	read
@@ -324,6 +360,7 @@ addFilePathArg(tParserCommandRead)
 addBusOptionArg(tParserCommandRead)
 addUnitOptionArg(tParserCommandRead)
 addChipSelectOptionArg(tParserCommandRead)
+addStripeArg(tParserCommandRead)
 addStartOffsetArg(tParserCommandRead)
 addLengthArg(tParserCommandRead)
 -- optional_args = {"p", "t", "jf", "jr"}
@@ -331,6 +368,8 @@ addPluginNameArg(tParserCommandRead)
 addPluginTypeArg(tParserCommandRead)
 addJtagResetArg(tParserCommandRead)
 addJtagKhzArg(tParserCommandRead)
+addVirtualSpiFlashArg(tParserCommandRead)
+addKeepResidentArg(tParserCommandRead)
 addSecureArgs(tParserCommandRead)
 
 -- erase
@@ -348,6 +387,7 @@ Exit codes:
 addBusOptionArg(tParserCommandErase)
 addUnitOptionArg(tParserCommandErase)
 addChipSelectOptionArg(tParserCommandErase)
+addStripeArg(tParserCommandErase)
 addStartOffsetArg(tParserCommandErase)
 addLengthArg(tParserCommandErase)
 -- optional_args = {"p", "t", "jf", "jr"}
@@ -355,6 +395,8 @@ addPluginNameArg(tParserCommandErase)
 addPluginTypeArg(tParserCommandErase)
 addJtagResetArg(tParserCommandErase)
 addJtagKhzArg(tParserCommandErase)
+addVirtualSpiFlashArg(tParserCommandErase)
+addKeepResidentArg(tParserCommandErase)
 addSecureArgs(tParserCommandErase)
 
 -- smart erase
@@ -379,6 +421,8 @@ addPluginNameArg(tParserCommandSmartErase)
 addPluginTypeArg(tParserCommandSmartErase)
 addJtagResetArg(tParserCommandSmartErase)
 addJtagKhzArg(tParserCommandSmartErase)
+addVirtualSpiFlashArg(tParserCommandSmartErase)
+addKeepResidentArg(tParserCommandSmartErase)
 addSecureArgs(tParserCommandSmartErase)
 addNoSfdp(tParserCommandSmartErase)
 
@@ -399,12 +443,15 @@ addFilePathArg(tParserCommandVerify)
 addBusOptionArg(tParserCommandVerify)
 addUnitOptionArg(tParserCommandVerify)
 addChipSelectOptionArg(tParserCommandVerify)
+addStripeArg(tParserCommandVerify)
 addStartOffsetArg(tParserCommandVerify)
 -- optional_args = {"p", "t", "jf", "jr"}
 addPluginNameArg(tParserCommandVerify)
 addPluginTypeArg(tParserCommandVerify)
 addJtagResetArg(tParserCommandVerify)
 addJtagKhzArg(tParserCommandVerify)
+addVirtualSpiFlashArg(tParserCommandVerify)
+addKeepResidentArg(tParserCommandVerify)
 addSecureArgs(tParserCommandVerify)
 
 -- verify_hash
@@ -423,12 +470,15 @@ addFilePathArg(tParserCommandVerifyHash)
 addBusOptionArg(tParserCommandVerifyHash)
 addUnitOptionArg(tParserCommandVerifyHash)
 addChipSelectOptionArg(tParserCommandVerifyHash)
+addStripeArg(tParserCommandVerifyHash)
 addStartOffsetArg(tParserCommandVerifyHash)
 -- optional_args = {"p", "t", "jf", "jr"}
 addPluginNameArg(tParserCommandVerifyHash)
 addPluginTypeArg(tParserCommandVerifyHash)
 addJtagResetArg(tParserCommandVerifyHash)
 addJtagKhzArg(tParserCommandVerifyHash)
+addVirtualSpiFlashArg(tParserCommandVerifyHash)
+addKeepResidentArg(tParserCommandVerifyHash)
 addSecureArgs(tParserCommandVerifyHash)
 
 -- hash
@@ -446,6 +496,7 @@ Exit codes:
 addBusOptionArg(tParserCommandHash)
 addUnitOptionArg(tParserCommandHash)
 addChipSelectOptionArg(tParserCommandHash)
+addStripeArg(tParserCommandHash)
 addStartOffsetArg(tParserCommandHash)
 addLengthArg(tParserCommandHash)
 -- optional_args = {"p", "t", "jf", "jr"}
@@ -453,8 +504,42 @@ addPluginNameArg(tParserCommandHash)
 addPluginTypeArg(tParserCommandHash)
 addJtagResetArg(tParserCommandHash)
 addJtagKhzArg(tParserCommandHash)
+addVirtualSpiFlashArg(tParserCommandHash)
+addKeepResidentArg(tParserCommandHash)
 addSecureArgs(tParserCommandHash)
 
+-- bench
+local tParserCommandBench = tParser
+	:command('bench', 'Measure the link and the flash operations. The area in the flash is overwritten.')
+	:target('fCommandBenchSelected')
+	:epilog([[
+--------------------------------------------------------------------
+Exit codes:
+===========
+0:  SUCCESSFUL
+1:  ERROR
+	]])
+-- required_args = {"b", "u", "cs", "s", "l"}
+addBusOptionArg(tParserCommandBench)
+addUnitOptionArg(tParserCommandBench)
+addChipSelectOptionArg(tParserCommandBench)
+addStripeArg(tParserCommandBench)
+addStartOffsetArg(tParserCommandBench)
+addLengthArg(tParserCommandBench)
+tParserCommandBench:option('--json', 'Write the report as JSON to this file. The default is the console.')
+	:target('strJsonFileName')
+tParserCommandBench:option('--min_time', 'Repeat the link tests for this number of seconds.')
+	:target('tMinTime')
+	:convert(tonumber)
+-- optional_args = {"p", "t", "jf", "jr"}
+addPluginNameArg(tParserCommandBench)
+addPluginTypeArg(tParserCommandBench)
+addJtagResetArg(tParserCommandBench)
+addJtagKhzArg(tParserCommandBench)
+addVirtualSpiFlashArg(tParserCommandBench)
+addKeepResidentArg(tParserCommandBench)
+addSecureArgs(tParserCommandBench)
+
 -- detect
 local tParserCommandDetect = tParser
 	:command('detect d', 'Check if flash is recognized')
@@ -471,11 +556,14 @@ Exit codes:
 addBusOptionArg(tParserCommandDetect)
 addUnitOptionArg(tParserCommandDetect)
 addChipSelectOptionArg(tParserCommandDetect)
+addStripeArg(tParserCommandDetect)
 -- optional_args = {"p", "t", "jf", "jr"}
 addPluginNameArg(tParserCommandDetect)
 addPluginTypeArg(tParserCommandDetect)
 addJtagResetArg(tParserCommandDetect)
 addJtagKhzArg(tParserCommandDetect)
+addVirtualSpiFlashArg(tParserCommandDetect)
+addKeepResidentArg(tParserCommandDetect)
 addSecureArgs(tParserCommandDetect)
 
 -- test
@@ -498,6 +586,7 @@ addPluginNameArg(tParserCommandTest)
 addPluginTypeArg(tParserCommandTest)
 addJtagResetArg(tParserCommandTest)
 addJtagKhzArg(tParserCommandTest)
+addVirtualSpiFlashArg(tParserCommandTest)
 addSecureArgs(tParserCommandTest)
 
 -- testcli
@@ -520,6 +609,7 @@ addPluginNameArg(tParserCommandTestCli)
 addPluginTypeArg(tParserCommandTestCli)
 addJtagResetArg(tParserCommandTestCli)
 addJtagKhzArg(tParserCommandTestCli)
+addVirtualSpiFlashArg(tParserCommandTestCli)
 addSecureArgs(tParserCommandTestCli)
 
 -- info
@@ -538,6 +628,8 @@ addPluginNameArg(tParserCommandInfo)
 addPluginTypeArg(tParserCommandInfo)
 addJtagResetArg(tParserCommandInfo)
 addJtagKhzArg(tParserCommandInfo)
+addVirtualSpiFlashArg(tParserCommandInfo)
+addKeepResidentArg(tParserCommandInfo)
 addSecureArgs(tParserCommandInfo)
 
 -- list_interfaces
@@ -555,6 +647,7 @@ Exit codes:
 addPluginTypeArg(tParserCommandListInterfaces)
 addJtagResetArg(tParserCommandListInterfaces)
 addJtagKhzArg(tParserCommandListInterfaces)
+addVirtualSpiFlashArg(tParserCommandListInterfaces)
 
 
 -- detect_netx
@@ -574,6 +667,7 @@ addPluginNameArg(tParserCommandDetectNetx)
 addPluginTypeArg(tParserCommandDetectNetx)
 addJtagResetArg(tParserCommandDetectNetx)
 addJtagKhzArg(tParserCommandDetectNetx)
+addVirtualSpiFlashArg(tParserCommandDetectNetx)
 addSecureArgs(tParserCommandDetectNetx)
 
 -- detect_secure_boot_mode
@@ -595,6 +689,7 @@ addPluginNameArg(tParserCommandDetectSecureBoot)
 addPluginTypeArg(tParserCommandDetectSecureBoot)
 addJtagResetArg(tParserCommandDetectSecureBoot)
 addJtagKhzArg(tParserCommandDetectSecureBoot)
+addVirtualSpiFlashArg(tParserCommandDetectSecureBoot)
 
 
 -- reset_netx
@@ -613,6 +708,7 @@ addPluginNameArg(tParserCommandResetNetx)
 addPluginTypeArg(tParserCommandResetNetx)
 addJtagResetArg(tParserCommandResetNetx)
 addJtagKhzArg(tParserCommandResetNetx)
+addVirtualSpiFlashArg(tParserCommandResetNetx)
 addSecureArgs(tParserCommandResetNetx)
 
 -- identify_netx
@@ -631,6 +727,7 @@ addPluginNameArg(tParserCommandIdentifyNetx)
 addPluginTypeArg(tParserCommandIdentifyNetx)
 addJtagResetArg(tParserCommandIdentifyNetx)
 addJtagKhzArg(tParserCommandIdentifyNetx)
+addVirtualSpiFlashArg(tParserCommandIdentifyNetx)
 addSecureArgs(tParserCommandIdentifyNetx)
 
 -- check_helper_version
@@ -731,6 +828,7 @@ end
 -- SHA over data file                                                           x
 -- SHA over flash                                                     x         x
 -- save file                                                  x
+-- benchmark: detect, then erase, flash, verify, read and hash a scratch area
 
 local function exec(aArgs)
 	local iMode          = aArgs.iMode
@@ -744,6 +842,8 @@ local function exec(aArgs)
 	local strDataFileName= aArgs.strDataFileName
 	local atPluginOptions= aArgs.atPluginOptions
     local bCompMode = aArgs.bCompMode
+	-- The internal flash can erase the blocks while flashing.
+	local fAutoErase = aArgs.fCommandFlashSelected and aArgs.bAutoErase and iBus == flasher.BUS_IFlash
 	local strSecureOption = nil
 	if aArgs.strSecureOption~= nil then
     local path = require 'pl.path'
@@ -811,6 +911,7 @@ local function exec(aArgs)
 		-- Download the flasher.
 		if fOk then
 			print("Downloading flasher binary")
+			flasher.setKeepResident(aArgs.bKeepResident)
 			aAttr = flasher.download(tPlugin, FLASHER_PATH, nil, bCompMode, strSecureOption)
 			if not aAttr then
 				fOk = false
@@ -838,30 +939,43 @@ local function exec(aArgs)
 				local ulDetectFlags = 0
 				if not aArgs.bNoSfdp and aArgs.fCommandSmartEraseSelected  then
 					ulDetectFlags = flasher.FLAG_DETECT_SPI_USE_SFDP_ERASE
+				elseif fAutoErase then
+					ulDetectFlags = flasher.FLAG_DETECT_IFLASH_AUTO_ERASE
 				end
-				fOk, strMsg, ulDeviceSize = flasher.detectAndCheckSizeLimit(tPlugin, aAttr, iBus, iUnit, iChipSelect, nil, nil, nil, ulDetectFlags)
-				if fOk ~= true then
-					fOk = false
-				else
-					if iBus == flasher.BUS_Spi then
-						local strDevDesc = flasher.readDeviceDescriptor(tPlugin, aAttr)
-						if strDevDesc==nil then
-							strMsg = "Failed to read the flash device descriptor!"
-							fOk = false
-						else
-							local strSpiDevName, strSpiDevId = flasher.SpiFlash_getNameAndId(strDevDesc)
-							tDevInfo.strDevName = strSpiDevName or "unknown"
-							tDevInfo.strDevId = strSpiDevId or "unknown"
-						end
+				if aArgs.strStripe ~= nil then
+					local strStripeUnit, strStripeChipSelect = string.match(aArgs.strStripe, '^(%d+):(%d+)$')
+					if strStripeUnit == nil or iBus ~= flasher.BUS_Spi then
+						fOk = false
+						strMsg = "The stripe option needs the SPI bus and the form UNIT:CHIP_SELECT."
+					else
+						ulDetectFlags = ulDetectFlags | flasher.getSpiStripeFlags(tonumber(strStripeUnit), tonumber(strStripeChipSelect))
 					end
-
-					-- if offset/len are set, we require that offset+len is less than or equal the device size
-					if ulStartOffset~= nil and ulLen~= nil and ulStartOffset+ulLen > ulDeviceSize and ulLen ~= 0xffffffff then
+				end
+				if fOk then
+					fOk, strMsg, ulDeviceSize = flasher.detectAndCheckSizeLimit(tPlugin, aAttr, iBus, iUnit, iChipSelect, nil, nil, nil, ulDetectFlags)
+					if fOk ~= true then
 						fOk = false
-						strMsg = string.format("Offset+size exceeds flash device size: 0x%08x bytes", ulDeviceSize)
 					else
-						fOk = true
-						strMsg = string.format("Flash device size: %u/0x%08x bytes", ulDeviceSize, ulDeviceSize)
+						if iBus == flasher.BUS_Spi then
+							local strDevDesc = flasher.readDeviceDescriptor(tPlugin, aAttr)
+							if strDevDesc==nil then
+								strMsg = "Failed to read the flash device descriptor!"
+								fOk = false
+							else
+								local strSpiDevName, strSpiDevId = flasher.SpiFlash_getNameAndId(strDevDesc)
+								tDevInfo.strDevName = strSpiDevName or "unknown"
+								tDevInfo.strDevId = strSpiDevId or "unknown"
+							end
+						end
+
+						-- if offset/len are set, we require that offset+len is less than or equal the device size
+						if ulStartOffset~= nil and ulLen~= nil and ulStartOffset+ulLen > ulDeviceSize and ulLen ~= 0xffffffff then
+							fOk = false
+							strMsg = string.format("Offset+size exceeds flash device size: 0x%08x bytes", ulDeviceSize)
+						else
+							fOk = true
+							strMsg = string.format("Flash device size: %u/0x%08x bytes", ulDeviceSize, ulDeviceSize)
+						end
 					end
 				end
 			end
@@ -869,7 +983,7 @@ local function exec(aArgs)
 
 		-- flash/erase: erase the area
 
-		if fOk and (aArgs.fCommandEraseSelected or (aArgs.fCommandFlashSelected and iBus ~= flasher.BUS_SDIO))then
+		if fOk and (aArgs.fCommandEraseSelected or (aArgs.fCommandFlashSelected and iBus ~= flasher.BUS_SDIO and not fAutoErase))then
 			fOk, strMsg = flasher.eraseArea(tPlugin, aAttr, ulStartOffset, ulLen)
 		end
 
@@ -888,11 +1002,25 @@ local function exec(aArgs)
 		end
 
 		-- read
+		-- The data is written to the output file chunk by chunk.
 		if fOk and aArgs.fCommandReadSelected then
-			strData, strMsg = flasher.readArea(tPlugin, aAttr, ulStartOffset, ulLen)
-			if strData == nil then
+			local tFile
+			tFile, strMsg = io.open(strDataFileName, "wb")
+			if tFile == nil then
 				fOk = false
-				strMsg = strMsg or "Error while reading"
+				strMsg = strMsg or "Failed to open file for writing"
+			else
+				local ulRead
+				ulRead, strMsg = flasher.readAreaToSink(tPlugin, aAttr, ulStartOffset, ulLen, tFile)
+				tFile:close()
+				if ulRead == nil then
+					-- Do not leave a truncated file behind.
+					os.remove(strDataFileName)
+					fOk = false
+					strMsg = strMsg or "Error while reading"
+				else
+					strMsg = string.format("%d bytes written to file %s", ulRead, strDataFileName)
+				end
 			end
 		end
 
@@ -950,12 +1078,43 @@ local function exec(aArgs)
 						print("Checksums are not equal!")
 						fOk = false
 						strMsg = "The data in the flash and the file do not have the same checksum"
+
+						-- Locate the differences with the hashes of smaller regions.
+						local atDiffs, strDiffMsg = flasher.locateHashDifferences(tPlugin, aAttr, ulStartOffset, strData)
+						if atDiffs == nil then
+							print("Failed to locate the differences: " .. tostring(strDiffMsg))
+						else
+							print(strDiffMsg)
+							for _, tDiff in ipairs(atDiffs) do
+								print(string.format("  differs: [0x%08x, 0x%08x[", tDiff.ulStart, tDiff.ulEnd))
+							end
+						end
 					end
 				end
 
-		-- save output file   strData --> strDataFileName
-		if fOk and aArgs.fCommandReadSelected then
-			fOk, strMsg = tFlasherHelper.writeBin(strDataFileName, strData)
+		-- bench: measure the link and the flash operations
+		if fOk and aArgs.fCommandBenchSelected then
+			local flasher_benchmark = require 'flasher_benchmark'
+			local tReport = flasher_benchmark.run(tPlugin, aAttr, {
+				iBus = iBus,
+				iUnit = iUnit,
+				iChipSelect = iChipSelect,
+				ulOffset = ulStartOffset,
+				ulSize = ulLen,
+				tMinTime = aArgs.tMinTime,
+				strDevName = tDevInfo.strDevName,
+				strDevId = tDevInfo.strDevId
+			})
+			local strJson = flasher_benchmark.toJson(tReport)
+			if aArgs.strJsonFileName == nil then
+				io.write(strJson)
+			else
+				fOk, strMsg = tFlasherHelper.writeBin(aArgs.strJsonFileName, strJson)
+			end
+			if fOk then
+				fOk = tReport.ok
+				strMsg = tReport.ok and "Benchmark finished" or "At least one benchmark phase failed"
+			end
 		end
 
         -- identify_netx
@@ -972,7 +1131,7 @@ local function exec(aArgs)
 
 		if aArgs.fCommandResetSelected then
 			if fOk then
-				tFlasherHelper.sleep_s(1)  -- Wait 1 second after disconnecting for the watchdog reset to finish
+				tFlasherHelper.sleep_s(tFlasherHelper.WATCHDOG_RESET_DELAY)  -- Wait after disconnecting for the watchdog reset to finish
 				strMsg = "Reset command finished"
 			else
 				strMsg = "Reset command failed"
@@ -1036,6 +1195,7 @@ function flasher_test_interface_cli.clearArgs(aArgs)
 	aArgs.fCommandVerifySelected = nil
 	aArgs.fCommandVerifyHashSelected = nil
 	aArgs.fCommandHashSelected = nil
+	aArgs.fCommandBenchSelected = nil
 	aArgs.fCommandDetectSelected = nil
 	aArgs.fCommandTestSelected = nil
 	aArgs.fCommandTestCliSelected = nil
@@ -1080,6 +1240,8 @@ function flasher_test_interface_cli:getBusWidth()
 		return 4
 	elseif self.aArgs.iBus == flasher.BUS_SDIO then
 		return 1
+	elseif self.aArgs.iBus == flasher.BUS_I2C then
+		return 1
 	end
 end
 
@@ -1092,6 +1254,8 @@ function flasher_test_interface_cli:getEmptyByte()
 		return 0xff
 	elseif self.aArgs.iBus == flasher.BUS_SDIO then
 		return 0x00
+	elseif self.aArgs.iBus == flasher.BUS_I2C then
+		return 0xff
 	end
 end
 
@@ -1204,6 +1368,7 @@ local function main()
 	or aArgs.fCommandVerifySelected              -- verify
 	or aArgs.fCommandVerifyHashSelected          -- verify_hash
 	or aArgs.fCommandHashSelected                -- hash
+	or aArgs.fCommandBenchSelected               -- bench
 	or aArgs.fCommandDetectSelected              -- detect
 	or aArgs.fCommandTestSelected                -- test
 	or aArgs.fCommandTestCliSelected             -- testcli
@@ -1291,6 +1456,9 @@ local function main()
 		},
 		romloader_uart = {
 			netx90_m2m_image = strnetX90M2MImageBin
+		},
+		romloader_virtual = {
+			spi_flashes = aArgs.astrVirtualSpiFlashes
 		}
 	}
 
@@ -1299,6 +1467,12 @@ local function main()
 
     require("muhkuh_cli_init")
 
+    -- The virtual netX runs the flasher core on the host. It is only
+    -- offered with simulated flashes.
+    if aArgs.astrVirtualSpiFlashes ~= nil and #aArgs.astrVirtualSpiFlashes > 0 then
+        require("virtual_target")
+    end
+
     if aArgs.fCommandListInterfacesSelected then
         tFlasherHelper.list_interfaces(aArgs.strPluginType, aArgs.atPluginOptions)
         os.exit(0)
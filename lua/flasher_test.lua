@@ -139,6 +139,8 @@ function flasher_test_interface:getBusWidth()
 		return 4
 	elseif self.iBus == tFlasher.BUS_SDIO then
 		return 1
+	elseif self.iBus == tFlasher.BUS_I2C then
+		return 1
 	end
 end
 
@@ -151,6 +153,8 @@ function flasher_test_interface:getEmptyByte()
 		return 0xff
 	elseif self.iBus == tFlasher.BUS_SDIO then
 		return 0x00
+	elseif self.iBus == tFlasher.BUS_I2C then
+		return 0xff
 	end
 end
 
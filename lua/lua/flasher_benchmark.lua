@@ -0,0 +1,301 @@
+local M = {}
+
+-- Benchmark of the link to the netX and of the flasher operations.
+--
+-- The benchmark runs in phases. The link phases measure write_image and
+-- read_image on the data buffer of the flasher and the round trip of a
+-- flasher call which does no work. The flash phases erase, program,
+-- verify, read and hash a scratch area of the selected device. The scratch
+-- area is overwritten.
+--
+-- Each phase reports the wall clock time. If the plugin has simulated
+-- statistics (see virtual_target.lua), the phase also reports the simulated
+-- time and bus traffic. These values do not depend on the host and can be
+-- compared between runs.
+--
+-- toJson converts the report to JSON.
+
+local class = require 'pl.class'
+local flasher = require 'flasher'
+local tFlasherHelper = require 'flasher_helper'
+
+local function printf(...) print(string.format(...)) end
+
+M.REPORT_VERSION = 1
+
+-- The link phases repeat the transfer until this time in seconds passed.
+M.DEFAULT_MIN_TIME = 2
+
+
+-- The data must not compress, or flashArea would measure the decompression.
+local function getTestData(ulSize)
+    local astrData = {}
+    local ulState = 0x12345678
+    for _ = 1, ulSize do
+        -- A small xorshift generator gives the same data on every run.
+        ulState = ulState ~ ((ulState << 13) & 0xffffffff)
+        ulState = ulState ~ (ulState >> 17)
+        ulState = ulState ~ ((ulState << 5) & 0xffffffff)
+        table.insert(astrData, string.char(ulState & 0xff))
+    end
+    return table.concat(astrData)
+end
+
+
+local function getSimulatedStatistics(tPlugin)
+    local tTotal = nil
+    if tPlugin.get_statistics ~= nil then
+        tTotal = tPlugin:get_statistics().tTotal
+    end
+    return tTotal
+end
+
+
+local Benchmark = class()
+
+function Benchmark:_init(tPlugin, tMinTime)
+    self.tPlugin = tPlugin
+    self.tMinTime = tMinTime
+    self.atPhases = {}
+end
+
+
+-- Run one phase. fnPhase returns fOk, strMsg, ulBytes and ulIterations.
+function Benchmark:runPhase(strName, fnPhase)
+    local tSimStart = getSimulatedStatistics(self.tPlugin)
+    local tStart = tFlasherHelper.clock()
+    local fOk, strMsg, ulBytes, ulIterations = fnPhase()
+    local tElapsed = tFlasherHelper.clock() - tStart
+
+    local tPhase = {
+        name = strName,
+        ok = (fOk == true),
+        seconds = tElapsed,
+        iterations = ulIterations or 1
+    }
+    if ulBytes ~= nil then
+        tPhase.bytes = ulBytes
+        if tElapsed > 0 then
+            tPhase.bytes_per_second = ulBytes / tElapsed
+        end
+    end
+    if tPhase.ok ~= true then
+        tPhase.error = strMsg or 'unknown error'
+    end
+
+    if tSimStart ~= nil then
+        local tSimEnd = getSimulatedStatistics(self.tPlugin)
+        local ulTimeUs = tSimEnd.ulTimeUs - tSimStart.ulTimeUs
+        tPhase.simulated = {
+            time_us = ulTimeUs,
+            bus_bytes = tSimEnd.ulBusBytes - tSimStart.ulBusBytes,
+            busy_polls = tSimEnd.ulBusyPolls - tSimStart.ulBusyPolls,
+            programs = tSimEnd.ulPrograms - tSimStart.ulPrograms,
+            erases = tSimEnd.ulErases - tSimStart.ulErases
+        }
+        if ulBytes ~= nil and ulTimeUs > 0 then
+            tPhase.simulated.bytes_per_second = ulBytes * 1000000 / ulTimeUs
+        end
+    end
+
+    printf('Benchmark %-12s %s', strName, tPhase.ok and string.format('%.3f s', tElapsed) or tPhase.error)
+    table.insert(self.atPhases, tPhase)
+    return tPhase.ok
+end
+
+
+-- Repeat fnStep until the minimum time passed. The clock is only read
+-- between the steps. fnStep returns the number of bytes or nil and a
+-- message.
+function Benchmark:repeatUntilMinTime(fnStep)
+    local tStart = tFlasherHelper.clock()
+    local ulBytes = 0
+    local ulIterations = 0
+    repeat
+        local ulStepBytes, strMsg = fnStep()
+        if ulStepBytes == nil then
+            return false, strMsg, ulBytes, ulIterations
+        end
+        ulBytes = ulBytes + ulStepBytes
+        ulIterations = ulIterations + 1
+    until tFlasherHelper.clock() - tStart >= self.tMinTime
+    return true, nil, ulBytes, ulIterations
+end
+
+
+-- tReport run(tPlugin, aAttr, tParameter)
+-- The flasher must be downloaded and the device detected. tParameter has
+-- the fields iBus, iUnit, iChipSelect, ulOffset, ulSize and optional
+-- tMinTime, strDevName and strDevId.
+-- The report has the field ok. It is false if one phase failed, the other
+-- phases are still run unless the area could not be erased or programmed.
+function M.run(tPlugin, aAttr, tParameter)
+    local strClock, tResolution = tFlasherHelper.clock_info()
+    local tBench = Benchmark(tPlugin, math.max(tParameter.tMinTime or M.DEFAULT_MIN_TIME, tResolution))
+
+    local ulOffset = tParameter.ulOffset
+    local ulSize = tParameter.ulSize
+    local ulBufferAdr = aAttr.ulBufferAdr
+    local ulLinkSize = math.min(aAttr.ulBufferLen, 0x10000)
+    local strLinkData = getTestData(ulLinkSize)
+    local strData = getTestData(ulSize)
+    local fOk = true
+
+    -- Link: write and read the data buffer of the flasher.
+    fOk = tBench:runPhase('link_write', function()
+        return tBench:repeatUntilMinTime(function()
+            flasher.write_image(tPlugin, ulBufferAdr, strLinkData)
+            return ulLinkSize
+        end)
+    end) and fOk
+
+    fOk = tBench:runPhase('link_read', function()
+        return tBench:repeatUntilMinTime(function()
+            local strRead = flasher.read_image(tPlugin, ulBufferAdr, ulLinkSize)
+            if strRead ~= strLinkData then
+                return nil, 'The data read back from the netX differs.'
+            end
+            return ulLinkSize
+        end)
+    end) and fOk
+
+    -- Call: a call which only expands an area to the erase blocks.
+    fOk = tBench:runPhase('call', function()
+        local fPhaseOk, strMsg, _, ulIterations = tBench:repeatUntilMinTime(function()
+            local ulEraseStart = flasher.getEraseArea(tPlugin, aAttr, ulOffset, ulOffset + 1)
+            if ulEraseStart == nil then
+                return nil, 'The flasher call failed.'
+            end
+            return 0
+        end)
+        return fPhaseOk, strMsg, nil, ulIterations
+    end) and fOk
+    local tCallPhase = tBench.atPhases[#tBench.atPhases]
+    if tCallPhase.ok == true then
+        tCallPhase.latency_s = tCallPhase.seconds / tCallPhase.iterations
+    end
+
+    -- Flash: the later phases need the data of the earlier ones.
+    local fAreaOk = tBench:runPhase('erase', function()
+        local fPhaseOk, strMsg = flasher.eraseArea(tPlugin, aAttr, ulOffset, ulSize)
+        return fPhaseOk, strMsg, ulSize
+    end)
+    fAreaOk = fAreaOk and tBench:runPhase('program', function()
+        local fPhaseOk, strMsg = flasher.flashArea(tPlugin, aAttr, ulOffset, strData, nil, nil, true)
+        return fPhaseOk, strMsg, ulSize
+    end)
+    fOk = fAreaOk and fOk
+
+    if fAreaOk == true then
+        fOk = tBench:runPhase('verify', function()
+            local fPhaseOk, strMsg = flasher.verifyArea(tPlugin, aAttr, ulOffset, strData)
+            return fPhaseOk, strMsg, ulSize
+        end) and fOk
+
+        fOk = tBench:runPhase('read', function()
+            local strRead, strMsg = flasher.readArea(tPlugin, aAttr, ulOffset, ulSize)
+            if strRead == nil then
+                return false, strMsg, ulSize
+            elseif strRead ~= strData then
+                return false, 'The data read from the flash differs.', ulSize
+            end
+            return true, nil, ulSize
+        end) and fOk
+
+        fOk = tBench:runPhase('hash', function()
+            local strHash, strMsg = flasher.hashArea(tPlugin, aAttr, ulOffset, ulSize)
+            return strHash ~= nil, strMsg, ulSize
+        end) and fOk
+    end
+
+    return {
+        version = M.REPORT_VERSION,
+        date = os.date('!%Y-%m-%dT%H:%M:%SZ'),
+        ok = fOk,
+        plugin = {
+            name = tPlugin:GetName(),
+            type = tPlugin:GetTyp(),
+            chip_type = tPlugin:GetChiptyp(),
+            simulated = (tPlugin.get_statistics ~= nil)
+        },
+        device = {
+            bus = tParameter.iBus,
+            unit = tParameter.iUnit,
+            chip_select = tParameter.iChipSelect,
+            name = tParameter.strDevName,
+            id = tParameter.strDevId,
+            offset = ulOffset,
+            size = ulSize
+        },
+        clock = {
+            source = strClock,
+            resolution_s = tResolution,
+            min_time_s = tBench.tMinTime
+        },
+        phases = tBench.atPhases
+    }
+end
+
+
+local function jsonString(strValue)
+    local strEscaped = string.gsub(strValue, '[%c"\\]', function(c)
+        local atEscapes = { ['"'] = '\\"', ['\\'] = '\\\\', ['\n'] = '\\n', ['\r'] = '\\r', ['\t'] = '\\t' }
+        return atEscapes[c] or string.format('\\u%04x', string.byte(c))
+    end)
+    return '"' .. strEscaped .. '"'
+end
+
+
+local function jsonValue(tValue, strIndent, astrOut)
+    local strType = type(tValue)
+    if strType == 'table' then
+        local strInner = strIndent .. '  '
+        local astrItems = {}
+        if #tValue > 0 or next(tValue) == nil then
+            for _, tItem in ipairs(tValue) do
+                local astrItem = {}
+                jsonValue(tItem, strInner, astrItem)
+                table.insert(astrItems, strInner .. table.concat(astrItem))
+            end
+            if #astrItems == 0 then
+                table.insert(astrOut, '[]')
+            else
+                table.insert(astrOut, '[\n' .. table.concat(astrItems, ',\n') .. '\n' .. strIndent .. ']')
+            end
+        else
+            -- Sort the keys, so reports can be compared with diff.
+            local astrKeys = {}
+            for strKey in pairs(tValue) do
+                table.insert(astrKeys, tostring(strKey))
+            end
+            table.sort(astrKeys)
+            for _, strKey in ipairs(astrKeys) do
+                local astrItem = {}
+                jsonValue(tValue[strKey], strInner, astrItem)
+                table.insert(astrItems, strInner .. jsonString(strKey) .. ': ' .. table.concat(astrItem))
+            end
+            table.insert(astrOut, '{\n' .. table.concat(astrItems, ',\n') .. '\n' .. strIndent .. '}')
+        end
+    elseif strType == 'string' then
+        table.insert(astrOut, jsonString(tValue))
+    elseif strType == 'boolean' then
+        table.insert(astrOut, tostring(tValue))
+    elseif math.type(tValue) == 'integer' then
+        table.insert(astrOut, string.format('%d', tValue))
+    elseif strType == 'number' and tValue == tValue and tValue ~= math.huge and tValue ~= -math.huge then
+        table.insert(astrOut, string.format('%.9g', tValue))
+    else
+        table.insert(astrOut, 'null')
+    end
+end
+
+
+-- Convert a report to JSON.
+function M.toJson(tReport)
+    local astrOut = {}
+    jsonValue(tReport, '', astrOut)
+    return table.concat(astrOut) .. '\n'
+end
+
+
+return M
@@ -228,43 +228,311 @@ local function SelectPlugin(_, strPluginType, atPluginOptions)
 	return tPlugin
 end
 
-function M.connect_retry(tPlugin, uLRetries)
-    local fCallSuccess
-    local strError
-    local ulConsoleMode = nil
-    print("connect to plugin")
+--------------------------------------------------------------------------
+-- clock and sleep
+--------------------------------------------------------------------------
 
-    if tPlugin == nil then
-        strError = "No plugin selected for connect"
+local fnClock = nil
+local strClockSource = nil
+local tClockResolution = nil
+local fnSleep = nil
+
+-- Get a clock with a sub-second resolution. A monotonic clock is preferred,
+-- it does not jump if the system time is changed. Only os.time is left if
+-- neither luaposix nor luasocket is available.
+-- Returns the function, its name and its resolution in seconds.
+local function getClock()
+    local fOk, tPosixTime = pcall(require, 'posix.time')
+    if fOk == true and type(tPosixTime) == 'table' and tPosixTime.clock_gettime ~= nil and tPosixTime.CLOCK_MONOTONIC ~= nil then
+        return function()
+            -- Old versions of luaposix return the seconds and nanoseconds,
+            -- new versions return a timespec.
+            local tSec, ulNsec = tPosixTime.clock_gettime(tPosixTime.CLOCK_MONOTONIC)
+            if type(tSec) == 'table' then
+                tSec, ulNsec = tSec.tv_sec, tSec.tv_nsec
+            end
+            return tSec + ulNsec / 1000000000
+        end, 'posix.time.clock_gettime', 0.000000001
+    end
+
+    local tSocket
+    fOk, tSocket = pcall(require, 'socket')
+    if fOk == true and type(tSocket) == 'table' and tSocket.gettime ~= nil then
+        return tSocket.gettime, 'socket.gettime', 0.000001
+    end
+
+    -- os.clock is the CPU time of this process. It does not run while
+    -- the process waits, so only os.time is left.
+    return os.time, 'os.time', 1
+end
+
+
+-- Get a sleep which does not keep the CPU busy. Without luasocket the
+-- sleep command of the OS is used. Windows has none which works without a
+-- console, so ping is used there. It waits about one second between the
+-- echo requests, which rounds the time up to full seconds.
+local function getSleep()
+    local fOk, tSocket = pcall(require, 'socket')
+    if fOk == true and type(tSocket) == 'table' and tSocket.sleep ~= nil then
+        return tSocket.sleep
+    end
+
+    if package.config:sub(1, 1) == '/' then
+        return function(tSeconds)
+            if os.execute(string.format('sleep %.3f', tSeconds)) ~= true then
+                -- Some sleep commands have no fractions.
+                os.execute(string.format('sleep %d', math.ceil(tSeconds)))
+            end
+        end
+    end
+
+    return function(tSeconds)
+        os.execute(string.format('ping -n %d 127.0.0.1 >NUL', math.ceil(tSeconds) + 1))
+    end
+end
+
+
+-- Get the time in seconds from a monotonic clock if one is available.
+-- Only the difference between two values is meaningful.
+function M.clock()
+    if fnClock == nil then
+        fnClock, strClockSource, tClockResolution = getClock()
+    end
+    return fnClock()
+end
+
+
+-- Get the name and the resolution in seconds of the clock used by M.clock.
+function M.clock_info()
+    if fnClock == nil then
+        fnClock, strClockSource, tClockResolution = getClock()
     end
+    return strClockSource, tClockResolution
+end
 
-    -- default retries are 3
-    if uLRetries == nil then
-        uLRetries = 3
+
+-- Sleep for a number of seconds. Fractions of a second are allowed.
+function M.sleep_s(tSeconds)
+    if tSeconds > 0 then
+        if fnSleep == nil then
+            fnSleep = getSleep()
+        end
+        fnSleep(tSeconds)
     end
+end
 
-    while uLRetries > 0 do
-        fCallSuccess, strError = pcall(function () tPlugin:Connect() end)
-        if fCallSuccess then
+
+--------------------------------------------------------------------------
+-- connection manager
+--------------------------------------------------------------------------
+
+-- The connection manager connects a plugin and retries failed attempts.
+--
+-- Options:
+--   ulAttempts        the number of attempts, the default is 3
+--   tInitialDelay     the delay in seconds after the first failed attempt
+--   tBackoffFactor    each following delay is multiplied by this factor
+--   tMaxDelay         the upper limit for the delay
+--   tAttemptDeadline  the time in seconds one attempt may take
+--   astrFatalErrors   texts of errors which stop the retries at once,
+--                     the default is M.CONNECT_FATAL_ERRORS
+--   fnEvent           fnEvent(strEvent, tEvent) is called for each step,
+--                     the default prints the progress
+--
+-- The Connect call of a plugin can not be interrupted, so the deadline is
+-- checked when the attempt returns. A failed attempt which took longer
+-- already waited inside the plugin. It is reported as "timeout" and the
+-- next attempt follows without a delay.
+--
+-- The events are "attempt", "connected", "failed", "wait" and "giveup".
+-- tEvent has the fields strWhat, ulAttempt and ulAttempts. "connected" and
+-- "failed" add tElapsed, "failed" and "giveup" add strError and strClass
+-- ("retryable", "timeout" or "fatal"), "wait" adds tDelay.
+
+M.CONNECT_FATAL_ERRORS = {
+    "start_mi image has been rejected or execution has failed."
+}
+
+local atConnectDefaults = {
+    ulAttempts = 3,
+    tInitialDelay = 0.5,
+    tBackoffFactor = 2,
+    tMaxDelay = 4,
+    tAttemptDeadline = 10
+}
+
+-- The netX resets 1 second after the watchdog was started.
+M.WATCHDOG_RESET_DELAY = 1.5
+
+
+local function printConnectEvent(strEvent, tEvent)
+    if tEvent.strWhat == 'connect' then
+        if strEvent == 'attempt' and tEvent.ulAttempt == 1 then
+            print("connect to plugin")
+        elseif strEvent == 'connected' then
             print("connect successful")
+        elseif strEvent == 'failed' then
+            print(string.format("connect not successful (%s): %s", tEvent.strClass, tostring(tEvent.strError)))
+        elseif strEvent == 'wait' then
+            print(string.format("retry connecting in %.1f s ... ", tEvent.tDelay))
+        end
+    elseif strEvent == 'failed' then
+        print(string.format("%s not successful (%s): %s", tEvent.strWhat, tEvent.strClass, tostring(tEvent.strError)))
+    end
+end
+
+
+local ConnectionManager = class()
+
+
+function ConnectionManager:_init(tOptions)
+    tOptions = tOptions or {}
+    for strKey, tDefault in pairs(atConnectDefaults) do
+        if tOptions[strKey] == nil then
+            self[strKey] = tDefault
+        else
+            self[strKey] = tOptions[strKey]
+        end
+    end
+    self.astrFatalErrors = tOptions.astrFatalErrors or M.CONNECT_FATAL_ERRORS
+    self.fnEvent = tOptions.fnEvent or printConnectEvent
+end
+
+
+-- Returns "fatal" if the error contains one of the fatal error texts, or
+-- "retryable".
+function ConnectionManager:classify(strError)
+    strError = tostring(strError)
+    for _, strPattern in ipairs(self.astrFatalErrors) do
+        if string.find(strError, strPattern, 1, true) ~= nil then
+            return 'fatal'
+        end
+    end
+    return 'retryable'
+end
+
+
+-- fOk, tResult retry(strWhat, fnAttempt)
+-- Call fnAttempt until it succeeds, a fatal error occurs or all attempts
+-- are used. fnAttempt returns true and a result, or false and an error.
+-- Returns true and the result, or false, the error and its class.
+function ConnectionManager:retry(strWhat, fnAttempt)
+    local fnEvent = self.fnEvent
+    local tDelay = self.tInitialDelay
+    local strError = "no attempt was made"
+    local strClass = 'retryable'
+
+    for ulAttempt = 1, self.ulAttempts do
+        local tEvent = { strWhat = strWhat, ulAttempt = ulAttempt, ulAttempts = self.ulAttempts }
+        fnEvent('attempt', tEvent)
+
+        local tStart = M.clock()
+        local fCallOk, fOk, tResult = pcall(fnAttempt)
+        tEvent.tElapsed = M.clock() - tStart
+        if fCallOk ~= true then
+            fOk, tResult = false, fOk
+        end
+        if fOk == true then
+            fnEvent('connected', tEvent)
+            return true, tResult
+        end
+
+        strError = tResult or "unknown error"
+        strClass = self:classify(strError)
+        if strClass ~= 'fatal' and self.tAttemptDeadline ~= nil and tEvent.tElapsed > self.tAttemptDeadline then
+            strClass = 'timeout'
+        end
+        tEvent.strError = strError
+        tEvent.strClass = strClass
+        fnEvent('failed', tEvent)
+
+        if strClass == 'fatal' then
             break
+        elseif ulAttempt < self.ulAttempts and strClass ~= 'timeout' then
+            fnEvent('wait', { strWhat = strWhat, ulAttempt = ulAttempt, ulAttempts = self.ulAttempts, tDelay = tDelay })
+            M.sleep_s(tDelay)
+            tDelay = math.min(tDelay * self.tBackoffFactor, self.tMaxDelay)
         end
-        ulConsoleMode = tPlugin:get_console_mode()
-		if not fCallSuccess then
-			if string.find(strError, "start_mi image has been rejected or execution has failed.") then
-				break
-			end
-		end
-		
-        print("connect not successful")
-        uLRetries = uLRetries - 1
-        M.sleep_s(1)
-        if uLRetries > 0 then
-            print("retry connecting ... ")
+    end
+
+    fnEvent('giveup', { strWhat = strWhat, ulAttempts = self.ulAttempts, strError = strError, strClass = strClass })
+    return false, strError, strClass
+end
+
+
+-- fOk, strError, ulConsoleMode connect(tPlugin)
+-- Connect the plugin. The console mode is only returned if the connect
+-- failed.
+function ConnectionManager:connect(tPlugin)
+    if tPlugin == nil then
+        return false, "No plugin selected for connect"
+    end
+
+    local fOk, strError = self:retry('connect', function()
+        tPlugin:Connect()
+        return true
+    end)
+
+    local ulConsoleMode = nil
+    if fOk ~= true then
+        local fCallOk, tConsoleMode = pcall(tPlugin.get_console_mode, tPlugin)
+        if fCallOk == true then
+            ulConsoleMode = tConsoleMode
+        end
+    end
+
+    return fOk, strError, ulConsoleMode
+end
+
+
+-- tPlugin, strError getPlugin(strPluginName, strPluginType, atPluginOptions)
+-- Open a plugin. This is retried as the interface may only show up some
+-- time after a reset.
+function ConnectionManager:getPlugin(strPluginName, strPluginType, atPluginOptions)
+    local fOk, tResult = self:retry('get plugin', function()
+        local tPlugin, strError = M.getPlugin(strPluginName, strPluginType, atPluginOptions)
+        if tPlugin == nil then
+            return false, strError or "Failed to get the plugin"
         end
+        return true, tPlugin
+    end)
+    if fOk ~= true then
+        return nil, tResult
     end
+    return tResult
+end
 
-    return fCallSuccess, strError, ulConsoleMode
+
+-- tPlugin, strError reconnect(strPluginName, strPluginType, atPluginOptions, tSettleDelay)
+-- Open and connect a plugin after a reset of the netX. The first attempt
+-- is made tSettleDelay seconds after the call.
+function ConnectionManager:reconnect(strPluginName, strPluginType, atPluginOptions, tSettleDelay)
+    M.sleep_s(tSettleDelay or 0)
+    local tPlugin, strError = self:getPlugin(strPluginName, strPluginType, atPluginOptions)
+    if tPlugin ~= nil then
+        local fOk
+        fOk, strError = self:connect(tPlugin)
+        if fOk ~= true then
+            tPlugin = nil
+        end
+    end
+    return tPlugin, strError
+end
+
+
+M.ConnectionManager = ConnectionManager
+
+
+-- fOk, strError, ulConsoleMode connect(tPlugin, tOptions)
+-- Connect a plugin with a connection manager. See ConnectionManager for
+-- the options.
+function M.connect(tPlugin, tOptions)
+    return ConnectionManager(tOptions):connect(tPlugin)
+end
+
+
+function M.connect_retry(tPlugin, uLRetries)
+    return M.connect(tPlugin, { ulAttempts = uLRetries })
 end
 
 -- Try to open a plugin for an interface with the given name.
@@ -411,7 +679,7 @@ function M.detect_chiptype(aArgs)
 
 	local tPlugin, strMsg = M.getPlugin(strPluginName, strPluginType, atPluginOptions)
 	if tPlugin then
-		fConnected, strMsg = pcall(tPlugin.Connect, tPlugin)
+		fConnected, strMsg = M.connect(tPlugin, { ulAttempts = 1 })
 		print("Connect() result: ", fConnected, strMsg)
 
 		-- translate this message string to a specific return code
@@ -873,16 +1141,6 @@ end
 
 
 
--- Sleep for a number of seconds
--- (between seconds and seconds+1)
-function M.sleep_s(seconds)
-	local t1 = os.time()
-	local t2
-	repeat
-		t2 = os.time()
-	until os.difftime(t2, t1) >= (seconds+1)
-end
-
 -- Set up the watchdog to reset after one second.
 -- This gives us time to disconnect the plugin.
 --
@@ -942,7 +1200,7 @@ function M.reset_netx_via_watchdog(aArgs, tPlugin)
 	fOk = false
 
 	if tPlugin ~= nil then
-		fOk, strMsg = pcall(tPlugin.Connect, tPlugin)
+		fOk, strMsg = M.connect(tPlugin, { ulAttempts = 1 })
 		if not fOk then
 			strMsg = strMsg or "Failed to open connection"
 		else
@@ -1020,9 +1278,9 @@ function M.reset_netx_via_watchdog(aArgs, tPlugin)
 			tPlugin:Disconnect()
 			collectgarbage('collect')
 
-			-- Wait 1 second (actually between 1 and 2 seconds)
+			-- Wait for the watchdog reset.
 			if (fOk == true) then
-				M.sleep_s(1)
+				M.sleep_s(M.WATCHDOG_RESET_DELAY)
 			end
 		end
 	end
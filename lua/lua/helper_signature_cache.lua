@@ -0,0 +1,229 @@
+local M = {}
+
+-- Cache for the results of the helper signature checks.
+--
+-- The signature check of the helpers needs several round trips to the netX
+-- for each helper. If the same helper files are used with the same chip
+-- again, the result of an earlier check can be used instead.
+--
+-- The cache is keyed by the SHA-384 of the helper file, the name of the
+-- helper, the key set and the unique ID of the chip. The key set is the
+-- SHA-384 over all files in the folder of the helper, so signing the helpers
+-- with other keys gives new entries.
+--
+-- The chip must be identified by its unique ID. The chip type and the
+-- interface are not enough: on a programming station a new board at the
+-- same port would get the result of the old board. Reading the unique ID
+-- needs the read_sip helper and a reset, so it is not done here. The cache
+-- is only used after the unique ID was set with setChipUid, for example by
+-- the read_sip step of the USIP player. Without the unique ID every helper
+-- is checked.
+--
+-- Only successful checks are stored. The cache is disabled by default.
+
+local mhash = require 'mhash'
+local dir = require 'pl.dir'
+local path = require 'pl.path'
+local pretty = require 'pl.pretty'
+
+-- The default cache file is in the temp folder of the USIP player.
+M.DEFAULT_CACHE_FILE = path.join(require 'usip_player_conf'.tempFolderConfPath, 'helper_signature_cache.txt')
+
+-- The path to the cache file. The cache is disabled if this is nil.
+local strCachePath = nil
+-- The maximum age of an entry in seconds. nil means no limit.
+local ulMaxAge = nil
+-- The unique ID of the chip as a string, or nil if it is not known.
+local strChipUid = nil
+-- The name of the plugin which was connected to the chip with the unique ID.
+local strChipUidPlugin = nil
+-- The key set hashes of the helper folders. The key is the folder.
+local atKeySets = {}
+-- The cache entries. The key is the hash as a hex string, the value is the
+-- time of the successful check.
+local atEntries = nil
+local fModified = false
+
+
+-- Enable the cache.
+-- strPath is the path to the cache file. It is optional, the default is
+-- DEFAULT_CACHE_FILE.
+-- ulMaxAgeInSeconds is optional. Older entries are not used.
+function M.enable(strPath, ulMaxAgeInSeconds)
+    strCachePath = strPath or M.DEFAULT_CACHE_FILE
+    ulMaxAge = ulMaxAgeInSeconds
+    atEntries = nil
+    fModified = false
+end
+
+
+function M.disable()
+    strCachePath = nil
+    atEntries = nil
+    fModified = false
+end
+
+
+function M.isEnabled()
+    return strCachePath ~= nil
+end
+
+
+-- Set the unique ID of the chip which is connected to the plugin with the
+-- name strPluginName. Pass nil if it is not known.
+function M.setChipUid(strUid, strPluginName)
+    strChipUid = strUid
+    strChipUidPlugin = strPluginName
+end
+
+
+-- Get the unique ID of the chip at tPlugin, or nil if it is not known.
+local function getChipUid(tPlugin)
+    local strUid = nil
+    if strChipUid ~= nil and strChipUidPlugin == tPlugin:GetName() then
+        strUid = strChipUid
+    end
+    return strUid
+end
+
+
+local function sha384(strData)
+    local mh = mhash.mhash_state()
+    mh:init(mhash.MHASH_SHA384)
+    mh:hash(strData)
+    return mh:hash_end()
+end
+
+
+-- Get the hash of the key set from the folder with the signed helpers.
+-- All files of the folder are hashed with their names.
+local function getKeySet(strHelperFolder)
+    local strKeySet = atKeySets[strHelperFolder]
+    if strKeySet == nil then
+        local astrFiles = dir.getfiles(strHelperFolder)
+        table.sort(astrFiles)
+
+        local mh = mhash.mhash_state()
+        mh:init(mhash.MHASH_SHA384)
+        for _, strFile in ipairs(astrFiles) do
+            local tFile = io.open(strFile, 'rb')
+            if tFile ~= nil then
+                local strData = tFile:read('*a')
+                tFile:close()
+                mh:hash(path.basename(strFile) .. '\0')
+                mh:hash(sha384(strData))
+            end
+        end
+        strKeySet = mh:hash_end()
+        atKeySets[strHelperFolder] = strKeySet
+    end
+    return strKeySet
+end
+
+
+local function loadEntries()
+    if atEntries == nil then
+        atEntries = {}
+        local tFile = io.open(strCachePath, 'r')
+        if tFile ~= nil then
+            local strData = tFile:read('*a')
+            tFile:close()
+            local atData = pretty.read(strData)
+            if type(atData) == 'table' then
+                atEntries = atData
+            end
+        end
+    end
+    return atEntries
+end
+
+
+-- Get the cache key for one helper on the connected chip.
+-- strHelperPath is the path of the signed helper file.
+-- Returns nil and a message if the cache is disabled or the unique ID of the
+-- chip is not known.
+function M.getKey(tPlugin, strHelperData, strHelperPath)
+    local strKey = nil
+    local strMsg = nil
+
+    local strUid = getChipUid(tPlugin)
+    if strCachePath == nil then
+        strMsg = 'The cache is disabled.'
+    elseif strUid == nil then
+        strMsg = 'The unique ID of the chip is not known.'
+    else
+        local mh = mhash.mhash_state()
+        mh:init(mhash.MHASH_SHA384)
+        mh:hash(sha384(strHelperData))
+        mh:hash('\0' .. path.basename(strHelperPath))
+        mh:hash('\0' .. getKeySet(path.dirname(strHelperPath)))
+        mh:hash('\0uid:' .. strUid)
+        local strHash = mh:hash_end()
+
+        strKey = string.gsub(strHash, '.', function(c) return string.format('%02x', string.byte(c)) end)
+    end
+
+    return strKey, strMsg
+end
+
+
+-- Check if the key has a valid entry.
+function M.lookup(strKey)
+    local fFound = false
+
+    if strKey ~= nil and strCachePath ~= nil then
+        local ulTime = loadEntries()[strKey]
+        if ulTime ~= nil then
+            fFound = (ulMaxAge == nil or os.time() - ulTime <= ulMaxAge)
+        end
+    end
+
+    return fFound
+end
+
+
+-- Remember a successful check.
+function M.store(strKey)
+    if strKey ~= nil and strCachePath ~= nil then
+        loadEntries()[strKey] = os.time()
+        fModified = true
+    end
+end
+
+
+-- Write the cache file if it was modified.
+-- Expired entries are removed.
+function M.save()
+    local fOk = true
+    local strMsg
+
+    if strCachePath ~= nil and fModified == true then
+        local atKeep = {}
+        local ulNow = os.time()
+        for strKey, ulTime in pairs(atEntries) do
+            if ulMaxAge == nil or ulNow - ulTime <= ulMaxAge then
+                atKeep[strKey] = ulTime
+            end
+        end
+
+        local strFolder = path.dirname(strCachePath)
+        if strFolder ~= '' and path.exists(strFolder) == false then
+            require 'pl.dir'.makepath(strFolder)
+        end
+
+        local tFile
+        tFile, strMsg = io.open(strCachePath, 'w')
+        if tFile == nil then
+            fOk = false
+        else
+            tFile:write(pretty.write(atKeep))
+            tFile:close()
+            fModified = false
+        end
+    end
+
+    return fOk, strMsg
+end
+
+
+return M
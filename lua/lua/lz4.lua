@@ -0,0 +1,203 @@
+local M = {}
+
+-- LZ4 block compression for the compressed flash mode.
+-- This is the plain block format without the frame header and checksums.
+-- It is decoded by lz4_decode_block in the flasher firmware.
+
+-- A match must start at least 12 bytes before the end of the block and the
+-- last 5 bytes must be literals. This keeps the blocks compatible with
+-- other LZ4 decoders.
+local MFLIMIT = 12
+local LASTLITERALS = 5
+local MINMATCH = 4
+local MAX_OFFSET = 0xffff
+
+
+local function append_length(atOut, ulLength)
+    while ulLength>=255 do
+        table.insert(atOut, string.char(255))
+        ulLength = ulLength - 255
+    end
+    table.insert(atOut, string.char(ulLength))
+end
+
+
+-- strCompressed, ulInPlaceGap compress(strData)
+-- Compress strData with a greedy hash match finder.
+--
+-- The second return value is needed to decompress the block in-place.
+-- If the compressed data is placed ulGap bytes after the start of the
+-- output buffer, the decoder never overwrites data it did not read yet
+-- for any ulGap >= ulInPlaceGap.
+function M.compress(strData)
+    local sizData = strData:len()
+    local atOut = {}
+    local sizOut = 0
+    local ulInPlaceGap = 0
+    local atHash = {}
+    local ulAnchor = 1
+    local ulPos = 1
+    local ulLastMatchPos = sizData - MFLIMIT + 1
+    local ulMatchLimit = sizData - LASTLITERALS
+
+    -- Emit one sequence. ulMatchLength is 0 for the last sequence.
+    local function emit(ulLiteralEnd, ulOffset, ulMatchLength)
+        local sizLiterals = ulLiteralEnd - ulAnchor
+        local ulLitToken = math.min(sizLiterals, 15)
+        local ulMatchToken = 0
+        if ulMatchLength~=0 then
+            ulMatchToken = math.min(ulMatchLength - MINMATCH, 15)
+        end
+        local sizStart = #atOut
+        table.insert(atOut, string.char((ulLitToken << 4) | ulMatchToken))
+        if ulLitToken==15 then
+            append_length(atOut, sizLiterals - 15)
+        end
+        local sizHeader = 0
+        for uiCnt=sizStart+1, #atOut do
+            sizHeader = sizHeader + atOut[uiCnt]:len()
+        end
+
+        -- The output position must not pass the input position before
+        -- the literals are copied.
+        local ulOutPos = ulAnchor - 1
+        local ulGap = ulOutPos - (sizOut + sizHeader)
+        if ulGap>ulInPlaceGap then
+            ulInPlaceGap = ulGap
+        end
+
+        table.insert(atOut, strData:sub(ulAnchor, ulLiteralEnd - 1))
+        sizOut = sizOut + sizHeader + sizLiterals
+
+        if ulMatchLength~=0 then
+            local sizMatchStart = #atOut
+            table.insert(atOut, string.char(ulOffset & 0xff, (ulOffset >> 8) & 0xff))
+            if ulMatchToken==15 then
+                append_length(atOut, ulMatchLength - MINMATCH - 15)
+            end
+            for uiCnt=sizMatchStart+1, #atOut do
+                sizOut = sizOut + atOut[uiCnt]:len()
+            end
+
+            -- The match must be written completely before the next token.
+            ulGap = (ulLiteralEnd - 1 + ulMatchLength) - sizOut
+            if ulGap>ulInPlaceGap then
+                ulInPlaceGap = ulGap
+            end
+        end
+    end
+
+    while ulPos<=ulLastMatchPos do
+        local ulValue = string.unpack('<I4', strData, ulPos)
+        local ulCandidate = atHash[ulValue]
+        atHash[ulValue] = ulPos
+
+        if ulCandidate~=nil and (ulPos-ulCandidate)<=MAX_OFFSET then
+            -- The first 4 bytes are equal. Extend the match in blocks of
+            -- 32 bytes first, then byte by byte.
+            local ulMaxLength = ulMatchLimit - ulPos + 1
+            local ulLength = MINMATCH
+            while ulLength+32<=ulMaxLength and strData:sub(ulPos+ulLength, ulPos+ulLength+31)==strData:sub(ulCandidate+ulLength, ulCandidate+ulLength+31) do
+                ulLength = ulLength + 32
+            end
+            while ulLength<ulMaxLength and strData:byte(ulPos+ulLength)==strData:byte(ulCandidate+ulLength) do
+                ulLength = ulLength + 1
+            end
+
+            emit(ulPos, ulPos-ulCandidate, ulLength)
+            ulPos = ulPos + ulLength
+            ulAnchor = ulPos
+        else
+            ulPos = ulPos + 1
+        end
+    end
+
+    -- The rest of the data are literals.
+    emit(sizData+1, 0, 0)
+
+    return table.concat(atOut), ulInPlaceGap
+end
+
+
+-- strData, strError decompress(strCompressed)
+-- Decompress an LZ4 block. This is the reference for lz4_decode_block and
+-- is used to check the compressor.
+function M.decompress(strCompressed)
+    local sizIn = strCompressed:len()
+    local ulIn = 1
+    -- The output as a list of byte values. Matches copy single bytes as
+    -- they may overlap with themselves.
+    local aucOut = {}
+    local sizOut = 0
+
+    local function read_length(ulLength)
+        local ucByte
+        repeat
+            if ulIn>sizIn then
+                return nil
+            end
+            ucByte = strCompressed:byte(ulIn)
+            ulIn = ulIn + 1
+            ulLength = ulLength + ucByte
+        until ucByte~=255
+        return ulLength
+    end
+
+    while ulIn<=sizIn do
+        local ucToken = strCompressed:byte(ulIn)
+        ulIn = ulIn + 1
+
+        local ulLength = ucToken >> 4
+        if ulLength==15 then
+            ulLength = read_length(ulLength)
+            if ulLength==nil then
+                return nil, 'The input ends in a literal length.'
+            end
+        end
+        if ulIn+ulLength-1>sizIn then
+            return nil, 'The input ends in the literals.'
+        end
+        for uiCnt=0, ulLength-1 do
+            aucOut[sizOut+uiCnt+1] = strCompressed:byte(ulIn+uiCnt)
+        end
+        ulIn = ulIn + ulLength
+        sizOut = sizOut + ulLength
+
+        if ulIn>sizIn then
+            break
+        end
+
+        if ulIn+1>sizIn then
+            return nil, 'The input ends in a match offset.'
+        end
+        local ulOffset = strCompressed:byte(ulIn) | (strCompressed:byte(ulIn+1) << 8)
+        ulIn = ulIn + 2
+        if ulOffset==0 or ulOffset>sizOut then
+            return nil, 'Invalid match offset.'
+        end
+
+        ulLength = ucToken & 0x0f
+        if ulLength==15 then
+            ulLength = read_length(ulLength)
+            if ulLength==nil then
+                return nil, 'The input ends in a match length.'
+            end
+        end
+        ulLength = ulLength + MINMATCH
+
+        for uiCnt=sizOut+1, sizOut+ulLength do
+            aucOut[uiCnt] = aucOut[uiCnt-ulOffset]
+        end
+        sizOut = sizOut + ulLength
+    end
+
+    -- Convert the bytes to a string in small pieces.
+    local astrOut = {}
+    for uiCnt=1, sizOut, 4096 do
+        table.insert(astrOut, string.char(table.unpack(aucOut, uiCnt, math.min(uiCnt+4095, sizOut))))
+    end
+    return table.concat(astrOut)
+end
+
+
+return M
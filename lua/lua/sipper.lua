@@ -22,6 +22,18 @@ tSignatures[2][1] = 256  -- 2048
 tSignatures[2][2] = 384  -- 3072
 tSignatures[2][3] = 512  -- 4096
 
+-- Get the SHA384 of an area in strData. The area is hashed in place, so
+-- no copy of it is made. ulOffset starts at 0. The area is clipped at the
+-- end of the data.
+local function hash_area(tHash, strData, ulOffset, ulSize)
+    tHash:init(mhash.MHASH_SHA384)
+    if ulOffset < string.len(strData) then
+        tHash:hash(strData, ulSize, ulOffset)
+    end
+    return tHash:hash_end()
+end
+
+
 local Sipper = class()
 
 function Sipper:_init(tLog)
@@ -172,42 +184,37 @@ function Sipper:analyze_hboot_image(strFileData)
 
             elseif tNewChunk["strChunkId"] == "USIP" then
                 local ulUsipStartOffset = tBinStringHandle:seek()
-                tChunkHash:init(mhash.MHASH_SHA384)
-                tChunkHash:hash(tNewChunk["strChunkId"])
-                tChunkHash:hash(tNewChunk["strChunkSize"])
+                tNewChunk["ulOffset"] = ulUsipStartOffset - 8
 
-                -- update the hash with page select
+                -- The hash covers the chunk from the chunk ID up to the end
+                -- of the content. It is built from the image data below.
+                tNewChunk["ulHashSize"] = 12
+
+                -- get the page select
                 tNewChunk["strPageSelect"] = tBinStringHandle:read(1)
                 tNewChunk["ulPageSelect"] = tFlasherHelper.bytes_to_uint32(tNewChunk["strPageSelect"])
-                tChunkHash:hash(tNewChunk["strPageSelect"])
 
                 -- get the key idx
                 tNewChunk["strKeyIdx"] = tBinStringHandle:read(1)
                 tNewChunk["ulKeyIdx"] = tFlasherHelper.bytes_to_uint32(tNewChunk["strKeyIdx"])
-                tChunkHash:hash(tNewChunk["strKeyIdx"])
 
                 -- get the content size
                 tNewChunk["strContentSize"] = tBinStringHandle:read(2)
                 local ulContentSize = tFlasherHelper.bytes_to_uint32(tNewChunk["strContentSize"])
                 tNewChunk["ulContentSize"] = ulContentSize + (ulContentSize % 4) -- round up to dword
-                tChunkHash:hash(tNewChunk["strContentSize"])
 
                 if tNewChunk["ulKeyIdx"] ~= 255 then
                     -- get the uuid
                     tNewChunk["strUUID"] = tBinStringHandle:read(12)
-                    tChunkHash:hash(tNewChunk["strUUID"])
 
                     -- extract all 4 anchors
                     tNewChunk["strAnchor"] = tBinStringHandle:read(16)
-                    tChunkHash:hash(tNewChunk["strAnchor"])
 
                     -- get the uuid mask
                     tNewChunk["strUUIDMask"] = tBinStringHandle:read(12)
-                    tChunkHash:hash(tNewChunk["strUUIDMask"])
 
                     -- get the anchor mask
                     tNewChunk["strAnchorMask"] = tBinStringHandle:read(16)
-                    tChunkHash:hash(tNewChunk["strAnchorMask"])
 
                     -- extract the key algorithm
                     tNewChunk["strKeyAlgorithm"] = tBinStringHandle:read(1)
@@ -221,7 +228,6 @@ function Sipper:analyze_hboot_image(strFileData)
 
                     -- extract padded key
                     tNewChunk["strPaddedKey"] = tBinStringHandle:read(520)
-                    tChunkHash:hash(tNewChunk["strPaddedKey"])
 
                     -- check if the extracted values are valid
                     if tSignatures[tNewChunk["ulKeyAlgorithm"]] == nil then
@@ -238,7 +244,7 @@ function Sipper:analyze_hboot_image(strFileData)
                     end
                     ulSignatureSize = tSignatures[tNewChunk["ulKeyAlgorithm"]][tNewChunk["ulKeyStrength"]]
                     tNewChunk["strDataContent"] = tBinStringHandle:read(tNewChunk["ulContentSize"])
-                    tChunkHash:hash(tNewChunk["strDataContent"])
+                    tNewChunk["ulHashSize"] = 12 + 56 + 520 + tNewChunk["ulContentSize"]
 
                     tNewChunk["strSignature"] = tBinStringHandle:read(ulSignatureSize)
 
@@ -252,57 +258,49 @@ function Sipper:analyze_hboot_image(strFileData)
 
                 -- ignore data until end of chunk
                 tBinStringHandle:seek("set", newOffset)
-                tNewChunk["strChunkHash"] = tChunkHash:hash_end()
+                tNewChunk["strChunkHash"] = hash_area(tChunkHash, strFileData, tNewChunk["ulOffset"], tNewChunk["ulHashSize"])
             elseif tNewChunk["strChunkId"] =="HTBL" then
-
-                tChunkHash:init(mhash.MHASH_SHA384)
-                tChunkHash:hash(tNewChunk["strChunkId"])
-                tChunkHash:hash(tNewChunk["strChunkSize"])
+                tNewChunk["ulOffset"] = tBinStringHandle:seek() - 8
 
                 local ulReadSize = 8  -- we start after chunk id and chunk size
 
-                -- update the hash with page select
+                -- get the page select
                 tNewChunk["strPageSelect"] = tBinStringHandle:read(1)
                 tNewChunk["ulPageSelect"] = tFlasherHelper.bytes_to_uint32(tNewChunk["strPageSelect"])
-                tChunkHash:hash(tNewChunk["strPageSelect"])
                 ulReadSize = ulReadSize + 1
 
-                -- update the hash with key idx
+                -- get the key idx
                 tNewChunk["strKeyIdx"] = tBinStringHandle:read(1)
                 tNewChunk["ulKeyIdx"] = tFlasherHelper.bytes_to_uint32(tNewChunk["strKeyIdx"])
-                tChunkHash:hash(tNewChunk["strKeyIdx"])
                 ulReadSize = ulReadSize + 1
 
                 local strHashTableEntries = tBinStringHandle:read(2)
                 local ulHashTableEntries = tFlasherHelper.bytes_to_uint32(strHashTableEntries)
                 local ulHashTableSize = ulHashTableEntries * 48
-                tChunkHash:hash(strHashTableEntries)
                 ulReadSize = ulReadSize + 2
 
                 -- get the uuid
                 tNewChunk["strUUID"] = tBinStringHandle:read(12)
-                tChunkHash:hash(tNewChunk["strUUID"])
                 ulReadSize = ulReadSize + 12
 
                 -- extract all 4 anchors
                 tNewChunk["strAnchor"] = tBinStringHandle:read(16)
-                tChunkHash:hash(tNewChunk["strAnchor"])
                 ulReadSize = ulReadSize + 16
 
                 -- get the uuid mask
                 tNewChunk["strUUIDMask"] = tBinStringHandle:read(12)
-                tChunkHash:hash(tNewChunk["strUUIDMask"])
                 ulReadSize = ulReadSize + 12
 
                 tNewChunk["strAnchorMask"] = tBinStringHandle:read(16)
-                tChunkHash:hash(tNewChunk["strAnchorMask"])
                 ulReadSize = ulReadSize + 16
 
-                local strHashTableContent = tBinStringHandle:read(ulHashTableSize)
-                tChunkHash:hash(strHashTableContent)
+                -- skip the hash table, it is only needed for the hash
+                tBinStringHandle:seek("cur", ulHashTableSize)
                 ulReadSize = ulReadSize + ulHashTableSize
 
-                tNewChunk["strChunkHash"] = tChunkHash:hash_end()
+                -- The hash covers everything up to the end of the hash table.
+                tNewChunk["ulHashSize"] = ulReadSize
+                tNewChunk["strChunkHash"] = hash_area(tChunkHash, strFileData, tNewChunk["ulOffset"], ulReadSize)
 
                 -- print(tBinStringHandle:seek())
                 -- chunk size does not include the chunk id and the chunk size itself
@@ -0,0 +1,137 @@
+local M = {}
+
+-- Sparse maps for flash images.
+--
+-- A sparse map is a list of extents with data which is not blank. Everything
+-- outside of the extents has the erased value of the flash. An erase
+-- produces these areas, so they do not have to be transferred or programmed.
+--
+-- The extents are relative to the start of the image. Each extent has the
+-- fields ulOffset and ulSize. The list is sorted and the extents do not
+-- overlap or touch.
+--
+-- In the WFP control file the map is stored in the "extents" attribute of a
+-- "Data" element. It is a comma separated list of "offset+size" pairs.
+
+-- The image is scanned in blocks of this size. Extents start and end at a
+-- block border or at the end of the image.
+M.BLOCK_SIZE = 0x1000
+
+-- The erased value of NOR flashes.
+M.ERASED_VALUE = 0xff
+
+
+-- atExtents scan(strData, ulBlockSize, ucErasedValue)
+-- Find all blocks in strData which are not completely erased and merge
+-- adjacent ones. ulBlockSize and ucErasedValue are optional.
+function M.scan(strData, ulBlockSize, ucErasedValue)
+    ulBlockSize = ulBlockSize or M.BLOCK_SIZE
+    ucErasedValue = ucErasedValue or M.ERASED_VALUE
+
+    local sizData = strData:len()
+    local strBlank = string.rep(string.char(ucErasedValue), ulBlockSize)
+    local strErased = string.char(ucErasedValue)
+    if string.match(strErased, '%w')==nil then
+        strErased = '%' .. strErased
+    end
+    local strPattern = '[^' .. strErased .. ']'
+    local atExtents = {}
+    local tLast = nil
+
+    local ulOffset = 0
+    while ulOffset<sizData do
+        -- Jump over the erased data to the next block with data.
+        local ulDataPos = string.find(strData, strPattern, ulOffset+1)
+        if ulDataPos==nil then
+            break
+        end
+        ulOffset = ((ulDataPos-1) // ulBlockSize) * ulBlockSize
+
+        -- Collect all following blocks which are not blank.
+        local ulEnd = ulOffset
+        repeat
+            ulEnd = math.min(ulEnd + ulBlockSize, sizData)
+        until ulEnd>=sizData or string.sub(strData, ulEnd+1, ulEnd+ulBlockSize)==strBlank
+
+        if tLast~=nil and tLast.ulOffset+tLast.ulSize==ulOffset then
+            tLast.ulSize = ulEnd - tLast.ulOffset
+        else
+            tLast = { ulOffset=ulOffset, ulSize=ulEnd-ulOffset }
+            table.insert(atExtents, tLast)
+        end
+        ulOffset = ulEnd
+    end
+
+    return atExtents
+end
+
+
+-- Get the number of bytes in the extents.
+function M.getDataSize(atExtents)
+    local ulSize = 0
+    for _, tExtent in ipairs(atExtents) do
+        ulSize = ulSize + tExtent.ulSize
+    end
+    return ulSize
+end
+
+
+-- atHoles getHoles(atExtents, sizData)
+-- Get the areas between the extents. These must be erased.
+function M.getHoles(atExtents, sizData)
+    local atHoles = {}
+    local ulOffset = 0
+    for _, tExtent in ipairs(atExtents) do
+        if tExtent.ulOffset>ulOffset then
+            table.insert(atHoles, { ulOffset=ulOffset, ulSize=tExtent.ulOffset-ulOffset })
+        end
+        ulOffset = tExtent.ulOffset + tExtent.ulSize
+    end
+    if sizData>ulOffset then
+        table.insert(atHoles, { ulOffset=ulOffset, ulSize=sizData-ulOffset })
+    end
+    return atHoles
+end
+
+
+-- Convert the extents to the attribute value for the control file.
+function M.toString(atExtents)
+    local astrExtents = {}
+    for _, tExtent in ipairs(atExtents) do
+        table.insert(astrExtents, string.format('0x%08x+0x%08x', tExtent.ulOffset, tExtent.ulSize))
+    end
+    return table.concat(astrExtents, ',')
+end
+
+
+-- atExtents, strError fromString(strExtents)
+-- Parse the attribute value from the control file. An empty string is an
+-- image without any data.
+function M.fromString(strExtents)
+    local atExtents = {}
+    local ulLastEnd = 0
+    for strExtent in string.gmatch(strExtents, '[^,]+') do
+        local strOffset, strSize = string.match(strExtent, '^%s*([%w]+)%s*%+%s*([%w]+)%s*$')
+        local ulOffset = tonumber(strOffset)
+        local ulSize = tonumber(strSize)
+        if ulOffset==nil or ulSize==nil then
+            return nil, string.format('Invalid extent "%s".', strExtent)
+        end
+        if ulOffset<ulLastEnd then
+            return nil, string.format('The extent "%s" is not sorted or overlaps the previous one.', strExtent)
+        end
+        table.insert(atExtents, { ulOffset=ulOffset, ulSize=ulSize })
+        ulLastEnd = ulOffset + ulSize
+    end
+    return atExtents
+end
+
+
+-- Check that all extents are inside an image of sizData bytes.
+function M.check(atExtents, sizData)
+    local tLast = atExtents[#atExtents]
+    return tLast==nil or tLast.ulOffset+tLast.ulSize<=sizData
+end
+
+
+return M
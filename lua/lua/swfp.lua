@@ -0,0 +1,359 @@
+local M = {}
+
+-- Reader and writer for SWFP files.
+--
+-- A SWFP is a simple container for flash images. Version 1 is the magic
+-- "SWFP" followed by records of the form
+--   u8 bus, u8 unit, u8 chip select, u32 offset, u32 size, data
+-- It has no index and no integrity data.
+--
+-- Version 2 starts with a header and a table of contents:
+--   c4  magic "SWF2"
+--   u16 version (2)
+--   u16 size of one TOC entry in bytes
+--   u32 number of records
+--   u32 compression block size
+--   c32 SHA-256 of all TOC entries
+-- Each TOC entry describes one record:
+--   u8  bus, u8 unit, u8 chip select, u8 compression
+--   u32 offset in the flash
+--   u32 size of the data
+--   u32 size of the stored payload
+--   u32 position of the payload in the file
+--   c32 SHA-256 of the data
+-- The payloads follow the TOC. A compressed payload is a list of LZ4 blocks
+-- in the format of lz4.lua. Each block has a u32 header with the stored
+-- size in bits 0..30. Bit 31 is set if the block is stored uncompressed.
+-- Each block expands to the compression block size, the last block may be
+-- shorter.
+--
+-- All values are little endian.
+--
+-- Version 2 has its own magic. A version 1 record can start with any bus
+-- ID, so the bytes after "SWFP" can not tell the versions apart.
+
+local mhash = require 'mhash'
+
+M.MAGIC = 'SWFP'
+M.MAGIC_2 = 'SWF2'
+M.VERSION_1 = 1
+M.VERSION_2 = 2
+
+M.COMPRESSION_NONE = 0
+M.COMPRESSION_LZ4 = 1
+
+-- This is the chunk size of flasher.flashArea.
+M.DEFAULT_BLOCK_SIZE = 0x10000
+
+local HEADER_FORMAT = '<c4I2I2I4I4c32'
+local HEADER_SIZE = string.packsize(HEADER_FORMAT)
+local TOC_ENTRY_FORMAT = '<BBBBI4I4I4I4c32'
+local TOC_ENTRY_SIZE = string.packsize(TOC_ENTRY_FORMAT)
+local BLOCK_STORED = 0x80000000
+
+
+local function sha256(strData)
+    local mh = mhash.mhash_state()
+    mh:init(mhash.MHASH_SHA256)
+    mh:hash(strData)
+    return mh:hash_end()
+end
+
+
+-- Compress the data in blocks. Blocks which do not get smaller are stored.
+local function compress(strData, ulBlockSize)
+    local lz4 = require 'lz4'
+    local astrPayload = {}
+    for ulOffset=1, strData:len(), ulBlockSize do
+        local strBlock = string.sub(strData, ulOffset, ulOffset+ulBlockSize-1)
+        local strCompressed = lz4.compress(strBlock)
+        if strCompressed:len()<strBlock:len() then
+            table.insert(astrPayload, string.pack('<I4', strCompressed:len()))
+            table.insert(astrPayload, strCompressed)
+        else
+            table.insert(astrPayload, string.pack('<I4', BLOCK_STORED | strBlock:len()))
+            table.insert(astrPayload, strBlock)
+        end
+    end
+    return table.concat(astrPayload)
+end
+
+
+local function decompress(strPayload, ulDataSize, ulBlockSize)
+    local lz4 = require 'lz4'
+    local astrData = {}
+    local ulPos = 1
+    local ulRemaining = ulDataSize
+    while ulRemaining>0 do
+        if ulPos+3>strPayload:len() then
+            return nil, 'The payload ends in a block header.'
+        end
+        local ulHeader = string.unpack('<I4', strPayload, ulPos)
+        ulPos = ulPos + 4
+        local sizStored = ulHeader & (~BLOCK_STORED)
+        local strStored = string.sub(strPayload, ulPos, ulPos+sizStored-1)
+        if strStored:len()~=sizStored then
+            return nil, 'The payload ends in a block.'
+        end
+        ulPos = ulPos + sizStored
+
+        local strBlock
+        if (ulHeader & BLOCK_STORED)~=0 then
+            strBlock = strStored
+        else
+            local strError
+            strBlock, strError = lz4.decompress(strStored)
+            if strBlock==nil then
+                return nil, strError
+            end
+        end
+        if strBlock:len()~=math.min(ulBlockSize, ulRemaining) then
+            return nil, 'A block has the wrong size.'
+        end
+        table.insert(astrData, strBlock)
+        ulRemaining = ulRemaining - strBlock:len()
+    end
+    return table.concat(astrData)
+end
+
+
+-- Get the data of a record. It is read from strFilename if the record
+-- has no strData.
+local function getRecordData(tRecord)
+    local strData = tRecord.strData
+    if strData==nil then
+        local tFile, strError = io.open(tRecord.strFilename, 'rb')
+        if tFile==nil then
+            return nil, strError
+        end
+        strData = tFile:read('a')
+        tFile:close()
+        if strData==nil then
+            return nil, string.format('Failed to read "%s".', tRecord.strFilename)
+        end
+    end
+    return strData
+end
+
+
+-- fOk, strError write(tFile, atRecords, ulVersion, fCompress, ulBlockSize)
+-- Write a SWFP to an open file.
+-- Each record has the fields ucBus, ucUnit, ucChipSelect, ulOffset and
+-- either strData or strFilename. ulVersion is VERSION_1 or VERSION_2, the
+-- default is VERSION_1. fCompress and ulBlockSize are only used for
+-- VERSION_2.
+-- Version 1 records are written one by one, so only the data of one
+-- record is in memory. Version 2 keeps all payloads until the TOC is
+-- written, as the TOC needs their sizes and positions.
+function M.write(tFile, atRecords, ulVersion, fCompress, ulBlockSize)
+    ulVersion = ulVersion or M.VERSION_1
+    ulBlockSize = ulBlockSize or M.DEFAULT_BLOCK_SIZE
+
+    if ulVersion==M.VERSION_1 then
+        tFile:write(M.MAGIC)
+        for _, tRecord in ipairs(atRecords) do
+            local strData, strError = getRecordData(tRecord)
+            if strData==nil then
+                return false, strError
+            end
+            tFile:write(string.pack(
+                '<BBBI4I4',
+                tRecord.ucBus,
+                tRecord.ucUnit,
+                tRecord.ucChipSelect,
+                tRecord.ulOffset,
+                strData:len()
+            ))
+            tFile:write(strData)
+        end
+
+    elseif ulVersion==M.VERSION_2 then
+        -- The payloads follow the TOC.
+        local ulPosition = HEADER_SIZE + #atRecords*TOC_ENTRY_SIZE
+        local astrToc = {}
+        local astrPayloads = {}
+        for _, tRecord in ipairs(atRecords) do
+            local strData, strError = getRecordData(tRecord)
+            if strData==nil then
+                return false, strError
+            end
+            local strPayload = strData
+            local ucCompression = M.COMPRESSION_NONE
+            if fCompress==true then
+                strPayload = compress(strData, ulBlockSize)
+                ucCompression = M.COMPRESSION_LZ4
+            end
+
+            table.insert(astrToc, string.pack(
+                TOC_ENTRY_FORMAT,
+                tRecord.ucBus,
+                tRecord.ucUnit,
+                tRecord.ucChipSelect,
+                ucCompression,
+                tRecord.ulOffset,
+                strData:len(),
+                strPayload:len(),
+                ulPosition,
+                sha256(strData)
+            ))
+            table.insert(astrPayloads, strPayload)
+            ulPosition = ulPosition + strPayload:len()
+        end
+        if ulPosition>0xffffffff then
+            return false, 'The SWFP would be larger than 4 GiB.'
+        end
+
+        local strToc = table.concat(astrToc)
+        tFile:write(string.pack(HEADER_FORMAT, M.MAGIC_2, M.VERSION_2, TOC_ENTRY_SIZE, #atRecords, ulBlockSize, sha256(strToc)))
+        tFile:write(strToc)
+        for _, strPayload in ipairs(astrPayloads) do
+            tFile:write(strPayload)
+        end
+
+    else
+        return false, string.format('Unknown SWFP version: %s', tostring(ulVersion))
+    end
+
+    return true
+end
+
+
+-- tSwfp, strError open(strPath)
+-- Open a SWFP and read the table of contents. Only the headers are read,
+-- for version 1 files the data is skipped.
+-- The result has the fields ulVersion and atRecords. Each record has the
+-- fields ucBus, ucUnit, ucChipSelect, ulOffset, ulSize and the position
+-- of the payload. Use readRecord to get the data.
+function M.open(strPath)
+    local tFile, strError = io.open(strPath, 'rb')
+    if tFile==nil then
+        return nil, strError
+    end
+
+    local tSwfp = { tFile=tFile, atRecords={} }
+    local strMagic = tFile:read(4)
+    if strMagic~=M.MAGIC and strMagic~=M.MAGIC_2 then
+        tFile:close()
+        return nil, 'The file has no SWFP magic.'
+    end
+
+    if strMagic==M.MAGIC_2 then
+        local strHeader = tFile:read(HEADER_SIZE - 4)
+        if strHeader==nil or strHeader:len()~=HEADER_SIZE-4 then
+            tFile:close()
+            return nil, 'The SWFP header is truncated.'
+        end
+        local ulVersion, sizTocEntry, ulRecords, ulBlockSize, strTocHash = string.unpack('<I2I2I4I4c32', strHeader)
+        if ulVersion~=M.VERSION_2 then
+            tFile:close()
+            return nil, string.format('Unknown SWFP version: %d', ulVersion)
+        end
+        if sizTocEntry<TOC_ENTRY_SIZE then
+            tFile:close()
+            return nil, 'The TOC entries are too small.'
+        end
+        local strToc = tFile:read(sizTocEntry*ulRecords) or ''
+        if strToc:len()~=sizTocEntry*ulRecords or sha256(strToc)~=strTocHash then
+            tFile:close()
+            return nil, 'The SWFP TOC is damaged.'
+        end
+
+        tSwfp.ulVersion = M.VERSION_2
+        tSwfp.ulBlockSize = ulBlockSize
+        for ulCnt=0, ulRecords-1 do
+            local ucBus, ucUnit, ucChipSelect, ucCompression, ulOffset, ulSize, sizPayload, ulPosition, strHash = string.unpack(TOC_ENTRY_FORMAT, strToc, ulCnt*sizTocEntry+1)
+            table.insert(tSwfp.atRecords, {
+                ucBus=ucBus,
+                ucUnit=ucUnit,
+                ucChipSelect=ucChipSelect,
+                ucCompression=ucCompression,
+                ulOffset=ulOffset,
+                ulSize=ulSize,
+                sizPayload=sizPayload,
+                ulPosition=ulPosition,
+                strHash=strHash
+            })
+        end
+
+    else
+        -- Version 1 has the first record header directly after the magic.
+        tSwfp.ulVersion = M.VERSION_1
+        while true do
+            local strHeader = tFile:read(11)
+            if strHeader==nil then
+                break
+            elseif strHeader:len()~=11 then
+                tFile:close()
+                return nil, 'A record header is truncated.'
+            end
+            local ucBus, ucUnit, ucChipSelect, ulOffset, ulSize = string.unpack('<BBBI4I4', strHeader)
+            local ulPosition = tFile:seek()
+            table.insert(tSwfp.atRecords, {
+                ucBus=ucBus,
+                ucUnit=ucUnit,
+                ucChipSelect=ucChipSelect,
+                ucCompression=M.COMPRESSION_NONE,
+                ulOffset=ulOffset,
+                ulSize=ulSize,
+                sizPayload=ulSize,
+                ulPosition=ulPosition
+            })
+            tFile:seek('set', ulPosition + ulSize)
+        end
+    end
+
+    return tSwfp
+end
+
+
+-- Get all records for one flash. ucUnit and ucChipSelect are optional.
+function M.getRecords(tSwfp, ucBus, ucUnit, ucChipSelect)
+    local atRecords = {}
+    for _, tRecord in ipairs(tSwfp.atRecords) do
+        if tRecord.ucBus==ucBus and (ucUnit==nil or tRecord.ucUnit==ucUnit) and (ucChipSelect==nil or tRecord.ucChipSelect==ucChipSelect) then
+            table.insert(atRecords, tRecord)
+        end
+    end
+    return atRecords
+end
+
+
+-- strData, strError readRecord(tSwfp, tRecord)
+-- Read and unpack the data of one record. For version 2 the SHA-256 of the
+-- data is checked.
+function M.readRecord(tSwfp, tRecord)
+    local tFile = tSwfp.tFile
+    tFile:seek('set', tRecord.ulPosition)
+    local strPayload = tFile:read(tRecord.sizPayload) or ''
+    if strPayload:len()~=tRecord.sizPayload then
+        return nil, 'The record is truncated.'
+    end
+
+    local strData = strPayload
+    if tRecord.ucCompression==M.COMPRESSION_LZ4 then
+        local strError
+        strData, strError = decompress(strPayload, tRecord.ulSize, tSwfp.ulBlockSize)
+        if strData==nil then
+            return nil, strError
+        end
+    elseif tRecord.ucCompression~=M.COMPRESSION_NONE then
+        return nil, string.format('Unknown compression: %d', tRecord.ucCompression)
+    end
+
+    if strData:len()~=tRecord.ulSize then
+        return nil, 'The record has the wrong size.'
+    end
+    if tRecord.strHash~=nil and sha256(strData)~=tRecord.strHash then
+        return nil, 'The SHA-256 of the record does not match.'
+    end
+
+    return strData
+end
+
+
+function M.close(tSwfp)
+    tSwfp.tFile:close()
+end
+
+
+return M
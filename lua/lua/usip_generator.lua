@@ -31,85 +31,95 @@ function UsipGenerator:_init(tLog)
     )
 end
 
-function UsipGenerator:gen_multi_usip(tUsipConfigDict)
-   local aDataList = {}
-   local tDataNames = {}
-    for iIdx = 0, tUsipConfigDict["num_of_chunks"] -1 do
-        local tChunkContent = tUsipConfigDict['content'][iIdx]
-
-        -- open the first output file
-
-        local strUsipData = ""
-
-        -- write the magic sequence
-        strUsipData = strUsipData .. string.char(0x00, 0xaf, 0xbe, 0xf3)
-
-        -- fill up with 12 zeros
-        strUsipData = strUsipData .. string.char(0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00)
-
-        -- write header image size
-        strUsipData = strUsipData .. tUsipConfigDict["header_image_size"]
-
-        -- fill up with 4 zeros
-        strUsipData = strUsipData .. string.char(0x00, 0x00, 0x00, 0x00)
-
-        -- write MOOH
-        strUsipData = strUsipData .. string.char(0x4d, 0x4f, 0x4f, 0x48)
-
-        -- fill up with 4 zeros
-        strUsipData = strUsipData .. string.char(0x00, 0x00, 0x00, 0x00)
-
-        -- write header hash
-        strUsipData = strUsipData .. tUsipConfigDict['sha224']
-
-        -- write header checksum
-        strUsipData = strUsipData .. tUsipConfigDict['header_check_sum']
-
-        -- write usip cookie
-        strUsipData = strUsipData .. string.char(0x55, 0x53, 0x49, 0x50)
-
-        -- write chunk size
-        strUsipData = strUsipData .. tChunkContent['chunk_size']
-
-        -- add page type
-        strUsipData = strUsipData .. tChunkContent['page_type']
-
-        -- add key index
-        strUsipData = strUsipData .. tChunkContent['key_idx']
+-- Get the parts of the single USIP image for one chunk. The image is the
+-- concatenation of the parts.
+-- Returns the parts, the index of the part with the chunk ID and a table
+-- with the index of the part with the patched data for each data entry.
+function UsipGenerator.get_usip_image_parts(tUsipConfigDict, tChunkContent)
+    local astrParts = {}
+    local atDataParts = {}
+
+    -- write the magic sequence
+    table.insert(astrParts, string.char(0x00, 0xaf, 0xbe, 0xf3))
+
+    -- fill up with 12 zeros
+    table.insert(astrParts, string.char(0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00))
+
+    -- write header image size
+    table.insert(astrParts, tUsipConfigDict["header_image_size"])
+
+    -- fill up with 4 zeros
+    table.insert(astrParts, string.char(0x00, 0x00, 0x00, 0x00))
+
+    -- write MOOH
+    table.insert(astrParts, string.char(0x4d, 0x4f, 0x4f, 0x48))
+
+    -- fill up with 4 zeros
+    table.insert(astrParts, string.char(0x00, 0x00, 0x00, 0x00))
+
+    -- write header hash
+    table.insert(astrParts, tUsipConfigDict['sha224'])
+
+    -- write header checksum
+    table.insert(astrParts, tUsipConfigDict['header_check_sum'])
+
+    -- write usip cookie
+    table.insert(astrParts, string.char(0x55, 0x53, 0x49, 0x50))
+    local iChunkPart = #astrParts
+
+    -- write chunk size
+    table.insert(astrParts, tChunkContent['chunk_size'])
+
+    -- add page type
+    table.insert(astrParts, tChunkContent['page_type'])
+
+    -- add key index
+    table.insert(astrParts, tChunkContent['key_idx'])
+
+    -- add patched size
+    table.insert(astrParts, tChunkContent['patched_size'])
+
+    if tChunkContent['key_idx_int'] ~= 255 then
+        table.insert(astrParts, tChunkContent['uuid'])
+        table.insert(astrParts, tChunkContent['anchor_0'])
+        table.insert(astrParts, tChunkContent['anchor_1'])
+        table.insert(astrParts, tChunkContent['anchor_2'])
+        table.insert(astrParts, tChunkContent['anchor_3'])
+        table.insert(astrParts, tChunkContent['uuid_mask'])
+        table.insert(astrParts, tChunkContent['anchor_mask_0'])
+        table.insert(astrParts, tChunkContent['anchor_mask_1'])
+        table.insert(astrParts, tChunkContent['anchor_mask_2'])
+        table.insert(astrParts, tChunkContent['anchor_mask_3'])
+        table.insert(astrParts, tChunkContent['padded_key'])
+    end
 
-        -- add patched size
-        strUsipData = strUsipData .. tChunkContent['patched_size']
+    -- add data
+    for iDataIdx=0, tChunkContent['ulDataCount'] do
+        table.insert(astrParts, tChunkContent['data'][iDataIdx]['offset'])
+        table.insert(astrParts, tChunkContent['data'][iDataIdx]['size'])
+        table.insert(astrParts, tChunkContent['data'][iDataIdx]['patched_data'])
+        atDataParts[iDataIdx] = #astrParts
+    end
 
-        if tChunkContent['key_idx_int'] ~= 255 then
-            strUsipData = strUsipData .. tChunkContent['uuid']
-            strUsipData = strUsipData .. tChunkContent['anchor_0']
-            strUsipData = strUsipData .. tChunkContent['anchor_1']
-            strUsipData = strUsipData .. tChunkContent['anchor_2']
-            strUsipData = strUsipData .. tChunkContent['anchor_3']
-            strUsipData = strUsipData .. tChunkContent['uuid_mask']
-            strUsipData = strUsipData .. tChunkContent['anchor_mask_0']
-            strUsipData = strUsipData .. tChunkContent['anchor_mask_1']
-            strUsipData = strUsipData .. tChunkContent['anchor_mask_2']
-            strUsipData = strUsipData .. tChunkContent['anchor_mask_3']
-            strUsipData = strUsipData .. tChunkContent['padded_key']
-        end
+    -- add padding
+    table.insert(astrParts, tChunkContent['padding'])
 
-        -- add data
-        for iDataIdx=0, tChunkContent['ulDataCount'] do
-            strUsipData = strUsipData .. tChunkContent['data'][iDataIdx]['offset']
-            strUsipData = strUsipData .. tChunkContent['data'][iDataIdx]['size']
-            strUsipData = strUsipData .. tChunkContent['data'][iDataIdx]['patched_data']
-        end
+    --add signature
+    table.insert(astrParts, tChunkContent['signature'])
+    -- add 4 zeros
+    table.insert(astrParts, string.char(0x00, 0x00, 0x00, 0x00))
 
-        -- add padding
-        strUsipData = strUsipData .. tChunkContent['padding']
+    return astrParts, iChunkPart, atDataParts
+end
 
-        --add signature
-        strUsipData = strUsipData .. tChunkContent['signature']
-        -- add 4 zeros
-        strUsipData = strUsipData .. string.char(0x00, 0x00, 0x00, 0x00)
+function UsipGenerator:gen_multi_usip(tUsipConfigDict)
+    local aDataList = {}
+    local tDataNames = {}
+    for iIdx = 0, tUsipConfigDict["num_of_chunks"] -1 do
+        local tChunkContent = tUsipConfigDict['content'][iIdx]
+        local astrParts = self.get_usip_image_parts(tUsipConfigDict, tChunkContent)
 
-        table.insert(aDataList, strUsipData)
+        table.insert(aDataList, table.concat(astrParts))
         table.insert(tDataNames, "single_usip_".. iIdx)
     end
     return aDataList, tDataNames
@@ -735,6 +745,73 @@ function UsipGenerator:cmd_gen_uniform_data(strComSipTemplatePath, strAppSipTemp
 end
 
 
+-- Generate the USIP images and optionally the SIP pages for a list of
+-- devices. See usip_template.lua for the fields and the device list.
+function UsipGenerator:cmd_gen_batch(strUsipFilePath, strDevicesFilePath, astrFields, strOutputDir, strPrefix,
+                                     strComSipTemplatePath, strAppSipTemplatePath, fSetSipProtectionCookie)
+    local tLog = self.tLog
+    local UsipTemplate = require 'usip_template'
+    local utils = require 'pl.utils'
+
+    local atFields = {}
+    for _, strField in ipairs(astrFields) do
+        local tField, strFieldError = UsipTemplate.parse_field(strField)
+        if tField == nil then
+            tLog.error(strFieldError)
+            return false
+        end
+        table.insert(atFields, tField)
+    end
+
+    local strComSipTemplate
+    local strAppSipTemplate
+    if strComSipTemplatePath ~= nil and strAppSipTemplatePath ~= nil then
+        local strReadError
+        strComSipTemplate, strReadError = utils.readfile(strComSipTemplatePath, true)
+        if strComSipTemplate ~= nil then
+            strAppSipTemplate, strReadError = utils.readfile(strAppSipTemplatePath, true)
+        end
+        if strComSipTemplate == nil or strAppSipTemplate == nil then
+            tLog.error('Failed to read the SIP templates: %s', strReadError)
+            return false
+        end
+    end
+
+    local strDevices, strDevicesReadError = utils.readfile(strDevicesFilePath)
+    if strDevices == nil then
+        tLog.error('Failed to read the device list from "%s": %s', strDevicesFilePath, strDevicesReadError)
+        return false
+    end
+    local atDevices, strDevicesError = UsipTemplate.parse_devices(strDevices)
+    if atDevices == nil then
+        tLog.error('Failed to parse the device list "%s": %s', strDevicesFilePath, strDevicesError)
+        return false
+    end
+
+    local tResult, strErrorMsg, tUsipConfigDict = self:analyze_usip(strUsipFilePath)
+    if tResult ~= true then
+        tLog.error('Failed to analyze the USIP data from "%s": %s', strUsipFilePath, strErrorMsg)
+        return false
+    end
+
+    local tTemplate = UsipTemplate(tLog)
+    tResult, strErrorMsg = tTemplate:prepare(
+        tUsipConfigDict,
+        atFields,
+        strComSipTemplate,
+        strAppSipTemplate,
+        fSetSipProtectionCookie
+    )
+    if tResult == true then
+        tResult, strErrorMsg = tTemplate:generate_batch(atDevices, strOutputDir, strPrefix)
+    end
+    if tResult ~= true then
+        tLog.error('Failed to generate the device data: %s', strErrorMsg)
+    end
+    return tResult
+end
+
+
 local function main()
     -- Get the path to this source file.
     local strThisModulePath = debug.getinfo(1, "S").source:sub(2)
@@ -806,6 +883,56 @@ local function main()
                         :default('debug')
                         :target('strLogLevel')
 
+    local tParserCommandBatch = tParser:command('batch b', 'Generate the USIP images for a list of devices.')
+                                       :target('fCommandBatchSelected')
+    tParserCommandBatch:argument('usip_input')
+                       :argname('<USIP_FILE>')
+                       :description("Use the contents of USIP_FILE as the template.")
+                       :target('strUsipFilePath')
+    tParserCommandBatch:argument('devices')
+                       :argname('<DEVICES_FILE>')
+                       :description(
+                           'Read the devices from DEVICES_FILE. Each line has the name of a device followed by ' ..
+                           'NAME=HEX values for the fields.'
+                       )
+                       :target('strDevicesFilePath')
+    tParserCommandBatch:argument('output_dir')
+                       :argname('<OUTPUT_DIR>')
+                       :description('Write the generated files to OUTPUT_DIR.')
+                       :target('strOutputDir')
+    tParserCommandBatch:option('--field')
+                       :argname('<NAME:PAGE:OFFSET:SIZE>')
+                       :description(
+                           'Define a field which is different for each device. PAGE is "com" or "app", ' ..
+                           'OFFSET is the offset in the secure info page.'
+                       )
+                       :count('*')
+                       :target('astrFields')
+    tParserCommandBatch:option('--prefix')
+                       :description('Start the names of the generated files with PREFIX.')
+                       :default('')
+                       :target('strPrefix')
+    tParserCommandBatch:option('--com_sip_template')
+                       :argname('<COM_TEMPLATE_FILE>')
+                       :description("Also generate the SIP pages with the default COM SIP contents from COM_TEMPLATE_FILE.")
+                       :target('strComSipTemplatePath')
+    tParserCommandBatch:option('--app_sip_template')
+                       :argname('<APP_TEMPLATE_FILE>')
+                       :description("Also generate the SIP pages with the default APP SIP contents from APP_TEMPLATE_FILE.")
+                       :target('strAppSipTemplatePath')
+    tParserCommandBatch:flag('--set_sip_protection')
+                       :description('Set the SIP protection cookie in the generated COM SIP pages.')
+                       :target('fSetSipProtectionCookie')
+                       :default(false)
+    tParserCommandBatch:option('-V --verbose')
+                       :description(string.format(
+                           'Set the verbosity level to LEVEL. Possible values for LEVEL are %s.',
+                           table.concat(atLogLevels, ', ')
+                       ))
+                       :argname('<LEVEL>')
+                       :default('info')
+                       :target('strLogLevel')
+
     local tArgs = tParser:parse()
 
     local tLogWriterConsole = require 'log.writer.console'.new()
@@ -832,6 +959,29 @@ local function main()
             tArgs.strAppOutputFile,
             tArgs.fSetSipProtectionCookie
         )
+
+    elseif tArgs.fCommandBatchSelected then
+        -- The SIP pages are only generated if at least one template is given.
+        local strComSipTemplatePath = tArgs.strComSipTemplatePath
+        local strAppSipTemplatePath = tArgs.strAppSipTemplatePath
+        if strComSipTemplatePath ~= nil or strAppSipTemplatePath ~= nil then
+            strComSipTemplatePath = strComSipTemplatePath or NETX90_DEFAULT_COM_SIP_BIN
+            strAppSipTemplatePath = strAppSipTemplatePath or NETX90_DEFAULT_APP_SIP_BIN
+        end
+        local usip_gen = UsipGenerator(tLog)
+        local tResult = usip_gen:cmd_gen_batch(
+            tArgs.strUsipFilePath,
+            tArgs.strDevicesFilePath,
+            tArgs.astrFields,
+            tArgs.strOutputDir,
+            tArgs.strPrefix,
+            strComSipTemplatePath,
+            strAppSipTemplatePath,
+            tArgs.fSetSipProtectionCookie
+        )
+        if tResult ~= true then
+            os.exit(1)
+        end
     end
 end
 
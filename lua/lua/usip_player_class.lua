@@ -1086,15 +1086,8 @@ function UsipPlayer:loadUsip(strUsipData, strPluginType)
         self.tPlugin:Disconnect()
         self.tFlasherHelper.sleep_s(3)
         -- get the jtag plugin with the attach option to not reset the netX
-
-        while ulRetries > 0 do
-            self.tPlugin = self.tFlasherHelper.getPlugin(self.strPluginName, self.strPluginType, self.atPluginOptions)
-            ulRetries = ulRetries-1
-            if self.tPlugin ~= nil then
-                break
-            end
-            self.tFlasherHelper.sleep_s(1)  -- todo use the same sleep everywhere
-        end
+        local tConnectionManager = self.tFlasherHelper.ConnectionManager({ ulAttempts = ulRetries })
+        self.tPlugin = tConnectionManager:getPlugin(self.strPluginName, self.strPluginType, self.atPluginOptions)
     end
 
     if self.tPlugin == nil then
@@ -1141,8 +1134,6 @@ function UsipPlayer:readSip(strReadSipPath, atPluginOptions, strExecReturnPath,
     local strAppSipData
     local aStrUUIDs = {}
 
-    local uLRetries = 5
-
     local strReadSipData = self.tFlasherHelper.loadBin(strReadSipPath)
 
     local fOk
@@ -1218,25 +1209,13 @@ function UsipPlayer:readSip(strReadSipPath, atPluginOptions, strExecReturnPath,
             -- can there be timing issues with different OS
             self.tPlugin:Disconnect()
             -- wait at least 2 sec for signature verification of read sip binary
-            self.tFlasherHelper.sleep_s(3)
-
-            while uLRetries > 0 do
-                self.tLog.info("try to get the Plugin again after read sip reset")
-                local fCallSuccess
-                fCallSuccess, self.tPlugin = pcall(
-                    self.tFlasherHelper.getPlugin, self.strPluginName, self.strPluginType, atPluginOptions)
-                if fCallSuccess then
-                    break
-                end
-                uLRetries = uLRetries - 1
-                self.tFlasherHelper.sleep_s(1)
-            end
-
-            if self.tPlugin then
-                self.tFlasherHelper.connect_retry(self.tPlugin, 10)
+            self.tLog.info("try to get the Plugin again after read sip reset")
+            local tConnectionManager = self.tFlasherHelper.ConnectionManager({ ulAttempts = 10 })
+            self.tPlugin, strMsg = tConnectionManager:reconnect(
+                self.strPluginName, self.strPluginType, atPluginOptions, 3)
 
-            else
-                strErrorMsg = "Could not reach plugin after reset"
+            if self.tPlugin == nil then
+                strErrorMsg = string.format("Could not reach plugin after reset: %s", strMsg)
                 fResult = false
             end
 
@@ -1259,6 +1238,16 @@ function UsipPlayer:readSip(strReadSipPath, atPluginOptions, strExecReturnPath,
             if fResult then
 
                 ulReadSipResult = self.tPlugin:read_data32(ulReadSipResultAddress)
+                if ulReadSipResult ~= 0xFFFFFFFF and (ulReadSipResult & UID_CPY_MSK) ~= 0 then
+                    aStrUUIDs[1] = self.tFlasherHelper.switch_endian(self.tPlugin:read_data32(ulReadUUIDAddress))
+                    aStrUUIDs[2] = self.tFlasherHelper.switch_endian(self.tPlugin:read_data32(ulReadUUIDAddress + 4))
+                    aStrUUIDs[3] = self.tFlasherHelper.switch_endian(self.tPlugin:read_data32(ulReadUUIDAddress + 8))
+                    -- The signature cache needs the unique ID to identify the chip.
+                    require 'helper_signature_cache'.setChipUid(
+                        string.format("%08x%08x%08x", aStrUUIDs[1], aStrUUIDs[2], aStrUUIDs[3]),
+                        self.tPlugin:GetName()
+                    )
+                end
                 if not fGetUidOnly then
                     if ulReadSipResult == 0xFFFFFFFF then
                             strErrorMsg = "Could not get proper result"
@@ -1277,11 +1266,7 @@ function UsipPlayer:readSip(strReadSipPath, atPluginOptions, strExecReturnPath,
                         fResult = false
                     end
                 else
-                    if ulReadSipResult & UID_CPY_MSK ~= 0 then
-                        aStrUUIDs[1] = self.tFlasherHelper.switch_endian(self.tPlugin:read_data32(ulReadUUIDAddress))
-                        aStrUUIDs[2] = self.tFlasherHelper.switch_endian(self.tPlugin:read_data32(ulReadUUIDAddress + 4))
-                        aStrUUIDs[3] = self.tFlasherHelper.switch_endian(self.tPlugin:read_data32(ulReadUUIDAddress + 8))
-                    else
+                    if aStrUUIDs[1] == nil then
                         strErrorMsg = "Could not receive uuid"
                         fResult = false
                     end
@@ -1456,19 +1441,14 @@ function UsipPlayer:kekProcess(strCombinedImageData)
     self.tLog.debug("Finished call, disconnecting")
     self.tPlugin:Disconnect()
     self.tLog.debug("Wait 3 seconds to be sure the set_kek process is finished")
-    self.tFlasherHelper.sleep_s(3)
-    -- todo check results of connect and getPlugin before continuing
     -- get the uart plugin again
-    self.tPlugin = self.tFlasherHelper.getPlugin(self.strPluginName, self.strPluginType, self.atPluginOptions)
-    if self.tPlugin then
-        local strError
-        fOk, strError = self.tFlasherHelper.connect_retry(self.tPlugin, 5)
-        if fOk == false then
-            self.tLog.error(strError)
-        end
-    else
-        self.tLog.error("Failed to get plugin after set KEK")
-        fOk = false
+    local tConnectionManager = self.tFlasherHelper.ConnectionManager({ ulAttempts = 5 })
+    local strError
+    self.tPlugin, strError = tConnectionManager:reconnect(
+        self.strPluginName, self.strPluginType, self.atPluginOptions, 3)
+    if self.tPlugin == nil then
+        self.tLog.error("Failed to get plugin after set KEK: %s", strError)
+        return false
     end
 
     local ulHbootResult = self.tPlugin:read_data32(ulHbootResultAddress)
@@ -1598,12 +1578,13 @@ function UsipPlayer:usip(
 
     if tResult and not fVerifyContentDisabled and not fDisableReset then
         -- just validate the content if the validation is enabled and no error occued during the loading process
+        local tConnectionManager = self.tFlasherHelper.ConnectionManager({ ulAttempts = 5 })
         if self.strPluginType ~= 'romloader_jtag' then
-            self.tPlugin = self.tFlasherHelper.getPlugin(self.strPluginName, self.strPluginType, self.atResetPluginOptions)
+            self.tPlugin = tConnectionManager:getPlugin(self.strPluginName, self.strPluginType, self.atResetPluginOptions)
         end
 
         if self.tPlugin then
-            tResult, strErrorMsg = self.tFlasherHelper.connect_retry(self.tPlugin, 5)
+            tResult, strErrorMsg = tConnectionManager:connect(self.tPlugin)
             if tResult == false then
                 self.tLog.error(strErrorMsg)
             end
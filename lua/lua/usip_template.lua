@@ -0,0 +1,432 @@
+-- Per-device USIP images and SIP pages from one template.
+--
+-- Serial numbers, MAC addresses and similar values are different for each
+-- device, everything else in the USIP is the same. The template is built
+-- once from a USIP which was parsed with UsipGenerator:analyze_usip. It
+-- keeps the single USIP images of gen_multi_usip and optionally the COM and
+-- APP SIP pages of gen_uniform_data together with an offset map of the
+-- fields.
+--
+-- A field is an area of a SIP page which is written by the data entries of
+-- the USIP. It has the fields strName, ulPage (1 for the COM SIP, 2 for the
+-- APP SIP), ulOffset in the page and ulSize. Each data entry which writes
+-- the area becomes one slot in the USIP images.
+--
+-- For a device only the slots are replaced. The images are kept as lists of
+-- parts, so the constant data is not copied again before the final concat.
+-- The hash state is saved at the first slot, so only the data from there
+-- to the end of the hashed area is hashed for each device.
+-- The chunk hash of a USIP image covers the same area as the one of
+-- Sipper:analyze_hboot_image. The SIP pages get the SHA384 of
+-- UsipGenerator.updateSipHash.
+
+local class = require 'pl.class'
+local mhash = require 'mhash'
+local tFlasherHelper = require 'flasher_helper'
+local UsipGenerator = require 'usip_generator'
+
+local SIP_PAGE_SIZE = 0x1000
+-- The SHA384 of a SIP page is at this offset.
+local SIP_HASH_OFFSET = 0x0fd0
+
+local atPageNames = {
+    [1] = 'com',
+    [2] = 'app'
+}
+
+
+-- An image with slots which are replaced for each device.
+local PatchedImage = class()
+
+
+-- Split strData into parts at the borders of the slots and of the hashed
+-- area. Each slot has the fields strField, ulPos (starting at 0) and
+-- ulSize. The slots must not overlap. ulHashSize is nil for no hash.
+function PatchedImage:_init(strData, atSlots, ulHashOffset, ulHashSize)
+    local sizData = string.len(strData)
+    local atBorders = { [0] = true, [sizData] = true }
+    local ulHashEnd = nil
+    if ulHashSize ~= nil then
+        ulHashOffset = math.min(ulHashOffset, sizData)
+        ulHashEnd = math.min(ulHashOffset + ulHashSize, sizData)
+        atBorders[ulHashOffset] = true
+        atBorders[ulHashEnd] = true
+    end
+    for _, tSlot in ipairs(atSlots) do
+        atBorders[tSlot.ulPos] = true
+        atBorders[tSlot.ulPos + tSlot.ulSize] = true
+    end
+    local aulBorders = {}
+    for ulBorder in pairs(atBorders) do
+        table.insert(aulBorders, ulBorder)
+    end
+    table.sort(aulBorders)
+
+    local astrParts = {}
+    local atPartAtPos = {}
+    for iIdx = 1, #aulBorders - 1 do
+        table.insert(astrParts, string.sub(strData, aulBorders[iIdx] + 1, aulBorders[iIdx + 1]))
+        atPartAtPos[aulBorders[iIdx]] = iIdx
+    end
+    -- This is the index after the last part.
+    atPartAtPos[sizData] = #astrParts + 1
+
+    for _, tSlot in ipairs(atSlots) do
+        tSlot.iPart = atPartAtPos[tSlot.ulPos]
+    end
+    self.astrParts = astrParts
+    self.atSlots = atSlots
+
+    -- Hash everything up to the first slot in the hashed area now.
+    self.tHashPrefix = nil
+    self.strHash = nil
+    if ulHashEnd ~= nil then
+        local iHashFirst = atPartAtPos[ulHashOffset]
+        local iHashEnd = atPartAtPos[ulHashEnd]
+        local iSlotFirst = iHashEnd
+        for _, tSlot in ipairs(atSlots) do
+            if tSlot.iPart >= iHashFirst and tSlot.iPart < iSlotFirst then
+                iSlotFirst = tSlot.iPart
+            end
+        end
+
+        local tHash = mhash.mhash_state()
+        tHash:init(mhash.MHASH_SHA384)
+        for iIdx = iHashFirst, iSlotFirst - 1 do
+            tHash:hash(astrParts[iIdx])
+        end
+        if iSlotFirst == iHashEnd then
+            -- No slot is hashed, the hash is the same for all devices.
+            self.strHash = tHash:hash_end()
+        else
+            self.tHashPrefix = tHash
+            self.iHashFrom = iSlotFirst
+            self.iHashEnd = iHashEnd
+        end
+    end
+end
+
+
+-- strData, strHash render(atValues)
+-- Put the values in the slots. atValues maps the field names to the values,
+-- the values must have the size of the fields.
+function PatchedImage:render(atValues)
+    local astrParts = self.astrParts
+    for _, tSlot in ipairs(self.atSlots) do
+        astrParts[tSlot.iPart] = atValues[tSlot.strField]
+    end
+
+    local strHash = self.strHash
+    if self.tHashPrefix ~= nil then
+        -- Continue on a copy of the saved state.
+        local tHash = mhash.mhash_state(self.tHashPrefix)
+        for iIdx = self.iHashFrom, self.iHashEnd - 1 do
+            tHash:hash(astrParts[iIdx])
+        end
+        strHash = tHash:hash_end()
+    end
+
+    return table.concat(astrParts), strHash
+end
+
+
+local UsipTemplate = class()
+
+
+function UsipTemplate:_init(tLog)
+    self.tLog = tLog
+    self.atFields = nil
+    self.atImages = nil
+    self.atSipPages = nil
+end
+
+
+-- Get the size of the area which is covered by the chunk hash. This must
+-- match Sipper:analyze_hboot_image.
+local function get_chunk_hash_size(tChunkContent)
+    local ulHashSize = 12
+    if tChunkContent['key_idx_int'] ~= 255 then
+        local ulContentSize = tFlasherHelper.bytes_to_uint32(tChunkContent['patched_size'])
+        ulHashSize = ulHashSize + 56 + 520 + ulContentSize + (ulContentSize % 4)
+    end
+    return ulHashSize
+end
+
+
+function UsipTemplate:__check_fields(atFields)
+    local strErrorMsg = nil
+    local atNames = {}
+    for _, tField in ipairs(atFields) do
+        if atPageNames[tField.ulPage] == nil then
+            strErrorMsg = string.format('The field "%s" has an unknown SIP page: %s', tField.strName, tostring(tField.ulPage))
+        elseif tField.ulSize < 1 or tField.ulOffset + tField.ulSize > SIP_HASH_OFFSET then
+            strErrorMsg = string.format('The field "%s" is not inside the data area of the SIP page.', tField.strName)
+        elseif atNames[tField.strName] ~= nil then
+            strErrorMsg = string.format('The field "%s" is defined twice.', tField.strName)
+        else
+            for _, tOther in pairs(atNames) do
+                if tOther.ulPage == tField.ulPage and
+                   tField.ulOffset < tOther.ulOffset + tOther.ulSize and
+                   tOther.ulOffset < tField.ulOffset + tField.ulSize then
+                    strErrorMsg = string.format('The fields "%s" and "%s" overlap.', tOther.strName, tField.strName)
+                    break
+                end
+            end
+        end
+        if strErrorMsg ~= nil then
+            break
+        end
+        atNames[tField.strName] = tField
+    end
+    return strErrorMsg == nil, strErrorMsg
+end
+
+
+-- tResult, strErrorMsg prepare(tUsipConfigDict, atFields, strComSipTemplate, strAppSipTemplate, fSetSipProtectionCookie)
+-- Build the template from an analyzed USIP. The SIP templates are optional,
+-- without them only the USIP images are generated.
+function UsipTemplate:prepare(tUsipConfigDict, atFields, strComSipTemplate, strAppSipTemplate, fSetSipProtectionCookie)
+    local tResult, strErrorMsg = self:__check_fields(atFields)
+    if tResult ~= true then
+        return false, strErrorMsg
+    end
+
+    local atCovered = {}
+    local atImages = {}
+    for iIdx = 0, tUsipConfigDict["num_of_chunks"] - 1 do
+        local tChunkContent = tUsipConfigDict['content'][iIdx]
+        local ulPage = tChunkContent['page_type_int']
+        local astrParts, iChunkPart, atDataParts = UsipGenerator.get_usip_image_parts(tUsipConfigDict, tChunkContent)
+
+        -- Get the position of each part in the image.
+        local aulPartPos = {}
+        local ulPos = 0
+        for iPart, strPart in ipairs(astrParts) do
+            aulPartPos[iPart] = ulPos
+            ulPos = ulPos + string.len(strPart)
+        end
+
+        local atSlots = {}
+        for iDataIdx = 0, tChunkContent['ulDataCount'] do
+            local tData = tChunkContent['data'][iDataIdx]
+            local ulDataStart = tData['offset_int']
+            local ulDataEnd = ulDataStart + string.len(tData['patched_data'])
+            for _, tField in ipairs(atFields) do
+                local ulFieldEnd = tField.ulOffset + tField.ulSize
+                if tField.ulPage == ulPage and tField.ulOffset < ulDataEnd and ulDataStart < ulFieldEnd then
+                    if tField.ulOffset < ulDataStart or ulFieldEnd > ulDataEnd then
+                        return false, string.format(
+                            'The field "%s" is only partly written by the data entry at offset 0x%04x of USIP chunk %d.',
+                            tField.strName,
+                            ulDataStart,
+                            iIdx
+                        )
+                    end
+                    table.insert(atSlots, {
+                        strField = tField.strName,
+                        ulPos = aulPartPos[atDataParts[iDataIdx]] + tField.ulOffset - ulDataStart,
+                        ulSize = tField.ulSize
+                    })
+                    atCovered[tField.strName] = true
+                end
+            end
+        end
+
+        atImages[iIdx + 1] = PatchedImage(
+            table.concat(astrParts),
+            atSlots,
+            aulPartPos[iChunkPart],
+            get_chunk_hash_size(tChunkContent)
+        )
+    end
+
+    for _, tField in ipairs(atFields) do
+        if atCovered[tField.strName] ~= true then
+            return false, string.format('The USIP does not write the field "%s".', tField.strName)
+        end
+    end
+
+    local atSipPages = nil
+    if strComSipTemplate ~= nil and strAppSipTemplate ~= nil then
+        if string.len(strComSipTemplate) ~= SIP_PAGE_SIZE or string.len(strAppSipTemplate) ~= SIP_PAGE_SIZE then
+            return false, string.format('The SIP templates must have %d bytes.', SIP_PAGE_SIZE)
+        end
+
+        -- This is the same as gen_uniform_data without the hashes.
+        local strComSipData = strComSipTemplate
+        if fSetSipProtectionCookie then
+            strComSipData = UsipGenerator(self.tLog):setSipProtectionCookie(strComSipData)
+        end
+        local astrPages = {}
+        astrPages[1], astrPages[2] = UsipGenerator.apply_usip_data(strComSipData, strAppSipTemplate, tUsipConfigDict)
+
+        atSipPages = {}
+        for ulPage, strPage in ipairs(astrPages) do
+            local atSlots = {}
+            for _, tField in ipairs(atFields) do
+                if tField.ulPage == ulPage then
+                    table.insert(atSlots, { strField = tField.strName, ulPos = tField.ulOffset, ulSize = tField.ulSize })
+                end
+            end
+            atSipPages[ulPage] = PatchedImage(string.sub(strPage, 1, SIP_HASH_OFFSET), atSlots, 0, SIP_HASH_OFFSET)
+        end
+    end
+
+    self.atFields = atFields
+    self.atImages = atImages
+    self.atSipPages = atSipPages
+    self.tLog.debug(
+        'Prepared the USIP template with %d images and %d fields.',
+        #atImages,
+        #atFields
+    )
+
+    return true
+end
+
+
+-- tResult, strErrorMsg, aDataList, astrChunkHashes, strComSipData, strAppSipData generate(atValues)
+-- Generate the USIP images for one device. atValues maps the field names to
+-- the values. The images are in the same order as the ones of
+-- gen_multi_usip. The SIP pages are only returned if the template has them.
+function UsipTemplate:generate(atValues)
+    if self.atImages == nil then
+        return false, 'The template is not prepared.'
+    end
+
+    for _, tField in ipairs(self.atFields) do
+        local strValue = atValues[tField.strName]
+        if strValue == nil then
+            return false, string.format('No value for the field "%s".', tField.strName)
+        elseif string.len(strValue) ~= tField.ulSize then
+            return false, string.format(
+                'The value for the field "%s" has %d bytes, but the field has %d.',
+                tField.strName,
+                string.len(strValue),
+                tField.ulSize
+            )
+        end
+    end
+
+    local aDataList = {}
+    local astrChunkHashes = {}
+    for iIdx, tImage in ipairs(self.atImages) do
+        aDataList[iIdx], astrChunkHashes[iIdx] = tImage:render(atValues)
+    end
+
+    local strComSipData
+    local strAppSipData
+    if self.atSipPages ~= nil then
+        local strData, strHash = self.atSipPages[1]:render(atValues)
+        strComSipData = strData .. strHash
+        strData, strHash = self.atSipPages[2]:render(atValues)
+        strAppSipData = strData .. strHash
+    end
+
+    return true, nil, aDataList, astrChunkHashes, strComSipData, strAppSipData
+end
+
+
+local function write_file(strPath, strData)
+    local tFile, strError = io.open(strPath, 'wb')
+    if tFile == nil then
+        return false, strError
+    end
+    tFile:write(strData)
+    tFile:close()
+    return true
+end
+
+
+-- tResult, strErrorMsg, aOutputList generate_batch(atDevices, strOutputDir, strPrefix)
+-- Generate the files for a list of devices. Each device has the fields
+-- strName and atValues. The USIP images are written to
+-- "<prefix><name>_single_usip_<n>.usp" like gen_multi_usip_hboot does. If
+-- the template has SIP pages, they are written to "<prefix><name>_com_sip.bin"
+-- and "<prefix><name>_app_sip.bin". The batch stops at the first error.
+function UsipTemplate:generate_batch(atDevices, strOutputDir, strPrefix)
+    local path = require 'pl.path'
+    if not path.exists(strOutputDir) then
+        path.mkdir(strOutputDir)
+    end
+    strPrefix = strPrefix or ""
+
+    local aOutputList = {}
+    for _, tDevice in ipairs(atDevices) do
+        local tResult, strErrorMsg, aDataList, _, strComSipData, strAppSipData = self:generate(tDevice.atValues)
+        if tResult ~= true then
+            return false, string.format('Device "%s": %s', tDevice.strName, strErrorMsg), aOutputList
+        end
+
+        local atFiles = {}
+        for iIdx, strData in ipairs(aDataList) do
+            table.insert(atFiles, { string.format("%s%s_single_usip_%d.usp", strPrefix, tDevice.strName, iIdx - 1), strData })
+        end
+        if strComSipData ~= nil then
+            table.insert(atFiles, { string.format("%s%s_%s_sip.bin", strPrefix, tDevice.strName, atPageNames[1]), strComSipData })
+            table.insert(atFiles, { string.format("%s%s_%s_sip.bin", strPrefix, tDevice.strName, atPageNames[2]), strAppSipData })
+        end
+        for _, tFile in ipairs(atFiles) do
+            local strOutputFilePath = path.join(strOutputDir, tFile[1])
+            tResult, strErrorMsg = write_file(strOutputFilePath, tFile[2])
+            if tResult ~= true then
+                return false, string.format('Failed to write "%s": %s', strOutputFilePath, strErrorMsg), aOutputList
+            end
+            table.insert(aOutputList, strOutputFilePath)
+        end
+    end
+
+    self.tLog.info('Generated %d files for %d devices.', #aOutputList, #atDevices)
+    return true, nil, aOutputList
+end
+
+
+-- atField, strErrorMsg parse_field(strField)
+-- Parse a field definition "NAME:PAGE:OFFSET:SIZE". PAGE is "com" or "app".
+function UsipTemplate.parse_field(strField)
+    local strName, strPage, strOffset, strSize = string.match(strField, '^([%w_%-]+):(%a+):(%w+):(%w+)$')
+    local ulPage = nil
+    for ulIdx, strPageName in pairs(atPageNames) do
+        if strPage ~= nil and string.lower(strPage) == strPageName then
+            ulPage = ulIdx
+        end
+    end
+    local ulOffset = tonumber(strOffset)
+    local ulSize = tonumber(strSize)
+    if strName == nil or ulPage == nil or ulOffset == nil or ulSize == nil then
+        return nil, string.format('Invalid field "%s", expected NAME:com|app:OFFSET:SIZE.', strField)
+    end
+    return { strName = strName, ulPage = ulPage, ulOffset = ulOffset, ulSize = ulSize }
+end
+
+
+-- atDevices, strErrorMsg parse_devices(strDevices)
+-- Parse a device list. Each line has the name of the device followed by
+-- NAME=HEX pairs for the fields. Empty lines and lines starting with "#"
+-- are ignored.
+function UsipTemplate.parse_devices(strDevices)
+    local atDevices = {}
+    local ulLine = 0
+    for strRawLine in string.gmatch(strDevices .. '\n', '([^\n]*)\n') do
+        ulLine = ulLine + 1
+        local strLine = string.match(strRawLine, '^%s*(.-)%s*$')
+        if strLine ~= '' and string.sub(strLine, 1, 1) ~= '#' then
+            local strName = string.match(strLine, '^(%S+)')
+            local tDevice = { strName = strName, atValues = {} }
+            for strAssignment in string.gmatch(string.sub(strLine, string.len(strName) + 1), '%S+') do
+                local strField, strHex = string.match(strAssignment, '^([%w_%-]+)=(%x+)$')
+                if strField == nil or (string.len(strHex) % 2) ~= 0 then
+                    return nil, string.format('Line %d: invalid value "%s", expected NAME=HEX.', ulLine, strAssignment)
+                end
+                tDevice.atValues[strField] = string.gsub(strHex, '%x%x', function(strByte)
+                    return string.char(tonumber(strByte, 16))
+                end)
+            end
+            table.insert(atDevices, tDevice)
+        end
+    end
+    return atDevices
+end
+
+
+return UsipTemplate
@@ -7,6 +7,7 @@ local tLog = require 'log'.new('trace', tLogWriter, require 'log.formatter.forma
 local sipper = require 'sipper'
 local tSipper = sipper(tLog)
 local path = require 'pl.path'
+local tSignatureCache = require 'helper_signature_cache'
 
 
 -- fOk, atResults verifySignature(tPlugin, strPluginType, astrPathList, strTempPath, strSipperExePath, strVerifySigPath)
@@ -53,15 +54,25 @@ function M.verifySignature(tPlugin, strPluginType, tDatalist, tPathList, strTemp
         -- cut out the program data from the rest of the image
         -- this is the raw program data
         -- local strVerifySigData, strMsg = tFlasherHelper.loadBin(strVerifySigPath)
-        if ulM2MMajor == 3 and ulM2MMinor >= 1 then
-            -- use the whole hboot image
-            tFlasher.write_image(tPlugin, ulVerifySigHbootLoadAddress, strVerifySigData)
-        else
+        -- The verify_sig program is only downloaded if at least one helper
+        -- is not in the signature cache.
+        local fVerifySigDownloaded = false
+        local function downloadVerifySig()
+            if fVerifySigDownloaded ~= true then
+                if ulM2MMajor == 3 and ulM2MMinor >= 1 then
+                    -- use the whole hboot image
+                    tFlasher.write_image(tPlugin, ulVerifySigHbootLoadAddress, strVerifySigData)
+                else
 
-            strVerifySigData = string.sub(strVerifySigData, 1037)
-            tFlasher.write_image(tPlugin, ulVerifySigDataLoadAddress, strVerifySigData)
+                    strVerifySigData = string.sub(strVerifySigData, 1037)
+                    tFlasher.write_image(tPlugin, ulVerifySigDataLoadAddress, strVerifySigData)
+                end
+                fVerifySigDownloaded = true
+            end
         end
 
+        local fCacheMsgShown = false
+
         -- iterate over the path list to check the signature of every usip file
         for idx, strFileData in ipairs(tDatalist) do
             local tResult = {
@@ -73,90 +84,104 @@ function M.verifySignature(tPlugin, strPluginType, tDatalist, tPathList, strTemp
                 }
 
             if strFileData ~= "" then
-                local strDataBlockTmpPath = nil
+                local strCacheKey, strCacheMsg = tSignatureCache.getKey(tPlugin, strFileData, tPathList[idx])
+                if strCacheKey == nil and tSignatureCache.isEnabled() and fCacheMsgShown ~= true then
+                    tLog.info("The signature cache is not used: %s", strCacheMsg)
+                    fCacheMsgShown = true
+                end
+                if tSignatureCache.lookup(strCacheKey) then
+                    tLog.info("The signature of file %s was already verified on this chip.", tPathList[idx])
+                    tResult.ok = true
+                    tResult.message = "Signature check result from the cache."
+                else
+                    downloadVerifySig()
 
+                    local strDataBlockTmpPath = nil
 
-                if tFlasherHelper.getStoreTempFiles() then
-                    -- only if fStoreTempFiles is enabled set a path to store the data_block binary in the temp folder
-                    strDataBlockTmpPath = path.join(strTempPath, string.format("data_block_%s.bin", idx))
-                end
 
-                -- generate data block
-                local strDataBlock, tGenDataBlockResult, strErrorMsg = tSipper:gen_data_block(
-                  strFileData,
-                  strDataBlockTmpPath
-                )
-                tResult.data_block = strDataBlock
-
-                -- check if the command executes without an error
-                if tGenDataBlockResult == true then
-                    -- execute verify signature binary
-
-                    tLog.debug("Clearing result areas ...")
-                    tPlugin:write_data32(ulVerifySigResultAddress, 0x00000000)
-                    tPlugin:write_data32(ulVerifySigDebugAddress, 0x00000000)
-
-                    -- todo: why is the plugin type checked inside the loop?
-                    if (
-                      strPluginType == 'romloader_jtag' or
-                      strPluginType == 'romloader_uart' or
-                      strPluginType == 'romloader_eth'
-                    ) then
-                        tLog.info("Write data block into intram at offset 0x%08x", ulDataBlockLoadAddress)
-                        tFlasher.write_image(tPlugin, ulDataBlockLoadAddress, strDataBlock)
-                        -- tFlasherHelper.dump_intram(
-                        --  tPlugin,
-                        --  0x000220b0,
-                        --  0x400,
-                        --  strTempPath,
-                        --  "dump_data_block_before.bin"
-                        -- )
-                        tLog.info("Start signature verification ...")
-                        if ulM2MMajor == 3 and ulM2MMinor >= 1 then
-                            tFlasher.call_hboot(tPlugin)
-                        else
-                            tPlugin:call(
-                                ulVerifySigDataLoadAddress + 1,
-                                ulDataBlockLoadAddress,
-                                tFlasher.default_callback_message,
-                                2
-                            )
-                        end
-                        -- tFlasherHelper.dump_intram(
-                        --   tPlugin,
-                        --   0x000220b0,
-                        --   0x400,
-                        --   strTempPath,
-                        --   "dump_data_block_after.bin"
-                        -- )
-
-                        ulVerifySigResult = tPlugin:read_data32(ulVerifySigResultAddress)
-                        ulVerifySigDebug = tPlugin:read_data32(ulVerifySigDebugAddress)
-                        tLog.debug( "ulVerifySigDebug: 0x%08x ", ulVerifySigDebug )
-                        tLog.debug( "ulVerifySigResult: 0x%08x", ulVerifySigResult )
-                        -- if the verify sig program runs without errors the result
-                        -- register has a value of 0x00000701
-                        if ulVerifySigResult == 0x701 then
-                             tLog.info( "Successfully verified the signature of file: %s", tPathList[idx])
-                            tResult.ok = true
+                    if tFlasherHelper.getStoreTempFiles() then
+                        -- only if fStoreTempFiles is enabled set a path to store the data_block binary in the temp folder
+                        strDataBlockTmpPath = path.join(strTempPath, string.format("data_block_%s.bin", idx))
+                    end
+
+                    -- generate data block
+                    local strDataBlock, tGenDataBlockResult, strErrorMsg = tSipper:gen_data_block(
+                      strFileData,
+                      strDataBlockTmpPath
+                    )
+                    tResult.data_block = strDataBlock
+
+                    -- check if the command executes without an error
+                    if tGenDataBlockResult == true then
+                        -- execute verify signature binary
+
+                        tLog.debug("Clearing result areas ...")
+                        tPlugin:write_data32(ulVerifySigResultAddress, 0x00000000)
+                        tPlugin:write_data32(ulVerifySigDebugAddress, 0x00000000)
+
+                        -- todo: why is the plugin type checked inside the loop?
+                        if (
+                          strPluginType == 'romloader_jtag' or
+                          strPluginType == 'romloader_uart' or
+                          strPluginType == 'romloader_eth'
+                        ) then
+                            tLog.info("Write data block into intram at offset 0x%08x", ulDataBlockLoadAddress)
+                            tFlasher.write_image(tPlugin, ulDataBlockLoadAddress, strDataBlock)
+                            -- tFlasherHelper.dump_intram(
+                            --  tPlugin,
+                            --  0x000220b0,
+                            --  0x400,
+                            --  strTempPath,
+                            --  "dump_data_block_before.bin"
+                            -- )
+                            tLog.info("Start signature verification ...")
+                            if ulM2MMajor == 3 and ulM2MMinor >= 1 then
+                                tFlasher.call_hboot(tPlugin)
+                            else
+                                tPlugin:call(
+                                    ulVerifySigDataLoadAddress + 1,
+                                    ulDataBlockLoadAddress,
+                                    tFlasher.default_callback_message,
+                                    2
+                                )
+                            end
+                            -- tFlasherHelper.dump_intram(
+                            --   tPlugin,
+                            --   0x000220b0,
+                            --   0x400,
+                            --   strTempPath,
+                            --   "dump_data_block_after.bin"
+                            -- )
+
+                            ulVerifySigResult = tPlugin:read_data32(ulVerifySigResultAddress)
+                            ulVerifySigDebug = tPlugin:read_data32(ulVerifySigDebugAddress)
+                            tLog.debug( "ulVerifySigDebug: 0x%08x ", ulVerifySigDebug )
+                            tLog.debug( "ulVerifySigResult: 0x%08x", ulVerifySigResult )
+                            -- if the verify sig program runs without errors the result
+                            -- register has a value of 0x00000701
+                            if ulVerifySigResult == 0x701 then
+                                 tLog.info( "Successfully verified the signature of file: %s", tPathList[idx])
+                                tResult.ok = true
+                                tSignatureCache.store(strCacheKey)
+                            else
+                                fOk = false
+                                tLog.error( "Failed to verify the signature of file: %s", tPathList[idx])
+                                tResult.ok = false
+                                tResult.message = "Signature verification failed."
+                            end
+
                         else
+                            -- netX90 rev_1 and ethernet detected, this function is not supported
+                            tLog.error( "This Interface is not yet supported! -> %s", strPluginType )
                             fOk = false
-                            tLog.error( "Failed to verify the signature of file: %s", tPathList[idx])
-                            tResult.ok = false
-                            tResult.message = "Signature verification failed."
                         end
-
                     else
-                        -- netX90 rev_1 and ethernet detected, this function is not supported
-                        tLog.error( "This Interface is not yet supported! -> %s", strPluginType )
                         fOk = false
+                        tLog.error( strErrorMsg )
+                        -- tLog.error( "Failed to generate data_block for file: %s ", strSingleFilePath )
+                        tResult.ok = false
+                        tResult.message = strErrorMsg
                     end
-                else
-                    fOk = false
-                    tLog.error( strErrorMsg )
-                    -- tLog.error( "Failed to generate data_block for file: %s ", strSingleFilePath )
-                    tResult.ok = false
-                    tResult.message = strErrorMsg
                 end
             else
                 tResult.ok = false
@@ -168,6 +193,11 @@ function M.verifySignature(tPlugin, strPluginType, tDatalist, tPathList, strTemp
 
             table.insert(atResults, tResult)
         end
+
+        local fCacheOk, strCacheMsg = tSignatureCache.save()
+        if fCacheOk ~= true then
+            tLog.warning("Failed to write the signature cache: %s", tostring(strCacheMsg))
+        end
     else
         tLog.error(strMsg)
         tLog.error( "Could not load data from file: %s", strVerifySigPath )
@@ -219,7 +249,7 @@ function M.verifyHelperSignatures(strPluginName, strPluginType, atPluginOptions,
         local aStrHelperFileDirs = path.join(strSecureOption, "netx90")
 
 
-        tResult, strErrorMsg = pcall(tPlugin.Connect, tPlugin)
+        tResult, strErrorMsg = tFlasherHelper.connect(tPlugin, { ulAttempts = 1 })
         if not tResult then
             tLog.error("Failed to open connection: %s", strMsg or "Unknown error")
         else
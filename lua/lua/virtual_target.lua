@@ -0,0 +1,331 @@
+-- A plugin for a virtual netX.
+--
+-- The virtual netX is the flasher core built for the host (see
+-- src/host/host_target.c). It runs as a separate process with simulated SPI
+-- flashes. The process has RAM at the same addresses as a netX 90, so the
+-- netX 90 flasher binary and flasher.lua can be used without changes. Only
+-- the code is not executed, a call always runs the flasher core of the
+-- host.
+--
+-- The plugin is only offered if at least one flash is configured in the
+-- plugin options:
+--   romloader_virtual = {
+--       spi_flashes = { '0:0:W25Q32::flash.bin', '0:1:ef4016:0x400000' },
+--       executable = 'host/flasher_host'
+--   }
+-- Each SPI flash is "unit:chip_select:device[:size][:file]". The device is
+-- the name of a flash in spi_flash_types.xml or a JEDEC ID for a generic
+-- flash. A generic flash needs the size. With a file the contents of the
+-- flash are kept between the runs.
+--
+-- The flashes have the typical program and erase times of the device. The
+-- time runs on a simulated clock, get_statistics returns it together with
+-- the bus traffic.
+--
+-- The requests are sent to stdin of the process, the replies come back
+-- through a FIFO. This needs a POSIX system.
+
+local class = require 'pl.class'
+
+local M = {}
+
+M.PLUGIN_ID = 'romloader_virtual'
+M.DEFAULT_EXECUTABLE = 'host/flasher_host'
+
+local HEADER_FORMAT = '<c1I4I4'
+local HEADER_SIZE = string.packsize(HEADER_FORMAT)
+local STATISTICS_FORMAT = '<I8I8I4I4I4'
+
+
+local VirtualTarget = class()
+
+
+function VirtualTarget:_init(strName, atOptions)
+    self.strName = strName
+    self.strExecutable = atOptions.executable or M.DEFAULT_EXECUTABLE
+    self.astrSpiFlashes = atOptions.spi_flashes or {}
+    self.tRequests = nil
+    self.tReplies = nil
+    self.strFifo = nil
+    -- This is false if the process ended or is about to end. Writing to
+    -- the pipe would raise SIGPIPE then.
+    self.fRunning = false
+end
+
+
+function VirtualTarget:GetName()
+    return self.strName
+end
+
+
+function VirtualTarget:GetTyp()
+    return M.PLUGIN_ID
+end
+
+
+function VirtualTarget:GetChiptyp()
+    local romloader = require 'romloader'
+    return romloader.ROMLOADER_CHIPTYP_NETX90
+end
+
+
+function VirtualTarget:GetChiptypName()
+    return 'netX90 (virtual)'
+end
+
+
+function VirtualTarget:get_console_mode()
+    local romloader = require 'romloader'
+    return romloader.CONSOLE_MODE_Open
+end
+
+
+-- The virtual target has no machine interface with a version.
+function VirtualTarget:get_mi_version_maj()
+    return 0
+end
+
+
+function VirtualTarget:get_mi_version_min()
+    return 0
+end
+
+
+function VirtualTarget:IsConnected()
+    return self.tRequests ~= nil
+end
+
+
+local function quote(strArg)
+    return "'" .. string.gsub(strArg, "'", "'\\''") .. "'"
+end
+
+
+-- Read one reply. Messages are passed to the callback until the final
+-- reply arrives. Returns the type, the 2 values and the data.
+function VirtualTarget:receive(fnCallbackMessage)
+    while true do
+        local strHeader = self.tReplies:read(HEADER_SIZE)
+        if strHeader == nil or strHeader:len() ~= HEADER_SIZE then
+            self.fRunning = false
+            self:Disconnect()
+            error('The virtual target closed the connection.')
+        end
+        local strType, ulValue0, ulValue1 = string.unpack(HEADER_FORMAT, strHeader)
+
+        local strData = ''
+        if strType == 'D' or strType == 'M' or strType == 'E' then
+            strData = self.tReplies:read(ulValue0) or ''
+            if strData:len() ~= ulValue0 then
+                self.fRunning = false
+                self:Disconnect()
+                error('The virtual target closed the connection.')
+            end
+        end
+
+        if strType == 'E' then
+            error(string.format('The virtual target reported an error: %s', strData))
+        elseif strType == 'M' then
+            if fnCallbackMessage ~= nil then
+                fnCallbackMessage(strData, 0)
+            end
+        else
+            return strType, ulValue0, ulValue1, strData
+        end
+    end
+end
+
+
+function VirtualTarget:request(strType, ulValue0, ulValue1, strData)
+    if self.tRequests == nil then
+        error('The virtual target is not connected.')
+    end
+    self.tRequests:write(string.pack(HEADER_FORMAT, strType, ulValue0, ulValue1))
+    if strData ~= nil then
+        self.tRequests:write(strData)
+    end
+    self.tRequests:flush()
+end
+
+
+function VirtualTarget:Connect()
+    if self.tRequests == nil then
+        local strFifo = os.tmpname()
+        os.remove(strFifo)
+        if os.execute('mkfifo ' .. quote(strFifo)) ~= true then
+            error('Failed to create a FIFO for the virtual target.')
+        end
+        self.strFifo = strFifo
+
+        local astrCmd = { quote(self.strExecutable), quote(strFifo) }
+        for _, strSpiFlash in ipairs(self.astrSpiFlashes) do
+            table.insert(astrCmd, '--spi')
+            table.insert(astrCmd, quote(strSpiFlash))
+        end
+        local tRequests, strError = io.popen(table.concat(astrCmd, ' '), 'w')
+        if tRequests == nil then
+            os.remove(strFifo)
+            error(string.format('Failed to start the virtual target: %s', strError))
+        end
+        self.tRequests = tRequests
+        self.fRunning = true
+
+        -- This blocks until the process opened the FIFO.
+        self.tReplies = io.open(strFifo, 'rb')
+        if self.tReplies == nil then
+            self:Disconnect()
+            error('Failed to open the FIFO of the virtual target.')
+        end
+
+        -- The process sends one reply when it is ready.
+        local fOk, strMsg = pcall(self.receive, self)
+        if fOk ~= true then
+            -- The process exits after a failed start.
+            self.fRunning = false
+            self:Disconnect()
+            error(strMsg, 0)
+        end
+    end
+end
+
+
+function VirtualTarget:Disconnect()
+    if self.tRequests ~= nil then
+        if self.fRunning == true then
+            self:request('Q', 0, 0)
+        end
+        self.fRunning = false
+        self.tRequests:close()
+        self.tRequests = nil
+    end
+    if self.tReplies ~= nil then
+        self.tReplies:close()
+        self.tReplies = nil
+    end
+    if self.strFifo ~= nil then
+        os.remove(self.strFifo)
+        self.strFifo = nil
+    end
+end
+
+
+function VirtualTarget:write_image(ulAddress, strData, fnCallbackProgress, sizData)
+    self:request('W', ulAddress, strData:len(), strData)
+    self:receive()
+    if fnCallbackProgress ~= nil then
+        fnCallbackProgress(sizData, sizData)
+    end
+end
+
+
+function VirtualTarget:read_image(ulAddress, sizData, fnCallbackProgress)
+    self:request('R', ulAddress, sizData)
+    local _, _, _, strData = self:receive()
+    if fnCallbackProgress ~= nil then
+        fnCallbackProgress(sizData, sizData)
+    end
+    return strData
+end
+
+
+function VirtualTarget:write_data32(ulAddress, ulValue)
+    self:write_image(ulAddress, string.pack('<I4', ulValue), nil, 4)
+end
+
+
+function VirtualTarget:read_data32(ulAddress)
+    return (string.unpack('<I4', self:read_image(ulAddress, 4)))
+end
+
+
+function VirtualTarget:call(ulExecAddress, ulParameterAddress, fnCallbackMessage)
+    self:request('C', ulExecAddress, ulParameterAddress)
+    local _, ulReturnValue = self:receive(fnCallbackMessage)
+    return ulReturnValue
+end
+
+
+-- Get the simulated statistics of the last call and of all calls since the
+-- connect. Both tables have the fields ulBusBytes, ulTimeUs, ulBusyPolls,
+-- ulPrograms and ulErases.
+function VirtualTarget:get_statistics()
+    local function unpack_statistics(strData, ulPos)
+        local ulBusBytes, ulTimeUs, ulBusyPolls, ulPrograms, ulErases, ulNext = string.unpack(STATISTICS_FORMAT, strData, ulPos)
+        return {
+            ulBusBytes = ulBusBytes,
+            ulTimeUs = ulTimeUs,
+            ulBusyPolls = ulBusyPolls,
+            ulPrograms = ulPrograms,
+            ulErases = ulErases
+        }, ulNext
+    end
+
+    self:request('S', 0, 0)
+    local _, _, _, strData = self:receive()
+    local tCall, ulPos = unpack_statistics(strData, 1)
+    local tTotal = unpack_statistics(strData, ulPos)
+    return { tCall = tCall, tTotal = tTotal }
+end
+
+
+-- The interface reference which is returned by DetectInterfaces.
+local VirtualTargetReference = class()
+
+
+function VirtualTargetReference:_init(strName, atOptions)
+    self.strName = strName
+    self.atOptions = atOptions
+end
+
+
+function VirtualTargetReference:GetName()
+    return self.strName
+end
+
+
+function VirtualTargetReference:GetTyp()
+    return M.PLUGIN_ID
+end
+
+
+function VirtualTargetReference:IsUsed()
+    return false
+end
+
+
+function VirtualTargetReference:IsValid()
+    return true
+end
+
+
+function VirtualTargetReference:Create()
+    return VirtualTarget(self.strName, self.atOptions)
+end
+
+
+-- The plugin provider.
+local tProvider = {}
+
+
+function tProvider:GetID()
+    return M.PLUGIN_ID
+end
+
+
+function tProvider:DetectInterfaces(aDetectedInterfaces, atPluginOptions)
+    local iDetected = 0
+    local atOptions = atPluginOptions and atPluginOptions[M.PLUGIN_ID]
+    if atOptions ~= nil and atOptions.spi_flashes ~= nil and #atOptions.spi_flashes > 0 then
+        table.insert(aDetectedInterfaces, VirtualTargetReference(M.PLUGIN_ID .. '_0', atOptions))
+        iDetected = 1
+    end
+    return iDetected
+end
+
+
+_G.__MUHKUH_PLUGINS = _G.__MUHKUH_PLUGINS or {}
+table.insert(_G.__MUHKUH_PLUGINS, tProvider)
+
+M.VirtualTarget = VirtualTarget
+
+return M
@@ -1,5 +1,6 @@
 -- Create the configuration class.
 local class = require 'pl.class'
+local sparse_extents = require 'sparse_extents'
 local WfpControl = class()
 
 local VERSION_MAJOR_POS = 1
@@ -478,6 +479,17 @@ function WfpControl.__parseCfg_StartElement(tParser, strName, atAttributes)
       if strCondition==nil then
         strCondition = ''
       end
+      -- The optional sparse map lists the parts of the file which are not blank.
+      local atExtents
+      local strExtents = atAttributes['extents']
+      if strExtents~=nil then
+        local strError
+        atExtents, strError = sparse_extents.fromString(strExtents)
+        if atExtents==nil then
+          aLxpAttr.tResult = nil
+          aLxpAttr.tLog.error('Error in line %d, col %d: attribute "extents" is invalid: %s', iPosLine, iPosColumn, strError)
+        end
+      end
 
       local tData = {}
       tData.strType = "Data"
@@ -485,6 +497,7 @@ function WfpControl.__parseCfg_StartElement(tParser, strName, atAttributes)
       tData.ulSize = ulSize
       tData.ulOffset = ulOffset
       tData.strCondition = strCondition
+      tData.atExtents = atExtents
 
       table.insert(aLxpAttr.tCurrentFlash.atData, tData)
     end
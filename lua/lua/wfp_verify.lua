@@ -1,6 +1,7 @@
 local M = {}
 
 local pl = require 'pl.import_into'()
+local sparse_extents = require 'sparse_extents'
 
 
 local function __splitDataString(strData, ulSplitOffset)
@@ -191,15 +192,33 @@ local function __generateFileList(tTargetFlash, tWfpControl, atWfpConditions, tL
               local strData = tWfpControl:getData(strFile)
               local sizData = string.len(strData)
 
-              local tCommand = {}
-              tCommand["strFile"] = pl.path.basename(tData.strFile)
-              tCommand["strFilePath"] = tData.strFile
-              tCommand["ulOffset"] = tData.ulOffset
-              tCommand["ulEndOffset"] = tData.ulOffset + sizData
-              tCommand["strData"] = strData
-              tCommand["ulSize"] = sizData
-              tCommand["strType"] = "flash"
-              table.insert(tFiles, tCommand)
+              -- With a sparse map the parts with data are compared and the
+              -- holes are checked to be erased.
+              local atExtents = tData.atExtents
+              if atExtents == nil or tTargetFlash.strBus == 'SDIO' or sparse_extents.check(atExtents, sizData) ~= true then
+                  atExtents = { { ulOffset = 0, ulSize = sizData } }
+              else
+                  for _, tHole in ipairs(sparse_extents.getHoles(atExtents, sizData)) do
+                      local tCommand = {}
+                      tCommand["ulOffset"] = ulOffset + tHole.ulOffset
+                      tCommand["ulSize"] = tHole.ulSize
+                      tCommand["ulEndOffset"] = ulOffset + tHole.ulOffset + tHole.ulSize
+                      tCommand["strType"] = "erase"
+                      table.insert(tFiles, tCommand)
+                  end
+              end
+
+              for _, tExtent in ipairs(atExtents) do
+                  local tCommand = {}
+                  tCommand["strFile"] = pl.path.basename(tData.strFile)
+                  tCommand["strFilePath"] = tData.strFile
+                  tCommand["ulOffset"] = ulOffset + tExtent.ulOffset
+                  tCommand["ulEndOffset"] = ulOffset + tExtent.ulOffset + tExtent.ulSize
+                  tCommand["strData"] = string.sub(strData, tExtent.ulOffset + 1, tExtent.ulOffset + tExtent.ulSize)
+                  tCommand["ulSize"] = tExtent.ulSize
+                  tCommand["strType"] = "flash"
+                  table.insert(tFiles, tCommand)
+              end
           end
        end
   end
@@ -207,80 +226,6 @@ local function __generateFileList(tTargetFlash, tWfpControl, atWfpConditions, tL
 end
 
 
-local function __verifyWFPData(atFlashData, tPlugin, tFlasher, aAttr, tLog)
-  -- run verify command for flash data chunks with in wfp.xml
-  -- run iserased command for erase commands in wfp.xml
-  local fVerified = true  -- be optimistic
-  local fOk
-  local tDataChunks = atFlashData['atChunkList']
-  tLog.info('verify chunks from chunk list')
-
-  -- verify the created chunks
-  for _, tChunk in ipairs(tDataChunks) do
-
-      if tChunk['strType'] == "erase" then
-          -- run isErased function for areas that are expected to be erased after using the wfp archive
-          tLog.info('(Flash Bus: %s Unit: %s ChipSelect: %s): verify erase command at offset [0x%08x, 0x%08x[.',
-            atFlashData['tBus'],
-            atFlashData['ulUnit'],
-            atFlashData['ulChipSelect'],
-            tChunk['ulOffset'],
-            tChunk['ulEndOffset']
-        )
-
-          fOk = tFlasher.isErased(tPlugin, aAttr, tChunk['ulOffset'], tChunk['ulEndOffset'])
-          if fOk == true then
-              tLog.info('ok')
-              tChunk['verified'] = true
-          else
-              tLog.info("ERROR: area [0x%08x to 0x%08x[ not erased!", tChunk['ulOffset'], tChunk['ulEndOffset'])
-              fVerified = false
-              tChunk['verified'] = false
-              print("verified result: " .. tostring(fVerified))
-          end
-
-
-      elseif tChunk['strType'] == "flash" then
-          local strChunkData = tChunk['strData']
-
-          -- run verify function for flashed data that is supposed to be in the flash after flashing the whole wfp
-          -- archive
-          tLog.info(
-            '(Flash Bus: %s Unit: %s ChipSelect: %s): verify flash command at offset [0x%08x, 0x%08x[. file %s',
-            atFlashData['tBus'],
-            atFlashData['ulUnit'],
-            atFlashData['ulChipSelect'],
-            tChunk['ulOffset'],
-            tChunk['ulEndOffset'],
-            tChunk['tFile']['strFilePath']
-          )
-
-          local strMessage
-          fOk, strMessage = tFlasher.verifyArea(tPlugin, aAttr, tChunk['ulOffset'], strChunkData)
-          if fOk == true then
-              tLog.info('ok')
-              tLog.info(strMessage or "")
-              tChunk['verified'] = true
-          else
-              tLog.info('ERROR: (Flash Bus: %s Unit: %s ChipSelect: %s): verify failed for area [0x%08x - 0x%08x[!',
-               atFlashData['tBus'],
-              atFlashData['ulUnit'],
-              atFlashData['ulChipSelect'],
-               tChunk['ulOffset'],
-                tChunk['ulEndOffset']
-            )
-              tLog.info(strMessage or "")
-              fVerified = false
-              tChunk['verified'] = false
-              print("verified result: " .. tostring(fVerified))
-          end
-      end
-
-  end
-  return fVerified
-end
-
-
 function M.verifyWFP(tTarget, tWfpControl, iChiptype, atWfpConditions, tPlugin, tFlasher, aAttr, tLog, fUseProductionMode)
 
 	-- loop over each target flash
@@ -289,10 +234,9 @@ function M.verifyWFP(tTarget, tWfpControl, iChiptype, atWfpConditions, tPlugin,
 	------ NEW: for netx90 the data of Bus:2 CS: 0 Unit:3 will be added to the flashes that are morrored by that flash
   ---- whenever data overlaps data that was already added to the buffer, it will replace that data either partially
   ---- or completely
-	-- loop over created buffer table for each flash
-	---- switch to current flash via detect command
-	---- clean flash list (remove entries that were flagged with 'delete' -> whole chunks overwritten by other data)
-	---- run __verifyWFPData() function with the cleaned chunk list for each flash
+	-- clean the chunk list of each flash (remove entries that were flagged with 'delete' -> whole chunks overwritten
+	-- by other data)
+	-- verify the chunks of all flashes with tFlasher.verifyBatch
 
     local fOk
     local fVerified = true -- return boolean of function -> be optimistic
@@ -465,27 +409,9 @@ function M.verifyWFP(tTarget, tWfpControl, iChiptype, atWfpConditions, tPlugin,
 
     tLog.info("Verify After gathering data.")
 
+    -- clean the chunk lists and collect the devices for one batched verify
+    local atDevices = {}
     for _, atFlashData in pairs(atFlashDataTable) do
-        tLog.info(
-          "Verify Data inside Flash B" .. atFlashData['tBus'] ..
-          " CS" .. atFlashData['ulChipSelect'] ..
-          " U" .. atFlashData['ulUnit']
-        )
-         -- Detect the device. (switch to right flash)
-        local fDetectOk, strMsg = tFlasher.detectAndCheckSizeLimit(
-          tPlugin,
-          aAttr,
-          atFlashData['tBus'],
-          atFlashData['ulUnit'],
-          atFlashData['ulChipSelect']
-        )
-        if fDetectOk ~= true then
-            tLog.error(strMsg)
-            fVerified = false
-            break
-        end
-
-        -- clean chunk list and print final chunks that will be verified
         local tCleanChunkList = {}
         for _, tChunk in ipairs(atFlashData['atChunkList']) do
             if tChunk['delete'] ~= true then
@@ -500,10 +426,38 @@ function M.verifyWFP(tTarget, tWfpControl, iChiptype, atWfpConditions, tPlugin,
         end
         atFlashData['atChunkList'] = tCleanChunkList
 
-        -- pass the chunk list of current flash to __verifyWFPData
-        fOk = __verifyWFPData(atFlashData, tPlugin, tFlasher, aAttr, tLog)
-        if fOk == false then
-            fVerified = false
+        table.insert(atDevices, {
+            tBus = atFlashData['tBus'],
+            ulUnit = atFlashData['ulUnit'],
+            ulChipSelect = atFlashData['ulChipSelect'],
+            atJobs = tCleanChunkList
+        })
+    end
+
+    -- The chunks of all flashes are verified in batches. The flasher detects
+    -- each flash once and runs the chunks of the different flashes in turn.
+    local strMsg
+    fOk, strMsg = tFlasher.verifyBatch(tPlugin, aAttr, atDevices)
+    if fOk == nil then
+        tLog.error(strMsg)
+        fVerified = false
+    else
+        for _, atFlashData in pairs(atFlashDataTable) do
+            for _, tChunk in ipairs(atFlashData['atChunkList']) do
+                tChunk['verified'] = (tChunk.fOk == true)
+                if tChunk['verified'] ~= true then
+                    tLog.info('ERROR: (Flash Bus: %s Unit: %s ChipSelect: %s): %s chunk [0x%08x - 0x%08x[: %s',
+                      atFlashData['tBus'],
+                      atFlashData['ulUnit'],
+                      atFlashData['ulChipSelect'],
+                      tChunk['strType'],
+                      tChunk['ulOffset'],
+                      tChunk['ulEndOffset'],
+                      tChunk.strMsg or "verify failed"
+                    )
+                    fVerified = false
+                end
+            end
         end
     end
 
@@ -0,0 +1,160 @@
+-- Measure the compression of images for the compressed flash mode.
+-- This runs on the host only, no netX is needed.
+--
+-- Usage: lua5.4 lz4_benchmark.lua [-c chunk_size] [-d decoder] file1 [file2 ...]
+--
+-- The images are split into chunks like in flasher.flashArea. Each chunk is
+-- compressed, decompressed with the reference decoder and compared.
+--
+-- The chunks are also decoded with lz4_decode_block of the flasher. This
+-- needs the host build of the decoder ("scons --host-target"), which is
+-- installed as host/lz4_block_bench in the testbench. Use -d to set another
+-- path. The decoder runs on a separate buffer and in-place from the end of
+-- the buffer like in flasher.flashArea.
+package.path = package.path .. ';lua/?.lua'
+local lz4 = require 'lz4'
+
+local function printf(...) print(string.format(...)) end
+
+local ulChunkSize = 0x10000
+local strDecoder = 'host/lz4_block_bench'
+local astrFiles = {}
+local uiArg = 1
+while uiArg<=#arg do
+	if arg[uiArg]=='-c' then
+		ulChunkSize = tonumber(arg[uiArg+1])
+		if ulChunkSize==nil or ulChunkSize<=0 then
+			error('Invalid chunk size.')
+		end
+		uiArg = uiArg + 2
+	elseif arg[uiArg]=='-d' then
+		strDecoder = arg[uiArg+1]
+		if strDecoder==nil then
+			error('Missing path of the decoder.')
+		end
+		uiArg = uiArg + 2
+	else
+		table.insert(astrFiles, arg[uiArg])
+		uiArg = uiArg + 1
+	end
+end
+if #astrFiles==0 then
+	error('Missing parameter: image files to compress.')
+end
+
+local tDecoderFile = io.open(strDecoder, 'rb')
+if tDecoderFile==nil then
+	printf('The host decoder %s was not found. Only the reference decoder is measured.', strDecoder)
+	strDecoder = nil
+else
+	tDecoderFile:close()
+end
+
+-- flasher.flashArea keeps some room at the end of the buffer for the
+-- compressed data. Get the size of a buffer which has room for one chunk.
+local ulBufferLen = ulChunkSize + (ulChunkSize >> 8) + 64
+while ulBufferLen - (ulBufferLen >> 8) - 64 < ulChunkSize do
+	ulBufferLen = ulBufferLen + 1
+end
+
+
+-- Decode all chunks of one file with lz4_decode_block.
+-- Returns the times for the separate buffer and the in-place decode and
+-- the number of bytes which were decoded in-place.
+local function runHostDecoder(atChunks)
+	local strChunkFile = os.tmpname()
+	local tFile = io.open(strChunkFile, 'wb')
+	for _, tChunk in ipairs(atChunks) do
+		tFile:write(string.pack('<I4I4I4I4', tChunk.strRaw:len(), tChunk.strCompressed:len(), tChunk.ulInPlaceGap, ulBufferLen))
+		tFile:write(tChunk.strCompressed)
+		tFile:write(tChunk.strRaw)
+	end
+	tFile:close()
+
+	local tProcess = io.popen(string.format('"%s" "%s"', strDecoder, strChunkFile), 'r')
+	local strOutput = tProcess:read('a')
+	local fOk = tProcess:close()
+	os.remove(strChunkFile)
+
+	local strChunks, strDecodeNs, strInPlaceBytes, strInPlaceNs = string.match(strOutput, 'chunks=(%d+) bytes=%d+ decode_ns=(%d+) inplace_chunks=%d+ inplace_bytes=(%d+) inplace_ns=(%d+)')
+	if fOk~=true or strChunks==nil or tonumber(strChunks)~=#atChunks then
+		error('lz4_decode_block failed. See the messages above.')
+	end
+
+	return tonumber(strDecodeNs)/1e9, tonumber(strInPlaceNs)/1e9, tonumber(strInPlaceBytes)
+end
+
+
+local ulTotalRaw = 0
+local ulTotalCompressed = 0
+local tTotalCompress = 0
+local tTotalDecompress = 0
+local tTotalHost = 0
+local tTotalInPlace = 0
+local ulTotalInPlace = 0
+
+local function printLine(strName, ulSize, ulCompressed, tCompress, tDecompress, tHost, tInPlace, ulInPlace)
+	local strHost = ''
+	if strDecoder~=nil then
+		strHost = string.format(' %10.2f %10.2f', ulSize/1048576/math.max(tHost, 1e-9), ulInPlace/1048576/math.max(tInPlace, 1e-9))
+	end
+	printf('%-40s %10d %10d %6.2fx %10.2f %10.2f%s', strName, ulSize, ulCompressed,
+		ulSize/math.max(ulCompressed, 1), ulSize/1048576/math.max(tCompress, 1e-6), ulSize/1048576/math.max(tDecompress, 1e-6), strHost)
+end
+
+if strDecoder==nil then
+	printf('%-40s %10s %10s %7s %10s %10s', 'file', 'size', 'packed', 'ratio', 'pack MB/s', 'unpack MB/s')
+else
+	printf('%-40s %10s %10s %7s %10s %10s %10s %10s', 'file', 'size', 'packed', 'ratio', 'pack MB/s', 'unpack MB/s', 'C MB/s', 'in-place')
+end
+for _, strFile in ipairs(astrFiles) do
+	local tFile, strError = io.open(strFile, 'rb')
+	if tFile==nil then
+		error(string.format('Failed to open %s: %s', strFile, strError))
+	end
+	local strData = tFile:read('a')
+	tFile:close()
+
+	local ulCompressed = 0
+	local tCompress = 0
+	local tDecompress = 0
+	local atChunks = {}
+	for ulOffset=1, strData:len(), ulChunkSize do
+		local strChunk = strData:sub(ulOffset, ulOffset+ulChunkSize-1)
+
+		local tStart = os.clock()
+		local strCompressed, ulInPlaceGap = lz4.compress(strChunk)
+		tCompress = tCompress + os.clock() - tStart
+		table.insert(atChunks, { strRaw=strChunk, strCompressed=strCompressed, ulInPlaceGap=ulInPlaceGap })
+
+		tStart = os.clock()
+		local strDecompressed = lz4.decompress(strCompressed)
+		tDecompress = tDecompress + os.clock() - tStart
+		if strDecompressed~=strChunk then
+			error(string.format('%s: the chunk at offset 0x%08x does not decompress to the original data.', strFile, ulOffset-1))
+		end
+
+		-- Incompressible chunks are sent as they are.
+		ulCompressed = ulCompressed + math.min(strCompressed:len(), strChunk:len())
+	end
+
+	local tHost = 0
+	local tInPlace = 0
+	local ulInPlace = 0
+	if strDecoder~=nil then
+		tHost, tInPlace, ulInPlace = runHostDecoder(atChunks)
+	end
+
+	local ulSize = strData:len()
+	printLine(strFile, ulSize, ulCompressed, tCompress, tDecompress, tHost, tInPlace, ulInPlace)
+
+	ulTotalRaw = ulTotalRaw + ulSize
+	ulTotalCompressed = ulTotalCompressed + ulCompressed
+	tTotalCompress = tTotalCompress + tCompress
+	tTotalDecompress = tTotalDecompress + tDecompress
+	tTotalHost = tTotalHost + tHost
+	tTotalInPlace = tTotalInPlace + tInPlace
+	ulTotalInPlace = ulTotalInPlace + ulInPlace
+end
+
+printLine('total', ulTotalRaw, ulTotalCompressed, tTotalCompress, tTotalDecompress, tTotalHost, tTotalInPlace, ulTotalInPlace)
@@ -38,23 +38,6 @@ end
 
 
 
-local function sdi_send_write_enable(tPlugin, aAttr)
-	local fOk = flasher.sdi_chip_select(tPlugin, aAttr, 1)
-	assert(fOk, "Failed to set CS to 1.")
-	
-	local strData = string.char(0x06)
-	fOk = flasher.sdi_send_data(tPlugin, aAttr, strData)
-	assert(fOk, "Failed to send data.")
-	
-	fOk = flasher.sdi_chip_select(tPlugin, aAttr, 0)
-	assert(fOk, "Failed to set CS to 0.")
-	
-	fOk = flasher.sdi_idle_bytes(tPlugin, aAttr, 1)
-	assert(fOk, "Failed to send 1 idle bytes.")
-end
-
-
-
 local function sdi_read_status_register1(tPlugin, aAttr)
 	local strRX
 	
@@ -105,32 +88,31 @@ end
 
 
 
-local function sdi_wait_for_not_busy(tPlugin, aAttr)
-	repeat
-		local ulStatus = sdi_read_status_register1(tPlugin, aAttr)
-		ulStatus = ulStatus & 1
-	until ulStatus==0
-end
-
-
-
 local function sdi_write_status_register(tPlugin, aAttr, ucData01, ucData02)
-	sdi_send_write_enable(tPlugin, aAttr)
-	
-	local fOk = flasher.sdi_chip_select(tPlugin, aAttr, 1)
-	assert(fOk, "Failed to set CS to 1.")
-	
-	local strData = string.char(0x01, ucData01, ucData02)
-	fOk = flasher.sdi_send_data(tPlugin, aAttr, strData)
-	assert(fOk, "Failed to send data.")
-	
-	fOk = flasher.sdi_chip_select(tPlugin, aAttr, 0)
-	assert(fOk, "Failed to set CS to 0.")
-	
-	fOk = flasher.sdi_idle_bytes(tPlugin, aAttr, 1)
-	assert(fOk, "Failed to send 1 idle bytes.")
-	
-	sdi_wait_for_not_busy(tPlugin, aAttr)
+	-- Write enable, write the status registers and wait until the busy
+	-- flag is cleared. This runs on the netX in one call.
+	local atMacro = {
+		{ 'cs', 1 },
+		{ 'send', string.char(0x06) },
+		{ 'cs', 0 },
+		{ 'idle', 1 },
+
+		{ 'cs', 1 },
+		{ 'send', string.char(0x01, ucData01, ucData02) },
+		{ 'cs', 0 },
+		{ 'idle', 1 },
+
+		{ 'label', 'wait_for_not_busy' },
+		{ 'cs', 1 },
+		{ 'send', string.char(0x05) },
+		{ 'receive', 1 },
+		{ 'cs', 0 },
+		{ 'idle', 1 },
+		{ 'poll', 0x01, 0x00, 'wait_for_not_busy', 1000 },
+		{ 'end' }
+	}
+	local strLog, strError = flasher.sdi_run_macro(tPlugin, aAttr, atMacro, 0)
+	assert(strLog, "Failed to write the status register: " .. tostring(strError))
 end
 
 
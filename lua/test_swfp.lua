@@ -0,0 +1,180 @@
+-- Round trip test for swfp.lua.
+-- This runs on the host only, no netX is needed.
+--
+-- Usage: lua5.4 test_swfp.lua
+--
+-- SWFP files of version 1, version 2 and version 2 with compression are
+-- written to a temporary file, opened again and all records are compared.
+-- The records are passed with their data or as files.
+-- The first record is an IFlash record. Its bus ID must not be mistaken
+-- for a version field.
+package.path = package.path .. ';lua/?.lua'
+local swfp = require 'swfp'
+
+local function printf(...) print(string.format(...)) end
+
+-- The bus IDs from flasher_interface.h .
+local BUS_ParFlash = 0
+local BUS_SPI = 1
+local BUS_IFlash = 2
+local BUS_SDIO = 3
+local BUS_I2C = 4
+
+
+-- Get reproducible test data. ulRepeat > 1 makes the data compressible.
+local function getTestData(ulSize, ulSeed, ulRepeat)
+	local atBytes = {}
+	local ulValue = ulSeed
+	for ulCnt=1, ulSize do
+		if ulRepeat==1 or (ulCnt % ulRepeat)==1 then
+			ulValue = (ulValue * 1103515245 + 12345) & 0x7fffffff
+		end
+		atBytes[ulCnt] = string.char((ulValue >> 16) & 0xff)
+	end
+	return table.concat(atBytes)
+end
+
+
+local atRecords = {
+	{ ucBus=BUS_IFlash,   ucUnit=0, ucChipSelect=0, ulOffset=0x00000000, strData=getTestData(0x3000, 1, 1) },
+	{ ucBus=BUS_IFlash,   ucUnit=2, ucChipSelect=0, ulOffset=0x00001000, strData=getTestData(0x0123, 2, 1) },
+	{ ucBus=BUS_SPI,      ucUnit=0, ucChipSelect=0, ulOffset=0x00010000, strData=getTestData(0x24000, 3, 16) },
+	{ ucBus=BUS_ParFlash, ucUnit=0, ucChipSelect=0, ulOffset=0x00000100, strData=getTestData(0x0400, 4, 1) },
+	{ ucBus=BUS_SDIO,     ucUnit=0, ucChipSelect=0, ulOffset=0x00200000, strData=string.rep('\255', 0x20000) },
+	{ ucBus=BUS_I2C,      ucUnit=0, ucChipSelect=0, ulOffset=0x00000010, strData='' },
+	{ ucBus=BUS_I2C,      ucUnit=0, ucChipSelect=0, ulOffset=0x00000020, strData='x' }
+}
+
+local atCases = {
+	{ strName='version 1',                  ulVersion=swfp.VERSION_1, fCompress=false },
+	{ strName='version 1, from files',      ulVersion=swfp.VERSION_1, fCompress=false, fFromFiles=true },
+	{ strName='version 2',                  ulVersion=swfp.VERSION_2, fCompress=false },
+	{ strName='version 2, from files',      ulVersion=swfp.VERSION_2, fCompress=true, fFromFiles=true },
+	{ strName='version 2, compressed',      ulVersion=swfp.VERSION_2, fCompress=true },
+	{ strName='version 2, small blocks',    ulVersion=swfp.VERSION_2, fCompress=true, ulBlockSize=0x1000 }
+}
+
+
+local function fail(strCase, strMessage, ...)
+	error(string.format('%s: ' .. strMessage, strCase, ...))
+end
+
+
+-- Store the data of each record in a temporary file and return records
+-- which only have the file name.
+local function getFileRecords()
+	local atFileRecords = {}
+	for _, tRecord in ipairs(atRecords) do
+		local strFilename = os.tmpname()
+		local tFile = io.open(strFilename, 'wb')
+		tFile:write(tRecord.strData)
+		tFile:close()
+		table.insert(atFileRecords, {
+			ucBus=tRecord.ucBus,
+			ucUnit=tRecord.ucUnit,
+			ucChipSelect=tRecord.ucChipSelect,
+			ulOffset=tRecord.ulOffset,
+			strFilename=strFilename
+		})
+	end
+	return atFileRecords
+end
+
+
+local function writeFile(strPath, tCase)
+	local atWriteRecords = atRecords
+	if tCase.fFromFiles==true then
+		atWriteRecords = getFileRecords()
+	end
+	local tFile = io.open(strPath, 'wb')
+	local fOk, strError = swfp.write(tFile, atWriteRecords, tCase.ulVersion, tCase.fCompress, tCase.ulBlockSize)
+	tFile:close()
+	if tCase.fFromFiles==true then
+		for _, tRecord in ipairs(atWriteRecords) do
+			os.remove(tRecord.strFilename)
+		end
+	end
+	if fOk~=true then
+		fail(tCase.strName, 'write failed: %s', tostring(strError))
+	end
+end
+
+
+local function checkFile(strPath, tCase)
+	local tSwfp, strError = swfp.open(strPath)
+	if tSwfp==nil then
+		fail(tCase.strName, 'open failed: %s', tostring(strError))
+	end
+	if tSwfp.ulVersion~=tCase.ulVersion then
+		fail(tCase.strName, 'the file was detected as version %d.', tSwfp.ulVersion)
+	end
+	if #tSwfp.atRecords~=#atRecords then
+		fail(tCase.strName, 'found %d records, expected %d.', #tSwfp.atRecords, #atRecords)
+	end
+
+	for uiCnt, tExpected in ipairs(atRecords) do
+		local tRecord = tSwfp.atRecords[uiCnt]
+		if tRecord.ucBus~=tExpected.ucBus or tRecord.ucUnit~=tExpected.ucUnit or tRecord.ucChipSelect~=tExpected.ucChipSelect or tRecord.ulOffset~=tExpected.ulOffset or tRecord.ulSize~=tExpected.strData:len() then
+			fail(tCase.strName, 'the header of record %d differs.', uiCnt)
+		end
+		local strData
+		strData, strError = swfp.readRecord(tSwfp, tRecord)
+		if strData==nil then
+			fail(tCase.strName, 'failed to read record %d: %s', uiCnt, tostring(strError))
+		end
+		if strData~=tExpected.strData then
+			fail(tCase.strName, 'the data of record %d differs.', uiCnt)
+		end
+	end
+
+	if #swfp.getRecords(tSwfp, BUS_IFlash)~=2 or #swfp.getRecords(tSwfp, BUS_I2C, 0, 0)~=2 then
+		fail(tCase.strName, 'getRecords returned the wrong records.')
+	end
+
+	swfp.close(tSwfp)
+end
+
+
+-- A damaged TOC of a version 2 file must be detected.
+local function checkDamagedToc(strPath)
+	local tFile = io.open(strPath, 'rb')
+	local strData = tFile:read('a')
+	tFile:close()
+
+	-- Change the offset of the first TOC entry, which is directly after the header.
+	local ulPos = string.packsize('<c4I2I2I4I4c32') + 5
+	strData = strData:sub(1, ulPos-1) .. string.char(strData:byte(ulPos) ~ 0x01) .. strData:sub(ulPos+1)
+	tFile = io.open(strPath, 'wb')
+	tFile:write(strData)
+	tFile:close()
+
+	local tSwfp = swfp.open(strPath)
+	if tSwfp~=nil then
+		swfp.close(tSwfp)
+		error('A damaged TOC was not detected.')
+	end
+end
+
+
+local strPath = os.tmpname()
+for _, tCase in ipairs(atCases) do
+	writeFile(strPath, tCase)
+	local tFile = io.open(strPath, 'rb')
+	local ulSize = tFile:seek('end')
+	tFile:close()
+	checkFile(strPath, tCase)
+	printf('%-30s %8d bytes  OK', tCase.strName, ulSize)
+end
+checkDamagedToc(strPath)
+printf('%-30s OK', 'damaged TOC')
+
+local tFile = io.open(strPath, 'wb')
+local fOk = swfp.write(tFile, { { ucBus=BUS_SPI, ucUnit=0, ucChipSelect=0, ulOffset=0, strFilename=strPath .. '.missing' } }, swfp.VERSION_1)
+tFile:close()
+if fOk==true then
+	error('A missing file was not detected.')
+end
+printf('%-30s OK', 'missing file')
+os.remove(strPath)
+
+print('All SWFP tests passed.')
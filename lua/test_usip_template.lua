@@ -0,0 +1,288 @@
+-- Compare usip_template.lua with the USIP generator and the sipper.
+-- This runs on the host only, no netX is needed.
+--
+-- Usage: lua5.4 test_usip_template.lua [seed] [devices]
+--
+-- A multi USIP with signed and unsigned chunks is built. For random devices
+-- the output of UsipTemplate:generate is compared with the reference path:
+-- the values are patched into a copy of the analyzed USIP, the images are
+-- built with UsipGenerator:gen_multi_usip, the SIP pages with
+-- UsipGenerator:convertUsipToBin and the chunk hashes with
+-- Sipper:analyze_hboot_image. The data entries of the signed chunks are
+-- also parsed from the images to check that each field ends up at its
+-- offset of the SIP page.
+package.path = package.path .. ';lua/?.lua'
+local Sipper = require 'sipper'
+local UsipGenerator = require 'usip_generator'
+local UsipTemplate = require 'usip_template'
+
+local tLogWriterConsole = require 'log.writer.console'.new()
+local tLogWriterFilter = require 'log.writer.filter'.new('warning', tLogWriterConsole)
+local tLog = require 'log'.new('trace',
+	tLogWriterFilter,
+	require 'log.formatter.format'.new())
+
+local function printf(...) print(string.format(...)) end
+
+local ulSeed = tonumber(arg[1] or '1')
+local ulDevices = tonumber(arg[2] or '20')
+math.randomseed(ulSeed)
+
+local SIP_PAGE_SIZE = 0x1000
+
+
+local function getRandomData(ulSize)
+	local atBytes = {}
+	for ulCnt=1, ulSize do
+		atBytes[ulCnt] = string.char(math.random(0, 255))
+	end
+	return table.concat(atBytes)
+end
+
+
+local function getPadding(ulSize)
+	return string.rep('\0', (4 - (ulSize % 4)) % 4)
+end
+
+
+-- Build one USIP chunk. atEntries is a list of { ulOffset, strData }.
+local function getUsipChunk(ulPage, ulKeyIdx, atEntries)
+	local astrPayload = {}
+	for _, tEntry in ipairs(atEntries) do
+		table.insert(astrPayload, string.pack('<I2I2', tEntry[1], string.len(tEntry[2])) .. tEntry[2])
+	end
+	local strPayload = table.concat(astrPayload)
+
+	local astrBody = { string.pack('<BBI2', ulPage, ulKeyIdx, string.len(strPayload)) }
+	local fSigned = (ulKeyIdx~=255)
+	if fSigned==true then
+		-- UUID, anchors and masks followed by an RSA 2048 key.
+		table.insert(astrBody, getRandomData(56))
+		table.insert(astrBody, string.char(1, 2) .. getRandomData(518))
+	end
+	table.insert(astrBody, strPayload)
+	table.insert(astrBody, getPadding(string.len(strPayload)))
+	table.insert(astrBody, getRandomData(fSigned and 96 or 4))
+	local strBody = table.concat(astrBody)
+	strBody = strBody .. getPadding(string.len(strBody))
+
+	return 'USIP' .. string.pack('<I4', string.len(strBody) // 4) .. strBody
+end
+
+
+local function getMultiUsip()
+	local strHeader = string.char(0x00, 0xaf, 0xbe, 0xf3) .. string.rep('\0', 12) ..
+	                  string.pack('<I4', 0x1234) .. string.rep('\0', 4) .. 'MOOH' .. string.rep('\0', 4) ..
+	                  getRandomData(28) .. 'CHKS'
+	return strHeader ..
+	       getUsipChunk(1, 16,  { { 0x0010, getRandomData(33) }, { 0x0100, getRandomData(64) }, { 0x0300, getRandomData(7) } }) ..
+	       'SKIP' .. string.pack('<I4', 2) .. string.rep('\0', 8) ..
+	       getUsipChunk(2, 255, { { 0x0020, getRandomData(16) }, { 0x0800, getRandomData(10) } }) ..
+	       getUsipChunk(1, 17,  { { 0x0100, getRandomData(64) }, { 0x0f00, getRandomData(0xd0) } }) ..
+	       string.rep('\0', 8)
+end
+
+
+-- The MAC is written by two chunks.
+local astrFields = {
+	'mac:com:0x108:6',
+	'serial:app:0x804:4',
+	'cal:com:0xf10:16'
+}
+
+
+local function writeFile(strPath, strData)
+	local tFile = assert(io.open(strPath, 'wb'))
+	tFile:write(strData)
+	tFile:close()
+end
+
+
+local function copyTable(tValue)
+	if type(tValue)~='table' then
+		return tValue
+	end
+	local tCopy = {}
+	for tKey, tItem in pairs(tValue) do
+		tCopy[tKey] = copyTable(tItem)
+	end
+	return tCopy
+end
+
+
+-- Patch the values of a device into a copy of the analyzed USIP.
+local function getPatchedConfig(tUsipConfigDict, atFields, atValues)
+	local tConfig = copyTable(tUsipConfigDict)
+	for iIdx=0, tConfig.num_of_chunks-1 do
+		local tChunk = tConfig.content[iIdx]
+		for iDataIdx=0, tChunk.ulDataCount do
+			local tData = tChunk.data[iDataIdx]
+			for _, tField in ipairs(atFields) do
+				if tField.ulPage==tChunk.page_type_int and tField.ulOffset>=tData.offset_int and tField.ulOffset+tField.ulSize<=tData.offset_int+tData.size_int then
+					local ulPos = tField.ulOffset - tData.offset_int
+					tData.patched_data = string.sub(tData.patched_data, 1, ulPos) .. atValues[tField.strName] .. string.sub(tData.patched_data, ulPos+tField.ulSize+1)
+				end
+			end
+		end
+	end
+	return tConfig
+end
+
+
+local function fail(ulDevice, strMessage, ...)
+	error(string.format('device %d: ' .. strMessage, ulDevice, ...))
+end
+
+
+-- Apply the data entries of a parsed signed chunk to an empty page and
+-- compare the fields.
+local function checkChunkContent(ulDevice, ulImage, tChunk, atFields, atValues)
+	local strPage = string.rep('\0', SIP_PAGE_SIZE)
+	local ulPos = 1
+	local ulEnd = string.len(tChunk.strDataContent)
+	while ulPos+3<=ulEnd do
+		local ulOffset, ulSize = string.unpack('<I2I2', tChunk.strDataContent, ulPos)
+		if ulSize==0 then
+			break
+		end
+		local strData = string.sub(tChunk.strDataContent, ulPos+4, ulPos+4+ulSize-1)
+		strPage = string.sub(strPage, 1, ulOffset) .. strData .. string.sub(strPage, ulOffset+ulSize+1)
+		ulPos = ulPos + 4 + ulSize
+	end
+
+	local ulFields = 0
+	for _, tField in ipairs(atFields) do
+		if tField.ulPage==tChunk.ulPageSelect then
+			local strValue = string.sub(strPage, tField.ulOffset+1, tField.ulOffset+tField.ulSize)
+			if strValue==atValues[tField.strName] then
+				ulFields = ulFields + 1
+			elseif strValue~=string.rep('\0', tField.ulSize) then
+				fail(ulDevice, 'image %d has a wrong value for the field "%s".', ulImage, tField.strName)
+			end
+		end
+	end
+	return ulFields
+end
+
+
+local function checkSipPage(ulDevice, strName, strPage, strReference, ulPage, atFields, atValues)
+	if strPage~=strReference then
+		fail(ulDevice, 'the %s SIP page differs from convertUsipToBin.', strName)
+	end
+	if UsipGenerator.updateSipHash(strPage)~=strPage then
+		fail(ulDevice, 'the %s SIP page has a wrong hash.', strName)
+	end
+	for _, tField in ipairs(atFields) do
+		if tField.ulPage==ulPage and string.sub(strPage, tField.ulOffset+1, tField.ulOffset+tField.ulSize)~=atValues[tField.strName] then
+			fail(ulDevice, 'the %s SIP page has a wrong value for the field "%s".', strName, tField.strName)
+		end
+	end
+end
+
+
+local function checkErrors(tUsipConfigDict, tTemplate)
+	local atBadFields = {
+		{ 'not written',    { 'x:com:0x0:4' } },
+		{ 'partly written', { 'x:com:0x30:4' } },
+		{ 'overlap',        { 'x:com:0x100:4', 'y:com:0x102:4' } },
+		{ 'hash area',      { 'x:app:0xfcf:2' } }
+	}
+	for _, tCase in ipairs(atBadFields) do
+		local atFields = {}
+		for _, strField in ipairs(tCase[2]) do
+			table.insert(atFields, assert(UsipTemplate.parse_field(strField)))
+		end
+		if UsipTemplate(tLog):prepare(tUsipConfigDict, atFields)==true then
+			error(string.format('prepare accepted the fields of the case "%s".', tCase[1]))
+		end
+	end
+
+	if tTemplate:generate({ mac='12345', serial='1234', cal=string.rep('x', 16) })==true then
+		error('generate accepted a short value.')
+	end
+	if tTemplate:generate({ mac='123456', serial='1234' })==true then
+		error('generate accepted a missing value.')
+	end
+	if UsipTemplate.parse_field('bad')~=nil or UsipTemplate.parse_devices('dev1 mac=00112233445x')~=nil then
+		error('An invalid field or device list was accepted.')
+	end
+end
+
+
+local strUsipPath = os.tmpname()
+local strComPath = os.tmpname()
+local strAppPath = os.tmpname()
+local strComTemplate = getRandomData(SIP_PAGE_SIZE)
+local strAppTemplate = getRandomData(SIP_PAGE_SIZE)
+writeFile(strUsipPath, getMultiUsip())
+writeFile(strComPath, strComTemplate)
+writeFile(strAppPath, strAppTemplate)
+
+local tGenerator = UsipGenerator(tLog)
+local tSipper = Sipper(tLog)
+local fOk, strError, tUsipConfigDict = tGenerator:analyze_usip(strUsipPath)
+if fOk~=true then
+	error('Failed to analyze the USIP: ' .. tostring(strError))
+end
+
+local atFields = {}
+for _, strField in ipairs(astrFields) do
+	table.insert(atFields, assert(UsipTemplate.parse_field(strField)))
+end
+local tTemplate = UsipTemplate(tLog)
+fOk, strError = tTemplate:prepare(tUsipConfigDict, atFields, strComTemplate, strAppTemplate, true)
+if fOk~=true then
+	error('Failed to prepare the template: ' .. tostring(strError))
+end
+
+for ulDevice=1, ulDevices do
+	local atValues = {}
+	for _, tField in ipairs(atFields) do
+		atValues[tField.strName] = getRandomData(tField.ulSize)
+	end
+
+	local aDataList, astrChunkHashes, strComSipData, strAppSipData
+	fOk, strError, aDataList, astrChunkHashes, strComSipData, strAppSipData = tTemplate:generate(atValues)
+	if fOk~=true then
+		fail(ulDevice, 'generate failed: %s', tostring(strError))
+	end
+
+	local tReference = getPatchedConfig(tUsipConfigDict, atFields, atValues)
+	local aReferenceList = tGenerator:gen_multi_usip(tReference)
+	if #aDataList~=#aReferenceList then
+		fail(ulDevice, 'generate returned %d images, gen_multi_usip %d.', #aDataList, #aReferenceList)
+	end
+
+	local ulFields = 0
+	for ulImage, strReference in ipairs(aReferenceList) do
+		if aDataList[ulImage]~=strReference then
+			fail(ulDevice, 'image %d differs from gen_multi_usip.', ulImage)
+		end
+		local tParsed = tSipper:analyze_hboot_image(strReference)
+		local tChunk = tParsed.atChunks[1]
+		if tChunk==nil or tChunk.strChunkHash~=astrChunkHashes[ulImage] then
+			fail(ulDevice, 'the chunk hash of image %d differs from Sipper:analyze_hboot_image.', ulImage)
+		end
+		if tChunk.ulKeyIdx~=255 then
+			ulFields = ulFields + checkChunkContent(ulDevice, ulImage, tChunk, atFields, atValues)
+		end
+	end
+	-- The MAC is in both signed chunks, the calibration data in one.
+	if ulFields~=3 then
+		fail(ulDevice, 'found %d fields in the signed chunks, expected 3.', ulFields)
+	end
+
+	local _, _, strComReference, strAppReference = tGenerator:convertUsipToBin(strComPath, strAppPath, tReference, true)
+	checkSipPage(ulDevice, 'COM', strComSipData, strComReference, 1, atFields, atValues)
+	checkSipPage(ulDevice, 'APP', strAppSipData, strAppReference, 2, atFields, atValues)
+end
+printf('%-30s %d devices  OK', 'images, hashes and SIP pages', ulDevices)
+
+checkErrors(tUsipConfigDict, tTemplate)
+printf('%-30s OK', 'invalid fields and values')
+
+os.remove(strUsipPath)
+os.remove(strComPath)
+os.remove(strAppPath)
+
+print('All USIP template tests passed.')
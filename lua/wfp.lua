@@ -5,6 +5,8 @@ local argparse = require 'argparse'
 local pl = require 'pl.import_into'()
 local wfp_control = require 'wfp_control'
 local wfp_verify = require 'wfp_verify'
+local sparse_extents = require 'sparse_extents'
+local swfp = require 'swfp'
 _G.tester = require 'tester_cli'
 
 --local tFlasher = require 'flasher'(tLog)
@@ -20,13 +22,15 @@ atName2Bus = {
     ['Parflash'] = tFlasher.BUS_Parflash,
     ['Spi'] = tFlasher.BUS_Spi,
     ['IFlash'] = tFlasher.BUS_IFlash,
-    ['SDIO'] = tFlasher.BUS_SDIO
+    ['SDIO'] = tFlasher.BUS_SDIO,
+    ['I2C'] = tFlasher.BUS_I2C
 }
 local atBus2Name = {
     [tFlasher.BUS_Parflash] = 'Parflash',
     [tFlasher.BUS_Spi] = 'Spi',
     [tFlasher.BUS_IFlash] = 'IFlash',
-    [tFlasher.BUS_SDIO] = 'SDIO'
+    [tFlasher.BUS_SDIO] = 'SDIO',
+    [tFlasher.BUS_I2C] = 'I2C'
 }
 
 
@@ -49,6 +53,11 @@ function WFPXml:parse(strWfpXmlData)
     -- print(strXmlData)
 end
 
+function WFPXml:parseString(strWfpXmlData)
+    self.nodeFlasherPack = self.xml.parse(strWfpXmlData, false, true)
+    self.tTargets = self.nodeFlasherPack:get_elements_with_name("Target")
+end
+
 function WFPXml:get_target(strNetX)
     for _, tTarget in ipairs(self.tTargets) do
 
@@ -148,16 +157,6 @@ function WFPXml:exportXml(outputDir)
     return fResult, strErrorMsg
 end
 
-local function __writeU32(tFile, ulData)
-    local ucB0 = math.fmod(ulData, 256)
-    ulData = (ulData - ucB0) / 256
-    local ucB1 = math.fmod(ulData, 256)
-    ulData = (ulData - ucB1) / 256
-    local ucB2 = math.fmod(ulData, 256)
-    local ucB3 = (ulData - ucB2) / 256
-    tFile:write(string.char(ucB0, ucB1, ucB2, ucB3))
-end
-
 
 
 local function __getNetxPath()
@@ -336,6 +335,44 @@ local function add_sip_data_to_wfp_xml(strWfpPath, strComSipBin, strAppSipBin, s
     return strWfpData
 end
 
+-- Add a sparse map to each "Data" element of the control file.
+-- atFiles maps the names in the control file to the absolute paths.
+local function add_sparse_extents_to_wfp_xml(tLog, strWfpData, atFiles, fHasSubdirs)
+    local wfp_xml = WFPXml()
+    local atExtentsCache = {}
+
+    wfp_xml:parseString(strWfpData)
+    for _, tTarget in ipairs(wfp_xml.tTargets) do
+        for _, tDataNode in ipairs(tTarget:get_elements_with_name("Data")) do
+            local strFile = tDataNode.attr['file']
+            local strCompareName = strFile
+            if fHasSubdirs ~= true then
+                strCompareName = pl.path.basename(strFile)
+            end
+            local strFileAbs = atFiles[strCompareName]
+            if strFileAbs ~= nil then
+                local strExtents = atExtentsCache[strFileAbs]
+                if strExtents == nil then
+                    local strData = pl.utils.readfile(strFileAbs, true)
+                    local atExtents = sparse_extents.scan(strData)
+                    strExtents = sparse_extents.toString(atExtents)
+                    atExtentsCache[strFileAbs] = strExtents
+                    tLog.info(
+                        'Sparse map for "%s": %d extent(s), 0x%08x of 0x%08x bytes with data.',
+                        strFile,
+                        #atExtents,
+                        sparse_extents.getDataSize(atExtents),
+                        strData:len()
+                    )
+                end
+                tDataNode:set_attrib('extents', strExtents)
+            end
+        end
+    end
+
+    return wfp_xml:toString()
+end
+
 local function prepare_usip(tLog, strUsipFilePath, fSetSipProtectionCookie)
     tLog.info("Add Secure Info Page (SIP) data to wfp archive")
     local usip_generator = require 'usip_generator'
@@ -368,7 +405,7 @@ local function prepare_usip(tLog, strUsipFilePath, fSetSipProtectionCookie)
 end
 
 local function pack(strWfpArchiveFile,strWfpControlFile,tWfpControl,tLog,fOverwrite,fBuildSWFP,
-      strUsipFilePath, fSetSipProtectionCookie, fSetKek)
+      strUsipFilePath, fSetSipProtectionCookie, fSetKek, fSparse, ulSwfpVersion, fCompress)
 
     local archive = require 'archive'
     local fOk=true
@@ -523,6 +560,10 @@ local function pack(strWfpArchiveFile,strWfpControlFile,tWfpControl,tLog,fOverwr
                                 strData = add_sip_data_to_wfp_xml(strWfpControlFile, strComSipBin, strAppSipBin,
                                 tUsipConfigDict['netx_type'], strUsipFilePath, tWfpControl.tUsip.set_kek)
                             end
+                            if fSparse == true then
+                                -- store the non-blank parts of each data file in the control file
+                                strData = add_sparse_extents_to_wfp_xml(tLog, strData, atFiles, tWfpControl:getHasSubdirs())
+                            end
                             tEntryCtrl:set_pathname('wfp.xml')
                             tEntryCtrl:set_size(string.len(strData))
                             tEntryCtrl:set_filetype(archive.AE_IFREG)
@@ -601,29 +642,36 @@ local function pack(strWfpArchiveFile,strWfpControlFile,tWfpControl,tLog,fOverwr
                 else
                     -- Build a SWFP.
 
+                    if fSparse == true then
+                        tLog.warning('A SWFP has no control file for the sparse maps. The files are stored in full.')
+                    end
+                    if fCompress == true and ulSwfpVersion ~= swfp.VERSION_2 then
+                        tLog.warning('Only a version 2 SWFP can be compressed. The files are stored uncompressed.')
+                    end
+
                     -- Create the new archive.
                     local tArchive, strError = io.open(strWfpArchiveFile, 'wb')
                     if tArchive == nil then
                         tLog.error('Failed to create the new SWFP archive "%s": %s', strWfpArchiveFile, strError)
                         fOk = false
                     else
-                        -- Write the SWFP magic.
-                        tArchive:write(string.char(0x53, 0x57, 0x46, 0x50))
-
-                        -- Loop over all files.
+                        -- Collect all files. The data is read by swfp.write .
+                        local atRecords = {}
                         for _, tAttr in ipairs(atSortedFiles) do
-                            -- Get the file data.
-                            local strData = pl.utils.readfile(tAttr.strFilename, true)
-
-                            -- Write the chunk header.
-                            tArchive:write(string.char(tAttr.ucBus))
-                            tArchive:write(string.char(tAttr.ucUnit))
-                            tArchive:write(string.char(tAttr.ucChipSelect))
-                            __writeU32(tArchive, tAttr.ulOffset)
-                            __writeU32(tArchive, string.len(strData))
-
-                            -- Write the data.
-                            tArchive:write(strData)
+                            table.insert(atRecords, {
+                                ucBus = tAttr.ucBus,
+                                ucUnit = tAttr.ucUnit,
+                                ucChipSelect = tAttr.ucChipSelect,
+                                ulOffset = tAttr.ulOffset,
+                                strFilename = tAttr.strFilename
+                            })
+                        end
+
+                        local fResult
+                        fResult, strError = swfp.write(tArchive, atRecords, ulSwfpVersion, fCompress)
+                        if fResult ~= true then
+                            tLog.error('Failed to write the SWFP archive "%s": %s', strWfpArchiveFile, strError)
+                            fOk = false
                         end
 
                         tArchive:close()
@@ -877,23 +925,31 @@ local function backup(tArgs, tLog, tWfpControl, bCompMode, strSecureOption, atPl
 
                                         -- continue with reading the selected area
 
-                                        -- read
-                                        local strData
-                                        strData, strMsg = tFlasher.readArea(tPlugin, aAttr, ulOffset, ulSize)
-                                        if strData == nil then
-                                            fOk = false
-                                            strMsg = strMsg or "Error while reading"
-                                        else
-                                            -- save the read area  to the output file (write binary)
-                                            local fileName = DestinationFolder .. "/" .. strFile
+                                        -- save the read area to the output file (write binary)
+                                        local fileName = DestinationFolder .. "/" .. strFile
 
-                                            -- create the subdirectory inside the output folder if it does not exist
-                                            local strSubFolderPath = pl.path.dirname(fileName)
-                                                if not pl.path.exists(strSubFolderPath) then
-                                                    pl.dir.makepath(strSubFolderPath)
-                                                end
+                                        -- create the subdirectory inside the output folder if it does not exist
+                                        local strSubFolderPath = pl.path.dirname(fileName)
+                                        if not pl.path.exists(strSubFolderPath) then
+                                            pl.dir.makepath(strSubFolderPath)
+                                        end
 
-                                            pl.utils.writefile(fileName, strData, true)
+                                        -- read, the data is written to the file chunk by chunk
+                                        local tFile
+                                        tFile, strMsg = io.open(fileName, "wb")
+                                        if tFile == nil then
+                                            fOk = false
+                                            strMsg = strMsg or "Failed to open the output file"
+                                        else
+                                            local ulRead
+                                            ulRead, strMsg = tFlasher.readAreaToSink(tPlugin, aAttr, ulOffset, ulSize, tFile)
+                                            tFile:close()
+                                            if ulRead == nil then
+                                                -- Do not leave a truncated file behind.
+                                                os.remove(fileName)
+                                                fOk = false
+                                                strMsg = strMsg or "Error while reading"
+                                            end
                                         end
                                     end
                                 end
@@ -1095,6 +1151,138 @@ local function validateAndCalculate(tLog, tWfpControl, strExpression, atOperands
     end
 end
 
+-- Check the syntax of all conditions of a flash.
+local function check_conditions(tLog, tWfpControl, atData, atWfpConditions)
+    for _, tData in ipairs(atData) do
+        if tData.strCondition ~= "" then
+            if validateAndCalculate(tLog, tWfpControl, tData.strCondition, atWfpConditions) == CALC_RESULT_ERROR then
+                tLog.error('Invalid Condition! Expression: %s; Operands: %s', tData.strCondition, atWfpConditions)
+                return false
+            end
+        end
+    end
+    return true
+end
+
+-- Load the data of a file entry from the WFP and get the extents to flash.
+-- Without a sparse map or with fUseSparseMap ~= true this is the complete
+-- file. The SIP hash update changes the data, so the map is not valid for it.
+-- Returns nil on error.
+local function load_data(tLog, tWfpControl, tData, strFile, fUseSparseMap)
+    local strData = tWfpControl:getData(strFile)
+    if strData == nil then
+        tLog.error('Failed to get the data %s', strFile)
+        return nil
+    end
+
+    local atExtents = tData.atExtents
+    if tData.fUpdateHash then
+        local usip_generator = require 'usip_generator'
+        local tUsipGen = usip_generator(tLog)
+        strData = tUsipGen.updateSipHash(strData)
+        atExtents = nil
+    end
+
+    local sizData = string.len(strData)
+    if atExtents == nil or fUseSparseMap ~= true then
+        atExtents = { { ulOffset = 0, ulSize = sizData } }
+    elseif sparse_extents.check(atExtents, sizData) ~= true then
+        tLog.error('The sparse map of %s exceeds the file size.', strFile)
+        return nil
+    else
+        tLog.info(
+            'Sparse map: flashing 0x%08x of 0x%08x bytes in %d extent(s).',
+            sparse_extents.getDataSize(atExtents),
+            sizData,
+            #atExtents
+        )
+    end
+
+    return strData, atExtents
+end
+
+-- Flash all SPI flashes of a target with one batch call. The flasher feeds
+-- the pages to the flashes in turn, so one flash is programmed while the
+-- others are busy. Each file gets an erase job for its area and flash jobs
+-- for its sparse extents, like in the loop over the single flashes.
+local function flash_spi_batch(tLog, tWfpControl, tFlasher, tPlugin, aAttr, atSpiFlashes, atWfpConditions)
+    local atDevices = {}
+    for _, tTargetFlash in ipairs(atSpiFlashes) do
+        if check_conditions(tLog, tWfpControl, tTargetFlash.atData, atWfpConditions) ~= true then
+            return false
+        end
+
+        local atJobs = {}
+        for _, tData in ipairs(tTargetFlash.atData) do
+            if tWfpControl:matchCondition(atWfpConditions, tData.strCondition) ~= true then
+                tLog.info('Not processing %s : prevented by condition.', tData.strFile or 'erase')
+            elseif tData.strFile == nil then
+                tLog.info('Found erase 0x%08x-0x%08x.', tData.ulOffset, tData.ulOffset + tData.ulSize)
+                table.insert(atJobs, {
+                    strType = 'erase',
+                    ulOffset = tData.ulOffset,
+                    ulEndOffset = tData.ulOffset + tData.ulSize
+                })
+            else
+                local strFile = tData.strFile
+                if tWfpControl:getHasSubdirs() ~= true then
+                    strFile = pl.path.basename(tData.strFile)
+                end
+                tLog.info('Found file "%s" with offset 0x%08x.', strFile, tData.ulOffset)
+                local strData, atExtents = load_data(tLog, tWfpControl, tData, strFile, true)
+                if strData == nil then
+                    return false
+                end
+                local sizData = string.len(strData)
+
+                table.insert(atJobs, {
+                    strType = 'erase',
+                    ulOffset = tData.ulOffset,
+                    ulEndOffset = tData.ulOffset + sizData
+                })
+                for _, tExtent in ipairs(atExtents) do
+                    table.insert(atJobs, {
+                        strType = 'flash',
+                        ulOffset = tData.ulOffset + tExtent.ulOffset,
+                        strData = string.sub(strData, tExtent.ulOffset + 1, tExtent.ulOffset + tExtent.ulSize)
+                    })
+                end
+            end
+        end
+
+        table.insert(atDevices, {
+            tBus = tFlasher.BUS_Spi,
+            ulUnit = tTargetFlash.ulUnit,
+            ulChipSelect = tTargetFlash.ulChipSelect,
+            atJobs = atJobs
+        })
+    end
+
+    tLog.info('Flashing %d SPI flashes in one batch.', #atDevices)
+    local fOk, strMsg = tFlasher.flashBatch(tPlugin, aAttr, atDevices)
+    if fOk == nil then
+        tLog.error(strMsg)
+        return false
+    end
+    for _, tDevice in ipairs(atDevices) do
+        for _, tJob in ipairs(tDevice.atJobs) do
+            if tJob.fOk ~= true then
+                tLog.error(
+                    'Unit %d, chip select %d, 0x%08x: %s',
+                    tDevice.ulUnit,
+                    tDevice.ulChipSelect,
+                    tJob.ulOffset,
+                    tJob.strMsg
+                )
+            end
+        end
+    end
+    if fOk ~= true then
+        tLog.error(strMsg)
+    end
+    return fOk
+end
+
 local function addOptionVerbose(tParserCommand)
     tParserCommand
         :option('-V --verbose')
@@ -1203,6 +1391,12 @@ tParserCommandFlash
         :description('Add a condition in the form KEY=VALUE.')
         :count('*')
         :target('astrConditions')
+tParserCommandFlash
+        :flag('--interleave_spi')
+        :description('Flash all SPI flashes of the target in one job. ' ..
+                    'The flasher programs one flash while the others are busy.')
+        :default(false)
+        :target('fInterleaveSpi')
 addOptionVerbose(tParserCommandFlash)
 addOptionPlugin(tParserCommandFlash)
 addOptionSecure(tParserCommandFlash)
@@ -1307,6 +1501,23 @@ tParserCommandPack
         :description('Build a SWFP file without compression.')
         :default(false)
         :target('fBuildSWFP')
+tParserCommandPack
+        :flag('--sparse')
+        :description('Add a map of the non-blank areas of each data file to the control file. ' ..
+                   'The flash command erases the complete area but transfers and programs only these parts.')
+        :default(false)
+        :target('fSparse')
+tParserCommandPack
+        :option('--swfp_version')
+        :description('The format version of the SWFP. Version 2 has a table of contents, ' ..
+                   'a SHA-256 for each file and optional compression. The default is 1.')
+        :target('ulSwfpVersion')
+        :convert(tonumber)
+tParserCommandPack
+        :flag('--compress')
+        :description('Compress the files in a version 2 SWFP with LZ4.')
+        :default(false)
+        :target('fCompress')
 addOptionVerbose(tParserCommandPack)
 addOptionFutureVersion(tParserCommandPack)
 
@@ -1805,8 +2016,29 @@ elseif tArgs.fCommandFlashSelected == true or tArgs.fCommandVerifySelected then
 
                                 end
                             end
+                            -- Flash all SPI flashes in one batch if requested. Only
+                            -- the other flashes are left for the loop below.
+                            local atFlashes = tTarget.atFlashes
+                            if tArgs.fCommandFlashSelected == true and tArgs.fInterleaveSpi == true and tArgs.fDryRun ~= true then
+                                local atSpiFlashes = {}
+                                atFlashes = {}
+                                for _, tTargetFlash in ipairs(tTarget.atFlashes) do
+                                    if atName2Bus[tTargetFlash.strBus] == tFlasher.BUS_Spi then
+                                        table.insert(atSpiFlashes, tTargetFlash)
+                                    else
+                                        table.insert(atFlashes, tTargetFlash)
+                                    end
+                                end
+                                if #atSpiFlashes > 0 then
+                                    fOk = flash_spi_batch(tLog, tWfpControl, tFlasher, tPlugin, aAttr, atSpiFlashes, atWfpConditions)
+                                end
+                            end
+
                             -- Loop over all flashes. (inside xml)
-                            for _, tTargetFlash in ipairs(tTarget.atFlashes) do
+                            for _, tTargetFlash in ipairs(atFlashes) do
+                                if fOk ~= true then
+                                    break
+                                end
                                 local strBusName = tTargetFlash.strBus
                                 local tBus = atName2Bus[strBusName]
                                 if tBus == nil then
@@ -1840,16 +2072,7 @@ elseif tArgs.fCommandFlashSelected == true or tArgs.fCommandVerifySelected then
 
                                     if tArgs.fCommandFlashSelected == true then
                                         -- loop over data inside xml and check if the conditions are valid
-                                        for _, tData in ipairs(tTargetFlash.atData) do
-                                            if tData.strCondition ~= "" then
-                                                if validateAndCalculate(tLog, tWfpControl, tData.strCondition,
-                                                        atWfpConditions) == CALC_RESULT_ERROR then
-                                                    tLog.error('Invalid Condition! Expression: %s; Operands: %s', tData.strCondition, atWfpConditions)
-                                                    fOk = false
-                                                    break
-                                                end
-                                            end
-                                        end
+                                        fOk = check_conditions(tLog, tWfpControl, tTargetFlash.atData, atWfpConditions)
 
                                         -- loop over data in xml and flash/erase
                                         if fOk == true then
@@ -1910,14 +2133,15 @@ elseif tArgs.fCommandFlashSelected == true or tArgs.fCommandVerifySelected then
                                                         )
                                                     else
                                                         -- Loading the file data from the archive.
-                                                        local strData = tWfpControl:getData(strFile)
-                                                        if tData.fUpdateHash then
-                                                            local usip_generator = require 'usip_generator'
-                                                            local tUsipGen = usip_generator(tLog)
-                                                            strData = tUsipGen.updateSipHash(strData)
-                                                        end
+                                                        -- SDIO is always written completely.
+                                                        local strData, atExtents = load_data(
+                                                            tLog,
+                                                            tWfpControl,
+                                                            tData,
+                                                            strFile,
+                                                            tBus ~= tFlasher.BUS_SDIO
+                                                        )
                                                         if strData == nil then
-                                                            tLog.error('Failed to get the data %s', strFile)
                                                             fOk = false
                                                             break
                                                         else
@@ -1940,12 +2164,20 @@ elseif tArgs.fCommandFlashSelected == true or tArgs.fCommandVerifySelected then
                                                                     fOk = false
                                                                     break
                                                                 else
-                                                                    fOk, strMsg = tFlasher.flashArea(
-                                                                        tPlugin,
-                                                                        aAttr,
-                                                                        ulOffset,
-                                                                        strData
-                                                                    )
+                                                                    -- With a sparse map only the parts with data
+                                                                    -- are transferred. The rest is blank after the
+                                                                    -- erase.
+                                                                    for _, tExtent in ipairs(atExtents) do
+                                                                        fOk, strMsg = tFlasher.flashArea(
+                                                                            tPlugin,
+                                                                            aAttr,
+                                                                            ulOffset + tExtent.ulOffset,
+                                                                            string.sub(strData, tExtent.ulOffset + 1, tExtent.ulOffset + tExtent.ulSize)
+                                                                        )
+                                                                        if fOk ~= true then
+                                                                            break
+                                                                        end
+                                                                    end
                                                                     if fOk ~= true then
                                                                         tLog.error('Failed to flash the area: %s', strMsg)
                                                                         fOk = false
@@ -2047,7 +2279,10 @@ elseif tArgs.fCommandPackSelected == true  then
         tArgs.fBuildSWFP,
         tArgs.strUsipFilePath,
         tArgs.fSetSipProtectionCookie,
-        tArgs.fSetKek
+        tArgs.fSetKek,
+        tArgs.fSparse,
+        tArgs.ulSwfpVersion,
+        tArgs.fCompress
     )
 
 elseif tArgs.fCommandCheckHelperSignatureSelected then
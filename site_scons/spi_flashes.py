@@ -53,50 +53,120 @@ strHead = """/******************************************************************
 
 #include "spi_flash_types.h"
 
-/* uncomment the next line to disable some strange flashes with byte program only */
-/* #define __NO_1BYTEPERPAGE_FLASHES__ */
 
-const SPIFLASH_ATTRIBUTES_T atKnownSpiFlashTypes[] =
+"""
+
+strIndexHead = """/* The ID index is not packed. It is searched for a matching device without
+ * unpacking any records. The record offset points into the packed records.
+ */
+const SPIFLASH_ID_INDEX_T atKnownSpiFlashIds[NUMBER_OF_SPIFLASH_ATTRIBUTES] =
+{
+"""
+
+strRecordsHead = """/* The records hold all attributes except the ID. Each record is packed on
+ * its own, see spi_flash_types_unpack in spi_flash.c for the format.
+ */
+const unsigned char aucKnownSpiFlashRecords[SPIFLASH_RECORDS_SIZE] =
 {
 """
 
 
-aTemplateLines = [
-	('.@name',                           '                                 .acName = "%s\\0",',   '/* name                       */'),
-	('.@size',                           '                                 .ulSize = %d,',        '/* size                       */'),
-	('.@clock',                          '                                .ulClock = %d,',        '/* minClock                   */'),
-	('Layout@pageSize',                  '                             .ulPageSize = %d,',        '/* pageSize                   */'),
-	('Layout@sectorPages',               '                          .ulSectorPages = %d,',        '/* sectorSize                 */'),
-	('Layout@mode',                      '                               .tAdrMode = %s,',        '/* address mode               */'),
-	('Read@readArrayCommand',            '                           .ucReadOpcode = 0x%02x,',    '/* readOpcode                 */'),
-	('Read@ignoreBytes',                 '                    .ucReadOpcodeDCBytes = %d,',        '/* readOpcodeDCBytes          */'),
-	('Write@writeEnableCommand',         '                    .ucWriteEnableOpcode = 0x%02x,',    '/* writeEnableOpcode          */'),
-	('Erase@erasePageCommand',           '                      .ucErasePageOpcode = 0x%02x,',    '/* erase page                 */'),
-	('Erase@eraseSectorCommand',         '                    .ucEraseSectorOpcode = 0x%02x,',    '/* eraseSectorOpcode          */'),
-	('Erase@eraseChipCommandLen',        '                      .ucEraseChipCmdLen = %d,',        '/* erase chip command length  */'),
-	('Erase@eraseChipCommandHex',        '                        .aucEraseChipCmd = {%s},',      '/* erase chip command         */'),
-	('Write@pageProgramCommand',         '                       .ucPageProgOpcode = 0x%02x,',    '/* pageProgOpcode             */'),
-	('Write@bufferFillCommand',          '                           .ucBufferFill = 0x%02x,',    '/* buffer fill opcode         */'),
-	('Write@bufferWriteCommand',         '                    .ucBufferWriteOpcode = 0x%02x,',    '/* buffer write opcode        */'),
-	('Write@eraseAndPageProgramCommand', '               .ucEraseAndPageProgOpcode = 0x%02x,',    '/* eraseAndPageProgOpcode     */'),
-	('Status@readStatusCommand',         '                     .ucReadStatusOpcode = 0x%02x,',    '/* readStatusOpcode           */'),
-	('Status@statusReadyMask',           '                      .ucStatusReadyMask = 0x%02x,',    '/* statusReadyMask            */'),
-	('Status@statusReadyValue',          '                     .ucStatusReadyValue = 0x%02x,',    '/* statusReadyValue           */'),
-	('Init0@commandLen',                 '                      .ucInitCmd0_length = %d,',        '/* initCmd0_length            */'),
-	('Init0@commandHex',                 '                            .aucInitCmd0 = {%s},',      '/* initCmd0                   */'),
-	('Init1@commandLen',                 '                      .ucInitCmd1_length = %d,',        '/* initCmd1_length            */'),
-	('Init1@commandHex',                 '                            .aucInitCmd1 = {%s},',      '/* initCmd1                   */'),
-	('Id@sendLen',                       '                             .ucIdLength = %d,',        '/* id_length                  */'),
-	('Id@sendHex',                       '                              .aucIdSend = {%s},',      '/* id_send                    */'),
-	('Id@maskHex',                       '                              .aucIdMask = {%s},',      '/* id_mask                    */'),
-	('Id@magicHex',                      '                             .aucIdMagic = {%s}',       '/* id_magic                   */')
+# The fields of a packed record in the order of the unpack routine.
+# Numbers are stored as unsigned LEB128, i.e. 7 bits per byte with bit 7 set
+# if another byte follows. Bytes are stored as they are. Command arrays are
+# stored as a length byte followed by the used bytes only.
+PACK_STRING = 0
+PACK_NUMBER = 1
+PACK_BYTE = 2
+PACK_ARRAY = 3
+
+aRecordFields = [
+	('.@name',                           PACK_STRING),
+	('.@size',                           PACK_NUMBER),
+	('.@clock',                          PACK_NUMBER),
+	('Layout@pageSize',                  PACK_NUMBER),
+	('Layout@sectorPages',               PACK_NUMBER),
+	('Layout@mode',                      PACK_BYTE),
+	('Read@readArrayCommand',            PACK_BYTE),
+	('Read@ignoreBytes',                 PACK_BYTE),
+	('Write@writeEnableCommand',         PACK_BYTE),
+	('Erase@erasePageCommand',           PACK_BYTE),
+	('Erase@eraseSectorCommand',         PACK_BYTE),
+	('Erase@eraseChipCommand',           PACK_ARRAY),
+	('Write@pageProgramCommand',         PACK_BYTE),
+	('Write@bufferFillCommand',          PACK_BYTE),
+	('Write@bufferWriteCommand',         PACK_BYTE),
+	('Write@eraseAndPageProgramCommand', PACK_BYTE),
+	('Status@readStatusCommand',         PACK_BYTE),
+	('Status@statusReadyMask',           PACK_BYTE),
+	('Status@statusReadyValue',          PACK_BYTE),
+	('Init0@command',                    PACK_ARRAY),
+	('Init1@command',                    PACK_ARRAY)
 ]
 
+def pack_record(aEntry):
+	aucRecord = []
+	for (strPath,ePack) in aRecordFields:
+		tValue = aEntry[strPath]
+		if ePack==PACK_STRING:
+			aucRecord.extend([ord(c) for c in tValue])
+			aucRecord.append(0)
+		elif ePack==PACK_NUMBER:
+			if tValue<0 or tValue>0xffffffff:
+				raise Exception('Device %s: The value %s is out of range.' % (aEntry['.@name'], strPath))
+			while True:
+				ucByte = tValue & 0x7f
+				tValue >>= 7
+				if tValue!=0:
+					aucRecord.append(ucByte|0x80)
+				else:
+					aucRecord.append(ucByte)
+					break
+		elif ePack==PACK_BYTE:
+			aucRecord.append(tValue & 0xff)
+		elif ePack==PACK_ARRAY:
+			# Only the real length counts, not the default command.
+			sizArray = aEntry[strPath+'Len']
+			aucRecord.append(sizArray)
+			aucRecord.extend(tValue[0:sizArray])
+		else:
+			raise Exception("Unknown pack type:", ePack)
+	return aucRecord
+
+
 strFooter = """};
 
 """
 
 
+strTimingsHead = """/* The timings are only used by the device models of the host target. They
+ * are not part of the netX binaries.
+ */
+#ifdef CFG_SPI_FLASH_TIMING
+const SPIFLASH_TIMING_T atKnownSpiFlashTimings[NUMBER_OF_SPIFLASH_ATTRIBUTES] =
+{
+"""
+
+strTimingsFooter = """};
+#endif
+
+"""
+
+
+# The optional "Timing" node of a flash. All values are typical times in
+# microseconds. A missing node or attribute is 0, the models use defaults
+# then.
+# The order must match SPIFLASH_TIMING_T.
+aTimingFields = [
+	'pageProgram',
+	'erasePage',
+	'eraseSector',
+	'eraseBlock32',
+	'eraseBlock64',
+	'eraseChip'
+]
+
+
 strHeaderTemplate = """
 #ifndef ${DEFINE}
 #define ${DEFINE}
@@ -177,6 +247,49 @@ typedef struct SPIFLASH_ATTRIBUTES_Ttag
 
 #define NUMBER_OF_SPIFLASH_ATTRIBUTES ${ELEMENTS}
 
+
+/*
+   The structure SPIFLASH_ID_INDEX_T is one entry of the unpacked ID index.
+   It holds the identify sequence of a device and the offset of its packed
+   record in aucKnownSpiFlashRecords.
+*/
+typedef struct SPIFLASH_ID_INDEX_Ttag
+{
+	unsigned short  usRecordOffset;                                 /* offset of the packed record in bytes                         */
+	unsigned char   ucIdLength;                                     /* length in bytes of the id_send, id_mask and id_magic fields  */
+	unsigned char   aucIdSend[SPIFLASH_ID_SIZE];                    /* command string to request the id                             */
+	unsigned char   aucIdMask[SPIFLASH_ID_SIZE];                    /* mask for the device id                                       */
+	unsigned char   aucIdMagic[SPIFLASH_ID_SIZE];                   /* magic sequence of this device                                */
+} SPIFLASH_ID_INDEX_T;
+
+/* size of all packed records in bytes */
+#define SPIFLASH_RECORDS_SIZE ${RECORDS_SIZE}
+
+extern const SPIFLASH_ID_INDEX_T atKnownSpiFlashIds[NUMBER_OF_SPIFLASH_ATTRIBUTES];
+extern const unsigned char aucKnownSpiFlashRecords[SPIFLASH_RECORDS_SIZE];
+
+
+/*
+   The structure SPIFLASH_TIMING_T holds the typical times of a device in
+   microseconds. It is only available with CFG_SPI_FLASH_TIMING. The entries
+   have the same order as atKnownSpiFlashIds. A value of 0 is unknown.
+   The block erase times are also a hint that the device has the 32K (0x52)
+   and 64K (0xd8) erase commands.
+*/
+typedef struct SPIFLASH_TIMING_Ttag
+{
+	unsigned long   ulPageProgramUs;                                /* time to program one page                                     */
+	unsigned long   ulErasePageUs;                                  /* time to erase one page                                       */
+	unsigned long   ulEraseSectorUs;                                /* time to erase one sector                                     */
+	unsigned long   ulEraseBlock32Us;                               /* time to erase one 32K block                                  */
+	unsigned long   ulEraseBlock64Us;                               /* time to erase one 64K block                                  */
+	unsigned long   ulEraseChipUs;                                  /* time to erase the complete chip                              */
+} SPIFLASH_TIMING_T;
+
+#ifdef CFG_SPI_FLASH_TIMING
+extern const SPIFLASH_TIMING_T atKnownSpiFlashTimings[NUMBER_OF_SPIFLASH_ATTRIBUTES];
+#endif
+
 #endif  /* ${DEFINE} */
 """
 
@@ -307,6 +420,15 @@ def spiflashes_action(target, source, env):
 			aEntry[strPath] = get_value(tFlashNode, strPath, eType)
 
 
+		# Get the optional timing.
+		tTimingNode = tFlashNode.find('Timing')
+		for strAttribute in aTimingFields:
+			ulValue = 0
+			if tTimingNode is not None and strAttribute in tTimingNode.attrib:
+				ulValue = int(tTimingNode.attrib[strAttribute], 0)
+			aEntry['Timing@'+strAttribute] = ulValue
+
+
 		# Is this entry unique?
 		strDeviceName = aEntry['.@name']
 		if strDeviceName in aFlashNames:
@@ -389,12 +511,12 @@ def spiflashes_action(target, source, env):
 
 		# Convert the layout mode to the enum.
 		aLayoutMode = dict({
-			'linear': 'SPIFLASH_ADR_LINEAR',
-			'pagesize bitshift': 'SPIFLASH_ADR_PAGESIZE_BITSHIFT'
+			'linear': 0,                       # SPIFLASH_ADR_LINEAR
+			'pagesize bitshift': 1             # SPIFLASH_ADR_PAGESIZE_BITSHIFT
 		})
 		strMode = aEntry['Layout@mode']
 		if not strMode in aLayoutMode:
-			raise Exception('Device %s: Unknown layout mode: %s' % strDeviceName, strMode)
+			raise Exception('Device %s: Unknown layout mode: %s' % (strDeviceName, strMode))
 		# Translate the mode name to the enum element.
 		aEntry['Layout@mode'] = aLayoutMode[strMode]
 
@@ -408,26 +530,49 @@ def spiflashes_action(target, source, env):
 		aFlashes.append(aEntry)
 
 
-	astrFlashes = []
-	astrFlashes.append(strHead)
-	uiIndent = 88
+	# Pack all records and build the index.
+	astrIndex = []
+	astrRecords = []
+	astrTimings = []
+	sizRecords = 0
 	for aEntry in aFlashes:
-		# Append the description.
-		astrFlashes.append('        /* %s */' % aEntry['Description'])
-		# Append all notes.
+		aucRecord = pack_record(aEntry)
+		if sizRecords+len(aucRecord)>0xffff:
+			raise Exception('The packed records exceed the 16 bit record offset.')
+
+		# Append the description and all notes to the record.
+		astrRecords.append('        /* %s */' % aEntry['Description'])
 		for strNote in aEntry['Note']:
-			astrFlashes.append('        /* %s */' % strNote)
-		astrFlashes.append('        {')
-		for (strPath,strPattern,strComment) in aTemplateLines:
-			strLine = strPattern % aEntry[strPath]
-			sizLine = len(strLine)
-			if sizLine<uiIndent:
-				strLine += ' '*(uiIndent-sizLine)
-			strLine += strComment
-			astrFlashes.append(strLine)
-		astrFlashes.append('        },')
-		astrFlashes.append('        ')
+			astrRecords.append('        /* %s */' % strNote)
+		for uiPos in range(0, len(aucRecord), 16):
+			astrRecords.append('        ' + ' '.join(['0x%02x,'%ucByte for ucByte in aucRecord[uiPos:uiPos+16]]))
+		astrRecords.append('        ')
+
+		astrIndex.append('        /* %s */' % aEntry['.@name'])
+		astrIndex.append('        {')
+		astrIndex.append('                .usRecordOffset = 0x%04x,' % sizRecords)
+		astrIndex.append('                .ucIdLength = %d,' % aEntry['Id@sendLen'])
+		astrIndex.append('                .aucIdSend = {%s},' % aEntry['Id@sendHex'])
+		astrIndex.append('                .aucIdMask = {%s},' % aEntry['Id@maskHex'])
+		astrIndex.append('                .aucIdMagic = {%s}' % aEntry['Id@magicHex'])
+		astrIndex.append('        },')
+
+		astrTimings.append('        /* %s */' % aEntry['.@name'])
+		astrTimings.append('        { %s },' % ', '.join(['%d' % aEntry['Timing@'+strAttribute] for strAttribute in aTimingFields]))
+
+		sizRecords += len(aucRecord)
+
+	astrFlashes = []
+	astrFlashes.append(strHead)
+	astrFlashes.append(strIndexHead)
+	astrFlashes.extend(astrIndex)
+	astrFlashes.append(strFooter)
+	astrFlashes.append(strRecordsHead)
+	astrFlashes.extend(astrRecords)
 	astrFlashes.append(strFooter)
+	astrFlashes.append(strTimingsHead)
+	astrFlashes.extend(astrTimings)
+	astrFlashes.append(strTimingsFooter)
 
 	# Write the result.
 	tFile = open(target[0].get_path(), 'wt')
@@ -440,6 +585,7 @@ def spiflashes_action(target, source, env):
 	aReplaceDict = dict({
 		'DEFINE':             strDefine,
 		'ELEMENTS':           len(aFlashes),
+		'RECORDS_SIZE':       sizRecords,
 
 		'SIZEOF_NAME':        aMaxSize['.@name'],
 		'SIZEOF_ERASE_CHIP':  aMaxSize['Erase@eraseChipCommand'],
@@ -748,3 +748,40 @@ size_t cfi_find_matching_sector_index(const FLASH_DEVICE_T *ptFlashDescription,
 	return 0xffffffffU;
 }
 
+
+/* Check if a data block contains only the erased value 0xff.
+ * Programming such a block does not change the flash contents, so the
+ * program routines can skip it. The aligned part is checked with
+ * "unsigned long" accesses, an unaligned head and tail byte by byte.
+ */
+int cfi_is_erased_data(const unsigned char *pucData, unsigned long ulSize)
+{
+	CADR_T tCnt;
+	CADR_T tEnd;
+	unsigned long ulValue;
+
+
+	tCnt.puc = pucData;
+	tEnd.puc = pucData + ulSize;
+	ulValue = ~0UL;
+
+	/* Check the unaligned head. */
+	while( tCnt.puc<tEnd.puc && (tCnt.ul&(sizeof(unsigned long)-1U))!=0 )
+	{
+		ulValue &= ~0xffUL | *(tCnt.puc++);
+	}
+
+	/* Check the aligned part. */
+	while( ulValue==~0UL && (tEnd.ul-tCnt.ul)>=sizeof(unsigned long) )
+	{
+		ulValue &= *(tCnt.pul++);
+	}
+
+	/* Check the unaligned tail. */
+	while( tCnt.puc<tEnd.puc )
+	{
+		ulValue &= ~0xffUL | *(tCnt.puc++);
+	}
+
+	return (ulValue==~0UL) ? 1 : 0;
+}
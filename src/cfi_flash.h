@@ -124,9 +124,10 @@ typedef struct tagFLASH_DEVICE FLASH_DEVICE_T;
 typedef FLASH_ERRORS_E(*PFN_FLASH_RESET)(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulSector);
 typedef FLASH_ERRORS_E(*PFN_FLASH_ERASE)(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulSector);
 typedef FLASH_ERRORS_E(*PFN_FLASH_ERASEALL)(const FLASH_DEVICE_T *ptFlashDev);
-typedef FLASH_ERRORS_E(*PFN_FLASH_PROGRAM)(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulStartOffset, unsigned long ulLength, const void* pvData);
+typedef FLASH_ERRORS_E(*PFN_FLASH_PROGRAM)(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulStartOffset, unsigned long ulLength, const void* pvData, unsigned long *pulSkippedBytes);
 typedef FLASH_ERRORS_E(*PFN_FLASH_LOCK)(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulSector);
 typedef FLASH_ERRORS_E(*PFN_FLASH_UNLOCK)(const FLASH_DEVICE_T *ptFlashDev);
+typedef FLASH_ERRORS_E(*PFN_FLASH_ERASE_SECTORS)(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulFirstSector, unsigned long ulSectorCnt);
 
 
 
@@ -146,6 +147,7 @@ typedef struct FLASH_FUNCTIONS_Ttag
 	PFN_FLASH_PROGRAM       pfnProgram;
 	PFN_FLASH_LOCK          pfnLock;
 	PFN_FLASH_UNLOCK        pfnUnlock;
+	PFN_FLASH_ERASE_SECTORS pfnEraseSectors;    /* Erase a range of sectors in as few erase operations as possible. */
 } FLASH_FUNCTIONS_T;
 
 
@@ -350,6 +352,7 @@ struct tagFLASH_DEVICE
 int CFI_IdentifyFlash(FLASH_DEVICE_T* ptFlashDevice, PARFLASH_CONFIGURATION_T *ptCfg);
 const SECTOR_INFO_T *cfi_find_matching_sector(const FLASH_DEVICE_T *ptFlashDescription, unsigned long ulAddress);
 size_t cfi_find_matching_sector_index(const FLASH_DEVICE_T *ptFlashDescription, unsigned long ulAddress);
+int cfi_is_erased_data(const unsigned char *pucData, unsigned long ulSize);
 
 #endif  /* __CFI_FLASH_H__ */
 
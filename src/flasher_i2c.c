@@ -22,386 +22,614 @@
 
 #include "flasher_i2c.h"
 #include "netx_io_areas.h"
+#include "progress_bar.h"
+#include "systime.h"
 #include "uprintf.h"
 
 /* ------------------------------------- */
 
-NETX_CONSOLEAPP_RESULT_T i2c_verify_with_progress (unsigned long ulFlashStartAdr, unsigned long ulDataByteLen, const unsigned char *pucDataStartAdr);
-NETX_CONSOLEAPP_RESULT_T i2c_read_with_progress   (unsigned long ulFlashStartAdr, unsigned long ulDataByteLen, unsigned char *pucDataStartAdr);
+/* This is the size of the segments for read, verify, hash and the
+ * erase check. Each segment is one sequential read transaction.
+ */
+#define I2C_SEGMENT_SIZE 1024
+
+static unsigned char aucI2cBuffer[I2C_SEGMENT_SIZE];
 
 /* ------------------------------------- */
 
-#define ReadBuffer_Size 256
-unsigned char pucReadBuffer[ReadBuffer_Size];
+#if ASIC_TYP==ASIC_TYP_NETX500
+static void i2c_execute(unsigned long ulVal)
+{
+	/* execute command */
+	ulVal |= HOSTMSK(i2c_data_CMD3);
+	ptNetXI2CArea->ulData = ulVal;
 
-void i2c_sendAddress  (unsigned int         uiParams,   int          iStopFlag);
-void i2c_readResponse (unsigned char        *pucBuffer, unsigned int uiLength);
-void i2c_writeData    (const unsigned char  *pucBuffer, unsigned int uiLength);
-void i2c_pollAck      (unsigned int uiAckCnt);
+	/* wait for execution */
+	while( (ptNetXI2CArea->ulData&HOSTMSK(i2c_data_CMD3))!=0 ) {}
+}
+#endif
 
-/* ------------------------------------- */
 
-NETX_CONSOLEAPP_RESULT_T i2c_flash(const unsigned char *pbData, unsigned long ulDataByteLen)
+/* Start a transfer at the EEPROM address ulAddress.
+ * Devices with 1 address byte get the address bits 8 to 10 in the
+ * device address, devices with 2 address bytes get the bits 16 to 18.
+ */
+static void i2c_sendAddress(const FLASHER_I2C_CONFIGURATION_T *ptCfg, unsigned long ulAddress, int iStopFlag)
 {
-  NETX_CONSOLEAPP_RESULT_T  tResult;
-  const unsigned char       *pbDataCnt;
-  const unsigned char       *pbDataEnd;
-  unsigned long             ulFlashStartAdr;
-  unsigned long             ulFlashAdrCnt;
-
-
-  ulFlashStartAdr = 0;
-
-  pbDataCnt     = pbData;
-  pbDataEnd     = pbDataCnt + ulDataByteLen;
-  ulFlashAdrCnt = ulFlashStartAdr;
-
-  while( pbDataCnt<pbDataEnd ) 
-  {
-    /*  programm the byte */
-    i2c_sendAddress(ulFlashAdrCnt, 0);
-    i2c_writeData(pbDataCnt, 1);
-    i2c_pollAck(512);
-
-    /*  next byte */
-    ++pbDataCnt;
-    ++ulFlashAdrCnt;
-  }
-
-
-  /*  verify data */
-  tResult = i2c_verify_with_progress(ulFlashStartAdr, ulDataByteLen, pbData);
-  
-  if( tResult!=NETX_CONSOLEAPP_RESULT_OK ) 
-  {
-     return tResult;
-  }
-
-  /*  all ok */
-  return NETX_CONSOLEAPP_RESULT_OK;
+#if ASIC_TYP==ASIC_TYP_NETX500
+	unsigned long ulVal;
+	unsigned long ulId;
+
+
+	if( ptCfg->ulAddressBytes==1 )
+	{
+		ulId = ptCfg->ulDeviceAddress | ((ulAddress >> 8U) & 7U);
+	}
+	else
+	{
+		ulId = ptCfg->ulDeviceAddress | ((ulAddress >> 16U) & 7U);
+	}
+
+	/* first byte of the command is the ID */
+	ulVal  = (ulId & 0x7fU) << HOSTSRT(i2c_ctrl_ID);
+
+	/* set speed to max */
+	ulVal |= 4<<HOSTSRT(i2c_ctrl_SPEED);
+
+	/* enable i2c core */
+	ulVal |= HOSTMSK(i2c_ctrl_ENABLE);
+	ptNetXI2CArea->ulCtrl = ulVal;
+
+	if( ptCfg->ulAddressBytes==1 )
+	{
+		/* the only address byte with start data */
+		ulVal  = ulAddress & 0xffU;
+		ulVal |= HOSTMSK(i2c_data_CMD2);
+	}
+	else
+	{
+		/* high address byte with start data */
+		i2c_execute(((ulAddress >> 8U) & 0xffU) | HOSTMSK(i2c_data_CMD2));
+
+		/* low address byte */
+		ulVal  = ulAddress & 0xffU;
+	}
+
+	/* append stop condition? */
+	if( iStopFlag!=0 )
+	{
+		ulVal |= HOSTMSK(i2c_data_CMD0);
+	}
+	i2c_execute(ulVal);
+#else
+	(void)ptCfg;
+	(void)ulAddress;
+	(void)iStopFlag;
+#endif
 }
 
 
-NETX_CONSOLEAPP_RESULT_T i2c_erase(unsigned long ulDataByteLen)
+/* Read uiLength bytes in one sequential read transaction. */
+static void i2c_readResponse(unsigned char *pucBuffer, unsigned int uiLength)
 {
-        unsigned long       ulFlashStartAdr;
-        unsigned long       ulFlashEndAdr;
-        unsigned long       ulFlashAdrCnt;
-        const unsigned char abEraseBuf[1] = { 0xff };
-
+#if ASIC_TYP==ASIC_TYP_NETX500
+	unsigned long ulVal;
+	unsigned int  uiCnt;
+
+
+	uiCnt = 0;
+	while( uiCnt<uiLength )
+	{
+		/* read byte */
+		ulVal  = HOSTMSK(i2c_data_CMD1);
+
+		/* is this the first byte? */
+		if( uiCnt==0 )
+		{
+			/* yes -> prepend start data */
+			ulVal |= HOSTMSK(i2c_data_CMD2);
+		}
+
+		/* is this the last byte? */
+		if( (uiCnt+1)==uiLength )
+		{
+			/* yes -> append stop condition */
+			ulVal |= HOSTMSK(i2c_data_CMD0);
+		}
+
+		i2c_execute(ulVal);
+
+		/* get byte */
+		pucBuffer[uiCnt] = (unsigned char)(ptNetXI2CArea->ulData&HOSTMSK(i2c_data_DATA));
+
+		/* next byte */
+		++uiCnt;
+	}
+#else
+	(void)pucBuffer;
+	(void)uiLength;
+#endif
+}
 
-        /*  check for magic */
-        if( ulDataByteLen==0xffffffff )
-        {
-                uprintf("! Error: complete device magic is not supported for i2c eeproms\n");
-                return NETX_CONSOLEAPP_RESULT_ERROR;
-        }
 
-        ulFlashStartAdr = 0;
-        ulFlashEndAdr = ulFlashStartAdr + ulDataByteLen;
+/* Write uiLength bytes and finish with a stop condition. */
+static void i2c_writeData(const unsigned char *pucBuffer, unsigned int uiLength)
+{
+#if ASIC_TYP==ASIC_TYP_NETX500
+	unsigned long ulVal;
+	unsigned int uiCnt;
+
+
+	uiCnt = 0;
+	while( uiCnt<uiLength )
+	{
+		/* set data byte */
+		ulVal  = pucBuffer[uiCnt];
+
+		/* is this the last byte? */
+		if( (uiCnt+1)==uiLength )
+		{
+			/* yes -> append stop condition */
+			ulVal |= HOSTMSK(i2c_data_CMD0);
+		}
+
+		i2c_execute(ulVal);
+
+		/* next byte */
+		++uiCnt;
+	}
+#else
+	(void)pucBuffer;
+	(void)uiLength;
+#endif
+}
 
-        ulFlashAdrCnt = ulFlashStartAdr;
 
-        while( ulFlashStartAdr<ulFlashEndAdr )
-        {
-                /*  programm the byte */
-                i2c_sendAddress(ulFlashAdrCnt, 0);
-                i2c_writeData(abEraseBuf, 1);
-                i2c_pollAck(512);
+/* Wait until the internal write cycle of the EEPROM is finished.
+ * The netX500 I2C core does not report a missing ACK, so the device
+ * can not be polled. Wait for the maximum write cycle time instead.
+ */
+static void i2c_waitWriteCycle(const FLASHER_I2C_CONFIGURATION_T *ptCfg)
+{
+	unsigned long ulStartMs;
 
-                /*  next byte */
-                ++ulFlashAdrCnt;
-        }
 
-        /*  all ok */
-        return NETX_CONSOLEAPP_RESULT_OK;
+	ulStartMs = systime_get_ms();
+	while( systime_elapsed(ulStartMs, ptCfg->ulWriteCycleTimeMs)==0 ) {}
 }
 
 
-NETX_CONSOLEAPP_RESULT_T i2c_read(unsigned char *pbData, unsigned long ulDataByteLen)
+/* Write the area [ulStartAdr, ulEndAdr[ with page writes.
+ * If pucData is NULL, the area is filled with 0xff.
+ */
+static NETX_CONSOLEAPP_RESULT_T i2c_write_pages(const FLASHER_I2C_CONFIGURATION_T *ptCfg, unsigned long ulStartAdr, unsigned long ulEndAdr, const unsigned char *pucData)
 {
-  NETX_CONSOLEAPP_RESULT_T tResult;
-  unsigned long ulFlashStartAdr;
-
-
-  ulFlashStartAdr = 0;
+	unsigned long ulAdrCnt;
+	unsigned long ulChunkSize;
+	unsigned long ulPageLeft;
+
+
+	/* Page writes with fill data need a buffer of one page. */
+	if( pucData==NULL )
+	{
+		memset(aucI2cBuffer, 0xff, ptCfg->ulPageSize);
+	}
+
+	progress_bar_init(ulEndAdr-ulStartAdr);
+
+	ulAdrCnt = ulStartAdr;
+	while( ulAdrCnt<ulEndAdr )
+	{
+		/* Do not cross a page border. */
+		ulPageLeft = ptCfg->ulPageSize - (ulAdrCnt & (ptCfg->ulPageSize-1U));
+		ulChunkSize = ulEndAdr - ulAdrCnt;
+		if( ulChunkSize>ulPageLeft )
+		{
+			ulChunkSize = ulPageLeft;
+		}
+
+		i2c_sendAddress(ptCfg, ulAdrCnt, 0);
+		if( pucData==NULL )
+		{
+			i2c_writeData(aucI2cBuffer, ulChunkSize);
+		}
+		else
+		{
+			i2c_writeData(pucData, ulChunkSize);
+			pucData += ulChunkSize;
+		}
+		i2c_waitWriteCycle(ptCfg);
+
+		ulAdrCnt += ulChunkSize;
+		progress_bar_set_position(ulAdrCnt-ulStartAdr);
+	}
+
+	progress_bar_finalize();
+
+	return NETX_CONSOLEAPP_RESULT_OK;
+}
 
-  /*  read data */
-  tResult = i2c_read_with_progress(ulFlashStartAdr, ulDataByteLen, pbData);
-  
-  if( tResult!=NETX_CONSOLEAPP_RESULT_OK ) 
-  {
-     return tResult;
-  }
 
-  /*  all ok */
-  return NETX_CONSOLEAPP_RESULT_OK;
+/* Compare the area [ulStartAdr, ulEndAdr[ with pucData.
+ * return value:
+ *   NETX_CONSOLEAPP_RESULT_OK: equal
+ *   NETX_CONSOLEAPP_RESULT_ERROR: not equal
+ */
+static NETX_CONSOLEAPP_RESULT_T i2c_compare(const FLASHER_I2C_CONFIGURATION_T *ptCfg, unsigned long ulStartAdr, unsigned long ulEndAdr, const unsigned char *pucData)
+{
+	unsigned long ulAdrCnt;
+	unsigned long ulSegSize;
+	unsigned long ulCnt;
+
+
+	uprintf("# Verifying...\n");
+
+	progress_bar_init(ulEndAdr-ulStartAdr);
+
+	ulAdrCnt = ulStartAdr;
+	while( ulAdrCnt<ulEndAdr )
+	{
+		/* get the next segment */
+		ulSegSize = ulEndAdr - ulAdrCnt;
+		if( ulSegSize>I2C_SEGMENT_SIZE )
+		{
+			ulSegSize = I2C_SEGMENT_SIZE;
+		}
+
+		/* read the segment */
+		i2c_sendAddress(ptCfg, ulAdrCnt, 0);
+		i2c_readResponse(aucI2cBuffer, ulSegSize);
+
+		/* compare... */
+		if( memcmp(aucI2cBuffer, pucData, ulSegSize)!=0 )
+		{
+			for(ulCnt=0; ulCnt<ulSegSize; ++ulCnt)
+			{
+				if( aucI2cBuffer[ulCnt]!=pucData[ulCnt] )
+				{
+					break;
+				}
+			}
+			uprintf("! verify error at address 0x%08x. buffer: 0x%02x, eeprom: 0x%02x.\n", ulAdrCnt+ulCnt, pucData[ulCnt], aucI2cBuffer[ulCnt]);
+			return NETX_CONSOLEAPP_RESULT_ERROR;
+		}
+
+		/* next segment */
+		ulAdrCnt += ulSegSize;
+		pucData += ulSegSize;
+		progress_bar_set_position(ulAdrCnt-ulStartAdr);
+	}
+
+	progress_bar_finalize();
+
+	uprintf(". verify ok\n");
+	return NETX_CONSOLEAPP_RESULT_OK;
 }
 
 
-NETX_CONSOLEAPP_RESULT_T i2c_verify(const unsigned char *pbData, unsigned long ulDataByteLen)
+static int i2c_check_area(const FLASHER_I2C_CONFIGURATION_T *ptCfg, unsigned long ulStartAdr, unsigned long ulEndAdr)
 {
-  NETX_CONSOLEAPP_RESULT_T tResult;
-  unsigned long ulFlashStartAdr;
+	int iResult;
 
 
-  ulFlashStartAdr = 0;
+	iResult = 0;
+	if( ulStartAdr>ulEndAdr || ulEndAdr>ptCfg->ulSizeInBytes )
+	{
+		uprintf("! The area [0x%08x, 0x%08x[ exceeds the EEPROM size of 0x%08x bytes.\n", ulStartAdr, ulEndAdr, ptCfg->ulSizeInBytes);
+		iResult = -1;
+	}
 
-  /*  verify data */
-  tResult = i2c_verify_with_progress(ulFlashStartAdr, ulDataByteLen, pbData);
-  
-  if( tResult!=NETX_CONSOLEAPP_RESULT_OK ) 
-  {
-     return tResult;
-  }
-
-  /*  all ok */
-  return NETX_CONSOLEAPP_RESULT_OK;
+	return iResult;
 }
 
-
 /* ------------------------------------- */
 
-NETX_CONSOLEAPP_RESULT_T i2c_verify_with_progress(unsigned long ulFlashStartAdr, unsigned long ulDataByteLen, const unsigned char *pucDataStartAdr)
+NETX_CONSOLEAPP_RESULT_T i2c_detect(CMD_PARAMETER_DETECT_T *ptParameter)
 {
-  unsigned long       ulC, ulE;
-  const unsigned char *pucDC;
-  unsigned long       ulSegSize, ulMaxSegSize;
-
-
-  ulMaxSegSize = ReadBuffer_Size;
-
-  /*  loop over all data */
-  ulC   = ulFlashStartAdr;
-  ulE   = ulC + ulDataByteLen;
-  pucDC = pucDataStartAdr;
-
-  while( ulC<ulE ) 
-  {
-     /*  get the next segment, limit it to 'ulMaxSegSize' */
-     ulSegSize = ulE - ulC;
-     
-     if( ulSegSize>ulMaxSegSize ) 
-     {
-       ulSegSize = ulMaxSegSize;
-     }
-
-      /*  read the segment */
-      i2c_sendAddress(ulC, 0);
-      i2c_readResponse(pucReadBuffer, ulSegSize);
-
-      /*  compare... */
-      if( memcmp(pucReadBuffer, pucDC, ulSegSize)!=0 ) 
-      {
-        return NETX_CONSOLEAPP_RESULT_ERROR;
-      }
-
-      /*  next segment */
-      ulC += ulSegSize;
-      pucDC += ulSegSize;
-  }
-
-    /*  compare ok! */
-    return NETX_CONSOLEAPP_RESULT_OK;
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	const FLASHER_I2C_CONFIGURATION_T *ptCfg;
+	DEVICE_DESCRIPTION_T *ptDeviceDescription;
+	unsigned long ulPageSize;
+
+
+	ptCfg = &(ptParameter->uSourceParameter.tI2c);
+	ptDeviceDescription = ptParameter->ptDeviceDescription;
+
+	/* Be pessimistic. */
+	tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+
+	ulPageSize = ptCfg->ulPageSize;
+	if( ptCfg->uiUnit!=0 || ptCfg->uiChipSelect!=0 )
+	{
+		uprintf("! Invalid unit or chip select: %d/%d\n", ptCfg->uiUnit, ptCfg->uiChipSelect);
+	}
+	else if( ptCfg->ulDeviceAddress>0x7fU )
+	{
+		uprintf("! Invalid device address: 0x%08x\n", ptCfg->ulDeviceAddress);
+	}
+	else if( ptCfg->ulAddressBytes!=1 && ptCfg->ulAddressBytes!=2 )
+	{
+		uprintf("! Invalid number of address bytes: %d\n", ptCfg->ulAddressBytes);
+	}
+	else if( ptCfg->ulSizeInBytes==0 || ptCfg->ulSizeInBytes>(ptCfg->ulAddressBytes==1 ? 0x800U : 0x80000U) )
+	{
+		uprintf("! Invalid size: 0x%08x\n", ptCfg->ulSizeInBytes);
+	}
+	else if( ulPageSize==0 || ulPageSize>256U || (ulPageSize&(ulPageSize-1U))!=0 )
+	{
+		uprintf("! Invalid page size: 0x%08x\n", ulPageSize);
+	}
+	else
+	{
+		uprintf(". I2C EEPROM at 0x%02x: 0x%08x bytes, page size 0x%08x, %d address bytes\n", ptCfg->ulDeviceAddress, ptCfg->ulSizeInBytes, ulPageSize, ptCfg->ulAddressBytes);
+
+		/* Read the first byte to make sure the bus works. */
+		i2c_sendAddress(ptCfg, 0, 0);
+		i2c_readResponse(aucI2cBuffer, 1);
+
+		/* Set the result data. */
+		memcpy(&(ptDeviceDescription->uInfo.tI2cEeprom.tCfg), ptCfg, sizeof(FLASHER_I2C_CONFIGURATION_T));
+		ptDeviceDescription->fIsValid = 1;
+		ptDeviceDescription->sizThis = sizeof(DEVICE_DESCRIPTION_T);
+		ptDeviceDescription->ulVersion = FLASHER_INTERFACE_VERSION;
+		ptDeviceDescription->tSourceTyp = BUS_I2C;
+
+		tResult = NETX_CONSOLEAPP_RESULT_OK;
+	}
+
+	return tResult;
 }
 
 
-NETX_CONSOLEAPP_RESULT_T i2c_read_with_progress(unsigned long ulFlashStartAdr, unsigned long ulDataByteLen, unsigned char *pucDataStartAdr)
+/* An EEPROM can be written byte by byte, so the erase area is the
+ * requested area.
+ */
+NETX_CONSOLEAPP_RESULT_T i2c_getEraseArea(CMD_PARAMETER_GETERASEAREA_T *ptParameter)
 {
-  unsigned long ulC, ulE;
-  unsigned char *pucDC;
-  unsigned long ulSegSize, ulMaxSegSize;
-
-
-  ulMaxSegSize = ReadBuffer_Size;
-
-  /*  loop over all data */
-  ulC = ulFlashStartAdr;
-  ulE = ulC + ulDataByteLen;
-  pucDC = pucDataStartAdr;
-
-  while( ulC<ulE ) 
-  {
-          /*  get the next segment, limit it to 'ulMaxSegSize' */
-          ulSegSize = ulE - ulC;
-          if( ulSegSize>ulMaxSegSize ) 
-          {
-                  ulSegSize = ulMaxSegSize;
-          }
-
-          /*  read the segment */
-          i2c_sendAddress(ulC, 0);
-          i2c_readResponse(pucDC, ulSegSize);
-          
-          /*  next segment */
-          ulC += ulSegSize;
-          pucDC += ulSegSize;
-   }
-
-        /*  compare ok! */
-        return NETX_CONSOLEAPP_RESULT_OK;
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	const FLASHER_I2C_CONFIGURATION_T *ptCfg;
 
+
+	ptCfg = &(ptParameter->ptDeviceDescription->uInfo.tI2cEeprom.tCfg);
+
+	tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+	if( i2c_check_area(ptCfg, ptParameter->ulStartAdr, ptParameter->ulEndAdr)==0 )
+	{
+		tResult = NETX_CONSOLEAPP_RESULT_OK;
+	}
+
+	return tResult;
 }
 
 
-/* ------------------------------------- */
+NETX_CONSOLEAPP_RESULT_T i2c_isErased(const CMD_PARAMETER_ISERASED_T *ptParameter, NETX_CONSOLEAPP_PARAMETER_T *ptConsoleParams)
+{
+	const FLASHER_I2C_CONFIGURATION_T *ptCfg;
+	unsigned long ulStartAdr;
+	unsigned long ulEndAdr;
+	unsigned long ulAdrCnt;
+	unsigned long ulSegSize;
+	unsigned long ulCnt;
+	unsigned long ulErased;
+
+
+	ptCfg = &(ptParameter->ptDeviceDescription->uInfo.tI2cEeprom.tCfg);
+	ulStartAdr = ptParameter->ulStartAdr;
+	ulEndAdr = ptParameter->ulEndAdr;
+
+	if( i2c_check_area(ptCfg, ulStartAdr, ulEndAdr)!=0 )
+	{
+		return NETX_CONSOLEAPP_RESULT_ERROR;
+	}
+
+	uprintf("# Checking if empty...\n");
+	progress_bar_init(ulEndAdr-ulStartAdr);
+
+	ulErased = 0xffU;
+	ulAdrCnt = ulStartAdr;
+	while( ulAdrCnt<ulEndAdr && ulErased==0xffU )
+	{
+		ulSegSize = ulEndAdr - ulAdrCnt;
+		if( ulSegSize>I2C_SEGMENT_SIZE )
+		{
+			ulSegSize = I2C_SEGMENT_SIZE;
+		}
+
+		i2c_sendAddress(ptCfg, ulAdrCnt, 0);
+		i2c_readResponse(aucI2cBuffer, ulSegSize);
+
+		for(ulCnt=0; ulCnt<ulSegSize; ++ulCnt)
+		{
+			ulErased &= aucI2cBuffer[ulCnt];
+			if( ulErased!=0xffU )
+			{
+				uprintf("! Memory not erased at address 0x%08x - expected: 0x%02x found: 0x%02x\n", ulAdrCnt+ulCnt, 0xff, ulErased);
+				break;
+			}
+		}
+
+		ulAdrCnt += ulSegSize;
+		progress_bar_set_position(ulAdrCnt-ulStartAdr);
+	}
+
+	progress_bar_finalize();
+
+	if( ulErased==0xffU )
+	{
+		uprintf(". CLEAN! The area is erased.\n");
+	}
+	else
+	{
+		uprintf(". DIRTY! The area is not erased.\n");
+	}
+	ptConsoleParams->pvReturnMessage = (void*)ulErased;
+
+	return NETX_CONSOLEAPP_RESULT_OK;
+}
 
-void i2c_sendAddress(unsigned int uiParams, int iStopFlag)
+
+NETX_CONSOLEAPP_RESULT_T i2c_flash(const CMD_PARAMETER_FLASH_T *ptParameter)
 {
-#if ASIC_TYP==ASIC_TYP_NETX500
-  unsigned long ulVal;
-
-
-  /*  first byte of the command is the ID */
-  ulVal  = 0x50<<HOSTSRT(i2c_ctrl_ID);
-  
-  /*  set speed to max (HOSTMSK(i2c_ctrl_SPEED)) */
-  ulVal |= 4<<HOSTSRT(i2c_ctrl_SPEED);
-  
-  /*  enable i2c core (HOSTMSK(i2c_ctrl_ENABLE)) */
-  ulVal |= HOSTMSK(i2c_ctrl_ENABLE);
-  ptNetXI2CArea->ulCtrl = ulVal;
-
-  /*  send parameter data */
-
-
-  /*  first parameter byte */
-  ulVal  = (uiParams >> 8)&0xff;
-  
-  /*  prepend start data */
-  ulVal |= HOSTMSK(i2c_data_CMD2);
-  
-  /*  execute command */
-  ulVal |= HOSTMSK(i2c_data_CMD3);
-  ptNetXI2CArea->ulData = ulVal;
-
-  /*  wait for execution */
-  while( (ptNetXI2CArea->ulData&HOSTMSK(i2c_data_CMD3))!=0 ) {}
-
-
-  /*  second parameter byte */
-  ulVal  = uiParams&0xff;
-  
-  /*  execute command */
-  ulVal |= HOSTMSK(i2c_data_CMD3);
-  
-  /*  append stop condition? */
-  if( iStopFlag!=0 ) 
-  {
-          ulVal |= HOSTMSK(i2c_data_CMD0);
-  }
-  
-  ptNetXI2CArea->ulData = ulVal;
-
-  /*  wait for execution */
-  while( (ptNetXI2CArea->ulData&HOSTMSK(i2c_data_CMD3))!=0 ) {}
-#endif
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	const FLASHER_I2C_CONFIGURATION_T *ptCfg;
+	unsigned long ulStartAdr;
+	unsigned long ulEndAdr;
+
+
+	ptCfg = &(ptParameter->ptDeviceDescription->uInfo.tI2cEeprom.tCfg);
+	ulStartAdr = ptParameter->ulStartAdr;
+	ulEndAdr = ulStartAdr + ptParameter->ulDataByteSize;
+
+	tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+	if( i2c_check_area(ptCfg, ulStartAdr, ulEndAdr)==0 )
+	{
+		uprintf("#Writing...\n");
+		tResult = i2c_write_pages(ptCfg, ulStartAdr, ulEndAdr, ptParameter->pucData);
+		if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+		{
+			tResult = i2c_compare(ptCfg, ulStartAdr, ulEndAdr, ptParameter->pucData);
+		}
+	}
+
+	return tResult;
 }
 
 
-void i2c_readResponse(unsigned char *pucBuffer, unsigned int uiLength)
+NETX_CONSOLEAPP_RESULT_T i2c_erase(const CMD_PARAMETER_ERASE_T *ptParameter)
 {
-#if ASIC_TYP==ASIC_TYP_NETX500
-        unsigned long ulVal;
-        unsigned int  uiCnt;
-
-
-        uiCnt = 0;
-        while( uiCnt<uiLength ) 
-        {
-           /*  read byte */
-           ulVal  = HOSTMSK(i2c_data_CMD1);
-           
-           /*  execute command */
-           ulVal |= HOSTMSK(i2c_data_CMD3);
-
-          /*  is this the first byte? */
-          if( uiCnt==0 ) 
-          {
-             /*  yes -> prepend start data */
-             ulVal |= HOSTMSK(i2c_data_CMD2);
-          }
-          
-          /*  is this the last byte? */
-          if( (uiCnt+1)==uiLength ) 
-          {
-             /*  yes -> append stop condition */
-             ulVal |= HOSTMSK(i2c_data_CMD0);
-          }
-          
-          ptNetXI2CArea->ulData = ulVal;
-
-          /*  wait exec */
-          while( (ptNetXI2CArea->ulData&HOSTMSK(i2c_data_CMD3))!=0 ) {}
-
-          /*  get byte */
-          pucBuffer[uiCnt] = (unsigned char)(ptNetXI2CArea->ulData&HOSTMSK(i2c_data_DATA));
-
-          /*  next byte */
-          ++uiCnt;
-        }
-#endif
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	const FLASHER_I2C_CONFIGURATION_T *ptCfg;
+
+
+	ptCfg = &(ptParameter->ptDeviceDescription->uInfo.tI2cEeprom.tCfg);
+
+	tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+	if( i2c_check_area(ptCfg, ptParameter->ulStartAdr, ptParameter->ulEndAdr)==0 )
+	{
+		/* An EEPROM has no erase command. Fill the area with 0xff. */
+		uprintf("# Erasing...\n");
+		tResult = i2c_write_pages(ptCfg, ptParameter->ulStartAdr, ptParameter->ulEndAdr, NULL);
+	}
+
+	return tResult;
 }
 
 
-void i2c_writeData(const unsigned char *pucBuffer, unsigned int uiLength)
+NETX_CONSOLEAPP_RESULT_T i2c_read(const CMD_PARAMETER_READ_T *ptParameter)
 {
-#if ASIC_TYP==ASIC_TYP_NETX500
-        unsigned long ulVal;
-        unsigned int uiCnt;
-
-
-        uiCnt = 0;
-        while( uiCnt<uiLength ) 
-        {
-           /*  set data byte */
-           ulVal  = pucBuffer[uiCnt];
-           
-           /*  execute command */
-           ulVal |= HOSTMSK(i2c_data_CMD3);
-
-           /*  is this the last byte? */
-           if( (uiCnt+1)==uiLength ) 
-           {
-                   /*  yes -> append stop condition */
-                   ulVal |= HOSTMSK(i2c_data_CMD0);
-           }
-           
-           ptNetXI2CArea->ulData = ulVal;
-
-           /*  wait exec */
-           while( (ptNetXI2CArea->ulData&HOSTMSK(i2c_data_CMD3))!=0 ) {}
-
-           /*  next byte */
-           ++uiCnt;
-        }
-#endif
+	const FLASHER_I2C_CONFIGURATION_T *ptCfg;
+	unsigned long ulStartAdr;
+	unsigned long ulEndAdr;
+	unsigned long ulAdrCnt;
+	unsigned long ulSegSize;
+	unsigned char *pucData;
+
+
+	ptCfg = &(ptParameter->ptDeviceDescription->uInfo.tI2cEeprom.tCfg);
+	ulStartAdr = ptParameter->ulStartAdr;
+	ulEndAdr = ptParameter->ulEndAdr;
+	pucData = ptParameter->pucData;
+
+	if( i2c_check_area(ptCfg, ulStartAdr, ulEndAdr)!=0 )
+	{
+		return NETX_CONSOLEAPP_RESULT_ERROR;
+	}
+
+	uprintf("# Reading...\n");
+	progress_bar_init(ulEndAdr-ulStartAdr);
+
+	/* Read directly to the destination buffer. The segments are only
+	 * used to update the progress bar.
+	 */
+	ulAdrCnt = ulStartAdr;
+	while( ulAdrCnt<ulEndAdr )
+	{
+		ulSegSize = ulEndAdr - ulAdrCnt;
+		if( ulSegSize>I2C_SEGMENT_SIZE )
+		{
+			ulSegSize = I2C_SEGMENT_SIZE;
+		}
+
+		i2c_sendAddress(ptCfg, ulAdrCnt, 0);
+		i2c_readResponse(pucData, ulSegSize);
+
+		ulAdrCnt += ulSegSize;
+		pucData += ulSegSize;
+		progress_bar_set_position(ulAdrCnt-ulStartAdr);
+	}
+
+	progress_bar_finalize();
+
+	return NETX_CONSOLEAPP_RESULT_OK;
 }
 
 
-void i2c_pollAck(unsigned int uiAckCnt)
+/* if return value is NETX_CONSOLEAPP_RESULT_OK,
+   the value stored in ptConsoleParams->pvReturnMessage is the result of the comparison.
+   0 = equal, 1 = not equal
+*/
+NETX_CONSOLEAPP_RESULT_T i2c_verify(const CMD_PARAMETER_VERIFY_T *ptParameter, NETX_CONSOLEAPP_PARAMETER_T *ptConsoleParams)
 {
-#if ASIC_TYP==ASIC_TYP_NETX500
-        unsigned long ulVal;
+	const FLASHER_I2C_CONFIGURATION_T *ptCfg;
+	NETX_CONSOLEAPP_RESULT_T tEqual;
 
 
-        /*  ack polling can't be done with netX500 :( */
-        i2c_sendAddress(0, 0);
-        ulVal = HOSTMSK(i2c_data_CMD1)|HOSTMSK(i2c_data_CMD3);
-        do {
-                /*  send dummy byte */
-                ptNetXI2CArea->ulData = ulVal;
+	ptCfg = &(ptParameter->ptDeviceDescription->uInfo.tI2cEeprom.tCfg);
 
-                /*  wait exec */
-                while( (ptNetXI2CArea->ulData&HOSTMSK(i2c_data_CMD3))!=0 ) {}
-        } while( --uiAckCnt!=0 );
+	if( i2c_check_area(ptCfg, ptParameter->ulStartAdr, ptParameter->ulEndAdr)!=0 )
+	{
+		return NETX_CONSOLEAPP_RESULT_ERROR;
+	}
 
-        /*  send stop condition */
-        ulVal = HOSTMSK(i2c_data_CMD0)|HOSTMSK(i2c_data_CMD1)|HOSTMSK(i2c_data_CMD3);
-        ptNetXI2CArea->ulData = ulVal;
+	tEqual = i2c_compare(ptCfg, ptParameter->ulStartAdr, ptParameter->ulEndAdr, ptParameter->pucData);
+	ptConsoleParams->pvReturnMessage = (void*)tEqual;
 
-        /*  wait exec */
-        while( (ptNetXI2CArea->ulData&HOSTMSK(i2c_data_CMD3))!=0 ) {}
-#endif
+	return NETX_CONSOLEAPP_RESULT_OK;
 }
 
+
+#if CFG_INCLUDE_SHA1!=0
+NETX_CONSOLEAPP_RESULT_T i2c_sha1(const CMD_PARAMETER_CHECKSUM_T *ptParameter, SHA_CTX *ptSha1Context)
+{
+	const FLASHER_I2C_CONFIGURATION_T *ptCfg;
+	unsigned long ulStartAdr;
+	unsigned long ulEndAdr;
+	unsigned long ulAdrCnt;
+	unsigned long ulSegSize;
+
+
+	ptCfg = &(ptParameter->ptDeviceDescription->uInfo.tI2cEeprom.tCfg);
+	ulStartAdr = ptParameter->ulStartAdr;
+	ulEndAdr = ptParameter->ulEndAdr;
+
+	if( i2c_check_area(ptCfg, ulStartAdr, ulEndAdr)!=0 )
+	{
+		return NETX_CONSOLEAPP_RESULT_ERROR;
+	}
+
+	uprintf("# Calculating checksum...\n");
+	progress_bar_init(ulEndAdr-ulStartAdr);
+
+	ulAdrCnt = ulStartAdr;
+	while( ulAdrCnt<ulEndAdr )
+	{
+		ulSegSize = ulEndAdr - ulAdrCnt;
+		if( ulSegSize>I2C_SEGMENT_SIZE )
+		{
+			ulSegSize = I2C_SEGMENT_SIZE;
+		}
+
+		i2c_sendAddress(ptCfg, ulAdrCnt, 0);
+		i2c_readResponse(aucI2cBuffer, ulSegSize);
+		SHA1_Update(ptSha1Context, aucI2cBuffer, ulSegSize);
+
+		ulAdrCnt += ulSegSize;
+		progress_bar_set_position(ulAdrCnt-ulStartAdr);
+	}
+
+	progress_bar_finalize();
+	uprintf(". hash done\n");
+
+	return NETX_CONSOLEAPP_RESULT_OK;
+}
+#endif
@@ -18,15 +18,26 @@
  *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
  ***************************************************************************/
 
+
 #include "netx_consoleapp.h"
+#include "flasher_interface.h"
+#if CFG_INCLUDE_SHA1!=0
+#       include "sha1.h"
+#endif
 
 
 #ifndef __FLASHER_I2C_H__
 #define __FLASHER_I2C_H__
 
-NETX_CONSOLEAPP_RESULT_T i2c_flash (const unsigned char *pbData, unsigned long ulDataByteLen);
-NETX_CONSOLEAPP_RESULT_T i2c_erase (unsigned long       ulDataByteLen);
-NETX_CONSOLEAPP_RESULT_T i2c_read  (unsigned char       *pbData, unsigned long ulDataByteLen);
-NETX_CONSOLEAPP_RESULT_T i2c_verify(const unsigned char *pbData, unsigned long ulDataByteLen);
+NETX_CONSOLEAPP_RESULT_T i2c_detect(CMD_PARAMETER_DETECT_T *ptParameter);
+NETX_CONSOLEAPP_RESULT_T i2c_getEraseArea(CMD_PARAMETER_GETERASEAREA_T *ptParameter);
+NETX_CONSOLEAPP_RESULT_T i2c_isErased(const CMD_PARAMETER_ISERASED_T *ptParameter, NETX_CONSOLEAPP_PARAMETER_T *ptConsoleParams);
+NETX_CONSOLEAPP_RESULT_T i2c_flash(const CMD_PARAMETER_FLASH_T *ptParameter);
+NETX_CONSOLEAPP_RESULT_T i2c_erase(const CMD_PARAMETER_ERASE_T *ptParameter);
+NETX_CONSOLEAPP_RESULT_T i2c_read(const CMD_PARAMETER_READ_T *ptParameter);
+NETX_CONSOLEAPP_RESULT_T i2c_verify(const CMD_PARAMETER_VERIFY_T *ptParameter, NETX_CONSOLEAPP_PARAMETER_T *ptConsoleParams);
+#if CFG_INCLUDE_SHA1!=0
+NETX_CONSOLEAPP_RESULT_T i2c_sha1(const CMD_PARAMETER_CHECKSUM_T *ptParameter, SHA_CTX *ptSha1Context);
+#endif
 
 #endif  // __FLASHER_I2C_H__
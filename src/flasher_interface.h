@@ -25,6 +25,7 @@
 #include <string.h>
 
 #include "cfi_flash.h"
+#include "i2c_eeprom.h"
 #include "internal_flash/internal_flash.h"
 #include "spi_flash.h"
 #include "spi_macro_player.h"
@@ -33,7 +34,8 @@
 #endif
 /*-------------------------------------*/
 
-#define FLASHER_INTERFACE_VERSION 0x00040000
+/* Change this when the layout of the parameters or the device description changes. */
+#define FLASHER_INTERFACE_VERSION 0x00050000
 
 
 typedef enum BUS_ENUM
@@ -41,7 +43,8 @@ typedef enum BUS_ENUM
 	BUS_ParFlash                    = 0,    /* Parallel flash */
 	BUS_SPI                         = 1,    /* Serial flash on SPI bus. */
 	BUS_IFlash                      = 2,    /* Internal flash. */
-	BUS_SDIO                        = 3     /* SDIO */
+	BUS_SDIO                        = 3,    /* SDIO */
+	BUS_I2C                         = 4     /* EEPROM on I2C bus. */
 } BUS_T;
 
 typedef enum OPERATION_MODE_ENUM
@@ -60,10 +63,25 @@ typedef enum OPERATION_MODE_ENUM
 	OPERATION_MODE_Identify         = 11,    /* Blink the status LED for 5 seconds to visualy identify the hardware */
 	OPERATION_MODE_SmartErase       = 12,    /* Erase an area using variable erase block sizes */
 	OPERATION_MODE_Reset            = 13,    /* Reset the netX chip using a watchdog reset */
-	OPERATION_MODE_GetFlashSize		= 14	 /* Get the supported and the actual sizes in byte */
+	OPERATION_MODE_GetFlashSize		= 14,	 /* Get the supported and the actual sizes in byte */
+	OPERATION_MODE_FlashCompressed  = 15,    /* Decompress an LZ4 block into the buffer and write it to flash. */
+	OPERATION_MODE_ChecksumRanges   = 16,    /* build one checksum for each region of a specified area of a device */
+	OPERATION_MODE_VerifyBatch      = 17,    /* run a list of verify and isErased jobs on several devices */
+	OPERATION_MODE_FlashBatch       = 18     /* erase and flash several SPI flashes at the same time */
 } OPERATION_MODE_T;
 
 
+/* The bus specific parameters of the detect command. */
+typedef union DETECT_SOURCE_PARAMETER_UNION
+{
+	PARFLASH_CONFIGURATION_T tParFlash;
+	FLASHER_SPI_CONFIGURATION_T tSpi;
+	INTERNAL_FLASH_CONFIGURATION_T tInternalFlash;
+	FLASHER_I2C_CONFIGURATION_T tI2c;
+	//SDIO_OPTIONS_T tSdioOptions;
+} DETECT_SOURCE_PARAMETER_T;
+
+
 typedef struct DEVICE_DESCRIPTION_STRUCT
 {
 	int fIsValid;                           /* a value of !=0 means the description is valid */
@@ -75,11 +93,23 @@ typedef struct DEVICE_DESCRIPTION_STRUCT
 	{
 		FLASH_DEVICE_T tParFlash;
 		FLASHER_SPI_FLASH_T tSpiInfo;
+		FLASHER_SPI_STRIPED_FLASH_T tSpiStripedInfo;  /* tSpiInfo is the logical flash, see FLASHER_SPI_FLAGS_T. */
 		INTERNAL_FLASH_T tInternalFlashInfo;
 #ifdef CFG_INCLUDE_SDIO
 		SDIO_HANDLE_T tSdioHandle;
+#endif
+#ifdef CFG_INCLUDE_I2C
+		FLASHER_I2C_EEPROM_T tI2cEeprom;
 #endif
 	} uInfo;
+
+	/* A copy of the detect parameters which produced this description.
+	 * The description stays in the buffer area between two calls. The
+	 * host compares the copy with its own detect parameters to reuse a
+	 * description from a resident flasher instead of detecting again.
+	 */
+	DETECT_SOURCE_PARAMETER_T uDetectParameter;
+	uint32_t ulDetectFlags;
 } DEVICE_DESCRIPTION_T;
 
 
@@ -97,6 +127,21 @@ typedef struct CMD_PARAMETER_FLASH_STRUCT
 } CMD_PARAMETER_FLASH_T;
 
 
+/*
+    tFlash describes the data after decompression. pucData is the buffer
+    which receives the decompressed data.
+    pucCompressedData points to an LZ4 block. It may be placed at the end
+    of the buffer, the decoder checks that it is not overwritten too early.
+*/
+
+typedef struct CMD_PARAMETER_FLASH_COMPRESSED_STRUCT
+{
+	CMD_PARAMETER_FLASH_T tFlash;
+	unsigned long ulCompressedByteSize;
+	const unsigned char *pucCompressedData;
+} CMD_PARAMETER_FLASH_COMPRESSED_T;
+
+
 typedef struct CMD_PARAMETER_ERASE_STRUCT
 {
 	const DEVICE_DESCRIPTION_T *ptDeviceDescription;
@@ -138,16 +183,26 @@ typedef struct CMD_PARAMETER_CHECKSUM_STRUCT
 } CMD_PARAMETER_CHECKSUM_T;
 
 
+/*
+    The area [ulStartAdr, ulEndAdr[ is split into regions of ulRegionSize
+    bytes. The last region may be shorter. The SHA1 of each region is
+    written to pucDigests, 20 bytes per region.
+*/
+
+typedef struct CMD_PARAMETER_CHECKSUM_RANGES_STRUCT
+{
+	const DEVICE_DESCRIPTION_T *ptDeviceDescription;
+	unsigned long ulStartAdr;
+	unsigned long ulEndAdr;
+	unsigned long ulRegionSize;
+	unsigned char *pucDigests;
+} CMD_PARAMETER_CHECKSUM_RANGES_T;
+
+
 typedef struct CMD_PARAMETER_DETECT_STRUCT
 {
 	BUS_T tSourceTyp;
-	union
-	{
-		PARFLASH_CONFIGURATION_T tParFlash;
-		FLASHER_SPI_CONFIGURATION_T tSpi;
-		INTERNAL_FLASH_CONFIGURATION_T tInternalFlash;
-		//SDIO_OPTIONS_T tSdioOptions;
-	} uSourceParameter;
+	DETECT_SOURCE_PARAMETER_T uSourceParameter;
 	DEVICE_DESCRIPTION_T *ptDeviceDescription;
 	uint32_t ulFlags;
 } CMD_PARAMETER_DETECT_T;
@@ -161,6 +216,73 @@ typedef struct CMD_PARAMETER_ISERASED_STRUCT
 } CMD_PARAMETER_ISERASED_T;
 
 
+typedef enum VERIFY_BATCH_OPERATION_ENUM
+{
+	VERIFY_BATCH_OPERATION_Verify   = 0,     /* compare the flash with pucData */
+	VERIFY_BATCH_OPERATION_IsErased = 1      /* check if the area is erased, pucData is not used */
+} VERIFY_BATCH_OPERATION_T;
+
+/*
+    One job of a verify batch. Each job has its own device description, so
+    one batch can cover several detected devices. ulReturnMessage is the
+    same value which the single verify or isErased command returns.
+    ulResult is NETX_CONSOLEAPP_RESULT_OK if the job could be executed.
+*/
+
+typedef struct VERIFY_BATCH_JOB_STRUCT
+{
+	const DEVICE_DESCRIPTION_T *ptDeviceDescription;
+	VERIFY_BATCH_OPERATION_T tOperation;
+	unsigned long ulStartAdr;
+	unsigned long ulEndAdr;
+	unsigned char *pucData;
+	unsigned long ulResult;
+	unsigned long ulReturnMessage;
+} VERIFY_BATCH_JOB_T;
+
+
+typedef struct CMD_PARAMETER_VERIFY_BATCH_STRUCT
+{
+	VERIFY_BATCH_JOB_T *ptJobs;
+	unsigned long ulJobCount;
+} CMD_PARAMETER_VERIFY_BATCH_T;
+
+
+typedef enum FLASH_BATCH_OPERATION_ENUM
+{
+	FLASH_BATCH_OPERATION_Erase = 0,     /* erase the area, it must be aligned to the erase blocks */
+	FLASH_BATCH_OPERATION_Flash = 1      /* write and verify pucData */
+} FLASH_BATCH_OPERATION_T;
+
+/* The maximum number of jobs in one flash batch. */
+#define FLASH_BATCH_MAX_JOBS 64
+
+/*
+    One job of a flash batch. The jobs of one device run in the order of
+    the table. The jobs of different devices run at the same time: while
+    one flash is busy, the next page or sector is started on another one.
+    Only SPI flashes are supported. ulResult is NETX_CONSOLEAPP_RESULT_OK
+    if the job was completed.
+*/
+
+typedef struct FLASH_BATCH_JOB_STRUCT
+{
+	const DEVICE_DESCRIPTION_T *ptDeviceDescription;
+	FLASH_BATCH_OPERATION_T tOperation;
+	unsigned long ulStartAdr;
+	unsigned long ulEndAdr;
+	unsigned char *pucData;
+	unsigned long ulResult;
+} FLASH_BATCH_JOB_T;
+
+
+typedef struct CMD_PARAMETER_FLASH_BATCH_STRUCT
+{
+	FLASH_BATCH_JOB_T *ptJobs;
+	unsigned long ulJobCount;
+} CMD_PARAMETER_FLASH_BATCH_T;
+
+
 typedef struct CMD_PARAMETER_GETERASEAREA_STRUCT
 {
 	const DEVICE_DESCRIPTION_T *ptDeviceDescription;
@@ -193,13 +315,17 @@ typedef struct tFlasherInputParameter_STRUCT
 	union
 	{
 		CMD_PARAMETER_FLASH_T tFlash;
+		CMD_PARAMETER_FLASH_COMPRESSED_T tFlashCompressed;
 		CMD_PARAMETER_ERASE_T tErase;
 		CMD_PARAMETER_SMART_ERASE_T tSmartErase;
 		CMD_PARAMETER_READ_T tRead;
 		CMD_PARAMETER_VERIFY_T tVerify;
 		CMD_PARAMETER_CHECKSUM_T tChecksum;
+		CMD_PARAMETER_CHECKSUM_RANGES_T tChecksumRanges;
 		CMD_PARAMETER_DETECT_T tDetect;
 		CMD_PARAMETER_ISERASED_T tIsErased;
+		CMD_PARAMETER_VERIFY_BATCH_T tVerifyBatch;
+		CMD_PARAMETER_FLASH_BATCH_T tFlashBatch;
 		CMD_PARAMETER_GETERASEAREA_T tGetEraseArea;
 		CMD_PARAMETER_GETBOARDINFO_T tGetBoardInfo;
 		CMD_PARAMETER_SPIMACROPLAYER_T tSpiMacroPlayer;
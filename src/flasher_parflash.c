@@ -53,6 +53,13 @@
 #endif /* CFG_DEBUGMSG!=0 */
 
 
+/* This is the maximum number of sectors passed to one call of
+ * pfnEraseSectors. It only limits the time between two progress updates,
+ * the driver splits the range further if the device requires this.
+ */
+#define PARFLASH_ERASE_SECTORS_PER_BATCH 32U
+
+
 
 #if ASIC_TYP==ASIC_TYP_NETX500 || ASIC_TYP==ASIC_TYP_NETX100 || ASIC_TYP==ASIC_TYP_NETX50
 /* in: ptCfg->uiChipSelect
@@ -638,6 +645,7 @@ NETX_CONSOLEAPP_RESULT_T parflash_flash(const CMD_PARAMETER_FLASH_T *ptParameter
 	unsigned long ulSectorOffset;
 	
 	unsigned long ulChunkSize;
+	unsigned long ulSkippedBytes;
 	FLASH_ERRORS_E tFlashError;
 
 	ulFlashStartAdr = ptParameter->ulStartAdr;
@@ -651,6 +659,7 @@ NETX_CONSOLEAPP_RESULT_T parflash_flash(const CMD_PARAMETER_FLASH_T *ptParameter
 		uprintf("#Writing...\n");
 		progress_bar_init(ulDataByteSize);
 		ulProgressBarPosition = 0;
+		ulSkippedBytes = 0;
 		
 		while( ulDataByteSize!=0 )
 		{
@@ -670,7 +679,7 @@ NETX_CONSOLEAPP_RESULT_T parflash_flash(const CMD_PARAMETER_FLASH_T *ptParameter
 			}
 	
 			DEBUGMSG(ZONE_VERBOSE, ("Flashing [0x%08x, 0x%08x[\n", ulFlashStartAdr, ulFlashStartAdr+ulChunkSize));
-			tFlashError = ptFlashDescription->tFlashFunctions.pfnProgram(ptFlashDescription, ulFlashStartAdr, ulChunkSize, pucDataStartAdr);
+			tFlashError = ptFlashDescription->tFlashFunctions.pfnProgram(ptFlashDescription, ulFlashStartAdr, ulChunkSize, pucDataStartAdr, &ulSkippedBytes);
 			if( tFlashError!=eFLASH_NO_ERROR )
 			{
 				/* failed to program the sector */
@@ -688,6 +697,9 @@ NETX_CONSOLEAPP_RESULT_T parflash_flash(const CMD_PARAMETER_FLASH_T *ptParameter
 			progress_bar_set_position(ulProgressBarPosition);
 		}
 		progress_bar_finalize();
+
+		/* Erased data is not programmed, it is still checked by the compare below. */
+		uprintf(". Skipped 0x%08x bytes of erased data.\n", ulSkippedBytes);
 	}
 		
 	if (tResult == NETX_CONSOLEAPP_RESULT_OK)
@@ -712,6 +724,8 @@ NETX_CONSOLEAPP_RESULT_T parflash_erase(const CMD_PARAMETER_ERASE_T *ptParameter
 	const SECTOR_INFO_T *ptSectors;
 	FLASH_ERRORS_E tFlashError;
 	size_t sizCnt;
+	size_t sizBatchEnd;
+	unsigned long ulBatchSize;
 
 	ulEraseStartAdr = ptParameter->ulStartAdr;
 	ulEraseEndAdr   = ptParameter->ulEndAdr;
@@ -741,23 +755,42 @@ NETX_CONSOLEAPP_RESULT_T parflash_erase(const CMD_PARAMETER_ERASE_T *ptParameter
 		ptSectors = ptFlashDescription->atSectors;
 		do
 		{
-			DEBUGMSG(ZONE_VERBOSE, (". Erasing sector %d: [0x%08x, 0x%08x[\n", 
-				sizCnt, ptSectors[sizCnt].ulOffset,ptSectors[sizCnt].ulOffset+ptSectors[sizCnt].ulSize));
-			tFlashError = ptFlashDescription->tFlashFunctions.pfnErase(ptFlashDescription, sizCnt);
+			/* Collect the sectors for the next erase operation. */
+			sizBatchEnd = sizCnt;
+			ulBatchSize = 0;
+			do
+			{
+				ulBatchSize += ptSectors[sizBatchEnd].ulSize;
+				++sizBatchEnd;
+			} while( ptFlashDescription->tFlashFunctions.pfnEraseSectors!=NULL &&
+			         sizBatchEnd-sizCnt<PARFLASH_ERASE_SECTORS_PER_BATCH &&
+			         sizBatchEnd<ptFlashDescription->ulSectorCnt &&
+			         ptSectors[sizBatchEnd].ulOffset<ulEraseEndAdr );
+
+			DEBUGMSG(ZONE_VERBOSE, (". Erasing sectors %d-%d: [0x%08x, 0x%08x[\n", 
+				sizCnt, sizBatchEnd-1, ptSectors[sizCnt].ulOffset, ptSectors[sizCnt].ulOffset+ulBatchSize));
+			if( ptFlashDescription->tFlashFunctions.pfnEraseSectors!=NULL )
+			{
+				tFlashError = ptFlashDescription->tFlashFunctions.pfnEraseSectors(ptFlashDescription, sizCnt, sizBatchEnd-sizCnt);
+			}
+			else
+			{
+				tFlashError = ptFlashDescription->tFlashFunctions.pfnErase(ptFlashDescription, sizCnt);
+			}
 			if( tFlashError!=eFLASH_NO_ERROR )
 			{
-				/* failed to erase the sector */
-				uprintf(". failed to erase flash sector %d\n", sizCnt);
+				/* failed to erase the sectors */
+				uprintf(". failed to erase flash sectors %d-%d\n", sizCnt, sizBatchEnd-1);
 				tResult = NETX_CONSOLEAPP_RESULT_ERROR;
 				break;
 			}
 			
 			/* Show progress */
-			ulProgressBarPosition += ptSectors[sizCnt].ulSize;
+			ulProgressBarPosition += ulBatchSize;
 			progress_bar_set_position(ulProgressBarPosition);
 			
 			/* Next sector. */
-			++sizCnt;
+			sizCnt = sizBatchEnd;
 			
 		} while( sizCnt<ptFlashDescription->ulSectorCnt && ptSectors[sizCnt].ulOffset<ulEraseEndAdr );
 		uprintf(". Erase complete.\n");
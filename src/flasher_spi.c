@@ -47,6 +47,170 @@ unsigned char pucSpiBuffer[SPI_BUFFER_SIZE];
 
 /*-----------------------------------*/
 
+/* Access to single and striped flashes.
+ *
+ * A striped flash is the logical view of two identical chips (see
+ * FLASHER_SPI_STRIPED_FLASH_T). The functions below map a logical address
+ * to the chip and its address. All other functions in this file only work
+ * on logical addresses.
+ *
+ * A program or erase on one chip is only started and not waited for. The
+ * next access to the same chip waits until it is ready. Consecutive pages
+ * alternate between the chips, so one chip programs while the next page is
+ * sent to the other one.
+ */
+
+/* Get the chip and its address for a logical address of a striped flash.
+ * The chip is ready and its clock is set when the function returns.
+ */
+static const FLASHER_SPI_FLASH_T *spi_stripe_select(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulAddress, unsigned long *pulChipAddress, int *piResult)
+{
+	const FLASHER_SPI_FLASH_T *ptChip;
+	unsigned long ulPageSize;
+	unsigned long ulPage;
+
+
+	ulPageSize = ptFlash->tAttributes.ulPageSize;
+	ulPage = ulAddress / ulPageSize;
+	ptChip = &(((const FLASHER_SPI_STRIPED_FLASH_T*)ptFlash)->atChip[ulPage & 1U]);
+	*pulChipAddress = (ulPage >> 1U) * ulPageSize + (ulAddress % ulPageSize);
+
+	/* The chips can be on the same unit with a different clock. */
+	Drv_SpiRestoreSpeed(ptChip);
+	*piResult = Drv_SpiWaitForReady(ptChip);
+
+	return ptChip;
+}
+
+
+/* Wait until all running operations of a striped flash are finished. */
+static int spi_stripe_wait_idle(const FLASHER_SPI_FLASH_T *ptFlash)
+{
+	const FLASHER_SPI_STRIPED_FLASH_T *ptStriped;
+	unsigned int uiChip;
+	int iResult;
+
+
+	iResult = 0;
+	if( ptFlash->fIsStriped!=0 )
+	{
+		ptStriped = (const FLASHER_SPI_STRIPED_FLASH_T*)ptFlash;
+		for(uiChip=0; uiChip<2U && iResult==0; ++uiChip)
+		{
+			Drv_SpiRestoreSpeed(&(ptStriped->atChip[uiChip]));
+			iResult = Drv_SpiWaitForReady(&(ptStriped->atChip[uiChip]));
+		}
+	}
+
+	return iResult;
+}
+
+
+static int spi_read_flash(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulAddress, unsigned char *pucData, size_t sizData)
+{
+	const FLASHER_SPI_FLASH_T *ptChip;
+	unsigned long ulChipAddress;
+	unsigned long ulPageSize;
+	size_t sizChunk;
+	int iResult;
+
+
+	if( ptFlash->fIsStriped==0 )
+	{
+		iResult = Drv_SpiReadFlash(ptFlash, ulAddress, pucData, sizData);
+	}
+	else
+	{
+		/* Read up to the end of each logical page from its chip. */
+		ulPageSize = ptFlash->tAttributes.ulPageSize;
+		iResult = 0;
+		while( sizData!=0 && iResult==0 )
+		{
+			sizChunk = ulPageSize - (ulAddress % ulPageSize);
+			if( sizChunk>sizData )
+			{
+				sizChunk = sizData;
+			}
+
+			ptChip = spi_stripe_select(ptFlash, ulAddress, &ulChipAddress, &iResult);
+			if( iResult==0 )
+			{
+				iResult = Drv_SpiReadFlash(ptChip, ulChipAddress, pucData, sizChunk);
+			}
+
+			ulAddress += sizChunk;
+			pucData += sizChunk;
+			sizData -= sizChunk;
+		}
+	}
+
+	return iResult;
+}
+
+
+/* Program one complete page. For a striped flash this only starts the
+ * program operation on the chip.
+ */
+static int spi_write_page(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulAddress, const unsigned char *pucData, size_t sizData)
+{
+	const FLASHER_SPI_FLASH_T *ptChip;
+	unsigned long ulChipAddress;
+	int iResult;
+
+
+	if( ptFlash->fIsStriped==0 )
+	{
+		iResult = Drv_SpiWritePage(ptFlash, ulAddress, pucData, sizData);
+	}
+	else
+	{
+		ptChip = spi_stripe_select(ptFlash, ulAddress, &ulChipAddress, &iResult);
+		if( iResult==0 )
+		{
+			iResult = Drv_SpiStartWritePage(ptChip, ulChipAddress, pucData, sizData);
+		}
+	}
+
+	return iResult;
+}
+
+
+/* Erase one sector. A sector of a striped flash is one sector on each
+ * chip. Both erase operations are started and run at the same time.
+ */
+static int spi_erase_sector(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulAddress)
+{
+	const FLASHER_SPI_STRIPED_FLASH_T *ptStriped;
+	const FLASHER_SPI_FLASH_T *ptChip;
+	unsigned int uiChip;
+	int iResult;
+
+
+	if( ptFlash->fIsStriped==0 )
+	{
+		iResult = Drv_SpiEraseFlashSector(ptFlash, ulAddress);
+	}
+	else
+	{
+		ptStriped = (const FLASHER_SPI_STRIPED_FLASH_T*)ptFlash;
+		iResult = 0;
+		for(uiChip=0; uiChip<2U && iResult==0; ++uiChip)
+		{
+			ptChip = &(ptStriped->atChip[uiChip]);
+			Drv_SpiRestoreSpeed(ptChip);
+			iResult = Drv_SpiWaitForReady(ptChip);
+			if( iResult==0 )
+			{
+				iResult = Drv_SpiStartEraseFlashSector(ptChip, ulAddress / 2U);
+			}
+		}
+	}
+
+	return iResult;
+}
+
+/*-----------------------------------*/
+
 static NETX_CONSOLEAPP_RESULT_T spi_write_with_progress(const FLASHER_SPI_FLASH_T *ptFlashDev, unsigned long ulFlashStartAdr, unsigned long ulDataByteLen, const unsigned char *pucDataStartAdr)
 {
 	const unsigned char *pucDC;
@@ -104,7 +268,7 @@ static NETX_CONSOLEAPP_RESULT_T spi_write_with_progress(const FLASHER_SPI_FLASH_
 			}
 
 			/* read the whole page */
-			iResult = Drv_SpiReadFlash(ptFlashDev, ulPageStartAdr, pucSpiBuffer, ulPageSize);
+			iResult = spi_read_flash(ptFlashDev, ulPageStartAdr, pucSpiBuffer, ulPageSize);
 			if( iResult!=0 )
 			{
 				tResult = NETX_CONSOLEAPP_RESULT_ERROR;
@@ -115,7 +279,7 @@ static NETX_CONSOLEAPP_RESULT_T spi_write_with_progress(const FLASHER_SPI_FLASH_
 				memcpy(pucSpiBuffer+ulOffset, pucDC, ulSegSize);
 
 				/* write the modified buffer */
-				iResult = Drv_SpiWritePage(ptFlashDev, ulPageStartAdr, pucSpiBuffer, ulPageSize);
+				iResult = spi_write_page(ptFlashDev, ulPageStartAdr, pucSpiBuffer, ulPageSize);
 /*				iResult = Drv_SpiEraseAndWritePage(ptFlashDev, ulPageStartAdr, ulPageSize, pucSpiBuffer); */
 				if( iResult!=0 )
 				{
@@ -141,7 +305,7 @@ static NETX_CONSOLEAPP_RESULT_T spi_write_with_progress(const FLASHER_SPI_FLASH_
 			while( ulC+ulPageSize<ulE )
 			{
 				/* write one page */
-				iResult = Drv_SpiWritePage(ptFlashDev, ulC, pucDC, ulPageSize);
+				iResult = spi_write_page(ptFlashDev, ulC, pucDC, ulPageSize);
 /*				iResult = Drv_SpiEraseAndWritePage(ptFlashDev, ulC, ulPageSize, pucDC); */
 				if( iResult!=0 )
 				{
@@ -170,7 +334,7 @@ static NETX_CONSOLEAPP_RESULT_T spi_write_with_progress(const FLASHER_SPI_FLASH_
 					/* modify the beginning of the page */
 					memcpy(pucSpiBuffer, pucDC, ulSegSize);
 					/* read the rest of the buffer */
-					iResult = Drv_SpiReadFlash(ptFlashDev, ulC+ulSegSize, pucSpiBuffer+ulSegSize, ulPageSize-ulSegSize);
+					iResult = spi_read_flash(ptFlashDev, ulC+ulSegSize, pucSpiBuffer+ulSegSize, ulPageSize-ulSegSize);
 					if( iResult!=0 )
 					{
 						tResult = NETX_CONSOLEAPP_RESULT_ERROR;
@@ -178,7 +342,7 @@ static NETX_CONSOLEAPP_RESULT_T spi_write_with_progress(const FLASHER_SPI_FLASH_
 					else
 					{
 						/* write the buffer */
-						iResult = Drv_SpiWritePage(ptFlashDev, ulC, pucSpiBuffer, ulPageSize);
+						iResult = spi_write_page(ptFlashDev, ulC, pucSpiBuffer, ulPageSize);
 /*						iResult = Drv_SpiEraseAndWritePage(ptFlashDev, ulC, ulPageSize, pucSpiBuffer); */
 						if( iResult!=0 )
 						{
@@ -191,6 +355,13 @@ static NETX_CONSOLEAPP_RESULT_T spi_write_with_progress(const FLASHER_SPI_FLASH_
 		}
 	}
 
+	/* A striped flash may still program the last pages. */
+	iResult = spi_stripe_wait_idle(ptFlashDev);
+	if( iResult!=0 )
+	{
+		tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+	}
+
 	progress_bar_finalize();
 
 	if( tResult==NETX_CONSOLEAPP_RESULT_OK )
@@ -236,7 +407,7 @@ static NETX_CONSOLEAPP_RESULT_T spi_verify_with_progress(const FLASHER_SPI_FLASH
 		}
 
 		/* read the segment */
-		iResult = Drv_SpiReadFlash(ptFlashDev, ulC, pucSpiBuffer, ulSegSize);
+		iResult = spi_read_flash(ptFlashDev, ulC, pucSpiBuffer, ulSegSize);
 		if( iResult!=0 )
 		{
 			return NETX_CONSOLEAPP_RESULT_ERROR;
@@ -297,7 +468,7 @@ static NETX_CONSOLEAPP_RESULT_T spi_read_with_progress(const FLASHER_SPI_FLASH_T
 		}
 
 		/* read the segment */
-		iResult = Drv_SpiReadFlash(ptFlashDev, ulFlashStartAdr, pucDataAdr, ulSegSize);
+		iResult = spi_read_flash(ptFlashDev, ulFlashStartAdr, pucDataAdr, ulSegSize);
 		if( iResult!=0 )
 		{
 			return NETX_CONSOLEAPP_RESULT_ERROR;
@@ -343,7 +514,7 @@ static NETX_CONSOLEAPP_RESULT_T spi_sha1_with_progress(const FLASHER_SPI_FLASH_T
 		}
 
 		/* read the segment */
-		iResult = Drv_SpiReadFlash(ptFlashDev, ulFlashStartAdr, pucSpiBuffer, ulSegSize);
+		iResult = spi_read_flash(ptFlashDev, ulFlashStartAdr, pucSpiBuffer, ulSegSize);
 		if( iResult!=0 )
 		{
 			return NETX_CONSOLEAPP_RESULT_ERROR;
@@ -473,7 +644,7 @@ static NETX_CONSOLEAPP_RESULT_T spi_erase_with_progress(const FLASHER_SPI_FLASH_
 		}
 		else
 		{
-			iResult = Drv_SpiEraseFlashSector(ptFlashDev, ulAddress);
+			iResult = spi_erase_sector(ptFlashDev, ulAddress);
 		}
 		if( iResult!=0 )
 		{
@@ -490,6 +661,13 @@ static NETX_CONSOLEAPP_RESULT_T spi_erase_with_progress(const FLASHER_SPI_FLASH_
 		progress_bar_set_position(ulProgressCnt);
 	}
 
+	/* A striped flash may still erase the last sectors. */
+	iResult = spi_stripe_wait_idle(ptFlashDev);
+	if( iResult!=0 )
+	{
+		tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+	}
+
 	progress_bar_finalize();
 	uprintf(". erase OK\n");
 
@@ -624,6 +802,12 @@ NETX_CONSOLEAPP_RESULT_T spi_smart_erase(const FLASHER_SPI_FLASH_T *ptFlashDescr
 	
 	/* Nr of valid entries */
 	unsigned int nrEraseOps = ptFlashDescription->usNrEraseOperations;
+
+	/* The erase commands work on one chip. A striped flash erases its sectors on both chips. */
+	if(ptFlashDescription->fIsStriped != 0){
+		return spi_erase(ptFlashDescription, ulStartAdr, ulEndAdr);
+	}
+
 	if(nrEraseOps == 0){
 		// This should only happen if there is no valid entry for this chip in the XML table of flashes
 		// and SFDP is disable by the user (--no_sfdp) or not supported by the chip.
@@ -824,6 +1008,423 @@ NETX_CONSOLEAPP_RESULT_T spi_erase(const FLASHER_SPI_FLASH_T *ptFlashDescription
 
 /*-----------------------------------*/
 
+/* Erase and program several SPI flashes at the same time.
+ *
+ * A flash runs a page program or sector erase on its own after the command
+ * is sent. The CPU only has to poll the status. The batch has one lane per
+ * flash. The scheduler starts the next operation of each lane without
+ * waiting and polls the busy lanes in a round robin fashion, so the busy
+ * times of the flashes overlap. It never waits for one flash while another
+ * one is idle.
+ *
+ * Each programmed page is read back and compared as soon as the flash is
+ * ready again. Partial pages at the start and the end of an area are merged
+ * with the old contents.
+ *
+ * Flashes on the same unit share the clock setting. The clock of a flash is
+ * set again before each access if the last access was to another flash.
+ */
+
+typedef enum SPI_LANE_STATE_ENUM
+{
+	SPI_LANE_STATE_Idle = 0,  /* No operation is running, the next one can be started. */
+	SPI_LANE_STATE_Busy = 1,  /* An erase or program operation is running. */
+	SPI_LANE_STATE_Done = 2   /* All jobs of the lane are processed. */
+} SPI_LANE_STATE_T;
+
+typedef struct SPI_LANE_STRUCT
+{
+	SPI_LANE_STATE_T tState;
+	const FLASHER_SPI_FLASH_T *ptFlash;
+	SPI_BATCH_JOB_T *ptJob;                /* The current job or NULL if the lane has no more jobs. */
+	unsigned long ulAddress;               /* The next erase block or page of the current job. */
+	unsigned long ulVerifyAdr;             /* The start of the data in the page which is programmed right now. */
+	unsigned long ulVerifySize;            /* The size of the data to verify, 0 if there is nothing to verify. */
+	const unsigned char *pucVerifyData;    /* The expected data. */
+} SPI_LANE_T;
+
+static SPI_LANE_T atSpiLanes[SPI_BATCH_MAX_FLASHES];
+static const FLASHER_SPI_FLASH_T *ptSpiLaneSelected;
+static unsigned long ulSpiBatchProgress;
+
+
+
+/* Restore the clock of the lane's flash if the last access was to another flash. */
+static void spi_lane_select(const SPI_LANE_T *ptLane)
+{
+	if( ptSpiLaneSelected!=ptLane->ptFlash )
+	{
+		Drv_SpiRestoreSpeed(ptLane->ptFlash);
+		ptSpiLaneSelected = ptLane->ptFlash;
+	}
+}
+
+
+
+/* Move the lane to the next job of its flash. */
+static void spi_lane_next_job(SPI_LANE_T *ptLane, SPI_BATCH_JOB_T *ptJobsEnd)
+{
+	SPI_BATCH_JOB_T *ptJob;
+
+
+	ptJob = ptLane->ptJob + 1;
+	while( ptJob<ptJobsEnd && ptJob->ptFlash!=ptLane->ptFlash )
+	{
+		++ptJob;
+	}
+
+	if( ptJob<ptJobsEnd )
+	{
+		ptLane->ptJob = ptJob;
+		ptLane->ulAddress = ptJob->ulStartAdr;
+	}
+	else
+	{
+		ptLane->ptJob = NULL;
+	}
+}
+
+
+
+/* Check the jobs and create one lane for each flash.
+ *
+ * \return The number of lanes or 0 on error.
+ */
+static unsigned int spi_lanes_setup(SPI_BATCH_JOB_T *ptJobs, SPI_BATCH_JOB_T *ptJobsEnd, unsigned long *pulTotalSize)
+{
+	SPI_BATCH_JOB_T *ptJob;
+	SPI_LANE_T *ptLane;
+	SPI_LANE_T *ptLanesEnd;
+	const FLASHER_SPI_FLASH_T *ptFlash;
+	unsigned int uiLanes;
+	unsigned long ulTotalSize;
+	int iOk;
+
+
+	iOk = 1;
+	uiLanes = 0;
+	ulTotalSize = 0;
+	for(ptJob=ptJobs; ptJob<ptJobsEnd; ++ptJob)
+	{
+		ptJob->tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+		ptFlash = ptJob->ptFlash;
+
+		if( ptFlash->tAttributes.ulPageSize>SPI_BUFFER_SIZE )
+		{
+			uprintf("! pagesize exceeds reserved buffer.\n");
+			iOk = 0;
+			break;
+		}
+		if( ptFlash->fIsStriped!=0 )
+		{
+			/* A striped flash already runs its chips at the same time. */
+			uprintf("! Striped flashes are not supported in a batch.\n");
+			iOk = 0;
+			break;
+		}
+		if( ptJob->tOperation==SPI_BATCH_OPERATION_Erase && ((ptJob->ulStartAdr % ptFlash->ulSectorSize)!=0 || (ptJob->ulEndAdr % ptFlash->ulSectorSize)!=0) )
+		{
+			uprintf("! The erase area [0x%08x, 0x%08x[ is not aligned to the sectors.\n", ptJob->ulStartAdr, ptJob->ulEndAdr);
+			iOk = 0;
+			break;
+		}
+		ulTotalSize += ptJob->ulEndAdr - ptJob->ulStartAdr;
+
+		/* Find the lane of the flash. */
+		ptLanesEnd = atSpiLanes + uiLanes;
+		for(ptLane=atSpiLanes; ptLane<ptLanesEnd; ++ptLane)
+		{
+			if( ptLane->ptFlash==ptFlash )
+			{
+				break;
+			}
+			if( ptLane->ptFlash->tSpiDev.pvUnit==ptFlash->tSpiDev.pvUnit && ptLane->ptFlash->tSpiDev.tMode!=ptFlash->tSpiDev.tMode )
+			{
+				uprintf("! All flashes on one unit must use the same SPI mode.\n");
+				iOk = 0;
+				break;
+			}
+		}
+		if( iOk==0 )
+		{
+			break;
+		}
+
+		if( ptLane==ptLanesEnd )
+		{
+			if( uiLanes==SPI_BATCH_MAX_FLASHES )
+			{
+				uprintf("! A batch can use at most %d flashes.\n", SPI_BATCH_MAX_FLASHES);
+				iOk = 0;
+				break;
+			}
+
+			ptLane->tState = SPI_LANE_STATE_Idle;
+			ptLane->ptFlash = ptFlash;
+			ptLane->ptJob = ptJob;
+			ptLane->ulAddress = ptJob->ulStartAdr;
+			ptLane->ulVerifySize = 0;
+			++uiLanes;
+		}
+	}
+
+	if( iOk==0 )
+	{
+		uiLanes = 0;
+	}
+
+	*pulTotalSize = ulTotalSize;
+	return uiLanes;
+}
+
+
+
+/* Start the next erase block or page of the lane. Finished jobs are
+ * completed and the lane moves on to the next job of its flash.
+ */
+static NETX_CONSOLEAPP_RESULT_T spi_lane_start(SPI_LANE_T *ptLane, SPI_BATCH_JOB_T *ptJobsEnd)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	const FLASHER_SPI_FLASH_T *ptFlash;
+	SPI_BATCH_JOB_T *ptJob;
+	const unsigned char *pucSrc;
+	unsigned long ulPageSize;
+	unsigned long ulPageStartAdr;
+	unsigned long ulOffset;
+	unsigned long ulSegSize;
+	int iResult;
+
+
+	tResult = NETX_CONSOLEAPP_RESULT_OK;
+	ptFlash = ptLane->ptFlash;
+	ptLane->tState = SPI_LANE_STATE_Idle;
+
+	while( ptLane->tState==SPI_LANE_STATE_Idle )
+	{
+		ptJob = ptLane->ptJob;
+		if( ptJob==NULL )
+		{
+			ptLane->tState = SPI_LANE_STATE_Done;
+		}
+		else if( ptLane->ulAddress>=ptJob->ulEndAdr )
+		{
+			/* The job is complete. */
+			ptJob->tResult = NETX_CONSOLEAPP_RESULT_OK;
+			spi_lane_next_job(ptLane, ptJobsEnd);
+		}
+		else if( ptJob->tOperation==SPI_BATCH_OPERATION_Erase )
+		{
+			iResult = Drv_SpiStartEraseFlashSector(ptFlash, ptLane->ulAddress);
+			if( iResult!=0 )
+			{
+				uprintf("! erase failed at address 0x%08x\n", ptLane->ulAddress);
+				tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+				break;
+			}
+
+			ptLane->ulAddress += ptFlash->ulSectorSize;
+			ptLane->ulVerifySize = 0;
+			ptLane->tState = SPI_LANE_STATE_Busy;
+
+			ulSpiBatchProgress += ptFlash->ulSectorSize;
+			progress_bar_set_position(ulSpiBatchProgress);
+		}
+		else
+		{
+			/* Get the part of the job in the current page. */
+			ulPageSize = ptFlash->tAttributes.ulPageSize;
+			ulOffset = ptLane->ulAddress % ulPageSize;
+			ulPageStartAdr = ptLane->ulAddress - ulOffset;
+			ulSegSize = ulPageSize - ulOffset;
+			if( ulSegSize>ptJob->ulEndAdr-ptLane->ulAddress )
+			{
+				ulSegSize = ptJob->ulEndAdr - ptLane->ulAddress;
+			}
+			pucSrc = ptJob->pucData + (ptLane->ulAddress - ptJob->ulStartAdr);
+
+			if( ulSegSize!=ulPageSize )
+			{
+				/* Merge a partial page with the old contents. The flash
+				 * copies the data when it receives the command, so the
+				 * buffer is free again when the function returns.
+				 */
+				iResult = Drv_SpiReadFlash(ptFlash, ulPageStartAdr, pucSpiBuffer, ulPageSize);
+				if( iResult==0 )
+				{
+					memcpy(pucSpiBuffer+ulOffset, pucSrc, ulSegSize);
+					iResult = Drv_SpiStartWritePage(ptFlash, ulPageStartAdr, pucSpiBuffer, ulPageSize);
+				}
+			}
+			else
+			{
+				iResult = Drv_SpiStartWritePage(ptFlash, ulPageStartAdr, pucSrc, ulPageSize);
+			}
+			if( iResult!=0 )
+			{
+				uprintf("! write error at address 0x%08x\n", ulPageStartAdr);
+				tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+				break;
+			}
+
+			ptLane->ulVerifyAdr = ptLane->ulAddress;
+			ptLane->ulVerifySize = ulSegSize;
+			ptLane->pucVerifyData = pucSrc;
+			ptLane->ulAddress += ulSegSize;
+			ptLane->tState = SPI_LANE_STATE_Busy;
+
+			ulSpiBatchProgress += ulSegSize;
+			progress_bar_set_position(ulSpiBatchProgress);
+		}
+	}
+
+	return tResult;
+}
+
+
+
+/* The flash of the lane is ready. Verify the last page and start the next operation. */
+static NETX_CONSOLEAPP_RESULT_T spi_lane_continue(SPI_LANE_T *ptLane, SPI_BATCH_JOB_T *ptJobsEnd)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	int iResult;
+
+
+	tResult = NETX_CONSOLEAPP_RESULT_OK;
+	ptLane->tState = SPI_LANE_STATE_Idle;
+
+	if( ptLane->ulVerifySize!=0 )
+	{
+		iResult = Drv_SpiReadFlash(ptLane->ptFlash, ptLane->ulVerifyAdr, pucSpiBuffer, ptLane->ulVerifySize);
+		if( iResult!=0 )
+		{
+			uprintf("! read error at address 0x%08x\n", ptLane->ulVerifyAdr);
+			tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+		}
+		else if( memcmp(pucSpiBuffer, ptLane->pucVerifyData, ptLane->ulVerifySize)!=0 )
+		{
+			uprintf("! verify error in the page at address 0x%08x\n", ptLane->ulVerifyAdr);
+			tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+		}
+		ptLane->ulVerifySize = 0;
+	}
+
+	if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+	{
+		tResult = spi_lane_start(ptLane, ptJobsEnd);
+	}
+
+	return tResult;
+}
+
+
+
+/**
+ * @brief Run erase and flash jobs on several SPI flashes at the same time.
+ *
+ * The jobs of one flash run in the order of the table. While one flash is
+ * busy with a page program or sector erase, the next operation is started
+ * on another flash. Erase areas must be aligned to the sectors.
+ * If one job fails, no new operations are started. The operations which
+ * are already running are completed before the function returns.
+ *
+ * @param ptJobs  [in,out] The job table. The result of each job is stored in tResult.
+ * @param uiJobs  [in]     The number of jobs.
+ *
+ * @return
+ * - NETX_CONSOLEAPP_RESULT_OK: all jobs were successful.
+ * - NETX_CONSOLEAPP_RESULT_ERROR: An error has occurred.
+ */
+NETX_CONSOLEAPP_RESULT_T spi_batch(SPI_BATCH_JOB_T *ptJobs, unsigned int uiJobs)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	SPI_BATCH_JOB_T *ptJobsEnd;
+	SPI_LANE_T *ptLane;
+	SPI_LANE_T *ptLanesEnd;
+	unsigned int uiLanes;
+	unsigned long ulTotalSize;
+	int iBusy;
+	int iIsReady;
+	int iResult;
+
+
+	ptJobsEnd = ptJobs + uiJobs;
+	uiLanes = spi_lanes_setup(ptJobs, ptJobsEnd, &ulTotalSize);
+	if( uiLanes==0 && uiJobs!=0 )
+	{
+		tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+	}
+	else
+	{
+		uprintf("# Erase and write %d jobs on %d flashes...\n", uiJobs, uiLanes);
+
+		tResult = NETX_CONSOLEAPP_RESULT_OK;
+		ptLanesEnd = atSpiLanes + uiLanes;
+		ptSpiLaneSelected = NULL;
+		ulSpiBatchProgress = 0;
+		progress_bar_init(ulTotalSize);
+
+		/* Start the first operation on all lanes. */
+		for(ptLane=atSpiLanes; ptLane<ptLanesEnd; ++ptLane)
+		{
+			spi_lane_select(ptLane);
+			tResult = spi_lane_start(ptLane, ptJobsEnd);
+			if( tResult!=NETX_CONSOLEAPP_RESULT_OK )
+			{
+				break;
+			}
+		}
+
+		/* Poll all busy lanes and start the next operation as soon as one is finished. */
+		do
+		{
+			iBusy = 0;
+			for(ptLane=atSpiLanes; ptLane<ptLanesEnd; ++ptLane)
+			{
+				if( ptLane->tState==SPI_LANE_STATE_Busy )
+				{
+					spi_lane_select(ptLane);
+					iResult = Drv_SpiIsReady(ptLane->ptFlash, &iIsReady);
+					if( iResult!=0 )
+					{
+						uprintf("! failed to read the status of the flash\n");
+						tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+						ptLane->tState = SPI_LANE_STATE_Idle;
+					}
+					else if( iIsReady==0 )
+					{
+						iBusy = 1;
+					}
+					else if( tResult!=NETX_CONSOLEAPP_RESULT_OK )
+					{
+						/* Another lane failed. Do not start anything new. */
+						ptLane->tState = SPI_LANE_STATE_Idle;
+					}
+					else
+					{
+						tResult = spi_lane_continue(ptLane, ptJobsEnd);
+						if( ptLane->tState==SPI_LANE_STATE_Busy )
+						{
+							iBusy = 1;
+						}
+					}
+				}
+			}
+
+			progress_bar_check_timer();
+		} while( iBusy!=0 );
+
+		progress_bar_finalize();
+		if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+		{
+			uprintf(". batch ok\n");
+		}
+	}
+
+	return tResult;
+}
+
+/*-----------------------------------*/
+
 /**
  * @brief Read data from the flash.
  *
@@ -925,17 +1526,17 @@ NETX_CONSOLEAPP_RESULT_T spi_verify(const FLASHER_SPI_FLASH_T *ptFlashDescriptio
  *
  * @param ptSpiConfiguration [in]  Configuration of the SPI interface, e.g. the clock frequency.
  * @param ptFlashDescription [out] Information about the flash device, if any was identified.
- * @param pcBufferEnd        [in]  Pointer to the end of a buffer at least 8 KB in size.
  * @param tFlags           [in]  32-Bit detect flag bitfield.
  *                                 Bit    0: Always use SFDP to get erase operations
- *                                 Bit 31-1: reserved
+ *                                 Bit  7-1: Striped flash, see spi_detect_striped
+ *                                 Bit 31-8: reserved
  *
  * @return
  * - NETX_CONSOLEAPP_RESULT_OK: a device was detected and the device information is stored in ptFlashDescription.
  * - NETX_CONSOLEAPP_RESULT_ERROR: no device was detected or an error occurred.
  */
 
-NETX_CONSOLEAPP_RESULT_T spi_detect(FLASHER_SPI_CONFIGURATION_T *ptSpiConfiguration, FLASHER_SPI_FLASH_T *ptFlashDescription, char *pcBufferEnd, FLASHER_SPI_FLAGS_T ulFlags)
+NETX_CONSOLEAPP_RESULT_T spi_detect(FLASHER_SPI_CONFIGURATION_T *ptSpiConfiguration, FLASHER_SPI_FLASH_T *ptFlashDescription, FLASHER_SPI_FLAGS_T ulFlags)
 {
 	NETX_CONSOLEAPP_RESULT_T tResult;
 	int iResult;
@@ -944,7 +1545,7 @@ NETX_CONSOLEAPP_RESULT_T spi_detect(FLASHER_SPI_CONFIGURATION_T *ptSpiConfigurat
 	/* try to detect flash */
 	uprintf(". Detecting SPI flash on unit %d, chip select %d...\n", ptSpiConfiguration->uiUnit, ptSpiConfiguration->uiChipSelect);
 	ptFlashDescription->uiSlaveId = ptSpiConfiguration->uiChipSelect;
-	iResult = Drv_SpiInitializeFlash(ptSpiConfiguration, ptFlashDescription, pcBufferEnd, ulFlags);
+	iResult = Drv_SpiInitializeFlash(ptSpiConfiguration, ptFlashDescription, ulFlags);
 	if( iResult!=0 )
 	{
 		/* failed to detect the SPI flash */
@@ -963,6 +1564,67 @@ NETX_CONSOLEAPP_RESULT_T spi_detect(FLASHER_SPI_CONFIGURATION_T *ptSpiConfigurat
 }
 
 
+/*-----------------------------------*/
+
+/**
+ * @brief Detect two identical flashes and combine them to one striped flash.
+ *
+ * The first flash is on the unit and chip select of ptSpiConfiguration, the
+ * second one on the unit and chip select in the stripe fields of tFlags.
+ * All other settings are the same for both flashes.
+ * The logical pages alternate between the flashes. Pass &ptStriped->tLogical
+ * to all other functions of this file.
+ *
+ * @param ptSpiConfiguration [in]  Configuration of the SPI interface of the first flash.
+ * @param ptStriped          [out] Information about both flashes and the combined flash.
+ * @param tFlags             [in]  Detect flags with the unit and chip select of the second flash.
+ *
+ * @return
+ * - NETX_CONSOLEAPP_RESULT_OK: both flashes were detected and are the same device.
+ * - NETX_CONSOLEAPP_RESULT_ERROR: a flash was not detected or the flashes differ.
+ */
+
+NETX_CONSOLEAPP_RESULT_T spi_detect_striped(const FLASHER_SPI_CONFIGURATION_T *ptSpiConfiguration, FLASHER_SPI_STRIPED_FLASH_T *ptStriped, FLASHER_SPI_FLAGS_T tFlags)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	FLASHER_SPI_CONFIGURATION_T tSpiConfiguration;
+	int iResult;
+
+
+	memcpy(&tSpiConfiguration, ptSpiConfiguration, sizeof(FLASHER_SPI_CONFIGURATION_T));
+	tResult = spi_detect(&tSpiConfiguration, &(ptStriped->atChip[0]), tFlags);
+	if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+	{
+		tSpiConfiguration.uiUnit = tFlags.bits.uiStripeUnit;
+		tSpiConfiguration.uiChipSelect = tFlags.bits.uiStripeChipSelect;
+		if( tSpiConfiguration.uiUnit==ptSpiConfiguration->uiUnit && tSpiConfiguration.uiChipSelect==ptSpiConfiguration->uiChipSelect )
+		{
+			uprintf("! The second flash of a striped flash must be on another unit or chip select.\n");
+			tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+		}
+		else
+		{
+			tResult = spi_detect(&tSpiConfiguration, &(ptStriped->atChip[1]), tFlags);
+		}
+	}
+
+	if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+	{
+		iResult = Drv_SpiInitializeStripedFlash(ptStriped);
+		if( iResult!=0 )
+		{
+			tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+		}
+		else
+		{
+			uprintf(". OK, striped flash with 0x%08x bytes and 0x%08x bytes per erase block\n", ptStriped->tLogical.tAttributes.ulSize, ptStriped->tLogical.ulSectorSize);
+		}
+	}
+
+	return tResult;
+}
+
+
 /*-----------------------------------*/
 
 /**
@@ -1017,7 +1679,7 @@ NETX_CONSOLEAPP_RESULT_T spi_isErased(const FLASHER_SPI_FLASH_T *ptFlashDescript
 		}
 
 		/* read the segment */
-		iResult = Drv_SpiReadFlash(ptFlashDescription, ulCnt, pucSpiBuffer, ulSegSize);
+		iResult = spi_read_flash(ptFlashDescription, ulCnt, pucSpiBuffer, ulSegSize);
 		if( iResult!=0 )
 		{
 			tResult = NETX_CONSOLEAPP_RESULT_ERROR;
@@ -30,8 +30,32 @@
 #endif
 
 
+typedef enum SPI_BATCH_OPERATION_ENUM
+{
+	SPI_BATCH_OPERATION_Erase = 0,     /* erase the sectors of the area */
+	SPI_BATCH_OPERATION_Flash = 1      /* program and verify the area with pucData */
+} SPI_BATCH_OPERATION_T;
+
+/* One job of spi_batch. The jobs of one flash run in the order of the
+ * table. The jobs of different flashes run at the same time.
+ */
+typedef struct SPI_BATCH_JOB_STRUCT
+{
+	const FLASHER_SPI_FLASH_T *ptFlash;
+	SPI_BATCH_OPERATION_T tOperation;
+	unsigned long ulStartAdr;
+	unsigned long ulEndAdr;
+	const unsigned char *pucData;
+	NETX_CONSOLEAPP_RESULT_T tResult;
+} SPI_BATCH_JOB_T;
+
+/* The maximum number of different flashes in one batch. */
+#define SPI_BATCH_MAX_FLASHES 8
+
+
 NETX_CONSOLEAPP_RESULT_T spi_flash(const FLASHER_SPI_FLASH_T *ptFlashDescription, unsigned long ulFlashStartAdr, unsigned long ulDataByteSize, const unsigned char *pucDataStartAdr);
 NETX_CONSOLEAPP_RESULT_T spi_erase(const FLASHER_SPI_FLASH_T *ptFlashDescription, unsigned long ulStartAdr, unsigned long ulEndAdr);
+NETX_CONSOLEAPP_RESULT_T spi_batch(SPI_BATCH_JOB_T *ptJobs, unsigned int uiJobs);
 #if CFG_INCLUDE_SMART_ERASE==1
 NETX_CONSOLEAPP_RESULT_T spi_smart_erase(const FLASHER_SPI_FLASH_T *ptFlashDescription, const unsigned long ulStartAdr, const unsigned long ulEndAdr);
 #endif
@@ -40,7 +64,8 @@ NETX_CONSOLEAPP_RESULT_T spi_read(const FLASHER_SPI_FLASH_T *ptFlashDescription,
 NETX_CONSOLEAPP_RESULT_T spi_sha1(const FLASHER_SPI_FLASH_T *ptFlashDescription, unsigned long ulStartAdr, unsigned long ulEndAdr, SHA_CTX *ptSha1Context);
 #endif
 NETX_CONSOLEAPP_RESULT_T spi_verify(const FLASHER_SPI_FLASH_T *ptFlashDescription, unsigned long ulFlashStartAdr, unsigned long ulFlashEndAdr, const unsigned char *pucData, void **ppvReturnMessage);
-NETX_CONSOLEAPP_RESULT_T spi_detect(FLASHER_SPI_CONFIGURATION_T *ptSpiConfiguration, FLASHER_SPI_FLASH_T *ptFlashDescription, char *pcBufferEnd, FLASHER_SPI_FLAGS_T ulFlags);
+NETX_CONSOLEAPP_RESULT_T spi_detect(FLASHER_SPI_CONFIGURATION_T *ptSpiConfiguration, FLASHER_SPI_FLASH_T *ptFlashDescription, FLASHER_SPI_FLAGS_T ulFlags);
+NETX_CONSOLEAPP_RESULT_T spi_detect_striped(const FLASHER_SPI_CONFIGURATION_T *ptSpiConfiguration, FLASHER_SPI_STRIPED_FLASH_T *ptStriped, FLASHER_SPI_FLAGS_T tFlags);
 NETX_CONSOLEAPP_RESULT_T spi_isErased(const FLASHER_SPI_FLASH_T *ptFlashDescription, unsigned long ulStartAdr, unsigned long ulEndAdr, void **ppvReturnMessage);
 NETX_CONSOLEAPP_RESULT_T spi_getEraseArea(const FLASHER_SPI_FLASH_T *ptFlashDescription, unsigned long ulStartAdr, unsigned long ulEndAdr, unsigned long *pulStartAdr, unsigned long *pulEndAdr);
 
@@ -0,0 +1,41 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* The host build does not use the platform library. This replaces its
+ * asic_types.h and adds the host as one more ASIC type.
+ */
+
+#ifndef __ASIC_TYPES_H__
+#define __ASIC_TYPES_H__
+
+#define ASIC_TYP_NETX500            500
+#define ASIC_TYP_NETX100            100
+#define ASIC_TYP_NETX56             56
+#define ASIC_TYP_NETX50             50
+#define ASIC_TYP_NETX10             10
+#define ASIC_TYP_NETX6              6
+#define ASIC_TYP_NETX4000_RELAXED   4000
+#define ASIC_TYP_NETX4000           4100
+#define ASIC_TYP_NETX90_MPW         90
+#define ASIC_TYP_NETX90             91
+#define ASIC_TYP_NETIOL             1
+#define ASIC_TYP_HOST               0xffff
+
+#endif  /* __ASIC_TYPES_H__ */
@@ -0,0 +1,62 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "board.h"
+
+#include "units.h"
+
+
+/*-------------------------------------------------------------------------*/
+
+
+/* The units of the virtual target have no register blocks. The simulated
+ * SPI driver selects the unit by its number.
+ */
+static const UNIT_TABLE_T tUnitTable_BusSPI =
+{
+	.sizEntries = 4,
+	.atEntries =
+	{
+		{ 0,  "SIM_SPI0",  NULL },
+		{ 1,  "SIM_SPI1",  NULL },
+		{ 2,  "SIM_SPI2",  NULL },
+		{ 3,  "SIM_SPI3",  NULL }
+	}
+};
+
+
+
+const BUS_TABLE_T tBusTable =
+{
+	.sizEntries = 1,
+	.atEntries =
+	{
+		{ BUS_SPI,       "Serial Flash",        &tUnitTable_BusSPI }
+	}
+};
+
+
+/*-------------------------------------------------------------------------*/
+
+
+NETX_CONSOLEAPP_RESULT_T board_init(void)
+{
+	return NETX_CONSOLEAPP_RESULT_OK;
+}
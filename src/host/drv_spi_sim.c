@@ -0,0 +1,250 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* A SPI driver for the host target. It passes all bytes to the device
+ * models which are attached to the units and chip selects. Each byte
+ * advances the simulated clock by 8 clocks of the current speed.
+ */
+
+#include <string.h>
+
+#include "drv_spi_sim.h"
+#include "sim_clock.h"
+
+
+typedef struct SPI_SIM_UNIT_STRUCT
+{
+	SPI_SIM_DEVICE_T *aptDevices[SPI_SIM_CHIP_SELECTS];
+	SPI_SIM_DEVICE_T *ptSelected;
+	unsigned long ulSpeedKhz;
+} SPI_SIM_UNIT_T;
+
+static SPI_SIM_UNIT_T atSpiSimUnits[SPI_SIM_UNITS];
+
+
+/*-----------------------------------*/
+
+
+static unsigned char spi_sim_exchange_byte(const FLASHER_SPI_CFG_T *ptCfg, unsigned char ucByte)
+{
+	SPI_SIM_UNIT_T *ptUnit;
+	SPI_SIM_DEVICE_T *ptDevice;
+	unsigned char ucReceived;
+
+
+	ptUnit = (SPI_SIM_UNIT_T*)ptCfg->pvUnit;
+	ptDevice = ptUnit->ptSelected;
+
+	sim_clock_transfer_byte(ptUnit->ulSpeedKhz);
+
+	/* MISO floats high without a selected device. */
+	ucReceived = 0xffU;
+	if( ptDevice!=NULL )
+	{
+		ucReceived = ptDevice->pfnExchange(ptDevice, ucByte, ptUnit->ulSpeedKhz);
+	}
+
+	return ucReceived;
+}
+
+
+static unsigned long spi_sim_get_device_speed_representation(const FLASHER_SPI_CFG_T *ptCfg, unsigned int uiSpeed)
+{
+	/* The simulated unit uses the speed in kHz. */
+	if( uiSpeed>ptCfg->ulMaximumSpeedKhz )
+	{
+		uiSpeed = ptCfg->ulMaximumSpeedKhz;
+	}
+
+	return uiSpeed;
+}
+
+
+static int spi_sim_slave_select(const FLASHER_SPI_CFG_T *ptCfg, int fIsSelected)
+{
+	SPI_SIM_UNIT_T *ptUnit;
+	SPI_SIM_DEVICE_T *ptDevice;
+
+
+	ptUnit = (SPI_SIM_UNIT_T*)ptCfg->pvUnit;
+
+	/* Release the old device. */
+	ptDevice = ptUnit->ptSelected;
+	if( ptDevice!=NULL )
+	{
+		ptUnit->ptSelected = NULL;
+		ptDevice->pfnSelect(ptDevice, 0);
+	}
+
+	if( fIsSelected!=0 )
+	{
+		ptDevice = ptUnit->aptDevices[ptCfg->uiChipSelect];
+		if( ptDevice!=NULL )
+		{
+			ptUnit->ptSelected = ptDevice;
+			ptDevice->pfnSelect(ptDevice, 1);
+		}
+	}
+
+	return 0;
+}
+
+
+static int spi_sim_send_idle(const FLASHER_SPI_CFG_T *ptCfg, size_t sizBytes)
+{
+	unsigned char ucIdleChar;
+
+
+	ucIdleChar = ptCfg->ucIdleChar;
+
+	while( sizBytes>0 )
+	{
+		spi_sim_exchange_byte(ptCfg, ucIdleChar);
+		--sizBytes;
+	}
+
+	return 0;
+}
+
+
+static int spi_sim_send_data(const FLASHER_SPI_CFG_T *ptCfg, const unsigned char *pucData, size_t sizData)
+{
+	const unsigned char *pucDataEnd;
+
+
+	pucDataEnd = pucData + sizData;
+	while( pucData<pucDataEnd )
+	{
+		spi_sim_exchange_byte(ptCfg, *(pucData++));
+	}
+
+	return 0;
+}
+
+
+static int spi_sim_receive_data(const FLASHER_SPI_CFG_T *ptCfg, unsigned char *pucData, size_t sizData)
+{
+	unsigned char ucIdleChar;
+	unsigned char *pucDataEnd;
+
+
+	ucIdleChar = ptCfg->ucIdleChar;
+
+	pucDataEnd = pucData + sizData;
+	while( pucData<pucDataEnd )
+	{
+		*pucData = spi_sim_exchange_byte(ptCfg, ucIdleChar);
+		++pucData;
+	}
+
+	return 0;
+}
+
+
+static int spi_sim_exchange_data(const FLASHER_SPI_CFG_T *ptCfg, const unsigned char *pucOutData, unsigned char *pucInData, size_t sizData)
+{
+	unsigned char *pucInDataEnd;
+
+
+	pucInDataEnd = pucInData + sizData;
+	while( pucInData<pucInDataEnd )
+	{
+		*pucInData = spi_sim_exchange_byte(ptCfg, *(pucOutData++));
+		++pucInData;
+	}
+
+	return 0;
+}
+
+
+static void spi_sim_set_new_speed(const FLASHER_SPI_CFG_T *ptCfg, unsigned long ulDeviceSpecificSpeed)
+{
+	SPI_SIM_UNIT_T *ptUnit;
+
+
+	ptUnit = (SPI_SIM_UNIT_T*)ptCfg->pvUnit;
+	ptUnit->ulSpeedKhz = ulDeviceSpecificSpeed;
+}
+
+
+static void spi_sim_deactivate(const FLASHER_SPI_CFG_T *ptCfg)
+{
+	spi_sim_slave_select(ptCfg, 0);
+}
+
+
+/*-----------------------------------*/
+
+
+int flasher_drv_spi_sim_attach(unsigned int uiUnit, unsigned int uiChipSelect, SPI_SIM_DEVICE_T *ptDevice)
+{
+	int iResult;
+
+
+	iResult = -1;
+	if( uiUnit<SPI_SIM_UNITS && uiChipSelect<SPI_SIM_CHIP_SELECTS )
+	{
+		atSpiSimUnits[uiUnit].aptDevices[uiChipSelect] = ptDevice;
+		iResult = 0;
+	}
+
+	return iResult;
+}
+
+
+int flasher_drv_spi_sim_init(FLASHER_SPI_CFG_T *ptCfg, const FLASHER_SPI_CONFIGURATION_T *ptSpiCfg, unsigned int uiUnit)
+{
+	int iResult;
+	unsigned int uiChipSelect;
+
+
+	iResult = -1;
+
+	uiChipSelect = ptSpiCfg->uiChipSelect;
+	if( uiUnit<SPI_SIM_UNITS && uiChipSelect<SPI_SIM_CHIP_SELECTS )
+	{
+		ptCfg->pvUnit = atSpiSimUnits + uiUnit;
+		ptCfg->ulSpeed = ptSpiCfg->ulInitialSpeedKhz;
+		ptCfg->ulMaximumSpeedKhz = ptSpiCfg->ulMaximumSpeedKhz;
+		ptCfg->uiIdleCfg = ptSpiCfg->uiIdleCfg;
+		ptCfg->tMode = ptSpiCfg->uiMode;
+		ptCfg->uiChipSelect = uiChipSelect;
+
+		ptCfg->pfnSelect = spi_sim_slave_select;
+		ptCfg->pfnSendIdle = spi_sim_send_idle;
+		ptCfg->pfnSendData = spi_sim_send_data;
+		ptCfg->pfnReceiveData = spi_sim_receive_data;
+		ptCfg->pfnExchangeData = spi_sim_exchange_data;
+		ptCfg->pfnSetNewSpeed = spi_sim_set_new_speed;
+		ptCfg->pfnExchangeByte = spi_sim_exchange_byte;
+		ptCfg->pfnGetDeviceSpeedRepresentation = spi_sim_get_device_speed_representation;
+		ptCfg->pfnDeactivate = spi_sim_deactivate;
+
+		ptCfg->ucIdleChar = 0xffU;
+		memcpy(ptCfg->aucMmio, ptSpiCfg->aucMmio, sizeof(ptSpiCfg->aucMmio));
+
+		atSpiSimUnits[uiUnit].ptSelected = NULL;
+		atSpiSimUnits[uiUnit].ulSpeedKhz = ptSpiCfg->ulInitialSpeedKhz;
+
+		iResult = 0;
+	}
+
+	return iResult;
+}
@@ -0,0 +1,57 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#ifndef __DRV_SPI_SIM_H__
+#define __DRV_SPI_SIM_H__
+
+#include "spi.h"
+
+
+/* The number of simulated SPI units and chip selects per unit. */
+#define SPI_SIM_UNITS 4
+#define SPI_SIM_CHIP_SELECTS 4
+
+
+/* A device on the simulated bus. The models embed this structure as the
+ * first element.
+ */
+struct SPI_SIM_DEVICE_STRUCT;
+
+typedef void (*PFN_SPI_SIM_SELECT_T)(struct SPI_SIM_DEVICE_STRUCT *ptDevice, int fIsSelected);
+typedef unsigned char (*PFN_SPI_SIM_EXCHANGE_T)(struct SPI_SIM_DEVICE_STRUCT *ptDevice, unsigned char ucByte, unsigned long ulSpeedKhz);
+
+typedef struct SPI_SIM_DEVICE_STRUCT
+{
+	PFN_SPI_SIM_SELECT_T pfnSelect;      /**< @brief Called when the chip select changes. */
+	PFN_SPI_SIM_EXCHANGE_T pfnExchange;  /**< @brief Exchange one byte at the current bus speed while the device is selected. */
+} SPI_SIM_DEVICE_T;
+
+
+/*-------------------------------------*/
+
+
+int flasher_drv_spi_sim_attach(unsigned int uiUnit, unsigned int uiChipSelect, SPI_SIM_DEVICE_T *ptDevice);
+int flasher_drv_spi_sim_init(FLASHER_SPI_CFG_T *ptCfg, const FLASHER_SPI_CONFIGURATION_T *ptSpiCfg, unsigned int uiUnit);
+
+
+/*-------------------------------------*/
+
+
+#endif	/* __DRV_SPI_SIM_H__ */
@@ -0,0 +1,155 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* Replacements for the parts of the platform library which are used by
+ * the flasher core.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "delay.h"
+#include "host_target.h"
+#include "rdy_run.h"
+#include "reset.h"
+#include "systime.h"
+#include "uprintf.h"
+
+
+/*-----------------------------------*/
+
+
+void uprintf(const char *pcFmt, ...)
+{
+	va_list ptArgument;
+	char acBuffer[1024];
+	int iLength;
+
+
+	va_start(ptArgument, pcFmt);
+	iLength = vsnprintf(acBuffer, sizeof(acBuffer), pcFmt, ptArgument);
+	va_end(ptArgument);
+
+	if( iLength>0 )
+	{
+		if( (size_t)iLength>=sizeof(acBuffer) )
+		{
+			iLength = sizeof(acBuffer) - 1;
+		}
+		host_target_message(acBuffer, (size_t)iLength);
+	}
+}
+
+
+void hexdump(const unsigned char *pucData, unsigned long ulSize)
+{
+	unsigned long ulCnt;
+
+
+	for(ulCnt=0; ulCnt<ulSize; ++ulCnt)
+	{
+		if( (ulCnt&15U)==0 )
+		{
+			uprintf("%08lx:", ulCnt);
+		}
+		uprintf(" %02x", pucData[ulCnt]);
+		if( (ulCnt&15U)==15U || ulCnt+1U==ulSize )
+		{
+			uprintf("\n");
+		}
+	}
+}
+
+
+/*-----------------------------------*/
+
+
+void systime_init(void)
+{
+}
+
+
+unsigned long systime_get_ms(void)
+{
+	struct timespec tNow;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &tNow);
+	return (unsigned long)(tNow.tv_sec * 1000U + tNow.tv_nsec / 1000000U);
+}
+
+
+int systime_elapsed(unsigned long ulStart, unsigned long ulDuration)
+{
+	unsigned long ulDiff;
+
+
+	/* This works with an overflow of the counter. */
+	ulDiff = systime_get_ms() - ulStart;
+	return (ulDiff>=ulDuration) ? 1 : 0;
+}
+
+
+void delay_us(unsigned int uiDelayUs)
+{
+	struct timespec tDelay;
+
+
+	tDelay.tv_sec = uiDelayUs / 1000000U;
+	tDelay.tv_nsec = (long)(uiDelayUs % 1000000U) * 1000L;
+	nanosleep(&tDelay, NULL);
+}
+
+
+/*-----------------------------------*/
+
+
+void rdy_run_setLEDs(RDYRUN_T tState)
+{
+	/* The virtual target has no LEDs. */
+	(void)tState;
+}
+
+
+void rdy_run_blinki_init(BLINKI_HANDLE_T *ptHandle, unsigned long ulMask, unsigned long ulState)
+{
+	ptHandle->ulMask = ulMask;
+	ptHandle->ulState = ulState;
+	ptHandle->ulTimer = 0;
+	ptHandle->ulBitPos = 0;
+}
+
+
+void rdy_run_blinki(BLINKI_HANDLE_T *ptHandle)
+{
+	(void)ptHandle;
+}
+
+
+/*-----------------------------------*/
+
+
+NETX_CONSOLEAPP_RESULT_T resetNetX(void)
+{
+	/* There is nothing to reset. The flash models keep their contents. */
+	uprintf("The virtual target ignores the reset.\n");
+	return NETX_CONSOLEAPP_RESULT_OK;
+}
@@ -0,0 +1,574 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* The main program of the host target.
+ *
+ * The process reads requests from stdin and writes the replies to the
+ * file given as the first argument. This is usually a FIFO. Each request
+ * and each reply starts with a header of 9 bytes: one byte for the type
+ * and 2 little endian 32 bit values.
+ *
+ *   Request                    Reply
+ *   'W' address, size, data    'K' 0, 0
+ *   'R' address, size          'D' size, 0, data
+ *   'C' exec, parameter        'M' size, 0, text (any number)
+ *                              'K' return value, 0
+ *   'S' 0, 0                   'D' 56, 0, statistics
+ *   'Q' 0, 0                   no reply, the process exits
+ *
+ * A failed request gets an 'E' reply with a size and the error message.
+ * After the start the process sends 'K' if the flashes and the RAM could be
+ * set up or 'E' if not.
+ *
+ * The statistics are the simulated values of the last call and of all
+ * calls since the start. Each part has 7 little endian 32 bit values: the
+ * bytes on the buses (low and high word), the simulated time in
+ * microseconds (low and high word), the busy polls, the programs and the
+ * erases.
+ *
+ * The flashes are given on the command line:
+ *   --spi unit:chip_select:device[:size][:file]
+ * The device is the name of an entry in spi_flash_types.xml, e.g. "W25Q32",
+ * or a JEDEC ID with 6 hex digits, e.g. "ef4016", for a generic flash. The
+ * size is optional for a known device and needed for a generic one. If a
+ * file is given, the contents of the flash are kept in this file.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "flasher_header.h"
+#include "host_target.h"
+#include "netx_consoleapp.h"
+#include "sim_clock.h"
+#include "spi_flash.h"
+#include "spi_nor_model.h"
+
+
+/* The flasher structures must have the same layout as on the netX. */
+typedef char HOST_TARGET_NEEDS_32BIT_POINTERS[(sizeof(void*)==4) ? 1 : -1];
+
+
+#define HOST_TARGET_HEADER_SIZE 9
+#define HOST_TARGET_MAX_SPI_FLASHES (SPI_SIM_UNITS*SPI_SIM_CHIP_SELECTS)
+#define HOST_TARGET_STATISTICS_SIZE (2*7*4)
+
+
+/* This is the parameter for netx_consoleapp_init. On the netX it is set
+ * by the startup code.
+ */
+unsigned int NetxConsoleParameter_Init;
+
+static FILE *ptReplyFile;
+static int fCallIsRunning;
+
+static SPI_NOR_MODEL_T atSpiFlashes[HOST_TARGET_MAX_SPI_FLASHES];
+static unsigned int uiSpiFlashes;
+
+static SIM_CLOCK_STATISTICS_T tLastCallStatistics;
+
+
+/*-----------------------------------*/
+
+
+static void put_u32(unsigned char *pucBuffer, unsigned long ulValue)
+{
+	pucBuffer[0] = (unsigned char)( ulValue        & 0xffU);
+	pucBuffer[1] = (unsigned char)((ulValue >>  8) & 0xffU);
+	pucBuffer[2] = (unsigned char)((ulValue >> 16) & 0xffU);
+	pucBuffer[3] = (unsigned char)((ulValue >> 24) & 0xffU);
+}
+
+
+static unsigned long get_u32(const unsigned char *pucBuffer)
+{
+	return (unsigned long)pucBuffer[0] | ((unsigned long)pucBuffer[1] << 8) | ((unsigned long)pucBuffer[2] << 16) | ((unsigned long)pucBuffer[3] << 24);
+}
+
+
+static void send_reply(char cType, unsigned long ulValue0, unsigned long ulValue1, const void *pvData, size_t sizData)
+{
+	unsigned char aucHeader[HOST_TARGET_HEADER_SIZE];
+
+
+	aucHeader[0] = (unsigned char)cType;
+	put_u32(aucHeader + 1, ulValue0);
+	put_u32(aucHeader + 5, ulValue1);
+	fwrite(aucHeader, 1, sizeof(aucHeader), ptReplyFile);
+	if( sizData!=0 )
+	{
+		fwrite(pvData, 1, sizData, ptReplyFile);
+	}
+}
+
+
+static void send_error(const char *pcMessage)
+{
+	size_t sizMessage;
+
+
+	sizMessage = strlen(pcMessage);
+	send_reply('E', sizMessage, 0, pcMessage, sizMessage);
+	fflush(ptReplyFile);
+}
+
+
+void host_target_message(const char *pcMessage, size_t sizMessage)
+{
+	if( fCallIsRunning!=0 )
+	{
+		send_reply('M', sizMessage, 0, pcMessage, sizMessage);
+	}
+	else
+	{
+		fwrite(pcMessage, 1, sizMessage, stderr);
+	}
+}
+
+
+/*-----------------------------------*/
+
+
+unsigned long start(unsigned long ulParameter)
+{
+	NetxConsoleParameter_Init = (unsigned int)ulParameter;
+	netx_consoleapp_init();
+
+	return 0;
+}
+
+
+/*-----------------------------------*/
+
+
+static int is_in_ram(unsigned long ulAddress, unsigned long ulSize)
+{
+	int iResult;
+
+
+	iResult = 0;
+	if( ulAddress>=HOST_TARGET_RAM_START && ulSize<=HOST_TARGET_RAM_SIZE && ulAddress-HOST_TARGET_RAM_START<=HOST_TARGET_RAM_SIZE-ulSize )
+	{
+		iResult = 1;
+	}
+
+	return iResult;
+}
+
+
+static int map_ram(void)
+{
+	int iResult;
+	void *pvRam;
+
+
+	iResult = 0;
+	pvRam = mmap((void*)HOST_TARGET_RAM_START, HOST_TARGET_RAM_SIZE, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_FIXED_NOREPLACE, -1, 0);
+	if( pvRam!=(void*)HOST_TARGET_RAM_START )
+	{
+		fprintf(stderr, "Failed to map the RAM at 0x%08x: %s\n", HOST_TARGET_RAM_START, strerror(errno));
+		iResult = -1;
+	}
+
+	return iResult;
+}
+
+
+static unsigned char *get_flash_memory(const char *pcFile, unsigned long ulSize)
+{
+	unsigned char *pucMemory;
+	int iFd;
+	struct stat tStat;
+
+
+	pucMemory = NULL;
+	if( pcFile==NULL )
+	{
+		pucMemory = (unsigned char*)malloc(ulSize);
+		if( pucMemory!=NULL )
+		{
+			memset(pucMemory, 0xff, ulSize);
+		}
+	}
+	else
+	{
+		iFd = open(pcFile, O_RDWR|O_CREAT, 0644);
+		if( iFd<0 )
+		{
+			fprintf(stderr, "Failed to open %s: %s\n", pcFile, strerror(errno));
+		}
+		else
+		{
+			/* A new file or the new part of a file is erased. */
+			tStat.st_size = 0;
+			if( fstat(iFd, &tStat)!=0 || ((unsigned long)tStat.st_size<ulSize && ftruncate(iFd, (off_t)ulSize)!=0) )
+			{
+				fprintf(stderr, "Failed to resize %s: %s\n", pcFile, strerror(errno));
+			}
+			else
+			{
+				pucMemory = mmap(NULL, ulSize, PROT_READ|PROT_WRITE, MAP_SHARED, iFd, 0);
+				if( pucMemory==MAP_FAILED )
+				{
+					fprintf(stderr, "Failed to map %s: %s\n", pcFile, strerror(errno));
+					pucMemory = NULL;
+				}
+				else if( (unsigned long)tStat.st_size<ulSize )
+				{
+					memset(pucMemory + tStat.st_size, 0xff, ulSize - (unsigned long)tStat.st_size);
+				}
+			}
+			close(iFd);
+		}
+	}
+
+	return pucMemory;
+}
+
+
+/* Get the model configuration for a device name or a JEDEC ID. */
+static int get_spi_flash_config(SPI_NOR_MODEL_CONFIG_T *ptCfg, const char *pcDevice, const char *pcSize)
+{
+	int iResult;
+	int iIndex;
+	unsigned long ulJedecId;
+	unsigned long ulSize;
+	unsigned char aucJedecId[3];
+	char *pcEnd;
+	SPIFLASH_ATTRIBUTES_T tAttr;
+	const SPIFLASH_TIMING_T *ptTiming;
+
+
+	iResult = -1;
+
+	/* An empty size or 0 is the size of the device. */
+	ulSize = 0;
+	if( pcSize!=NULL )
+	{
+		ulSize = strtoul(pcSize, NULL, 0);
+	}
+
+	iIndex = spi_flash_types_get_by_name(pcDevice, &tAttr);
+	if( iIndex>=0 )
+	{
+#ifdef CFG_SPI_FLASH_TIMING
+		ptTiming = atKnownSpiFlashTimings + iIndex;
+#else
+		ptTiming = NULL;
+#endif
+		if( ulSize!=0 && ulSize!=tAttr.ulSize )
+		{
+			fprintf(stderr, "The size of %s is 0x%08lx.\n", pcDevice, tAttr.ulSize);
+		}
+		else
+		{
+			iResult = spi_nor_model_get_config(ptCfg, &tAttr, ptTiming);
+			if( iResult!=0 )
+			{
+				fprintf(stderr, "The model does not support the flash %s.\n", pcDevice);
+			}
+		}
+	}
+	else
+	{
+		ulJedecId = strtoul(pcDevice, &pcEnd, 16);
+		if( strlen(pcDevice)!=6 || *pcEnd!=0 )
+		{
+			fprintf(stderr, "Unknown SPI flash: %s\n", pcDevice);
+		}
+		else if( ulSize==0 || ulSize>SPI_NOR_MODEL_MAX_SIZE || (ulSize&0xfffU)!=0 )
+		{
+			fprintf(stderr, "A generic SPI flash needs a size in 4K steps up to 16MB.\n");
+		}
+		else
+		{
+			aucJedecId[0] = (unsigned char)((ulJedecId >> 16) & 0xffU);
+			aucJedecId[1] = (unsigned char)((ulJedecId >>  8) & 0xffU);
+			aucJedecId[2] = (unsigned char)( ulJedecId        & 0xffU);
+			spi_nor_model_get_generic_config(ptCfg, aucJedecId, ulSize);
+			iResult = 0;
+		}
+	}
+
+	return iResult;
+}
+
+
+/* Parse "unit:chip_select:device[:size][:file]". */
+static int add_spi_flash(char *pcSpec)
+{
+	int iResult;
+	char *apcFields[5];
+	unsigned int uiFields;
+	unsigned int uiUnit;
+	unsigned int uiChipSelect;
+	unsigned char *pucMemory;
+	SPI_NOR_MODEL_CONFIG_T tCfg;
+	SPI_NOR_MODEL_T *ptModel;
+
+
+	iResult = -1;
+
+	uiFields = 0;
+	apcFields[0] = pcSpec;
+	while( uiFields<4 && (pcSpec=strchr(pcSpec, ':'))!=NULL )
+	{
+		*(pcSpec++) = 0;
+		apcFields[++uiFields] = pcSpec;
+	}
+	++uiFields;
+
+	if( uiFields<3 || uiSpiFlashes>=HOST_TARGET_MAX_SPI_FLASHES )
+	{
+		fprintf(stderr, "Invalid SPI flash. Use unit:chip_select:device[:size][:file].\n");
+	}
+	else if( get_spi_flash_config(&tCfg, apcFields[2], (uiFields>3) ? apcFields[3] : NULL)==0 )
+	{
+		uiUnit = (unsigned int)strtoul(apcFields[0], NULL, 0);
+		uiChipSelect = (unsigned int)strtoul(apcFields[1], NULL, 0);
+
+		pucMemory = get_flash_memory((uiFields>4) ? apcFields[4] : NULL, tCfg.ulSize);
+		if( pucMemory!=NULL )
+		{
+			ptModel = atSpiFlashes + uiSpiFlashes;
+			iResult = spi_nor_model_init(ptModel, &tCfg, pucMemory);
+			if( iResult==0 )
+			{
+				iResult = flasher_drv_spi_sim_attach(uiUnit, uiChipSelect, &(ptModel->tDevice));
+				if( iResult!=0 )
+				{
+					fprintf(stderr, "Invalid unit %d or chip select %d.\n", uiUnit, uiChipSelect);
+				}
+				else
+				{
+					++uiSpiFlashes;
+				}
+			}
+		}
+	}
+
+	return iResult;
+}
+
+
+/*-----------------------------------*/
+
+
+static unsigned char *put_statistics(unsigned char *pucBuffer, const SIM_CLOCK_STATISTICS_T *ptStatistics)
+{
+	unsigned long long ullTimeUs;
+
+
+	ullTimeUs = ptStatistics->ullTimeNs / 1000U;
+	put_u32(pucBuffer +  0, (unsigned long)(ptStatistics->ullBusBytes & 0xffffffffU));
+	put_u32(pucBuffer +  4, (unsigned long)(ptStatistics->ullBusBytes >> 32));
+	put_u32(pucBuffer +  8, (unsigned long)(ullTimeUs & 0xffffffffU));
+	put_u32(pucBuffer + 12, (unsigned long)(ullTimeUs >> 32));
+	put_u32(pucBuffer + 16, ptStatistics->ulBusyPolls);
+	put_u32(pucBuffer + 20, ptStatistics->ulPrograms);
+	put_u32(pucBuffer + 24, ptStatistics->ulErases);
+
+	return pucBuffer + 28;
+}
+
+
+static void send_statistics(void)
+{
+	unsigned char aucStatistics[HOST_TARGET_STATISTICS_SIZE];
+	unsigned char *pucBuffer;
+
+
+	pucBuffer = put_statistics(aucStatistics, &tLastCallStatistics);
+	put_statistics(pucBuffer, &tSimClock);
+	send_reply('D', sizeof(aucStatistics), 0, aucStatistics, sizeof(aucStatistics));
+	fflush(ptReplyFile);
+}
+
+
+/*-----------------------------------*/
+
+
+static int process_requests(void)
+{
+	int iResult;
+	unsigned char aucHeader[HOST_TARGET_HEADER_SIZE];
+	unsigned long ulValue0;
+	unsigned long ulValue1;
+	unsigned char *pucData;
+	int fRunning;
+	SIM_CLOCK_STATISTICS_T tStart;
+
+
+	iResult = 0;
+	fRunning = 1;
+	while( fRunning!=0 )
+	{
+		if( fread(aucHeader, 1, sizeof(aucHeader), stdin)!=sizeof(aucHeader) )
+		{
+			/* The host closed the pipe. */
+			break;
+		}
+		ulValue0 = get_u32(aucHeader + 1);
+		ulValue1 = get_u32(aucHeader + 5);
+
+		switch( aucHeader[0] )
+		{
+		case 'W':
+			if( is_in_ram(ulValue0, ulValue1)==0 )
+			{
+				/* Drop the data. */
+				while( ulValue1!=0 && fgetc(stdin)!=EOF )
+				{
+					--ulValue1;
+				}
+				send_error("The write is outside of the RAM.");
+			}
+			else
+			{
+				pucData = (unsigned char*)ulValue0;
+				if( fread(pucData, 1, ulValue1, stdin)!=ulValue1 )
+				{
+					iResult = -1;
+					fRunning = 0;
+				}
+				else
+				{
+					send_reply('K', 0, 0, NULL, 0);
+					fflush(ptReplyFile);
+				}
+			}
+			break;
+
+		case 'R':
+			if( is_in_ram(ulValue0, ulValue1)==0 )
+			{
+				send_error("The read is outside of the RAM.");
+			}
+			else
+			{
+				send_reply('D', ulValue1, 0, (const void*)ulValue0, ulValue1);
+				fflush(ptReplyFile);
+			}
+			break;
+
+		case 'C':
+			if( is_in_ram(ulValue1, sizeof(NETX_CONSOLEAPP_PARAMETER_T))==0 )
+			{
+				send_error("The parameter is outside of the RAM.");
+			}
+			else
+			{
+				/* The execution address points to the netX code. The
+				 * host always runs its own flasher core.
+				 */
+				memcpy(&tStart, &tSimClock, sizeof(SIM_CLOCK_STATISTICS_T));
+				fCallIsRunning = 1;
+				start(ulValue1);
+				fCallIsRunning = 0;
+				sim_clock_get_difference(&tStart, &tLastCallStatistics);
+				send_reply('K', ((NETX_CONSOLEAPP_PARAMETER_T*)ulValue1)->ulReturnValue, 0, NULL, 0);
+				fflush(ptReplyFile);
+			}
+			break;
+
+		case 'S':
+			send_statistics();
+			break;
+
+		case 'Q':
+			fRunning = 0;
+			break;
+
+		default:
+			send_error("Unknown request.");
+			break;
+		}
+	}
+
+	return iResult;
+}
+
+
+int main(int argc, char **argv)
+{
+	int iResult;
+	int iArg;
+
+
+	iResult = -1;
+	if( argc<2 )
+	{
+		fprintf(stderr, "Usage: %s reply_file [--spi unit:chip_select:device[:size][:file]]...\n", argv[0]);
+	}
+	else
+	{
+		/* Open the reply file first. The host waits for the first reply
+		 * and must not block if the arguments are wrong.
+		 */
+		ptReplyFile = fopen(argv[1], "wb");
+		if( ptReplyFile==NULL )
+		{
+			fprintf(stderr, "Failed to open %s: %s\n", argv[1], strerror(errno));
+		}
+		else
+		{
+			iResult = 0;
+			iArg = 2;
+			while( iResult==0 && iArg<argc )
+			{
+				if( strcmp(argv[iArg], "--spi")==0 && iArg+1<argc )
+				{
+					iResult = add_spi_flash(argv[iArg+1]);
+					iArg += 2;
+				}
+				else
+				{
+					fprintf(stderr, "Unknown argument: %s\n", argv[iArg]);
+					iResult = -1;
+				}
+			}
+
+			if( iResult==0 )
+			{
+				iResult = map_ram();
+			}
+
+			if( iResult!=0 )
+			{
+				send_error("Failed to start the virtual target.");
+			}
+			else
+			{
+				send_reply('K', 0, 0, NULL, 0);
+				fflush(ptReplyFile);
+				iResult = process_requests();
+			}
+			fclose(ptReplyFile);
+		}
+	}
+
+	return (iResult==0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,52 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* The virtual netX on the host.
+ *
+ * The host target runs the flasher core in a normal process. The RAM of
+ * the netX is mapped to the same addresses as on the real chip, so all
+ * pointers in the parameter block and the device description work without
+ * a translation. The process must be built for 32 bit to keep the layout
+ * of the structures in flasher_interface.h.
+ *
+ * The host talks to the process over a pipe and a FIFO. See host_target.c
+ * for the protocol.
+ */
+
+#ifndef __HOST_TARGET_H__
+#define __HOST_TARGET_H__
+
+#include <stddef.h>
+
+
+/* This is the INTRAM of the netX 90. It holds the flasher binary, the
+ * parameters and the data buffer. The flasher header of the netX 90
+ * build points into this area, so the same Lua scripts and binaries work
+ * for the host target.
+ */
+#define HOST_TARGET_RAM_START 0x00030000U
+#define HOST_TARGET_RAM_SIZE  0x00040000U
+
+
+/* Send a message from uprintf to the host. */
+void host_target_message(const char *pcMessage, size_t sizMessage);
+
+
+#endif  /* __HOST_TARGET_H__ */
@@ -0,0 +1,227 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_target.h"
+#include "host_test.h"
+#include "spi_flash.h"
+
+
+/* This is the parameter for netx_consoleapp_init. The tests do not use it. */
+unsigned int NetxConsoleParameter_Init;
+
+static int fHostTestVerbose;
+
+static tFlasherInputParameter tHostTestParameter;
+
+
+/*-----------------------------------*/
+
+
+/* The messages of the flasher are only shown in verbose mode. */
+void host_target_message(const char *pcMessage, size_t sizMessage)
+{
+	if( fHostTestVerbose!=0 )
+	{
+		fwrite(pcMessage, 1, sizMessage, stdout);
+	}
+}
+
+
+void host_test_set_verbose(int fVerbose)
+{
+	fHostTestVerbose = fVerbose;
+}
+
+
+/* Attach a model of a flash from spi_flash_types.xml to a simulated bus.
+ * The flash is erased.
+ */
+int host_test_add_spi_flash(SPI_NOR_MODEL_T *ptModel, const char *pcDevice, unsigned int uiUnit, unsigned int uiChipSelect)
+{
+	int iResult;
+	int iIndex;
+	SPIFLASH_ATTRIBUTES_T tAttr;
+	SPI_NOR_MODEL_CONFIG_T tCfg;
+	unsigned char *pucMemory;
+
+
+	iResult = -1;
+	iIndex = spi_flash_types_get_by_name(pcDevice, &tAttr);
+	if( iIndex<0 )
+	{
+		fprintf(stderr, "! Unknown SPI flash: %s\n", pcDevice);
+	}
+	else if( spi_nor_model_get_config(&tCfg, &tAttr, atKnownSpiFlashTimings + iIndex)!=0 )
+	{
+		fprintf(stderr, "! The model does not support the flash %s.\n", pcDevice);
+	}
+	else
+	{
+		pucMemory = (unsigned char*)malloc(tCfg.ulSize);
+		if( pucMemory==NULL )
+		{
+			fprintf(stderr, "! Failed to allocate the memory for the flash %s.\n", pcDevice);
+		}
+		else
+		{
+			memset(pucMemory, 0xff, tCfg.ulSize);
+			iResult = spi_nor_model_init(ptModel, &tCfg, pucMemory);
+			if( iResult==0 )
+			{
+				iResult = flasher_drv_spi_sim_attach(uiUnit, uiChipSelect, &(ptModel->tDevice));
+			}
+		}
+	}
+
+	return iResult;
+}
+
+
+/*-----------------------------------*/
+
+
+/* Call the flasher and get the return message. */
+static NETX_CONSOLEAPP_RESULT_T host_test_call_with_message(tFlasherInputParameter *ptParameter, unsigned long *pulReturnMessage)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	NETX_CONSOLEAPP_PARAMETER_T tConsoleParameter;
+
+
+	memset(&tConsoleParameter, 0, sizeof(tConsoleParameter));
+	tConsoleParameter.pvInitParams = ptParameter;
+	ptParameter->ulParamVersion = FLASHER_INTERFACE_VERSION;
+
+	tResult = netx_consoleapp_main(&tConsoleParameter);
+	if( pulReturnMessage!=NULL )
+	{
+		*pulReturnMessage = (unsigned long)tConsoleParameter.pvReturnMessage;
+	}
+
+	return tResult;
+}
+
+
+NETX_CONSOLEAPP_RESULT_T host_test_call(tFlasherInputParameter *ptParameter)
+{
+	return host_test_call_with_message(ptParameter, NULL);
+}
+
+
+NETX_CONSOLEAPP_RESULT_T host_test_detect_spi(DEVICE_DESCRIPTION_T *ptDevice, unsigned int uiUnit, unsigned int uiChipSelect, unsigned long ulMaximumSpeedKhz, unsigned long ulFlags)
+{
+	FLASHER_SPI_CONFIGURATION_T *ptSpiCfg;
+
+
+	memset(&tHostTestParameter, 0, sizeof(tHostTestParameter));
+	tHostTestParameter.tOperationMode = OPERATION_MODE_Detect;
+	tHostTestParameter.uParameter.tDetect.tSourceTyp = BUS_SPI;
+	tHostTestParameter.uParameter.tDetect.ptDeviceDescription = ptDevice;
+	tHostTestParameter.uParameter.tDetect.ulFlags = ulFlags;
+	ptSpiCfg = &(tHostTestParameter.uParameter.tDetect.uSourceParameter.tSpi);
+	ptSpiCfg->uiUnit = uiUnit;
+	ptSpiCfg->uiChipSelect = uiChipSelect;
+	ptSpiCfg->ulInitialSpeedKhz = HOST_TEST_SPI_INITIAL_SPEED_KHZ;
+	ptSpiCfg->ulMaximumSpeedKhz = ulMaximumSpeedKhz;
+
+	return host_test_call(&tHostTestParameter);
+}
+
+
+NETX_CONSOLEAPP_RESULT_T host_test_erase(const DEVICE_DESCRIPTION_T *ptDevice, unsigned long ulStartAdr, unsigned long ulEndAdr)
+{
+	memset(&tHostTestParameter, 0, sizeof(tHostTestParameter));
+	tHostTestParameter.tOperationMode = OPERATION_MODE_Erase;
+	tHostTestParameter.uParameter.tErase.ptDeviceDescription = ptDevice;
+	tHostTestParameter.uParameter.tErase.ulStartAdr = ulStartAdr;
+	tHostTestParameter.uParameter.tErase.ulEndAdr = ulEndAdr;
+
+	return host_test_call(&tHostTestParameter);
+}
+
+
+NETX_CONSOLEAPP_RESULT_T host_test_flash(const DEVICE_DESCRIPTION_T *ptDevice, unsigned long ulStartAdr, const unsigned char *pucData, unsigned long ulSize)
+{
+	memset(&tHostTestParameter, 0, sizeof(tHostTestParameter));
+	tHostTestParameter.tOperationMode = OPERATION_MODE_Flash;
+	tHostTestParameter.uParameter.tFlash.ptDeviceDescription = ptDevice;
+	tHostTestParameter.uParameter.tFlash.ulStartAdr = ulStartAdr;
+	tHostTestParameter.uParameter.tFlash.ulDataByteSize = ulSize;
+	tHostTestParameter.uParameter.tFlash.pucData = (unsigned char*)pucData;
+
+	return host_test_call(&tHostTestParameter);
+}
+
+
+NETX_CONSOLEAPP_RESULT_T host_test_read(const DEVICE_DESCRIPTION_T *ptDevice, unsigned long ulStartAdr, unsigned char *pucData, unsigned long ulSize)
+{
+	memset(&tHostTestParameter, 0, sizeof(tHostTestParameter));
+	tHostTestParameter.tOperationMode = OPERATION_MODE_Read;
+	tHostTestParameter.uParameter.tRead.ptDeviceDescription = ptDevice;
+	tHostTestParameter.uParameter.tRead.ulStartAdr = ulStartAdr;
+	tHostTestParameter.uParameter.tRead.ulEndAdr = ulStartAdr + ulSize;
+	tHostTestParameter.uParameter.tRead.pucData = pucData;
+
+	return host_test_call(&tHostTestParameter);
+}
+
+
+/* Set up the SPI device for the macro player like sdi_init does. */
+NETX_CONSOLEAPP_RESULT_T host_test_init_spi_macro(FLASHER_SPI_CFG_T *ptSpiDev, unsigned int uiUnit, unsigned int uiChipSelect, unsigned long ulSpeedKhz)
+{
+	FLASHER_SPI_CONFIGURATION_T *ptSpiCfg;
+
+
+	memset(&tHostTestParameter, 0, sizeof(tHostTestParameter));
+	tHostTestParameter.tOperationMode = OPERATION_MODE_SpiMacroPlayer;
+	tHostTestParameter.uParameter.tSpiMacroPlayer.ulCommand = SMC_INITIALIZE;
+	tHostTestParameter.uParameter.tSpiMacroPlayer.ptSpiDev = ptSpiDev;
+	ptSpiCfg = &(tHostTestParameter.uParameter.tSpiMacroPlayer.uCfg.tInit.tSpi);
+	ptSpiCfg->uiUnit = uiUnit;
+	ptSpiCfg->uiChipSelect = uiChipSelect;
+	ptSpiCfg->ulInitialSpeedKhz = ulSpeedKhz;
+	ptSpiCfg->ulMaximumSpeedKhz = ulSpeedKhz;
+
+	return host_test_call(&tHostTestParameter);
+}
+
+
+/* Run a macro. The return message is the size of the log or the error code. */
+NETX_CONSOLEAPP_RESULT_T host_test_run_spi_macro(FLASHER_SPI_CFG_T *ptSpiDev, const unsigned char *pucMacro, size_t sizMacro, unsigned char *pucLog, size_t sizLog, unsigned long *pulReturnMessage)
+{
+	SPI_MACRO_PARAMETER_RUN_T *ptRun;
+
+
+	memset(&tHostTestParameter, 0, sizeof(tHostTestParameter));
+	tHostTestParameter.tOperationMode = OPERATION_MODE_SpiMacroPlayer;
+	tHostTestParameter.uParameter.tSpiMacroPlayer.ulCommand = SMC_RUN_MACRO;
+	tHostTestParameter.uParameter.tSpiMacroPlayer.ptSpiDev = ptSpiDev;
+	ptRun = &(tHostTestParameter.uParameter.tSpiMacroPlayer.uCfg.tRunMacro);
+	ptRun->pucMacro = pucMacro;
+	ptRun->sizMacro = sizMacro;
+	ptRun->pucLog = pucLog;
+	ptRun->sizLog = sizLog;
+
+	return host_test_call_with_message(&tHostTestParameter, pulReturnMessage);
+}
@@ -0,0 +1,53 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+/* Helpers for the unit tests which run the flasher core on the host.
+ *
+ * The tests link the flasher core without host_target.c and call
+ * netx_consoleapp_main directly. The SPI flashes are models on the
+ * simulated buses, see spi_nor_model.h .
+ */
+
+#ifndef __HOST_TEST_H__
+#define __HOST_TEST_H__
+
+#include "flasher_interface.h"
+#include "netx_consoleapp.h"
+#include "spi_nor_model.h"
+
+
+/* The clock for the detection of SPI flashes. */
+#define HOST_TEST_SPI_INITIAL_SPEED_KHZ 1000U
+
+
+void host_test_set_verbose(int fVerbose);
+int host_test_add_spi_flash(SPI_NOR_MODEL_T *ptModel, const char *pcDevice, unsigned int uiUnit, unsigned int uiChipSelect);
+
+NETX_CONSOLEAPP_RESULT_T host_test_call(tFlasherInputParameter *ptParameter);
+NETX_CONSOLEAPP_RESULT_T host_test_detect_spi(DEVICE_DESCRIPTION_T *ptDevice, unsigned int uiUnit, unsigned int uiChipSelect, unsigned long ulMaximumSpeedKhz, unsigned long ulFlags);
+NETX_CONSOLEAPP_RESULT_T host_test_erase(const DEVICE_DESCRIPTION_T *ptDevice, unsigned long ulStartAdr, unsigned long ulEndAdr);
+NETX_CONSOLEAPP_RESULT_T host_test_flash(const DEVICE_DESCRIPTION_T *ptDevice, unsigned long ulStartAdr, const unsigned char *pucData, unsigned long ulSize);
+NETX_CONSOLEAPP_RESULT_T host_test_read(const DEVICE_DESCRIPTION_T *ptDevice, unsigned long ulStartAdr, unsigned char *pucData, unsigned long ulSize);
+NETX_CONSOLEAPP_RESULT_T host_test_init_spi_macro(FLASHER_SPI_CFG_T *ptSpiDev, unsigned int uiUnit, unsigned int uiChipSelect, unsigned long ulSpeedKhz);
+NETX_CONSOLEAPP_RESULT_T host_test_run_spi_macro(FLASHER_SPI_CFG_T *ptSpiDev, const unsigned char *pucMacro, size_t sizMacro, unsigned char *pucLog, size_t sizLog, unsigned long *pulReturnMessage);
+
+
+#endif  /* __HOST_TEST_H__ */
@@ -0,0 +1,254 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* Run lz4_decode_block of the flasher on the host.
+ *
+ * This is used by lz4_benchmark.lua. The script compresses the chunks and
+ * writes them to a file with one record per chunk:
+ *
+ *   uint32 size of the raw chunk
+ *   uint32 size of the compressed chunk
+ *   uint32 in-place gap of the compressed chunk
+ *   uint32 size of the flasher buffer for the chunk
+ *   the compressed chunk
+ *   the raw chunk
+ *
+ * All values are little endian. Each chunk is decoded 3 times:
+ *
+ *   1) to a separate buffer,
+ *   2) in-place from the end of the buffer, like flasher.flashArea places
+ *      the data, if flashArea would send this chunk compressed,
+ *   3) in-place with the compressed data exactly "gap" bytes after the
+ *      start of the buffer. This is the worst case the compressor allows.
+ *
+ * All results must match the raw chunk. The times of 1) and 2) are printed
+ * in one line for the script.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lz4_block.h"
+
+
+typedef struct LZ4_BENCH_TOTALS_STRUCT
+{
+	unsigned long ulChunks;
+	unsigned long ulBytes;
+	unsigned long long ullDecodeNs;
+	unsigned long ulInPlaceChunks;
+	unsigned long ulInPlaceBytes;
+	unsigned long long ullInPlaceNs;
+} LZ4_BENCH_TOTALS_T;
+
+
+static unsigned long long get_time_ns(void)
+{
+	struct timespec tNow;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &tNow);
+	return ((unsigned long long)tNow.tv_sec) * 1000000000ULL + (unsigned long long)tNow.tv_nsec;
+}
+
+
+static int read_uint32(FILE *ptFile, unsigned long *pulValue)
+{
+	unsigned char aucData[4];
+	int iResult;
+
+
+	iResult = -1;
+	if( fread(aucData, 1, sizeof(aucData), ptFile)==sizeof(aucData) )
+	{
+		*pulValue = ((unsigned long)aucData[0])       |
+		            ((unsigned long)aucData[1] <<  8) |
+		            ((unsigned long)aucData[2] << 16) |
+		            ((unsigned long)aucData[3] << 24);
+		iResult = 0;
+	}
+
+	return iResult;
+}
+
+
+/* Decode one chunk and compare it with the raw data.
+ * The time of the decoder is added to *pullTimeNs.
+ */
+static int decode_and_compare(unsigned long ulChunk, const char *pcMode, const unsigned char *pucSrc, unsigned long ulSrcSize, unsigned char *pucDst, const unsigned char *pucRaw, unsigned long ulRawSize, unsigned long long *pullTimeNs)
+{
+	unsigned long long ullStart;
+	unsigned long ulDecodedSize;
+	LZ4_RESULT_T tResult;
+	int iResult;
+
+
+	ullStart = get_time_ns();
+	tResult = lz4_decode_block(pucSrc, ulSrcSize, pucDst, ulRawSize, &ulDecodedSize);
+	*pullTimeNs += get_time_ns() - ullStart;
+
+	iResult = -1;
+	if( tResult!=LZ4_RESULT_OK )
+	{
+		fprintf(stderr, "! Chunk %lu, %s: lz4_decode_block failed with %d.\n", ulChunk, pcMode, tResult);
+	}
+	else if( ulDecodedSize!=ulRawSize )
+	{
+		fprintf(stderr, "! Chunk %lu, %s: decoded 0x%08lx bytes, expected 0x%08lx.\n", ulChunk, pcMode, ulDecodedSize, ulRawSize);
+	}
+	else if( memcmp(pucDst, pucRaw, ulRawSize)!=0 )
+	{
+		fprintf(stderr, "! Chunk %lu, %s: the decoded data differs from the raw data.\n", ulChunk, pcMode);
+	}
+	else
+	{
+		iResult = 0;
+	}
+
+	return iResult;
+}
+
+
+static int process_chunk(FILE *ptFile, unsigned long ulRawSize, LZ4_BENCH_TOTALS_T *ptTotals)
+{
+	unsigned long ulCompressedSize;
+	unsigned long ulGap;
+	unsigned long ulBufferSize;
+	unsigned long ulAllocSize;
+	unsigned long ulOffset;
+	unsigned long long ullDummyNs;
+	unsigned char *pucCompressed;
+	unsigned char *pucRaw;
+	unsigned char *pucBuffer;
+	int iResult;
+
+
+	if( read_uint32(ptFile, &ulCompressedSize)!=0 || read_uint32(ptFile, &ulGap)!=0 || read_uint32(ptFile, &ulBufferSize)!=0 )
+	{
+		fprintf(stderr, "! Chunk %lu: the record header is truncated.\n", ptTotals->ulChunks);
+		return -1;
+	}
+
+	/* The buffer must hold the worst case placement of the compressed data. */
+	ulAllocSize = ulBufferSize;
+	if( ulAllocSize<ulRawSize )
+	{
+		ulAllocSize = ulRawSize;
+	}
+	if( ulAllocSize<(ulGap + ulCompressedSize) )
+	{
+		ulAllocSize = ulGap + ulCompressedSize;
+	}
+
+	iResult = -1;
+	pucCompressed = (unsigned char*)malloc(ulCompressedSize + 1U);
+	pucRaw = (unsigned char*)malloc(ulRawSize + 1U);
+	pucBuffer = (unsigned char*)malloc(ulAllocSize + 1U);
+	if( pucCompressed==NULL || pucRaw==NULL || pucBuffer==NULL )
+	{
+		fprintf(stderr, "! Failed to allocate the buffers for chunk %lu.\n", ptTotals->ulChunks);
+	}
+	else if( fread(pucCompressed, 1, ulCompressedSize, ptFile)!=ulCompressedSize || fread(pucRaw, 1, ulRawSize, ptFile)!=ulRawSize )
+	{
+		fprintf(stderr, "! Chunk %lu: the record data is truncated.\n", ptTotals->ulChunks);
+	}
+	else
+	{
+		/* Decode to a separate buffer. */
+		iResult = decode_and_compare(ptTotals->ulChunks, "separate buffer", pucCompressed, ulCompressedSize, pucBuffer, pucRaw, ulRawSize, &(ptTotals->ullDecodeNs));
+
+		/* Decode in-place from the end of the buffer like flasher.flashArea. */
+		ulOffset = (ulBufferSize - ulCompressedSize) & 0xfffffffcU;
+		if( iResult==0 && ulCompressedSize<ulRawSize && ulCompressedSize<=ulBufferSize && ulOffset>=ulGap )
+		{
+			memcpy(pucBuffer + ulOffset, pucCompressed, ulCompressedSize);
+			iResult = decode_and_compare(ptTotals->ulChunks, "in-place at the end of the buffer", pucBuffer + ulOffset, ulCompressedSize, pucBuffer, pucRaw, ulRawSize, &(ptTotals->ullInPlaceNs));
+			if( iResult==0 )
+			{
+				++ptTotals->ulInPlaceChunks;
+				ptTotals->ulInPlaceBytes += ulRawSize;
+			}
+		}
+
+		/* Decode in-place with the smallest gap the compressor allows. */
+		if( iResult==0 )
+		{
+			memcpy(pucBuffer + ulGap, pucCompressed, ulCompressedSize);
+			ullDummyNs = 0;
+			iResult = decode_and_compare(ptTotals->ulChunks, "in-place at the gap", pucBuffer + ulGap, ulCompressedSize, pucBuffer, pucRaw, ulRawSize, &ullDummyNs);
+		}
+
+		if( iResult==0 )
+		{
+			++ptTotals->ulChunks;
+			ptTotals->ulBytes += ulRawSize;
+		}
+	}
+
+	free(pucCompressed);
+	free(pucRaw);
+	free(pucBuffer);
+
+	return iResult;
+}
+
+
+int main(int argc, char **argv)
+{
+	FILE *ptFile;
+	LZ4_BENCH_TOTALS_T tTotals;
+	unsigned long ulRawSize;
+	int iResult;
+
+
+	if( argc!=2 )
+	{
+		fprintf(stderr, "Usage: %s chunk_file\n", argv[0]);
+		return 2;
+	}
+
+	ptFile = fopen(argv[1], "rb");
+	if( ptFile==NULL )
+	{
+		fprintf(stderr, "! Failed to open %s.\n", argv[1]);
+		return 2;
+	}
+
+	memset(&tTotals, 0, sizeof(tTotals));
+	iResult = 0;
+	while( iResult==0 && read_uint32(ptFile, &ulRawSize)==0 )
+	{
+		iResult = process_chunk(ptFile, ulRawSize, &tTotals);
+	}
+	fclose(ptFile);
+
+	if( iResult!=0 )
+	{
+		return 1;
+	}
+
+	printf("chunks=%lu bytes=%lu decode_ns=%llu inplace_chunks=%lu inplace_bytes=%lu inplace_ns=%llu\n",
+	       tTotals.ulChunks, tTotals.ulBytes, tTotals.ullDecodeNs,
+	       tTotals.ulInPlaceChunks, tTotals.ulInPlaceBytes, tTotals.ullInPlaceNs);
+
+	return 0;
+}
@@ -0,0 +1,88 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* A portable version of sha_transform from sha1_arm.S. The rest of the
+ * SHA1 implementation is shared with the ARM builds.
+ */
+
+#include <stdint.h>
+
+
+#define ROL(x,n) (((x)<<(n)) | ((x)>>(32-(n))))
+
+
+void sha_transform(uint32_t *hash, const unsigned char *data, uint32_t *W)
+{
+	uint32_t a, b, c, d, e, f, k, t;
+	unsigned int i;
+
+
+	for(i=0; i<16; ++i)
+	{
+		W[i] = ((uint32_t)data[4*i]<<24) | ((uint32_t)data[4*i+1]<<16) | ((uint32_t)data[4*i+2]<<8) | (uint32_t)data[4*i+3];
+	}
+	for(i=16; i<80; ++i)
+	{
+		t = W[i-3] ^ W[i-8] ^ W[i-14] ^ W[i-16];
+		W[i] = ROL(t, 1);
+	}
+
+	a = hash[0];
+	b = hash[1];
+	c = hash[2];
+	d = hash[3];
+	e = hash[4];
+
+	for(i=0; i<80; ++i)
+	{
+		if( i<20 )
+		{
+			f = (b & c) | ((~b) & d);
+			k = 0x5a827999U;
+		}
+		else if( i<40 )
+		{
+			f = b ^ c ^ d;
+			k = 0x6ed9eba1U;
+		}
+		else if( i<60 )
+		{
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8f1bbcdcU;
+		}
+		else
+		{
+			f = b ^ c ^ d;
+			k = 0xca62c1d6U;
+		}
+		t = ROL(a, 5) + f + e + k + W[i];
+		e = d;
+		d = c;
+		c = ROL(b, 30);
+		b = a;
+		a = t;
+	}
+
+	hash[0] += a;
+	hash[1] += b;
+	hash[2] += c;
+	hash[3] += d;
+	hash[4] += e;
+}
@@ -0,0 +1,52 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include "sim_clock.h"
+
+
+SIM_CLOCK_STATISTICS_T tSimClock;
+
+
+/* One byte is 8 clocks on the bus. */
+void sim_clock_transfer_byte(unsigned long ulSpeedKhz)
+{
+	++tSimClock.ullBusBytes;
+	if( ulSpeedKhz!=0 )
+	{
+		tSimClock.ullTimeNs += 8000000ULL / ulSpeedKhz;
+	}
+}
+
+
+unsigned long long sim_clock_get_ns(void)
+{
+	return tSimClock.ullTimeNs;
+}
+
+
+/* Get the statistics since ptStart. */
+void sim_clock_get_difference(const SIM_CLOCK_STATISTICS_T *ptStart, SIM_CLOCK_STATISTICS_T *ptDifference)
+{
+	ptDifference->ullTimeNs = tSimClock.ullTimeNs - ptStart->ullTimeNs;
+	ptDifference->ullBusBytes = tSimClock.ullBusBytes - ptStart->ullBusBytes;
+	ptDifference->ulBusyPolls = tSimClock.ulBusyPolls - ptStart->ulBusyPolls;
+	ptDifference->ulPrograms = tSimClock.ulPrograms - ptStart->ulPrograms;
+	ptDifference->ulErases = tSimClock.ulErases - ptStart->ulErases;
+}
@@ -0,0 +1,49 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+#ifndef __SIM_CLOCK_H__
+#define __SIM_CLOCK_H__
+
+
+/* The simulated time of the host target.
+ *
+ * The time only advances with the bytes on the simulated buses and is
+ * compared with the busy times of the device models. The time of the netX
+ * CPU between the transfers is not simulated, so the result is the time
+ * the flashes and the buses need at least.
+ */
+typedef struct SIM_CLOCK_STATISTICS_STRUCT
+{
+	unsigned long long ullTimeNs;     /**< @brief The simulated time in nanoseconds. */
+	unsigned long long ullBusBytes;   /**< @brief The number of bytes on all simulated buses. */
+	unsigned long ulBusyPolls;        /**< @brief The number of status reads while a device was busy. */
+	unsigned long ulPrograms;         /**< @brief The number of program operations. */
+	unsigned long ulErases;           /**< @brief The number of erase operations. */
+} SIM_CLOCK_STATISTICS_T;
+
+
+extern SIM_CLOCK_STATISTICS_T tSimClock;
+
+
+void sim_clock_transfer_byte(unsigned long ulSpeedKhz);
+unsigned long long sim_clock_get_ns(void);
+void sim_clock_get_difference(const SIM_CLOCK_STATISTICS_T *ptStart, SIM_CLOCK_STATISTICS_T *ptDifference);
+
+
+#endif  /* __SIM_CLOCK_H__ */
@@ -0,0 +1,571 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+#include <string.h>
+
+#include "spi_nor_model.h"
+#include "sim_clock.h"
+
+
+/* The number of address bytes for all commands. */
+#define SPI_NOR_MODEL_ADDRESS_BYTES 3U
+
+/* These commands are the same for all supported flashes. */
+#define SPI_NOR_MODEL_OPCODE_READ          0x03U
+#define SPI_NOR_MODEL_OPCODE_WRITE_DISABLE 0x04U
+#define SPI_NOR_MODEL_OPCODE_ERASE_32K     0x52U
+#define SPI_NOR_MODEL_OPCODE_READ_SFDP     0x5aU
+#define SPI_NOR_MODEL_OPCODE_ERASE_64K     0xd8U
+
+/* The typical times of a W25Q32 are used for unknown values. */
+#define SPI_NOR_MODEL_DEFAULT_PAGE_PROGRAM_US  700U
+#define SPI_NOR_MODEL_DEFAULT_ERASE_PAGE_US    10000U
+#define SPI_NOR_MODEL_DEFAULT_ERASE_SECTOR_US  45000U
+#define SPI_NOR_MODEL_DEFAULT_ERASE_32K_US     120000U
+#define SPI_NOR_MODEL_DEFAULT_ERASE_64K_US     150000U
+
+/* The BFPT starts after the SFDP header and one parameter header. */
+#define SPI_NOR_MODEL_SFDP_BFPT_OFFSET 0x30U
+#define SPI_NOR_MODEL_SFDP_BFPT_DWORDS 9U
+
+
+static unsigned long spi_nor_model_default(unsigned long ulValue, unsigned long ulDefault)
+{
+	if( ulValue==0 )
+	{
+		ulValue = ulDefault;
+	}
+
+	return ulValue;
+}
+
+
+static void spi_nor_model_set_default_timing(SPI_NOR_MODEL_CONFIG_T *ptCfg)
+{
+	SPIFLASH_TIMING_T *ptTiming;
+	unsigned long ulBlocks;
+
+
+	ptTiming = &ptCfg->tTiming;
+	ptTiming->ulPageProgramUs = spi_nor_model_default(ptTiming->ulPageProgramUs, SPI_NOR_MODEL_DEFAULT_PAGE_PROGRAM_US);
+	ptTiming->ulErasePageUs = spi_nor_model_default(ptTiming->ulErasePageUs, SPI_NOR_MODEL_DEFAULT_ERASE_PAGE_US);
+	ptTiming->ulEraseSectorUs = spi_nor_model_default(ptTiming->ulEraseSectorUs, SPI_NOR_MODEL_DEFAULT_ERASE_SECTOR_US);
+	ptTiming->ulEraseBlock32Us = spi_nor_model_default(ptTiming->ulEraseBlock32Us, SPI_NOR_MODEL_DEFAULT_ERASE_32K_US);
+	ptTiming->ulEraseBlock64Us = spi_nor_model_default(ptTiming->ulEraseBlock64Us, SPI_NOR_MODEL_DEFAULT_ERASE_64K_US);
+
+	/* A chip erase takes about as long as erasing all 64K blocks. */
+	ulBlocks = (ptCfg->ulSize + 0xffffU) >> 16U;
+	ptTiming->ulEraseChipUs = spi_nor_model_default(ptTiming->ulEraseChipUs, ulBlocks * ptTiming->ulEraseBlock64Us);
+}
+
+
+/* Build the SFDP header, one parameter header and the basic flash
+ * parameter table with the density, the page size and the erase types.
+ */
+static void spi_nor_model_build_sfdp(SPI_NOR_MODEL_T *ptModel)
+{
+	const SPI_NOR_MODEL_CONFIG_T *ptCfg;
+	unsigned char *pucSfdp;
+	unsigned char *pucBfpt;
+	unsigned long ulDensity;
+	unsigned int uiShift;
+
+
+	ptCfg = &ptModel->tCfg;
+	pucSfdp = ptModel->aucSfdp;
+	memset(pucSfdp, 0xff, SPI_NOR_MODEL_SFDP_SIZE);
+
+	/* SFDP header: magic, version 1.6, 1 parameter header. */
+	memcpy(pucSfdp, "SFDP", 4);
+	pucSfdp[4] = 0x06U;
+	pucSfdp[5] = 0x01U;
+	pucSfdp[6] = 0x00U;
+
+	/* Parameter header of the BFPT. */
+	pucSfdp[0x08] = 0x00U;
+	pucSfdp[0x09] = 0x06U;
+	pucSfdp[0x0a] = 0x01U;
+	pucSfdp[0x0b] = SPI_NOR_MODEL_SFDP_BFPT_DWORDS;
+	pucSfdp[0x0c] = SPI_NOR_MODEL_SFDP_BFPT_OFFSET;
+	pucSfdp[0x0d] = 0x00U;
+	pucSfdp[0x0e] = 0x00U;
+
+	pucBfpt = pucSfdp + SPI_NOR_MODEL_SFDP_BFPT_OFFSET;
+	memset(pucBfpt, 0x00, SPI_NOR_MODEL_SFDP_BFPT_DWORDS * 4U);
+
+	/* DWORD 1: 4K erase, write granularity of 64 bytes or more, 3 byte addresses. */
+	pucBfpt[0] = 0x03U;
+	pucBfpt[1] = 0xffU;
+	if( ptCfg->ulSectorSize==0x1000U )
+	{
+		pucBfpt[0] = 0x01U;
+		pucBfpt[1] = ptCfg->ucEraseSectorOpcode;
+	}
+	if( ptCfg->ulPageSize>=64U )
+	{
+		pucBfpt[0] |= 0x04U;
+	}
+	pucBfpt[3] = 0xffU;
+
+	/* DWORD 2: the density in bits minus 1. */
+	ulDensity = (ptCfg->ulSize << 3U) - 1U;
+	pucBfpt[4] = (unsigned char)( ulDensity         & 0xffU);
+	pucBfpt[5] = (unsigned char)((ulDensity >>  8U) & 0xffU);
+	pucBfpt[6] = (unsigned char)((ulDensity >> 16U) & 0xffU);
+	pucBfpt[7] = (unsigned char)((ulDensity >> 24U) & 0x7fU);
+
+	/* DWORD 8 and 9: the erase types. */
+	uiShift = 0;
+	while( (1UL<<uiShift)<ptCfg->ulSectorSize )
+	{
+		++uiShift;
+	}
+	pucBfpt[0x1c] = (unsigned char)uiShift;
+	pucBfpt[0x1d] = ptCfg->ucEraseSectorOpcode;
+	pucBfpt[0x1e] = 15U;
+	pucBfpt[0x1f] = SPI_NOR_MODEL_OPCODE_ERASE_32K;
+	pucBfpt[0x20] = 16U;
+	pucBfpt[0x21] = SPI_NOR_MODEL_OPCODE_ERASE_64K;
+}
+
+
+static int spi_nor_model_is_busy(const SPI_NOR_MODEL_T *ptModel)
+{
+	return (sim_clock_get_ns()<ptModel->ullReadyTimeNs) ? 1 : 0;
+}
+
+
+static void spi_nor_model_set_busy(SPI_NOR_MODEL_T *ptModel, unsigned long ulTimeUs)
+{
+	ptModel->ullReadyTimeNs = sim_clock_get_ns() + 1000ULL * ulTimeUs;
+}
+
+
+static unsigned char spi_nor_model_get_status(const SPI_NOR_MODEL_T *ptModel)
+{
+	const SPI_NOR_MODEL_CONFIG_T *ptCfg;
+	unsigned char ucStatus;
+
+
+	ptCfg = &ptModel->tCfg;
+
+	ucStatus = ptCfg->ucStatusReadyValue;
+	if( spi_nor_model_is_busy(ptModel)!=0 )
+	{
+		ucStatus = (unsigned char)~ucStatus;
+	}
+	ucStatus &= ptCfg->ucStatusReadyMask;
+
+	/* Show the write enable latch if it is not part of the ready bits. */
+	if( ptModel->fWriteEnabled!=0 && (ptCfg->ucStatusReadyMask&SPI_NOR_MODEL_STATUS_WEL)==0 )
+	{
+		ucStatus |= SPI_NOR_MODEL_STATUS_WEL;
+	}
+
+	return ucStatus;
+}
+
+
+static void spi_nor_model_erase(SPI_NOR_MODEL_T *ptModel, unsigned long ulBlockSize, unsigned long ulTimeUs)
+{
+	unsigned long ulStart;
+
+
+	/* The address is rounded down to the start of the block. */
+	ulStart = ptModel->ulAddress & ~(ulBlockSize - 1U);
+	if( ulStart<ptModel->tCfg.ulSize )
+	{
+		if( ulBlockSize>ptModel->tCfg.ulSize-ulStart )
+		{
+			ulBlockSize = ptModel->tCfg.ulSize - ulStart;
+		}
+		memset(ptModel->pucMemory + ulStart, 0xff, ulBlockSize);
+	}
+
+	spi_nor_model_set_busy(ptModel, ulTimeUs);
+	++tSimClock.ulErases;
+}
+
+
+static void spi_nor_model_program(SPI_NOR_MODEL_T *ptModel)
+{
+	unsigned long ulPageSize;
+	unsigned long ulPageStart;
+	unsigned long ulCnt;
+	unsigned char *pucPage;
+
+
+	/* A program can only clear bits. */
+	ulPageSize = ptModel->tCfg.ulPageSize;
+	ulPageStart = ptModel->ulAddress & ~(ulPageSize - 1U);
+	if( ulPageStart<ptModel->tCfg.ulSize )
+	{
+		pucPage = ptModel->pucMemory + ulPageStart;
+		for(ulCnt=0; ulCnt<ulPageSize; ++ulCnt)
+		{
+			pucPage[ulCnt] &= ptModel->aucPage[ulCnt];
+		}
+	}
+
+	spi_nor_model_set_busy(ptModel, ptModel->tCfg.tTiming.ulPageProgramUs);
+	++tSimClock.ulPrograms;
+}
+
+
+/* Execute the command when the chip select goes high. */
+static void spi_nor_model_finish_command(SPI_NOR_MODEL_T *ptModel)
+{
+	const SPI_NOR_MODEL_CONFIG_T *ptCfg;
+	unsigned char ucOpcode;
+	int fHasAddress;
+	int fIsEnabled;
+	int fClearWriteEnable;
+
+
+	ptCfg = &ptModel->tCfg;
+	ucOpcode = ptModel->ucOpcode;
+	fHasAddress = (ptModel->ulBytes>SPI_NOR_MODEL_ADDRESS_BYTES) ? 1 : 0;
+	fIsEnabled = (ptModel->fWriteEnabled!=0 || ptCfg->ucWriteEnableOpcode==0) ? 1 : 0;
+	fClearWriteEnable = 1;
+
+	if( ptModel->fIgnoreCommand!=0 )
+	{
+		/* A busy flash ignores all commands. */
+		fClearWriteEnable = 0;
+	}
+	else if( ptCfg->sizEraseChipCmd!=0 && ptModel->ulBytes==ptCfg->sizEraseChipCmd && memcmp(ptModel->aucCommand, ptCfg->aucEraseChipCmd, ptCfg->sizEraseChipCmd)==0 )
+	{
+		if( fIsEnabled!=0 )
+		{
+			memset(ptModel->pucMemory, 0xff, ptCfg->ulSize);
+			spi_nor_model_set_busy(ptModel, ptCfg->tTiming.ulEraseChipUs);
+			++tSimClock.ulErases;
+		}
+	}
+	else if( ptCfg->ucWriteEnableOpcode!=0 && ucOpcode==ptCfg->ucWriteEnableOpcode )
+	{
+		if( ptModel->ulBytes==1 )
+		{
+			ptModel->fWriteEnabled = 1;
+		}
+		fClearWriteEnable = 0;
+	}
+	else if( ucOpcode==ptCfg->ucPageProgramOpcode )
+	{
+		if( fIsEnabled!=0 && ptModel->ulBytes>1U+SPI_NOR_MODEL_ADDRESS_BYTES )
+		{
+			spi_nor_model_program(ptModel);
+		}
+	}
+	else if( ptCfg->ucErasePageOpcode!=0 && ucOpcode==ptCfg->ucErasePageOpcode )
+	{
+		if( fIsEnabled!=0 && fHasAddress!=0 )
+		{
+			spi_nor_model_erase(ptModel, ptCfg->ulPageSize, ptCfg->tTiming.ulErasePageUs);
+		}
+	}
+	else if( ucOpcode==ptCfg->ucEraseSectorOpcode )
+	{
+		if( fIsEnabled!=0 && fHasAddress!=0 )
+		{
+			spi_nor_model_erase(ptModel, ptCfg->ulSectorSize, ptCfg->tTiming.ulEraseSectorUs);
+		}
+	}
+	else if( ptCfg->fHasBlockErase!=0 && ucOpcode==SPI_NOR_MODEL_OPCODE_ERASE_32K )
+	{
+		if( fIsEnabled!=0 && fHasAddress!=0 )
+		{
+			spi_nor_model_erase(ptModel, 0x8000U, ptCfg->tTiming.ulEraseBlock32Us);
+		}
+	}
+	else if( ptCfg->fHasBlockErase!=0 && ucOpcode==SPI_NOR_MODEL_OPCODE_ERASE_64K )
+	{
+		if( fIsEnabled!=0 && fHasAddress!=0 )
+		{
+			spi_nor_model_erase(ptModel, 0x10000U, ptCfg->tTiming.ulEraseBlock64Us);
+		}
+	}
+	else if( ucOpcode!=SPI_NOR_MODEL_OPCODE_WRITE_DISABLE )
+	{
+		/* Read commands do not change the write enable latch. */
+		fClearWriteEnable = 0;
+	}
+
+	if( fClearWriteEnable!=0 )
+	{
+		ptModel->fWriteEnabled = 0;
+	}
+}
+
+
+static void spi_nor_model_select(SPI_SIM_DEVICE_T *ptDevice, int fIsSelected)
+{
+	SPI_NOR_MODEL_T *ptModel;
+
+
+	ptModel = (SPI_NOR_MODEL_T*)ptDevice;
+
+	if( fIsSelected==0 )
+	{
+		if( ptModel->ulBytes!=0 )
+		{
+			spi_nor_model_finish_command(ptModel);
+		}
+	}
+
+	/* Start a new command. */
+	ptModel->ulBytes = 0;
+	ptModel->ulAddress = 0;
+}
+
+
+/* Collect the address of a command. Returns 1 for the data bytes after the
+ * address and the dummy bytes and sets the index of the data byte.
+ */
+static int spi_nor_model_get_data_index(SPI_NOR_MODEL_T *ptModel, unsigned long ulIndex, unsigned char ucByte, unsigned long ulDummyBytes, unsigned long *pulDataIndex)
+{
+	int iResult;
+
+
+	iResult = 0;
+	if( ulIndex<=SPI_NOR_MODEL_ADDRESS_BYTES )
+	{
+		ptModel->ulAddress = (ptModel->ulAddress << 8U) | ucByte;
+	}
+	else if( ulIndex>SPI_NOR_MODEL_ADDRESS_BYTES+ulDummyBytes )
+	{
+		*pulDataIndex = ulIndex - 1U - SPI_NOR_MODEL_ADDRESS_BYTES - ulDummyBytes;
+		iResult = 1;
+	}
+
+	return iResult;
+}
+
+
+static unsigned char spi_nor_model_exchange(SPI_SIM_DEVICE_T *ptDevice, unsigned char ucByte, unsigned long ulSpeedKhz)
+{
+	SPI_NOR_MODEL_T *ptModel;
+	const SPI_NOR_MODEL_CONFIG_T *ptCfg;
+	unsigned long ulIndex;
+	unsigned long ulDataIndex;
+	unsigned long ulDummyBytes;
+	unsigned char ucOpcode;
+	unsigned char ucResponse;
+
+
+	ptModel = (SPI_NOR_MODEL_T*)ptDevice;
+	ptCfg = &ptModel->tCfg;
+	ucResponse = 0xffU;
+
+	ulIndex = ptModel->ulBytes;
+	++ptModel->ulBytes;
+	if( ulIndex<SPIFLASH_ERASECHIP_SIZE )
+	{
+		ptModel->aucCommand[ulIndex] = ucByte;
+	}
+
+	if( ulIndex==0 )
+	{
+		/* Get the opcode. */
+		ptModel->ucOpcode = ucByte;
+		ptModel->fIgnoreCommand = (spi_nor_model_is_busy(ptModel)!=0 && ucByte!=ptCfg->ucReadStatusOpcode) ? 1 : 0;
+		if( ucByte==ptCfg->ucPageProgramOpcode )
+		{
+			memset(ptModel->aucPage, 0xff, sizeof(ptModel->aucPage));
+		}
+	}
+	else if( ptModel->fIgnoreCommand==0 )
+	{
+		ucOpcode = ptModel->ucOpcode;
+		if( ucOpcode==ptCfg->ucReadStatusOpcode )
+		{
+			ucResponse = spi_nor_model_get_status(ptModel);
+			if( spi_nor_model_is_busy(ptModel)!=0 )
+			{
+				++tSimClock.ulBusyPolls;
+			}
+		}
+		else if( ucOpcode==ptCfg->aucIdSend[0] )
+		{
+			if( ulIndex<ptCfg->sizId )
+			{
+				ucResponse = ptCfg->aucIdMagic[ulIndex];
+			}
+		}
+		else if( ucOpcode==SPI_NOR_MODEL_OPCODE_READ || ucOpcode==ptCfg->ucReadOpcode )
+		{
+			ulDummyBytes = (ucOpcode==ptCfg->ucReadOpcode) ? ptCfg->ucReadDummyBytes : 0U;
+			if( spi_nor_model_get_data_index(ptModel, ulIndex, ucByte, ulDummyBytes, &ulDataIndex)!=0 )
+			{
+				ucResponse = ptModel->pucMemory[(ptModel->ulAddress + ulDataIndex) % ptCfg->ulSize];
+			}
+		}
+		else if( ucOpcode==SPI_NOR_MODEL_OPCODE_READ_SFDP && ptCfg->fHasBlockErase!=0 )
+		{
+			/* SFDP has one dummy byte. */
+			if( spi_nor_model_get_data_index(ptModel, ulIndex, ucByte, 1U, &ulDataIndex)!=0 )
+			{
+				ulDataIndex += ptModel->ulAddress;
+				if( ulDataIndex<SPI_NOR_MODEL_SFDP_SIZE )
+				{
+					ucResponse = ptModel->aucSfdp[ulDataIndex];
+				}
+			}
+		}
+		else if( ucOpcode==ptCfg->ucPageProgramOpcode )
+		{
+			if( spi_nor_model_get_data_index(ptModel, ulIndex, ucByte, 0U, &ulDataIndex)!=0 )
+			{
+				/* The data wraps around at the end of the page. */
+				ptModel->aucPage[(ptModel->ulAddress + ulDataIndex) & (ptCfg->ulPageSize - 1U)] = ucByte;
+			}
+		}
+		else
+		{
+			/* All erase commands have an address. Others ignore it. */
+			spi_nor_model_get_data_index(ptModel, ulIndex, ucByte, 0U, &ulDataIndex);
+		}
+	}
+
+	/* The sample point is too late above the maximum clock. */
+	if( ptCfg->ulMaximumSpeedKhz!=0 && ulSpeedKhz>ptCfg->ulMaximumSpeedKhz )
+	{
+		ucResponse = (unsigned char)((ucResponse >> 1U) | 0x80U);
+	}
+
+	return ucResponse;
+}
+
+
+/*-----------------------------------*/
+
+
+/* Get the configuration of a generic flash with a JEDEC ID, 256 byte pages,
+ * 4K sectors, block erase and SFDP.
+ */
+void spi_nor_model_get_generic_config(SPI_NOR_MODEL_CONFIG_T *ptCfg, const unsigned char *pucJedecId, unsigned long ulSize)
+{
+	memset(ptCfg, 0, sizeof(SPI_NOR_MODEL_CONFIG_T));
+
+	ptCfg->ulSize = ulSize;
+	ptCfg->ulPageSize = 256U;
+	ptCfg->ulSectorSize = 0x1000U;
+	ptCfg->ucReadOpcode = 0x0bU;
+	ptCfg->ucReadDummyBytes = 1U;
+	ptCfg->ucWriteEnableOpcode = 0x06U;
+	ptCfg->ucPageProgramOpcode = 0x02U;
+	ptCfg->ucEraseSectorOpcode = 0x20U;
+	ptCfg->ucReadStatusOpcode = 0x05U;
+	ptCfg->ucStatusReadyMask = 0x01U;
+	ptCfg->ucStatusReadyValue = 0x00U;
+	ptCfg->fHasBlockErase = 1;
+	ptCfg->sizEraseChipCmd = 1U;
+	ptCfg->aucEraseChipCmd[0] = 0xc7U;
+
+	/* The ID command is 0x9f and 3 bytes. */
+	ptCfg->sizId = 4U;
+	ptCfg->aucIdSend[0] = 0x9fU;
+	memcpy(ptCfg->aucIdMagic + 1, pucJedecId, 3U);
+
+	spi_nor_model_set_default_timing(ptCfg);
+}
+
+
+/* Get the configuration from an entry of spi_flash_types.xml. ptTiming can
+ * be NULL. Only flashes with linear addresses and a page program command
+ * can be simulated.
+ */
+int spi_nor_model_get_config(SPI_NOR_MODEL_CONFIG_T *ptCfg, const SPIFLASH_ATTRIBUTES_T *ptAttr, const SPIFLASH_TIMING_T *ptTiming)
+{
+	int iResult;
+
+
+	memset(ptCfg, 0, sizeof(SPI_NOR_MODEL_CONFIG_T));
+
+	iResult = -1;
+	if( ptAttr->tAdrMode==SPIFLASH_ADR_LINEAR &&
+	    ptAttr->ucPageProgOpcode!=0 &&
+	    ptAttr->ucIdLength!=0 &&
+	    ptAttr->ulPageSize!=0 && ptAttr->ulPageSize<=SPI_NOR_MODEL_MAX_PAGE_SIZE && (ptAttr->ulPageSize&(ptAttr->ulPageSize-1U))==0 &&
+	    ptAttr->ulSize!=0 && ptAttr->ulSize<=SPI_NOR_MODEL_MAX_SIZE )
+	{
+		ptCfg->ulSize = ptAttr->ulSize;
+		ptCfg->ulPageSize = ptAttr->ulPageSize;
+		ptCfg->ulSectorSize = ptAttr->ulPageSize * ptAttr->ulSectorPages;
+		ptCfg->ulMaximumSpeedKhz = ptAttr->ulClock;
+		ptCfg->ucReadOpcode = ptAttr->ucReadOpcode;
+		ptCfg->ucReadDummyBytes = ptAttr->ucReadOpcodeDCBytes;
+		ptCfg->ucWriteEnableOpcode = ptAttr->ucWriteEnableOpcode;
+		ptCfg->ucPageProgramOpcode = ptAttr->ucPageProgOpcode;
+		ptCfg->ucErasePageOpcode = ptAttr->ucErasePageOpcode;
+		ptCfg->ucEraseSectorOpcode = ptAttr->ucEraseSectorOpcode;
+		ptCfg->ucReadStatusOpcode = ptAttr->ucReadStatusOpcode;
+		ptCfg->ucStatusReadyMask = ptAttr->ucStatusReadyMask;
+		ptCfg->ucStatusReadyValue = ptAttr->ucStatusReadyValue;
+		ptCfg->sizEraseChipCmd = ptAttr->ucEraseChipCmdLen;
+		memcpy(ptCfg->aucEraseChipCmd, ptAttr->aucEraseChipCmd, SPIFLASH_ERASECHIP_SIZE);
+		ptCfg->sizId = ptAttr->ucIdLength;
+		memcpy(ptCfg->aucIdSend, ptAttr->aucIdSend, SPIFLASH_ID_SIZE);
+		memcpy(ptCfg->aucIdMagic, ptAttr->aucIdMagic, SPIFLASH_ID_SIZE);
+
+		if( ptTiming!=NULL )
+		{
+			memcpy(&ptCfg->tTiming, ptTiming, sizeof(SPIFLASH_TIMING_T));
+			/* Known block erase times show the 32K and 64K erase. */
+			if( ptTiming->ulEraseBlock32Us!=0 && ptTiming->ulEraseBlock64Us!=0 && ptCfg->ulSectorSize<=0x8000U )
+			{
+				ptCfg->fHasBlockErase = 1;
+			}
+		}
+		spi_nor_model_set_default_timing(ptCfg);
+
+		iResult = 0;
+	}
+
+	return iResult;
+}
+
+
+int spi_nor_model_init(SPI_NOR_MODEL_T *ptModel, const SPI_NOR_MODEL_CONFIG_T *ptCfg, unsigned char *pucMemory)
+{
+	int iResult;
+
+
+	iResult = -1;
+	if( ptCfg->ulSize!=0 && ptCfg->ulSectorSize!=0 && pucMemory!=NULL )
+	{
+		iResult = 0;
+	}
+
+	memset(ptModel, 0, sizeof(SPI_NOR_MODEL_T));
+
+	ptModel->tDevice.pfnSelect = spi_nor_model_select;
+	ptModel->tDevice.pfnExchange = spi_nor_model_exchange;
+
+	memcpy(&ptModel->tCfg, ptCfg, sizeof(SPI_NOR_MODEL_CONFIG_T));
+	ptModel->pucMemory = pucMemory;
+
+	if( ptCfg->fHasBlockErase!=0 )
+	{
+		spi_nor_model_build_sfdp(ptModel);
+	}
+
+	return iResult;
+}
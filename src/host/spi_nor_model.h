@@ -0,0 +1,100 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* A model of a SPI NOR flash for the host target.
+ *
+ * The model is configured from an entry of spi_flash_types.xml or as a
+ * generic flash with a JEDEC ID. It understands the ID, status, write
+ * enable, read, page program, page, sector and block erase and the chip
+ * erase commands with 3 address bytes. Erase and program are executed when
+ * the chip select goes high, like on a real flash.
+ *
+ * After a program or erase the flash is busy for the typical time of the
+ * device. The time runs on the simulated clock (see sim_clock.h), so the
+ * busy polls of the flasher are counted instead of waited for. A busy flash
+ * only answers the status command.
+ *
+ * Above the maximum clock of the device the read data is shifted by one
+ * bit, like with a sample point that is too late.
+ */
+
+#ifndef __SPI_NOR_MODEL_H__
+#define __SPI_NOR_MODEL_H__
+
+#include "drv_spi_sim.h"
+#include "spi_flash_types.h"
+
+
+#define SPI_NOR_MODEL_MAX_PAGE_SIZE 256
+#define SPI_NOR_MODEL_MAX_SIZE 0x01000000U
+#define SPI_NOR_MODEL_SFDP_SIZE 0x54U
+
+#define SPI_NOR_MODEL_STATUS_WEL 0x02U
+
+
+typedef struct SPI_NOR_MODEL_CONFIG_STRUCT
+{
+	unsigned long ulSize;                                 /**< @brief The size of the flash in bytes. */
+	unsigned long ulPageSize;                             /**< @brief The size of one page in bytes. */
+	unsigned long ulSectorSize;                           /**< @brief The size of one sector in bytes. */
+	unsigned long ulMaximumSpeedKhz;                      /**< @brief The maximum clock of the device. 0 is no limit. */
+	unsigned char ucReadOpcode;                           /**< @brief The opcode for read. 0x03 is always available. */
+	unsigned char ucReadDummyBytes;                       /**< @brief The dummy bytes after the address of a read. */
+	unsigned char ucWriteEnableOpcode;                    /**< @brief The opcode for write enable. 0 means that the flash is always enabled. */
+	unsigned char ucPageProgramOpcode;                    /**< @brief The opcode for page program. */
+	unsigned char ucErasePageOpcode;                      /**< @brief The opcode to erase one page. 0 means not available. */
+	unsigned char ucEraseSectorOpcode;                    /**< @brief The opcode to erase one sector. */
+	unsigned char ucReadStatusOpcode;                     /**< @brief The opcode for read status. */
+	unsigned char ucStatusReadyMask;                      /**< @brief The bits in the status which show a busy flash. */
+	unsigned char ucStatusReadyValue;                     /**< @brief The value of these bits when the flash is ready. */
+	int fHasBlockErase;                                   /**< @brief The flash has the 32K (0x52) and 64K (0xd8) erase and SFDP. */
+	size_t sizEraseChipCmd;                               /**< @brief The length of the chip erase command. 0 means not available. */
+	unsigned char aucEraseChipCmd[SPIFLASH_ERASECHIP_SIZE];
+	size_t sizId;                                         /**< @brief The length of the ID command and response. */
+	unsigned char aucIdSend[SPIFLASH_ID_SIZE];
+	unsigned char aucIdMagic[SPIFLASH_ID_SIZE];
+	SPIFLASH_TIMING_T tTiming;                            /**< @brief The busy times. 0 is replaced by a default. */
+} SPI_NOR_MODEL_CONFIG_T;
+
+
+typedef struct SPI_NOR_MODEL_STRUCT
+{
+	SPI_SIM_DEVICE_T tDevice;                             /**< @brief The bus interface. This must be the first element. */
+	SPI_NOR_MODEL_CONFIG_T tCfg;                          /**< @brief The configuration. */
+	unsigned char *pucMemory;                             /**< @brief The contents of the flash. */
+
+	int fWriteEnabled;                                    /**< @brief The write enable latch. */
+	unsigned long long ullReadyTimeNs;                    /**< @brief The simulated time when the flash is ready again. */
+	unsigned char ucOpcode;                               /**< @brief The opcode of the current command. */
+	int fIgnoreCommand;                                   /**< @brief The current command started while the flash was busy. */
+	unsigned long ulBytes;                                /**< @brief The number of bytes since the chip select. */
+	unsigned long ulAddress;                              /**< @brief The address of the current command. */
+	unsigned char aucCommand[SPIFLASH_ERASECHIP_SIZE];    /**< @brief The first bytes of the current command. */
+	unsigned char aucPage[SPI_NOR_MODEL_MAX_PAGE_SIZE];   /**< @brief The data for a page program. */
+	unsigned char aucSfdp[SPI_NOR_MODEL_SFDP_SIZE];       /**< @brief The SFDP table. */
+} SPI_NOR_MODEL_T;
+
+
+void spi_nor_model_get_generic_config(SPI_NOR_MODEL_CONFIG_T *ptCfg, const unsigned char *pucJedecId, unsigned long ulSize);
+int spi_nor_model_get_config(SPI_NOR_MODEL_CONFIG_T *ptCfg, const SPIFLASH_ATTRIBUTES_T *ptAttr, const SPIFLASH_TIMING_T *ptTiming);
+int spi_nor_model_init(SPI_NOR_MODEL_T *ptModel, const SPI_NOR_MODEL_CONFIG_T *ptCfg, unsigned char *pucMemory);
+
+
+#endif  /* __SPI_NOR_MODEL_H__ */
@@ -0,0 +1,719 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* Program data with erased chunks through the Spansion and the Strata
+ * driver on a model of a parallel NOR flash.
+ *
+ * The drivers must not send a program command for data which contains
+ * only the erased value. All other data must reach the flash and the
+ * skipped bytes must be reported. The cases cover the buffered and the
+ * single element writes, 8 and 16 bit buses and paired devices.
+ *
+ * The drivers access the flash through normal pointers. Here the flash is
+ * a read-only mapping, so each write raises SIGSEGV. The handler makes
+ * the mapping writable and single steps the write. The SIGTRAP after the
+ * write passes the value to the model, which then puts the data it wants
+ * the driver to read into the mapping. This needs Linux on x86.
+ *
+ * The 32 bit buses are not tested, they need a 32 bit "unsigned long".
+ *
+ * Use "-v" to see the messages of the flasher.
+ */
+
+#define _GNU_SOURCE
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+#include "cfi_flash.h"
+#include "spansion.h"
+#include "strata.h"
+
+
+#if defined(__linux__) && (defined(__i386__) || defined(__x86_64__))
+
+
+#define TEST_SECTOR_SIZE    0x1000U
+#define TEST_SECTORS        4U
+#define TEST_FLASH_SIZE     (TEST_SECTOR_SIZE * TEST_SECTORS)
+
+/* The data has blocks of this size which are erased, random or erased
+ * except for one byte.
+ */
+#define TEST_BLOCK_SIZE     0x80U
+
+/* The largest write buffer of all devices in a pair. */
+#define TEST_MAX_BUFFER     0x100U
+
+#define TEST_EFLAGS_TF      0x00000100U
+
+#define TEST_MFG_SPANSION   0x01U
+#define TEST_MFG_INTEL      0x89U
+
+#define TEST_INTEL_STATUS_READY  0x80U
+
+
+typedef enum TEST_CMDSET_ENUM
+{
+	TEST_CMDSET_Spansion  = 0,
+	TEST_CMDSET_Intel     = 1
+} TEST_CMDSET_T;
+
+
+typedef enum TEST_MODEL_STATE_ENUM
+{
+	TEST_MODEL_STATE_Read           = 0,
+	TEST_MODEL_STATE_Unlock1        = 1,    /* Spansion: got the first unlock cycle. */
+	TEST_MODEL_STATE_Unlock2        = 2,    /* Spansion: got the second unlock cycle. */
+	TEST_MODEL_STATE_Program        = 3,    /* Spansion: the next write is the data for a single element. */
+	TEST_MODEL_STATE_BufferCount    = 4,    /* The next write is the number of elements minus 1. */
+	TEST_MODEL_STATE_BufferData     = 5,    /* The next writes fill the write buffer. */
+	TEST_MODEL_STATE_BufferConfirm  = 6,    /* The next write starts programming the buffer. */
+	TEST_MODEL_STATE_Id             = 7,    /* The reads return the manufacturer. */
+	TEST_MODEL_STATE_Status         = 8     /* Intel: the reads return the status. */
+} TEST_MODEL_STATE_T;
+
+
+typedef struct TEST_MODEL_STRUCT
+{
+	TEST_CMDSET_T tCmdSet;
+	unsigned long ulElementSize;            /* The number of bytes on the bus. */
+	int fPaired;
+	TEST_MODEL_STATE_T tState;
+	unsigned long ulBufferOffset;           /* The offset of the first element in the write buffer. */
+	unsigned long ulBufferSize;             /* The number of bytes in the write buffer. */
+	unsigned long ulBufferElementsLeft;
+	unsigned long ulProgramCommands;
+	unsigned long ulProgrammedBytes;
+	const char *pcError;                    /* The first protocol error or NULL. */
+	unsigned char aucBuffer[TEST_MAX_BUFFER];
+	unsigned char aucArray[TEST_FLASH_SIZE];
+} TEST_MODEL_T;
+
+
+typedef struct TEST_CASE_STRUCT
+{
+	const char *pcName;
+	TEST_CMDSET_T tCmdSet;
+	BUS_WIDTH_T tBits;
+	int fPaired;
+	unsigned long ulMaxBufferWriteSize;     /* The buffer of one device. 1 means no buffered writes. */
+	unsigned long ulOffset;
+	unsigned long ulLength;
+} TEST_CASE_T;
+
+
+static const TEST_CASE_T atCases[] =
+{
+	{ "spansion 8 bit",           TEST_CMDSET_Spansion, BUS_WIDTH_8Bit,  0, 0x20U, 0x0013U, 0x3e41U },
+	{ "spansion 16 bit",          TEST_CMDSET_Spansion, BUS_WIDTH_16Bit, 0, 0x40U, 0x0016U, 0x3e40U },
+	{ "spansion 2x8 bit",         TEST_CMDSET_Spansion, BUS_WIDTH_16Bit, 1, 0x20U, 0x0016U, 0x3e40U },
+	{ "spansion 16 bit no buffer", TEST_CMDSET_Spansion, BUS_WIDTH_16Bit, 0, 0x01U, 0x0016U, 0x3e40U },
+	{ "strata 8 bit",             TEST_CMDSET_Intel,    BUS_WIDTH_8Bit,  0, 0x20U, 0x0000U, 0x4000U },
+	{ "strata 16 bit",            TEST_CMDSET_Intel,    BUS_WIDTH_16Bit, 0, 0x40U, 0x0040U, 0x3f80U },
+	{ "strata 2x8 bit",           TEST_CMDSET_Intel,    BUS_WIDTH_16Bit, 1, 0x20U, 0x0040U, 0x3f80U }
+};
+
+
+static TEST_MODEL_T tModel;
+static unsigned char *pucWindow;
+static unsigned long ulPendingOffset;
+static int fVerbose;
+
+static union
+{
+	unsigned char auc[TEST_FLASH_SIZE];
+	unsigned long aul[TEST_FLASH_SIZE / sizeof(unsigned long)];
+} uData;
+
+
+
+void host_target_message(const char *pcMessage, size_t sizMessage)
+{
+	if( fVerbose!=0 )
+	{
+		fwrite(pcMessage, 1, sizMessage, stdout);
+	}
+}
+
+
+
+static void model_error(TEST_MODEL_T *ptModel, const char *pcError)
+{
+	if( ptModel->pcError==NULL )
+	{
+		ptModel->pcError = pcError;
+	}
+	ptModel->tState = TEST_MODEL_STATE_Read;
+}
+
+
+
+/* Put a value on each device of the element at ulOffset. */
+static void model_show_element(const TEST_MODEL_T *ptModel, unsigned long ulOffset, unsigned char ucValue)
+{
+	memset(pucWindow + ulOffset, 0, ptModel->ulElementSize);
+	pucWindow[ulOffset] = ucValue;
+	if( ptModel->fPaired!=0 )
+	{
+		pucWindow[ulOffset + ptModel->ulElementSize / 2U] = ucValue;
+	}
+}
+
+
+
+/* Show the driver what it would read from the flash in the current state. */
+static void model_render(const TEST_MODEL_T *ptModel)
+{
+	unsigned long ulSector;
+
+
+	memcpy(pucWindow, ptModel->aucArray, TEST_FLASH_SIZE);
+	if( ptModel->tState==TEST_MODEL_STATE_Id )
+	{
+		model_show_element(ptModel, 0, (ptModel->tCmdSet==TEST_CMDSET_Spansion) ? TEST_MFG_SPANSION : TEST_MFG_INTEL);
+	}
+	else if( ptModel->tCmdSet==TEST_CMDSET_Intel && ptModel->tState!=TEST_MODEL_STATE_Read )
+	{
+		/* The Strata driver polls the status at the start of the sector. */
+		for(ulSector=0; ulSector<TEST_SECTORS; ++ulSector)
+		{
+			model_show_element(ptModel, ulSector * TEST_SECTOR_SIZE, TEST_INTEL_STATUS_READY);
+		}
+	}
+}
+
+
+
+/* Program data into the array. The flash can only clear bits. */
+static void model_program(TEST_MODEL_T *ptModel, unsigned long ulOffset, const unsigned char *pucData, unsigned long ulSize)
+{
+	unsigned long ulCnt;
+	unsigned char ucAnd;
+
+
+	if( ulOffset+ulSize>TEST_FLASH_SIZE )
+	{
+		model_error(ptModel, "The data of a program command is outside of the flash.");
+	}
+	else
+	{
+		ucAnd = 0xffU;
+		for(ulCnt=0; ulCnt<ulSize; ++ulCnt)
+		{
+			ptModel->aucArray[ulOffset + ulCnt] &= pucData[ulCnt];
+			ucAnd &= pucData[ulCnt];
+		}
+		if( ucAnd==0xffU )
+		{
+			model_error(ptModel, "A program command wrote only erased data.");
+		}
+		++ptModel->ulProgramCommands;
+		ptModel->ulProgrammedBytes += ulSize;
+	}
+}
+
+
+
+static void model_buffer_data(TEST_MODEL_T *ptModel, unsigned long ulOffset, const unsigned char *pucElement)
+{
+	if( ptModel->ulBufferSize==0 )
+	{
+		ptModel->ulBufferOffset = ulOffset;
+	}
+
+	if( ulOffset!=ptModel->ulBufferOffset+ptModel->ulBufferSize || ptModel->ulBufferSize+ptModel->ulElementSize>TEST_MAX_BUFFER )
+	{
+		model_error(ptModel, "The write buffer is not filled in one piece.");
+	}
+	else
+	{
+		memcpy(ptModel->aucBuffer + ptModel->ulBufferSize, pucElement, ptModel->ulElementSize);
+		ptModel->ulBufferSize += ptModel->ulElementSize;
+		--ptModel->ulBufferElementsLeft;
+		if( ptModel->ulBufferElementsLeft==0 )
+		{
+			ptModel->tState = TEST_MODEL_STATE_BufferConfirm;
+		}
+	}
+}
+
+
+
+static void model_write_spansion(TEST_MODEL_T *ptModel, unsigned long ulOffset, const unsigned char *pucElement)
+{
+	unsigned long ulIndex;
+	unsigned char ucCmd;
+
+
+	/* The unlock addresses count elements of the bus. */
+	ulIndex = ulOffset / ptModel->ulElementSize;
+	ucCmd = pucElement[0];
+
+	switch( ptModel->tState )
+	{
+	case TEST_MODEL_STATE_Program:
+		model_program(ptModel, ulOffset, pucElement, ptModel->ulElementSize);
+		ptModel->tState = TEST_MODEL_STATE_Read;
+		break;
+
+	case TEST_MODEL_STATE_BufferCount:
+		ptModel->ulBufferSize = 0;
+		ptModel->ulBufferElementsLeft = (unsigned long)ucCmd + 1U;
+		ptModel->tState = TEST_MODEL_STATE_BufferData;
+		break;
+
+	case TEST_MODEL_STATE_BufferData:
+		model_buffer_data(ptModel, ulOffset, pucElement);
+		break;
+
+	case TEST_MODEL_STATE_BufferConfirm:
+		if( ucCmd!=0x29U )
+		{
+			model_error(ptModel, "The write buffer was not confirmed.");
+		}
+		else
+		{
+			model_program(ptModel, ptModel->ulBufferOffset, ptModel->aucBuffer, ptModel->ulBufferSize);
+			ptModel->tState = TEST_MODEL_STATE_Read;
+		}
+		break;
+
+	case TEST_MODEL_STATE_Unlock1:
+		if( ulIndex==0x2aaU && ucCmd==0x55U )
+		{
+			ptModel->tState = TEST_MODEL_STATE_Unlock2;
+		}
+		else
+		{
+			model_error(ptModel, "Wrong second unlock cycle.");
+		}
+		break;
+
+	case TEST_MODEL_STATE_Unlock2:
+		if( ulIndex==0x555U && ucCmd==0xa0U )
+		{
+			ptModel->tState = TEST_MODEL_STATE_Program;
+		}
+		else if( ulIndex==0x555U && ucCmd==0x90U )
+		{
+			ptModel->tState = TEST_MODEL_STATE_Id;
+		}
+		else if( (ulOffset%TEST_SECTOR_SIZE)==0 && ucCmd==0x25U )
+		{
+			ptModel->tState = TEST_MODEL_STATE_BufferCount;
+		}
+		else
+		{
+			model_error(ptModel, "Unknown Spansion command.");
+		}
+		break;
+
+	case TEST_MODEL_STATE_Read:
+	case TEST_MODEL_STATE_Id:
+	case TEST_MODEL_STATE_Status:
+		if( ucCmd==0xf0U )
+		{
+			ptModel->tState = TEST_MODEL_STATE_Read;
+		}
+		else if( ulIndex==0x555U && ucCmd==0xaaU )
+		{
+			ptModel->tState = TEST_MODEL_STATE_Unlock1;
+		}
+		else
+		{
+			model_error(ptModel, "Wrong first unlock cycle.");
+		}
+		break;
+	}
+}
+
+
+
+static void model_write_intel(TEST_MODEL_T *ptModel, unsigned long ulOffset, const unsigned char *pucElement)
+{
+	unsigned char ucCmd;
+
+
+	ucCmd = pucElement[0];
+
+	switch( ptModel->tState )
+	{
+	case TEST_MODEL_STATE_BufferCount:
+		ptModel->ulBufferSize = 0;
+		ptModel->ulBufferElementsLeft = (unsigned long)ucCmd + 1U;
+		ptModel->tState = TEST_MODEL_STATE_BufferData;
+		break;
+
+	case TEST_MODEL_STATE_BufferData:
+		model_buffer_data(ptModel, ulOffset, pucElement);
+		break;
+
+	case TEST_MODEL_STATE_BufferConfirm:
+		if( ucCmd!=0xd0U )
+		{
+			model_error(ptModel, "The write buffer was not confirmed.");
+		}
+		else
+		{
+			model_program(ptModel, ptModel->ulBufferOffset, ptModel->aucBuffer, ptModel->ulBufferSize);
+			ptModel->tState = TEST_MODEL_STATE_Status;
+		}
+		break;
+
+	case TEST_MODEL_STATE_Read:
+	case TEST_MODEL_STATE_Unlock1:
+	case TEST_MODEL_STATE_Unlock2:
+	case TEST_MODEL_STATE_Program:
+	case TEST_MODEL_STATE_Id:
+	case TEST_MODEL_STATE_Status:
+		switch( ucCmd )
+		{
+		case 0xffU:
+			ptModel->tState = TEST_MODEL_STATE_Read;
+			break;
+
+		case 0x50U:
+			/* Clear the status. There are no errors to clear. */
+			break;
+
+		case 0x70U:
+			ptModel->tState = TEST_MODEL_STATE_Status;
+			break;
+
+		case 0x90U:
+			ptModel->tState = TEST_MODEL_STATE_Id;
+			break;
+
+		case 0xe8U:
+			if( (ulOffset%TEST_SECTOR_SIZE)!=0 )
+			{
+				model_error(ptModel, "The write buffer command is not at the start of a sector.");
+			}
+			else
+			{
+				ptModel->tState = TEST_MODEL_STATE_BufferCount;
+			}
+			break;
+
+		default:
+			model_error(ptModel, "Unknown Intel command.");
+			break;
+		}
+		break;
+	}
+}
+
+
+
+static void test_on_segv(int iSignal, siginfo_t *ptInfo, void *pvContext)
+{
+	ucontext_t *ptContext;
+	unsigned char *pucAddress;
+
+
+	ptContext = (ucontext_t*)pvContext;
+	pucAddress = (unsigned char*)ptInfo->si_addr;
+	if( pucAddress<pucWindow || pucAddress>=pucWindow+TEST_FLASH_SIZE )
+	{
+		/* This is a real crash. Let it happen again without the handler. */
+		signal(iSignal, SIG_DFL);
+	}
+	else
+	{
+		/* Repeat the write on the writable flash, then stop. */
+		ulPendingOffset = (unsigned long)(pucAddress - pucWindow);
+		mprotect(pucWindow, TEST_FLASH_SIZE, PROT_READ|PROT_WRITE);
+		ptContext->uc_mcontext.gregs[REG_EFL] |= TEST_EFLAGS_TF;
+	}
+}
+
+
+
+static void test_on_trap(int iSignal, siginfo_t *ptInfo, void *pvContext)
+{
+	ucontext_t *ptContext;
+	unsigned long ulOffset;
+	unsigned char aucElement[4];
+
+
+	(void)iSignal;
+	(void)ptInfo;
+
+	ptContext = (ucontext_t*)pvContext;
+	ptContext->uc_mcontext.gregs[REG_EFL] &= ~(greg_t)TEST_EFLAGS_TF;
+
+	/* The drivers always write complete elements. */
+	ulOffset = ulPendingOffset & ~(tModel.ulElementSize - 1U);
+	memcpy(aucElement, pucWindow + ulOffset, tModel.ulElementSize);
+	if( tModel.tCmdSet==TEST_CMDSET_Spansion )
+	{
+		model_write_spansion(&tModel, ulOffset, aucElement);
+	}
+	else
+	{
+		model_write_intel(&tModel, ulOffset, aucElement);
+	}
+	model_render(&tModel);
+
+	mprotect(pucWindow, TEST_FLASH_SIZE, PROT_READ);
+}
+
+
+
+static int install_handlers(void)
+{
+	struct sigaction tAction;
+	int iResult;
+
+
+	iResult = -1;
+	pucWindow = (unsigned char*)mmap(NULL, TEST_FLASH_SIZE, PROT_READ, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+	if( pucWindow==MAP_FAILED )
+	{
+		fprintf(stderr, "! Failed to map the flash.\n");
+	}
+	else
+	{
+		memset(&tAction, 0, sizeof(tAction));
+		sigemptyset(&tAction.sa_mask);
+		tAction.sa_flags = SA_SIGINFO;
+		tAction.sa_sigaction = test_on_segv;
+		if( sigaction(SIGSEGV, &tAction, NULL)==0 )
+		{
+			tAction.sa_sigaction = test_on_trap;
+			if( sigaction(SIGTRAP, &tAction, NULL)==0 )
+			{
+				iResult = 0;
+			}
+		}
+		if( iResult!=0 )
+		{
+			fprintf(stderr, "! Failed to install the signal handlers.\n");
+		}
+	}
+
+	return iResult;
+}
+
+
+
+/* Fill the data with blocks which are erased, random or erased except for
+ * one byte.
+ */
+static void fill_data(unsigned char *pucData, unsigned long ulLength)
+{
+	unsigned long ulOffset;
+	unsigned long ulCnt;
+	unsigned long ulBlockSize;
+
+
+	for(ulOffset=0; ulOffset<ulLength; ulOffset+=ulBlockSize)
+	{
+		ulBlockSize = ulLength - ulOffset;
+		if( ulBlockSize>TEST_BLOCK_SIZE )
+		{
+			ulBlockSize = TEST_BLOCK_SIZE;
+		}
+
+		memset(pucData + ulOffset, 0xff, ulBlockSize);
+		switch( rand()%3 )
+		{
+		case 0:
+			break;
+
+		case 1:
+			for(ulCnt=0; ulCnt<ulBlockSize; ++ulCnt)
+			{
+				pucData[ulOffset + ulCnt] = (unsigned char)rand();
+			}
+			break;
+
+		case 2:
+			pucData[ulOffset + (unsigned long)rand()%ulBlockSize] = (unsigned char)(rand() % 0xff);
+			break;
+		}
+	}
+}
+
+
+
+static int run_case(const TEST_CASE_T *ptCase)
+{
+	FLASH_DEVICE_T tDevice;
+	FLASH_ERRORS_E tResult;
+	unsigned long ulSector;
+	unsigned long ulOffset;
+	unsigned long ulSkippedBytes;
+	unsigned char ucExpected;
+	int iIdentified;
+	int iResult;
+
+
+	memset(&tModel, 0, sizeof(tModel));
+	tModel.tCmdSet = ptCase->tCmdSet;
+	tModel.ulElementSize = 1U << ptCase->tBits;
+	tModel.fPaired = ptCase->fPaired;
+	tModel.tState = TEST_MODEL_STATE_Read;
+	memset(tModel.aucArray, 0xff, TEST_FLASH_SIZE);
+	mprotect(pucWindow, TEST_FLASH_SIZE, PROT_READ|PROT_WRITE);
+	model_render(&tModel);
+	mprotect(pucWindow, TEST_FLASH_SIZE, PROT_READ);
+
+	memset(&tDevice, 0, sizeof(tDevice));
+	tDevice.tBits = ptCase->tBits;
+	tDevice.fPaired = ptCase->fPaired;
+	tDevice.ulFlashSize = TEST_FLASH_SIZE;
+	tDevice.ulMaxBufferWriteSize = ptCase->ulMaxBufferWriteSize;
+	tDevice.pucFlashBase = pucWindow;
+	tDevice.ulSectorCnt = TEST_SECTORS;
+	for(ulSector=0; ulSector<TEST_SECTORS; ++ulSector)
+	{
+		tDevice.atSectors[ulSector].ulOffset = ulSector * TEST_SECTOR_SIZE;
+		tDevice.atSectors[ulSector].ulSize = TEST_SECTOR_SIZE;
+	}
+
+	fill_data(uData.auc, ptCase->ulLength);
+
+	iResult = -1;
+	if( ptCase->tCmdSet==TEST_CMDSET_Spansion )
+	{
+		iIdentified = SpansionIdentifyFlash(&tDevice);
+	}
+	else
+	{
+		iIdentified = IntelIdentifyFlash(&tDevice);
+	}
+	if( iIdentified==0 )
+	{
+		fprintf(stderr, "! The driver did not identify the flash: %s\n", (tModel.pcError!=NULL) ? tModel.pcError : "wrong manufacturer");
+	}
+	else
+	{
+		ulSkippedBytes = 0;
+		tResult = tDevice.tFlashFunctions.pfnProgram(&tDevice, ptCase->ulOffset, ptCase->ulLength, uData.auc, &ulSkippedBytes);
+		if( tModel.pcError!=NULL )
+		{
+			fprintf(stderr, "! %s\n", tModel.pcError);
+		}
+		else if( tResult!=eFLASH_NO_ERROR )
+		{
+			fprintf(stderr, "! The driver returned %d.\n", tResult);
+		}
+		else if( tModel.tState!=TEST_MODEL_STATE_Read )
+		{
+			fprintf(stderr, "! The flash is not in read mode after programming.\n");
+		}
+		else if( ulSkippedBytes==0 || ulSkippedBytes+tModel.ulProgrammedBytes!=ptCase->ulLength )
+		{
+			fprintf(stderr, "! 0x%08lx bytes were programmed and 0x%08lx skipped for 0x%08lx bytes of data.\n", tModel.ulProgrammedBytes, ulSkippedBytes, ptCase->ulLength);
+		}
+		else
+		{
+			iResult = 0;
+			for(ulOffset=0; ulOffset<TEST_FLASH_SIZE; ++ulOffset)
+			{
+				ucExpected = 0xffU;
+				if( ulOffset>=ptCase->ulOffset && ulOffset<ptCase->ulOffset+ptCase->ulLength )
+				{
+					ucExpected = uData.auc[ulOffset - ptCase->ulOffset];
+				}
+				if( pucWindow[ulOffset]!=ucExpected )
+				{
+					fprintf(stderr, "! The flash at 0x%08lx is 0x%02x, expected 0x%02x.\n", ulOffset, pucWindow[ulOffset], ucExpected);
+					iResult = -1;
+					break;
+				}
+			}
+		}
+
+		if( fVerbose!=0 )
+		{
+			printf("%lu program commands, 0x%08lx bytes programmed, 0x%08lx bytes skipped\n", tModel.ulProgramCommands, tModel.ulProgrammedBytes, ulSkippedBytes);
+		}
+	}
+
+	return iResult;
+}
+
+
+
+int main(int argc, char **argv)
+{
+	const TEST_CASE_T *ptCase;
+	const TEST_CASE_T *ptCaseEnd;
+	int iResult;
+	int iCaseResult;
+
+
+	if( argc==2 && strcmp(argv[1], "-v")==0 )
+	{
+		fVerbose = 1;
+	}
+
+	srand(1);
+
+	iResult = install_handlers();
+	if( iResult==0 )
+	{
+		ptCase = atCases;
+		ptCaseEnd = atCases + (sizeof(atCases)/sizeof(atCases[0]));
+		while( ptCase<ptCaseEnd )
+		{
+			iCaseResult = run_case(ptCase);
+			printf("%-26s %s\n", ptCase->pcName, (iCaseResult==0) ? "OK" : "FAILED");
+			iResult |= iCaseResult;
+			++ptCase;
+		}
+	}
+
+	if( iResult!=0 )
+	{
+		printf("Some CFI flash program tests failed.\n");
+		return 1;
+	}
+
+	printf("All CFI flash program tests passed.\n");
+	return 0;
+}
+
+
+#else
+
+
+void host_target_message(const char *pcMessage, size_t sizMessage)
+{
+	(void)pcMessage;
+	(void)sizMessage;
+}
+
+
+int main(void)
+{
+	printf("The CFI flash model needs Linux on x86. Skipping the tests.\n");
+	return 0;
+}
+
+
+#endif
@@ -0,0 +1,332 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* Compare the internal flash kernels with the byte loops they replaced.
+ *
+ * The "flash" is a normal buffer on the host. All combinations of the
+ * alignment of the flash and the data are tested with random lengths
+ * and random positions of the first difference. The kernels must return
+ * exactly the same results as the byte loops.
+ *
+ * The kernels expect a 32 bit "unsigned long". Build this with -m32 like
+ * the rest of the host target.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "internal_flash/internal_flash_kernels.h"
+
+
+#define TEST_MAX_LENGTH   0x300U
+#define TEST_GUARD        0x20U
+#define TEST_BUFFER_SIZE  (TEST_GUARD + 8U + TEST_MAX_LENGTH + TEST_GUARD)
+#define TEST_ROUNDS       2000U
+
+
+typedef union TEST_BUFFER_UNION
+{
+	unsigned char auc[TEST_BUFFER_SIZE];
+	unsigned long aul[TEST_BUFFER_SIZE / sizeof(unsigned long)];
+} TEST_BUFFER_T;
+
+static TEST_BUFFER_T tFlash;
+static TEST_BUFFER_T tData;
+static TEST_BUFFER_T tDstKernel;
+static TEST_BUFFER_T tDstReference;
+
+
+
+/* This is the old copy loop of internal_flash_maz_v0_read. */
+static void reference_copy(unsigned char *pucDst, const unsigned char *pucFlash, unsigned long ulLength)
+{
+	unsigned long ulOffset;
+
+
+	for(ulOffset=0; ulOffset<ulLength; ++ulOffset)
+	{
+		pucDst[ulOffset] = pucFlash[ulOffset];
+	}
+}
+
+
+
+/* This is the old compare loop of internal_flash_maz_v0_verify. */
+static unsigned long reference_compare(const unsigned char *pucFlash, const unsigned char *pucData, unsigned long ulLength)
+{
+	unsigned long ulOffset;
+
+
+	for(ulOffset=0; ulOffset<ulLength; ++ulOffset)
+	{
+		if( pucFlash[ulOffset]!=pucData[ulOffset] )
+		{
+			break;
+		}
+	}
+
+	return ulOffset;
+}
+
+
+
+/* This is the old check loop of internal_flash_maz_v0_is_erased. */
+static unsigned long reference_find_not_erased(const unsigned char *pucFlash, unsigned long ulLength)
+{
+	unsigned long ulOffset;
+
+
+	for(ulOffset=0; ulOffset<ulLength; ++ulOffset)
+	{
+		if( pucFlash[ulOffset]!=0xffU )
+		{
+			break;
+		}
+	}
+
+	return ulOffset;
+}
+
+
+
+static void fill_random(unsigned char *pucBuffer, unsigned long ulLength)
+{
+	unsigned long ulCnt;
+
+
+	for(ulCnt=0; ulCnt<ulLength; ++ulCnt)
+	{
+		pucBuffer[ulCnt] = (unsigned char)(rand() & 0xff);
+	}
+}
+
+
+
+/* Get a random length. Short lengths and lengths around the 16 byte
+ * blocks of the kernels are more interesting than long ones.
+ */
+static unsigned long get_random_length(void)
+{
+	unsigned long ulLength;
+
+
+	switch( rand() % 3 )
+	{
+	case 0:
+		ulLength = (unsigned long)(rand() % 40);
+		break;
+
+	case 1:
+		ulLength = 16U * (unsigned long)(rand() % (TEST_MAX_LENGTH / 16U)) + (unsigned long)(rand() % 3) - 1U;
+		if( ulLength>TEST_MAX_LENGTH )
+		{
+			ulLength = 0;
+		}
+		break;
+
+	default:
+		ulLength = (unsigned long)(rand() % (TEST_MAX_LENGTH + 1U));
+		break;
+	}
+
+	return ulLength;
+}
+
+
+
+/* Get the position of a difference. A result of ulLength means "no difference". */
+static unsigned long get_random_position(unsigned long ulLength)
+{
+	unsigned long ulPosition;
+
+
+	ulPosition = ulLength;
+	if( ulLength!=0 && (rand() % 4)!=0 )
+	{
+		ulPosition = (unsigned long)rand() % ulLength;
+	}
+
+	return ulPosition;
+}
+
+
+
+static int test_copy(unsigned long ulFlashAlign, unsigned long ulDstAlign, unsigned long ulLength)
+{
+	const unsigned char *pucFlash;
+	unsigned char *pucDstKernel;
+	unsigned char *pucDstReference;
+	int iResult;
+
+
+	fill_random(tFlash.auc, TEST_BUFFER_SIZE);
+	fill_random(tDstKernel.auc, TEST_BUFFER_SIZE);
+	memcpy(tDstReference.auc, tDstKernel.auc, TEST_BUFFER_SIZE);
+
+	pucFlash = tFlash.auc + TEST_GUARD + ulFlashAlign;
+	pucDstKernel = tDstKernel.auc + TEST_GUARD + ulDstAlign;
+	pucDstReference = tDstReference.auc + TEST_GUARD + ulDstAlign;
+
+	iflash_copy(pucDstKernel, pucFlash, ulLength);
+	reference_copy(pucDstReference, pucFlash, ulLength);
+
+	/* This includes the guard areas before and after the destination. */
+	iResult = 0;
+	if( memcmp(tDstKernel.auc, tDstReference.auc, TEST_BUFFER_SIZE)!=0 )
+	{
+		fprintf(stderr, "! iflash_copy differs: flash alignment %lu, destination alignment %lu, length 0x%04lx.\n", ulFlashAlign, ulDstAlign, ulLength);
+		iResult = -1;
+	}
+
+	return iResult;
+}
+
+
+
+static int test_compare(unsigned long ulFlashAlign, unsigned long ulDataAlign, unsigned long ulLength)
+{
+	unsigned char *pucFlash;
+	unsigned char *pucData;
+	unsigned long ulPosition;
+	unsigned long ulKernel;
+	unsigned long ulReference;
+	int iResult;
+
+
+	fill_random(tFlash.auc, TEST_BUFFER_SIZE);
+	fill_random(tData.auc, TEST_BUFFER_SIZE);
+
+	pucFlash = tFlash.auc + TEST_GUARD + ulFlashAlign;
+	pucData = tData.auc + TEST_GUARD + ulDataAlign;
+	memcpy(pucData, pucFlash, ulLength);
+
+	/* Change one bit at a random position. */
+	ulPosition = get_random_position(ulLength);
+	if( ulPosition<ulLength )
+	{
+		pucData[ulPosition] ^= (unsigned char)(1U << (rand() & 7));
+	}
+
+	ulKernel = iflash_compare(pucFlash, pucData, ulLength);
+	ulReference = reference_compare(pucFlash, pucData, ulLength);
+
+	iResult = 0;
+	if( ulKernel!=ulReference )
+	{
+		fprintf(stderr, "! iflash_compare returned 0x%04lx, expected 0x%04lx: flash alignment %lu, data alignment %lu, length 0x%04lx.\n", ulKernel, ulReference, ulFlashAlign, ulDataAlign, ulLength);
+		iResult = -1;
+	}
+
+	return iResult;
+}
+
+
+
+static int test_find_not_erased(unsigned long ulFlashAlign, unsigned long ulLength)
+{
+	unsigned char *pucFlash;
+	unsigned long ulPosition;
+	unsigned long ulKernel;
+	unsigned long ulReference;
+	int iResult;
+
+
+	/* The bytes around the area are not erased. They must not be found. */
+	fill_random(tFlash.auc, TEST_BUFFER_SIZE);
+	pucFlash = tFlash.auc + TEST_GUARD + ulFlashAlign;
+	memset(pucFlash, 0xff, ulLength);
+
+	/* Clear one bit at a random position. */
+	ulPosition = get_random_position(ulLength);
+	if( ulPosition<ulLength )
+	{
+		pucFlash[ulPosition] &= (unsigned char)~(1U << (rand() & 7));
+	}
+
+	ulKernel = iflash_find_not_erased(pucFlash, ulLength);
+	ulReference = reference_find_not_erased(pucFlash, ulLength);
+
+	iResult = 0;
+	if( ulKernel!=ulReference )
+	{
+		fprintf(stderr, "! iflash_find_not_erased returned 0x%04lx, expected 0x%04lx: flash alignment %lu, length 0x%04lx.\n", ulKernel, ulReference, ulFlashAlign, ulLength);
+		iResult = -1;
+	}
+
+	return iResult;
+}
+
+
+
+int main(int argc, char **argv)
+{
+	unsigned long ulRound;
+	unsigned long ulFlashAlign;
+	unsigned long ulDataAlign;
+	unsigned long ulTests;
+	unsigned long ulErrors;
+	unsigned int uiSeed;
+
+
+	if( sizeof(unsigned long)!=4 )
+	{
+		fprintf(stderr, "! The kernels need a 32 bit \"unsigned long\". Build this test with -m32.\n");
+		return 2;
+	}
+
+	uiSeed = 1;
+	if( argc==2 )
+	{
+		uiSeed = (unsigned int)strtoul(argv[1], NULL, 0);
+	}
+	srand(uiSeed);
+
+	ulTests = 0;
+	ulErrors = 0;
+	for(ulRound=0; ulRound<TEST_ROUNDS; ++ulRound)
+	{
+		for(ulFlashAlign=0; ulFlashAlign<8U; ++ulFlashAlign)
+		{
+			for(ulDataAlign=0; ulDataAlign<8U; ++ulDataAlign)
+			{
+				if( test_copy(ulFlashAlign, ulDataAlign, get_random_length())!=0 )
+				{
+					++ulErrors;
+				}
+				if( test_compare(ulFlashAlign, ulDataAlign, get_random_length())!=0 )
+				{
+					++ulErrors;
+				}
+				ulTests += 2;
+			}
+
+			if( test_find_not_erased(ulFlashAlign, get_random_length())!=0 )
+			{
+				++ulErrors;
+			}
+			++ulTests;
+		}
+	}
+
+	printf("seed=%u tests=%lu errors=%lu\n", uiSeed, ulTests, ulErrors);
+
+	return (ulErrors==0) ? 0 : 1;
+}
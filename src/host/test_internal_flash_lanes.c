@@ -0,0 +1,358 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* Run the lane scheduler of the internal flash with simulated controllers.
+ *
+ * The model has the 3 flash controllers of the netX90. Each one runs one
+ * erase or program operation for a fixed time. The time only advances
+ * with the simulated CPU work:
+ *
+ *   - starting an operation or checking the result of the last one,
+ *   - one read of the status register while polling.
+ *
+ * Each test runs the same lanes one after the other like the old code
+ * and then all at the same time with iflash_lanes_run. The simulated
+ * times must show the speedup. The model also checks that no controller
+ * gets a new operation while it is still running.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "internal_flash/internal_flash_lanes.h"
+
+
+#define TEST_CONTROLLERS 3U
+
+/* The operation which never fails. */
+#define TEST_NO_FAILURE 0xffffffffU
+
+
+typedef struct TEST_MODEL_STRUCT
+{
+	unsigned long long ullTimeNs;                             /* The simulated time. */
+	unsigned long ulOperationNs;                              /* The time of one erase or program operation on a controller. */
+	unsigned long ulStepNs;                                   /* The CPU time to start an operation or to check its result. */
+	unsigned long ulPollNs;                                   /* The CPU time for one read of the status register. */
+	unsigned long long aullBusyUntilNs[TEST_CONTROLLERS];     /* The end of the running operation on each controller. */
+	unsigned long ulErrors;                                   /* Violations of the controller rules. */
+} TEST_MODEL_T;
+
+typedef struct TEST_LANE_STRUCT
+{
+	IFLASH_LANE_T tLane;           /* The state for the scheduler. This must be the first element. */
+	unsigned int uiController;
+	unsigned long ulOperations;    /* The number of erase blocks or pages in the lane. */
+	unsigned long ulStarted;       /* The number of started operations. */
+	unsigned long ulFinished;      /* The number of checked operations. */
+	unsigned long ulFailAt;        /* The check of this operation fails. */
+} TEST_LANE_T;
+
+typedef struct TEST_LANE_SETUP_STRUCT
+{
+	unsigned int uiController;
+	unsigned long ulOperations;
+	unsigned long ulFailAt;
+} TEST_LANE_SETUP_T;
+
+
+
+static int test_controller_is_running(const TEST_MODEL_T *ptModel, unsigned int uiController)
+{
+	return ptModel->ullTimeNs<ptModel->aullBusyUntilNs[uiController];
+}
+
+
+
+static NETX_CONSOLEAPP_RESULT_T test_lane_start(const void *pvContext, IFLASH_LANE_T *ptGenericLane)
+{
+	TEST_MODEL_T *ptModel;
+	TEST_LANE_T *ptLane;
+
+
+	ptModel = (TEST_MODEL_T*)pvContext;
+	ptLane = (TEST_LANE_T*)ptGenericLane;
+
+	ptLane->tLane.tState = IFLASH_LANE_STATE_Done;
+	if( ptLane->ulStarted<ptLane->ulOperations )
+	{
+		ptModel->ullTimeNs += ptModel->ulStepNs;
+		if( test_controller_is_running(ptModel, ptLane->uiController)!=0 )
+		{
+			fprintf(stderr, "! Controller %u got a new operation while it was still running.\n", ptLane->uiController);
+			++ptModel->ulErrors;
+		}
+		ptModel->aullBusyUntilNs[ptLane->uiController] = ptModel->ullTimeNs + ptModel->ulOperationNs;
+		++ptLane->ulStarted;
+		ptLane->tLane.tState = IFLASH_LANE_STATE_Busy;
+	}
+
+	return NETX_CONSOLEAPP_RESULT_OK;
+}
+
+
+
+static NETX_CONSOLEAPP_RESULT_T test_lane_continue(const void *pvContext, IFLASH_LANE_T *ptGenericLane)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	TEST_MODEL_T *ptModel;
+	TEST_LANE_T *ptLane;
+
+
+	ptModel = (TEST_MODEL_T*)pvContext;
+	ptLane = (TEST_LANE_T*)ptGenericLane;
+
+	/* Check the result of the last operation. */
+	ptModel->ullTimeNs += ptModel->ulStepNs;
+	if( test_controller_is_running(ptModel, ptLane->uiController)!=0 )
+	{
+		fprintf(stderr, "! The result of controller %u was checked while it was still running.\n", ptLane->uiController);
+		++ptModel->ulErrors;
+	}
+
+	++ptLane->ulFinished;
+	if( ptLane->ulFinished==ptLane->ulFailAt )
+	{
+		ptLane->tLane.tState = IFLASH_LANE_STATE_Idle;
+		tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+	}
+	else
+	{
+		tResult = test_lane_start(pvContext, ptGenericLane);
+	}
+
+	return tResult;
+}
+
+
+
+static int test_lane_is_running(const void *pvContext, const IFLASH_LANE_T *ptGenericLane)
+{
+	TEST_MODEL_T *ptModel;
+	const TEST_LANE_T *ptLane;
+
+
+	ptModel = (TEST_MODEL_T*)pvContext;
+	ptLane = (const TEST_LANE_T*)ptGenericLane;
+
+	ptModel->ullTimeNs += ptModel->ulPollNs;
+	return test_controller_is_running(ptModel, ptLane->uiController);
+}
+
+
+
+static const IFLASH_LANE_FUNCTIONS_T tTestLaneFunctions =
+{
+	test_lane_start,
+	test_lane_continue,
+	test_lane_is_running
+};
+
+
+
+static void test_setup_lanes(TEST_LANE_T *ptLanes, IFLASH_LANE_T **pptLanes, const TEST_LANE_SETUP_T *ptSetup, unsigned int uiLanes)
+{
+	unsigned int uiCnt;
+
+
+	for(uiCnt=0; uiCnt<uiLanes; ++uiCnt)
+	{
+		memset(ptLanes + uiCnt, 0, sizeof(TEST_LANE_T));
+		ptLanes[uiCnt].tLane.tState = IFLASH_LANE_STATE_Idle;
+		ptLanes[uiCnt].uiController = ptSetup[uiCnt].uiController;
+		ptLanes[uiCnt].ulOperations = ptSetup[uiCnt].ulOperations;
+		ptLanes[uiCnt].ulFailAt = ptSetup[uiCnt].ulFailAt;
+		pptLanes[uiCnt] = &(ptLanes[uiCnt].tLane);
+	}
+}
+
+
+
+/* Run the lanes one after the other and then in parallel.
+ *
+ * \return 0 if both runs processed all operations and the speedup is at least uiMinSpeedupPercent.
+ */
+static int test_speedup(const char *pcName, const TEST_MODEL_T *ptTiming, const TEST_LANE_SETUP_T *ptSetup, unsigned int uiLanes, unsigned int uiMinSpeedupPercent)
+{
+	TEST_MODEL_T tModel;
+	TEST_LANE_T atLanes[TEST_CONTROLLERS];
+	IFLASH_LANE_T *aptLanes[TEST_CONTROLLERS];
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	unsigned long long ullSequentialNs;
+	unsigned long long ullParallelNs;
+	unsigned long ulSpeedupPercent;
+	unsigned int uiCnt;
+	int iResult;
+
+
+	iResult = 0;
+
+	/* Run one lane after the other. */
+	memcpy(&tModel, ptTiming, sizeof(TEST_MODEL_T));
+	test_setup_lanes(atLanes, aptLanes, ptSetup, uiLanes);
+	tResult = NETX_CONSOLEAPP_RESULT_OK;
+	for(uiCnt=0; uiCnt<uiLanes && tResult==NETX_CONSOLEAPP_RESULT_OK; ++uiCnt)
+	{
+		tResult = iflash_lanes_run(&tTestLaneFunctions, &tModel, aptLanes + uiCnt, 1);
+	}
+	ullSequentialNs = tModel.ullTimeNs;
+	if( tResult!=NETX_CONSOLEAPP_RESULT_OK || tModel.ulErrors!=0 )
+	{
+		fprintf(stderr, "! %s: the sequential run failed.\n", pcName);
+		iResult = -1;
+	}
+
+	/* Run all lanes at the same time. */
+	memcpy(&tModel, ptTiming, sizeof(TEST_MODEL_T));
+	test_setup_lanes(atLanes, aptLanes, ptSetup, uiLanes);
+	tResult = iflash_lanes_run(&tTestLaneFunctions, &tModel, aptLanes, uiLanes);
+	ullParallelNs = tModel.ullTimeNs;
+	if( tResult!=NETX_CONSOLEAPP_RESULT_OK || tModel.ulErrors!=0 )
+	{
+		fprintf(stderr, "! %s: the parallel run failed.\n", pcName);
+		iResult = -1;
+	}
+	for(uiCnt=0; uiCnt<uiLanes; ++uiCnt)
+	{
+		if( atLanes[uiCnt].ulFinished!=atLanes[uiCnt].ulOperations || atLanes[uiCnt].tLane.tState!=IFLASH_LANE_STATE_Done )
+		{
+			fprintf(stderr, "! %s: lane %u finished %lu of %lu operations.\n", pcName, uiCnt, atLanes[uiCnt].ulFinished, atLanes[uiCnt].ulOperations);
+			iResult = -1;
+		}
+	}
+
+	ulSpeedupPercent = (unsigned long)((ullSequentialNs * 100U) / ullParallelNs);
+	printf("%-32s sequential %8llu us, parallel %8llu us, speedup %lu.%02lu\n", pcName, ullSequentialNs / 1000U, ullParallelNs / 1000U, ulSpeedupPercent / 100U, ulSpeedupPercent % 100U);
+	if( ulSpeedupPercent<uiMinSpeedupPercent )
+	{
+		fprintf(stderr, "! %s: the speedup is below %u.%02u.\n", pcName, uiMinSpeedupPercent / 100U, uiMinSpeedupPercent % 100U);
+		iResult = -1;
+	}
+
+	return iResult;
+}
+
+
+
+/* One lane fails. The scheduler must wait for the running operation on
+ * the other lane, but it must not start a new one.
+ */
+static int test_failure(const TEST_MODEL_T *ptTiming)
+{
+	static const TEST_LANE_SETUP_T atSetup[2] =
+	{
+		{ 0, 10, 3 },
+		{ 1, 10, TEST_NO_FAILURE }
+	};
+	TEST_MODEL_T tModel;
+	TEST_LANE_T atLanes[TEST_CONTROLLERS];
+	IFLASH_LANE_T *aptLanes[TEST_CONTROLLERS];
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	unsigned int uiCnt;
+	int iResult;
+
+
+	iResult = 0;
+	memcpy(&tModel, ptTiming, sizeof(TEST_MODEL_T));
+	test_setup_lanes(atLanes, aptLanes, atSetup, 2);
+	tResult = iflash_lanes_run(&tTestLaneFunctions, &tModel, aptLanes, 2);
+	if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+	{
+		fprintf(stderr, "! failure: the error of lane 0 was not returned.\n");
+		iResult = -1;
+	}
+	if( tModel.ulErrors!=0 )
+	{
+		iResult = -1;
+	}
+	if( atLanes[0].ulStarted!=3 || atLanes[1].ulStarted>4 )
+	{
+		fprintf(stderr, "! failure: operations were started after the error: %lu and %lu.\n", atLanes[0].ulStarted, atLanes[1].ulStarted);
+		iResult = -1;
+	}
+	for(uiCnt=0; uiCnt<TEST_CONTROLLERS; ++uiCnt)
+	{
+		if( test_controller_is_running(&tModel, uiCnt)!=0 )
+		{
+			fprintf(stderr, "! failure: controller %u is still running.\n", uiCnt);
+			iResult = -1;
+		}
+	}
+	if( atLanes[1].tLane.tState!=IFLASH_LANE_STATE_Idle )
+	{
+		fprintf(stderr, "! failure: lane 1 was not stopped.\n");
+		iResult = -1;
+	}
+
+	printf("%-32s %s\n", "failure", (iResult==0) ? "OK" : "FAILED");
+
+	return iResult;
+}
+
+
+
+int main(void)
+{
+	/* An erase of a 4KB block takes about 20ms. The check reads the block. */
+	static const TEST_MODEL_T tTimingErase =
+	{
+		0, 20000000U, 40000U, 1000U, { 0, 0, 0 }, 0
+	};
+	/* A page of 16 bytes takes about 20us. */
+	static const TEST_MODEL_T tTimingProgram =
+	{
+		0, 20000U, 2000U, 1000U, { 0, 0, 0 }, 0
+	};
+	/* Flash01_Main has 128 erase blocks in each of the two macros. */
+	static const TEST_LANE_SETUP_T atEraseFlash01[2] =
+	{
+		{ 0, 128, TEST_NO_FAILURE },
+		{ 1, 128, TEST_NO_FAILURE }
+	};
+	/* Program 64KB on both sides of the boundary. */
+	static const TEST_LANE_SETUP_T atProgramFlash01[2] =
+	{
+		{ 0, 4096, TEST_NO_FAILURE },
+		{ 1, 4096, TEST_NO_FAILURE }
+	};
+	/* Lanes of different lengths on all controllers. */
+	static const TEST_LANE_SETUP_T atEraseUneven[3] =
+	{
+		{ 0, 10, TEST_NO_FAILURE },
+		{ 1, 3, TEST_NO_FAILURE },
+		{ 2, 7, TEST_NO_FAILURE }
+	};
+	int iResult;
+
+
+	iResult  = test_speedup("erase Flash01_Main", &tTimingErase, atEraseFlash01, 2, 190);
+	iResult |= test_speedup("program 2x64KB in Flash01_Main", &tTimingProgram, atProgramFlash01, 2, 170);
+	iResult |= test_speedup("erase 3 uneven lanes", &tTimingErase, atEraseUneven, 3, 190);
+	iResult |= test_failure(&tTimingErase);
+
+	if( iResult!=0 )
+	{
+		printf("Some lane tests failed.\n");
+		return 1;
+	}
+
+	printf("All lane tests passed.\n");
+	return 0;
+}
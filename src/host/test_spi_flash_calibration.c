@@ -0,0 +1,177 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* Run the SPI clock calibration of the detection against the SPI NOR model.
+ *
+ * The model corrupts the read data above its maximum clock. The W25Q32 in
+ * spi_flash_types.xml has a clock of 80MHz. The detection must select the
+ * clock of the flash if the model and the interface allow it. Otherwise
+ * it must select the step of the ladder in spi_flash.c which is one below
+ * the last good step. Then the flash is written and read back at the
+ * selected clock.
+ *
+ * Use "-v" to see the messages of the flasher.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "spi_flash.h"
+
+
+#define TEST_FLASH_NAME "W25Q32"
+#define TEST_DATA_OFFSET 0x00011234U
+#define TEST_DATA_SIZE 0x00000567U
+
+
+typedef struct TEST_CALIBRATION_CASE_STRUCT
+{
+	unsigned long ulDeviceMaximumKhz;      /* The model corrupts reads above this clock. 0 is no limit. */
+	unsigned long ulInterfaceMaximumKhz;   /* The maximum clock of the SPI interface. */
+	unsigned long ulExpectedKhz;           /* The clock which must be selected. */
+} TEST_CALIBRATION_CASE_T;
+
+
+static const TEST_CALIBRATION_CASE_T atCases[] =
+{
+	/* All steps up to the clock of the flash pass. */
+	{     0U, 100000U, 80000U },
+	{ 80000U, 100000U, 80000U },
+
+	/* The interface is slower than the flash. */
+	{     0U,  33000U, 33000U },
+
+	/* 66MHz fails, 50MHz was the last good step, 40MHz is used. */
+	{ 50000U, 100000U, 40000U },
+	{ 60000U, 100000U, 40000U },
+
+	/* 33MHz fails, 25MHz was the last good step, 20MHz is used. */
+	{ 30000U, 100000U, 20000U },
+
+	/* The first step fails. Stay at the initial speed. */
+	{  1500U, 100000U, HOST_TEST_SPI_INITIAL_SPEED_KHZ }
+};
+
+
+static SPI_NOR_MODEL_T tModel;
+static DEVICE_DESCRIPTION_T tDevice;
+static unsigned char aucData[TEST_DATA_SIZE];
+static unsigned char aucReadBack[TEST_DATA_SIZE];
+
+
+
+static int run_case(const TEST_CALIBRATION_CASE_T *ptCase)
+{
+	int iResult;
+	unsigned long ulSelectedKhz;
+	unsigned int uiCnt;
+
+
+	iResult = -1;
+	if( host_test_add_spi_flash(&tModel, TEST_FLASH_NAME, 0, 0)!=0 )
+	{
+		fprintf(stderr, "! Failed to add the flash.\n");
+	}
+	else
+	{
+		tModel.tCfg.ulMaximumSpeedKhz = ptCase->ulDeviceMaximumKhz;
+
+		memset(&tDevice, 0, sizeof(tDevice));
+		if( host_test_detect_spi(&tDevice, 0, 0, ptCase->ulInterfaceMaximumKhz, 0)!=NETX_CONSOLEAPP_RESULT_OK || tDevice.fIsValid==0 )
+		{
+			fprintf(stderr, "! The detection failed.\n");
+		}
+		else
+		{
+			ulSelectedKhz = tDevice.uInfo.tSpiInfo.ulCalibratedSpeedKhz;
+			if( ulSelectedKhz!=ptCase->ulExpectedKhz )
+			{
+				fprintf(stderr, "! The calibration selected %lu kHz, expected %lu kHz.\n", ulSelectedKhz, ptCase->ulExpectedKhz);
+			}
+			else
+			{
+				/* The selected clock must work for all commands. */
+				for(uiCnt=0; uiCnt<TEST_DATA_SIZE; ++uiCnt)
+				{
+					aucData[uiCnt] = (unsigned char)(uiCnt * 7U + (uiCnt >> 8U) + 1U);
+				}
+				memset(aucReadBack, 0, sizeof(aucReadBack));
+				if( host_test_flash(&tDevice, TEST_DATA_OFFSET, aucData, TEST_DATA_SIZE)!=NETX_CONSOLEAPP_RESULT_OK )
+				{
+					fprintf(stderr, "! Failed to flash at %lu kHz.\n", ulSelectedKhz);
+				}
+				else if( memcmp(tModel.pucMemory + TEST_DATA_OFFSET, aucData, TEST_DATA_SIZE)!=0 )
+				{
+					fprintf(stderr, "! The flash contents differ after flashing at %lu kHz.\n", ulSelectedKhz);
+				}
+				else if( host_test_read(&tDevice, TEST_DATA_OFFSET, aucReadBack, TEST_DATA_SIZE)!=NETX_CONSOLEAPP_RESULT_OK || memcmp(aucReadBack, aucData, TEST_DATA_SIZE)!=0 )
+				{
+					fprintf(stderr, "! Failed to read back the data at %lu kHz.\n", ulSelectedKhz);
+				}
+				else
+				{
+					iResult = 0;
+				}
+			}
+		}
+
+		free(tModel.pucMemory);
+	}
+
+	return iResult;
+}
+
+
+
+int main(int argc, char **argv)
+{
+	const TEST_CALIBRATION_CASE_T *ptCase;
+	const TEST_CALIBRATION_CASE_T *ptCaseEnd;
+	int iResult;
+	int iCaseResult;
+
+
+	if( argc==2 && strcmp(argv[1], "-v")==0 )
+	{
+		host_test_set_verbose(1);
+	}
+
+	iResult = 0;
+	ptCase = atCases;
+	ptCaseEnd = atCases + (sizeof(atCases)/sizeof(atCases[0]));
+	while( ptCase<ptCaseEnd )
+	{
+		iCaseResult = run_case(ptCase);
+		printf("device max %6lu kHz, interface max %6lu kHz, expected %6lu kHz: %s\n", ptCase->ulDeviceMaximumKhz, ptCase->ulInterfaceMaximumKhz, ptCase->ulExpectedKhz, (iCaseResult==0) ? "OK" : "FAILED");
+		iResult |= iCaseResult;
+		++ptCase;
+	}
+
+	if( iResult!=0 )
+	{
+		printf("Some calibration tests failed.\n");
+		return 1;
+	}
+
+	printf("All calibration tests passed.\n");
+	return 0;
+}
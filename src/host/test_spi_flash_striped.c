@@ -0,0 +1,294 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* Erase, write and read a striped flash on the SPI NOR models.
+ *
+ * Two W25Q32 are combined to one striped flash. Page n of the logical
+ * flash is page n/2 of chip n%2. The test keeps the expected contents of
+ * the logical flash in a buffer. After each erase and flash the complete
+ * contents of both chips are compared with it. This also catches writes
+ * to the wrong chip or outside of the requested area.
+ *
+ * All ranges start and end at odd offsets and cross the borders between
+ * the stripes. Unaligned ranges are also read back.
+ *
+ * Use "-v" to see the messages of the flasher.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "spi_flash.h"
+
+
+#define TEST_FLASH_NAME "W25Q32"
+
+/* The second chip is on the same unit with chip select 1. */
+#define TEST_STRIPE_UNIT 0U
+#define TEST_STRIPE_CHIP_SELECT 1U
+
+
+typedef struct TEST_RANGE_STRUCT
+{
+	unsigned long ulOffset;
+	unsigned long ulSize;
+} TEST_RANGE_T;
+
+
+/* The ranges for flash. Each one is written with new data. */
+static const TEST_RANGE_T atFlashRanges[] =
+{
+	{ 0x000100f0U, 0x00000020U },   /* Over the border from chip 0 to chip 1. */
+	{ 0x000101f1U, 0x0000001eU },   /* Over the border from chip 1 to chip 0. */
+	{ 0x00010333U, 0x00001234U },   /* Many stripes, odd start and end. */
+	{ 0x00012100U, 0x000001ffU },   /* Starts with a complete stripe of chip 1. */
+	{ 0x000123ffU, 0x00000001U },   /* The last byte of a stripe. */
+	{ 0x00013e07U, 0x00000402U }    /* Over the border of the logical erase blocks. */
+};
+
+/* The ranges for read. They are checked after all flash operations. */
+static const TEST_RANGE_T atReadRanges[] =
+{
+	{ 0x000100ffU, 0x00000002U },
+	{ 0x000101fdU, 0x00000105U },
+	{ 0x00010001U, 0x00003fffU },
+	{ 0x00013f00U, 0x00000301U }
+};
+
+
+static SPI_NOR_MODEL_T atModels[2];
+static DEVICE_DESCRIPTION_T tDevice;
+static unsigned char *pucExpected;
+static unsigned char *pucBuffer;
+static unsigned long ulChipSize;
+static unsigned long ulPageSize;
+
+
+
+/* Get the byte of a chip which holds a byte of the logical flash. */
+static unsigned char get_chip_byte(unsigned long ulLogicalOffset)
+{
+	unsigned long ulPage;
+	unsigned long ulChipOffset;
+
+
+	ulPage = ulLogicalOffset / ulPageSize;
+	ulChipOffset = (ulPage / 2U) * ulPageSize + (ulLogicalOffset % ulPageSize);
+
+	return atModels[ulPage % 2U].pucMemory[ulChipOffset];
+}
+
+
+
+/* Compare both chips with the expected contents of the logical flash. */
+static int check_chips(const char *pcStep)
+{
+	unsigned long ulOffset;
+	unsigned long ulLogicalSize;
+	int iResult;
+
+
+	iResult = 0;
+	ulLogicalSize = 2U * ulChipSize;
+	for(ulOffset=0; ulOffset<ulLogicalSize; ++ulOffset)
+	{
+		if( get_chip_byte(ulOffset)!=pucExpected[ulOffset] )
+		{
+			fprintf(stderr, "! %s: the logical offset 0x%08lx on chip %lu is 0x%02x, expected 0x%02x.\n", pcStep, ulOffset, (ulOffset / ulPageSize) % 2U, get_chip_byte(ulOffset), pucExpected[ulOffset]);
+			iResult = -1;
+			break;
+		}
+	}
+
+	return iResult;
+}
+
+
+
+static int test_erase(void)
+{
+	unsigned long ulStart;
+	unsigned long ulEnd;
+	int iResult;
+
+
+	/* Fill both chips with data. */
+	memset(atModels[0].pucMemory, 0x00, ulChipSize);
+	memset(atModels[1].pucMemory, 0x00, ulChipSize);
+	memset(pucExpected, 0x00, 2U * ulChipSize);
+
+	/* A logical erase block is one sector on each chip. */
+	ulStart = 0x00010000U;
+	ulEnd = 0x00018000U;
+	iResult = -1;
+	if( host_test_erase(&tDevice, ulStart, ulEnd)!=NETX_CONSOLEAPP_RESULT_OK )
+	{
+		fprintf(stderr, "! Failed to erase 0x%08lx-0x%08lx.\n", ulStart, ulEnd);
+	}
+	else
+	{
+		memset(pucExpected + ulStart, 0xff, ulEnd - ulStart);
+		iResult = check_chips("erase");
+	}
+
+	return iResult;
+}
+
+
+
+static int test_flash(void)
+{
+	const TEST_RANGE_T *ptRange;
+	const TEST_RANGE_T *ptRangeEnd;
+	unsigned long ulCnt;
+	unsigned long ulSeed;
+	int iResult;
+
+
+	iResult = 0;
+	ulSeed = 1;
+	ptRange = atFlashRanges;
+	ptRangeEnd = atFlashRanges + (sizeof(atFlashRanges)/sizeof(atFlashRanges[0]));
+	while( iResult==0 && ptRange<ptRangeEnd )
+	{
+		for(ulCnt=0; ulCnt<ptRange->ulSize; ++ulCnt)
+		{
+			ulSeed = ulSeed * 1103515245U + 12345U;
+			pucBuffer[ulCnt] = (unsigned char)((ulSeed >> 16U) & 0xffU);
+		}
+
+		if( host_test_flash(&tDevice, ptRange->ulOffset, pucBuffer, ptRange->ulSize)!=NETX_CONSOLEAPP_RESULT_OK )
+		{
+			fprintf(stderr, "! Failed to flash 0x%08lx bytes at 0x%08lx.\n", ptRange->ulSize, ptRange->ulOffset);
+			iResult = -1;
+		}
+		else
+		{
+			memcpy(pucExpected + ptRange->ulOffset, pucBuffer, ptRange->ulSize);
+			iResult = check_chips("flash");
+		}
+		++ptRange;
+	}
+
+	return iResult;
+}
+
+
+
+static int test_read(void)
+{
+	const TEST_RANGE_T *ptRange;
+	const TEST_RANGE_T *ptRangeEnd;
+	int iResult;
+
+
+	iResult = 0;
+	ptRange = atReadRanges;
+	ptRangeEnd = atReadRanges + (sizeof(atReadRanges)/sizeof(atReadRanges[0]));
+	while( iResult==0 && ptRange<ptRangeEnd )
+	{
+		memset(pucBuffer, 0x5a, ptRange->ulSize);
+		if( host_test_read(&tDevice, ptRange->ulOffset, pucBuffer, ptRange->ulSize)!=NETX_CONSOLEAPP_RESULT_OK )
+		{
+			fprintf(stderr, "! Failed to read 0x%08lx bytes at 0x%08lx.\n", ptRange->ulSize, ptRange->ulOffset);
+			iResult = -1;
+		}
+		else if( memcmp(pucBuffer, pucExpected + ptRange->ulOffset, ptRange->ulSize)!=0 )
+		{
+			fprintf(stderr, "! The data read from 0x%08lx differs.\n", ptRange->ulOffset);
+			iResult = -1;
+		}
+		++ptRange;
+	}
+
+	return iResult;
+}
+
+
+
+int main(int argc, char **argv)
+{
+	FLASHER_SPI_FLAGS_T tFlags;
+	int iResult;
+
+
+	if( argc==2 && strcmp(argv[1], "-v")==0 )
+	{
+		host_test_set_verbose(1);
+	}
+
+	iResult = -1;
+	if( host_test_add_spi_flash(atModels + 0, TEST_FLASH_NAME, 0, 0)!=0 || host_test_add_spi_flash(atModels + 1, TEST_FLASH_NAME, TEST_STRIPE_UNIT, TEST_STRIPE_CHIP_SELECT)!=0 )
+	{
+		fprintf(stderr, "! Failed to add the flashes.\n");
+	}
+	else
+	{
+		ulChipSize = atModels[0].tCfg.ulSize;
+		ulPageSize = atModels[0].tCfg.ulPageSize;
+		pucExpected = (unsigned char*)malloc(2U * ulChipSize);
+		pucBuffer = (unsigned char*)malloc(0x10000U);
+
+		tFlags.rawValue = 0;
+		tFlags.bits.bStriped = 1;
+		tFlags.bits.uiStripeUnit = TEST_STRIPE_UNIT;
+		tFlags.bits.uiStripeChipSelect = TEST_STRIPE_CHIP_SELECT;
+
+		memset(&tDevice, 0, sizeof(tDevice));
+		if( pucExpected==NULL || pucBuffer==NULL )
+		{
+			fprintf(stderr, "! Failed to allocate the buffers.\n");
+		}
+		else if( host_test_detect_spi(&tDevice, 0, 0, 50000U, tFlags.rawValue)!=NETX_CONSOLEAPP_RESULT_OK || tDevice.fIsValid==0 )
+		{
+			fprintf(stderr, "! Failed to detect the striped flash.\n");
+		}
+		else if( tDevice.uInfo.tSpiInfo.fIsStriped==0 || tDevice.uInfo.tSpiInfo.tAttributes.ulSize!=2U*ulChipSize )
+		{
+			fprintf(stderr, "! The detected flash is not striped or has the wrong size.\n");
+		}
+		else
+		{
+			iResult = test_erase();
+			printf("%-8s %s\n", "erase", (iResult==0) ? "OK" : "FAILED");
+			if( iResult==0 )
+			{
+				iResult = test_flash();
+				printf("%-8s %s\n", "flash", (iResult==0) ? "OK" : "FAILED");
+			}
+			if( iResult==0 )
+			{
+				iResult = test_read();
+				printf("%-8s %s\n", "read", (iResult==0) ? "OK" : "FAILED");
+			}
+		}
+	}
+
+	if( iResult!=0 )
+	{
+		printf("Some striping tests failed.\n");
+		return 1;
+	}
+
+	printf("All striping tests passed.\n");
+	return 0;
+}
@@ -0,0 +1,275 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+/* Run macros of the SPI macro player against the SPI NOR model.
+ *
+ * The macros which loop forever must stop with SMC_ERROR_STEP_LIMIT or,
+ * inside of a poll loop, with SMC_ERROR_POLL_TIMEOUT. A poll loop which
+ * waits for a chip erase runs much more than SMC_MACRO_MAX_STEPS opcodes
+ * and must still succeed.
+ *
+ * Use "-v" to see the messages of the flasher.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host_test.h"
+#include "sim_clock.h"
+#include "spi_flash.h"
+
+
+#define TEST_FLASH_NAME "W25Q32"
+/* A slow clock makes the status reads of the chip erase take longer. */
+#define TEST_SPEED_KHZ 1000U
+
+/* Each iteration of the status loops below has 5 opcodes. */
+#define TEST_STATUS_LOOP_STEPS 5U
+
+
+typedef struct TEST_MACRO_CASE_STRUCT
+{
+	const char *pcName;
+	const unsigned char *pucMacro;
+	size_t sizMacro;
+	int fSuccess;                        /* The macro must succeed. */
+	unsigned long ulReturnMessage;       /* The size of the log or the error code. */
+} TEST_MACRO_CASE_T;
+
+
+/* Read the JEDEC ID. */
+static const unsigned char aucMacroReadId[] =
+{
+	SMC_OP_CHIP_SELECT, 1,
+	SMC_OP_EXCHANGE, 4, 0x9f, 0x00, 0x00, 0x00,
+	SMC_OP_CAPTURE,
+	SMC_OP_CHIP_SELECT, 0,
+	SMC_OP_END
+};
+
+/* 0x0000: jump to itself. */
+static const unsigned char aucMacroJumpForever[] =
+{
+	SMC_OP_JUMP, 0x00, 0x00
+};
+
+/* Read the status until the flash is busy. It never is. */
+static const unsigned char aucMacroStatusLoop[] =
+{
+	/* 0x0000 */ SMC_OP_CHIP_SELECT, 1,
+	/* 0x0002 */ SMC_OP_SEND, 1, 0x05,
+	/* 0x0005 */ SMC_OP_RECEIVE, 1,
+	/* 0x0007 */ SMC_OP_CHIP_SELECT, 0,
+	/* 0x0009 */ SMC_OP_JUMP_EQ, 0x01, 0x00, 0x00, 0x00
+};
+
+/* Poll until the flash is busy. It never is. */
+static const unsigned char aucMacroPollNeverReady[] =
+{
+	/* 0x0000 */ SMC_OP_CHIP_SELECT, 1,
+	/* 0x0002 */ SMC_OP_SEND, 1, 0x05,
+	/* 0x0005 */ SMC_OP_RECEIVE, 1,
+	/* 0x0007 */ SMC_OP_CHIP_SELECT, 0,
+	/* 0x0009 */ SMC_OP_POLL, 0x01, 0x01, 0x00, 0x00, 20, 0
+};
+
+/* The poll jumps back into a loop which never reaches the POLL again. */
+static const unsigned char aucMacroLoopInsidePoll[] =
+{
+	/* 0x0000 */ SMC_OP_JUMP, 0x06, 0x00,
+	/* 0x0003 */ SMC_OP_JUMP, 0x03, 0x00,
+	/* 0x0006 */ SMC_OP_POLL, 0xff, 0x01, 0x03, 0x00, 20, 0
+};
+
+/* Erase the complete chip and wait until it is ready. */
+static const unsigned char aucMacroChipErase[] =
+{
+	/* 0x0000 */ SMC_OP_CHIP_SELECT, 1,
+	/* 0x0002 */ SMC_OP_SEND, 1, 0x06,
+	/* 0x0005 */ SMC_OP_CHIP_SELECT, 0,
+	/* 0x0007 */ SMC_OP_CHIP_SELECT, 1,
+	/* 0x0009 */ SMC_OP_SEND, 1, 0xc7,
+	/* 0x000c */ SMC_OP_CHIP_SELECT, 0,
+	/* 0x000e */ SMC_OP_CHIP_SELECT, 1,
+	/* 0x0010 */ SMC_OP_SEND, 1, 0x05,
+	/* 0x0013 */ SMC_OP_RECEIVE, 1,
+	/* 0x0015 */ SMC_OP_CHIP_SELECT, 0,
+	/* 0x0017 */ SMC_OP_POLL, 0x01, 0x00, 0x0e, 0x00, 0x60, 0xea,
+	/* 0x001e */ SMC_OP_END
+};
+
+
+static const TEST_MACRO_CASE_T atCases[] =
+{
+	{ "read id",           aucMacroReadId,         sizeof(aucMacroReadId),         1, 4U },
+	{ "jump forever",      aucMacroJumpForever,    sizeof(aucMacroJumpForever),    0, SMC_ERROR_STEP_LIMIT },
+	{ "status loop",       aucMacroStatusLoop,     sizeof(aucMacroStatusLoop),     0, SMC_ERROR_STEP_LIMIT },
+	{ "poll never ready",  aucMacroPollNeverReady, sizeof(aucMacroPollNeverReady), 0, SMC_ERROR_POLL_TIMEOUT },
+	{ "loop inside poll",  aucMacroLoopInsidePoll, sizeof(aucMacroLoopInsidePoll), 0, SMC_ERROR_POLL_TIMEOUT },
+	{ "chip erase",        aucMacroChipErase,      sizeof(aucMacroChipErase),      1, 0U }
+};
+
+
+static SPI_NOR_MODEL_T tModel;
+static FLASHER_SPI_CFG_T tSpiDev;
+static unsigned char aucLog[16];
+
+
+
+static int run_case(const TEST_MACRO_CASE_T *ptCase)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	unsigned long ulReturnMessage;
+	int iResult;
+
+
+	memset(aucLog, 0, sizeof(aucLog));
+	ulReturnMessage = 0xffffffffU;
+	tResult = host_test_run_spi_macro(&tSpiDev, ptCase->pucMacro, ptCase->sizMacro, aucLog, sizeof(aucLog), &ulReturnMessage);
+
+	iResult = -1;
+	if( (tResult==NETX_CONSOLEAPP_RESULT_OK)!=(ptCase->fSuccess!=0) )
+	{
+		fprintf(stderr, "! The macro %s.\n", (tResult==NETX_CONSOLEAPP_RESULT_OK) ? "succeeded" : "failed");
+	}
+	else if( ulReturnMessage!=ptCase->ulReturnMessage )
+	{
+		fprintf(stderr, "! The return message is %lu, expected %lu.\n", ulReturnMessage, ptCase->ulReturnMessage);
+	}
+	else
+	{
+		iResult = 0;
+	}
+
+	return iResult;
+}
+
+
+
+/* The model answers the ID command with aucIdMagic. The first byte is the
+ * response to the opcode.
+ */
+static int check_id(void)
+{
+	int iResult;
+
+
+	iResult = 0;
+	if( memcmp(aucLog + 1, tModel.tCfg.aucIdMagic + 1, 3)!=0 )
+	{
+		fprintf(stderr, "! The captured ID %02x %02x %02x is wrong.\n", aucLog[1], aucLog[2], aucLog[3]);
+		iResult = -1;
+	}
+
+	return iResult;
+}
+
+
+
+/* The erase must have needed more opcodes than the step limit. */
+static int check_chip_erase(unsigned long ulBusyPolls)
+{
+	int iResult;
+	unsigned long ulOffset;
+
+
+	iResult = 0;
+	if( ulBusyPolls*TEST_STATUS_LOOP_STEPS<=SMC_MACRO_MAX_STEPS )
+	{
+		fprintf(stderr, "! The chip erase needed only %lu polls. This does not test the step limit.\n", ulBusyPolls);
+		iResult = -1;
+	}
+	else
+	{
+		for(ulOffset=0; ulOffset<tModel.tCfg.ulSize; ++ulOffset)
+		{
+			if( tModel.pucMemory[ulOffset]!=0xffU )
+			{
+				fprintf(stderr, "! The flash is not erased at 0x%08lx.\n", ulOffset);
+				iResult = -1;
+				break;
+			}
+		}
+	}
+
+	return iResult;
+}
+
+
+
+int main(int argc, char **argv)
+{
+	const TEST_MACRO_CASE_T *ptCase;
+	const TEST_MACRO_CASE_T *ptCaseEnd;
+	unsigned long ulBusyPolls;
+	int iResult;
+	int iCaseResult;
+
+
+	if( argc==2 && strcmp(argv[1], "-v")==0 )
+	{
+		host_test_set_verbose(1);
+	}
+
+	iResult = -1;
+	if( host_test_add_spi_flash(&tModel, TEST_FLASH_NAME, 0, 0)!=0 )
+	{
+		fprintf(stderr, "! Failed to add the flash.\n");
+	}
+	else if( host_test_init_spi_macro(&tSpiDev, 0, 0, TEST_SPEED_KHZ)!=NETX_CONSOLEAPP_RESULT_OK )
+	{
+		fprintf(stderr, "! Failed to initialize the macro player.\n");
+	}
+	else
+	{
+		/* The chip erase must have something to erase. */
+		memset(tModel.pucMemory, 0x00, tModel.tCfg.ulSize);
+
+		iResult = 0;
+		ptCase = atCases;
+		ptCaseEnd = atCases + (sizeof(atCases)/sizeof(atCases[0]));
+		while( ptCase<ptCaseEnd )
+		{
+			ulBusyPolls = tSimClock.ulBusyPolls;
+			iCaseResult = run_case(ptCase);
+			if( iCaseResult==0 && ptCase->pucMacro==aucMacroReadId )
+			{
+				iCaseResult = check_id();
+			}
+			else if( iCaseResult==0 && ptCase->pucMacro==aucMacroChipErase )
+			{
+				iCaseResult = check_chip_erase(tSimClock.ulBusyPolls - ulBusyPolls);
+			}
+			printf("%-20s %s\n", ptCase->pcName, (iCaseResult==0) ? "OK" : "FAILED");
+			iResult |= iCaseResult;
+			++ptCase;
+		}
+	}
+
+	if( iResult!=0 )
+	{
+		printf("Some macro player tests failed.\n");
+		return 1;
+	}
+
+	printf("All macro player tests passed.\n");
+	return 0;
+}
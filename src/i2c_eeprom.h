@@ -0,0 +1,48 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef __I2C_EEPROM_H__
+#define __I2C_EEPROM_H__
+
+
+/* An I2C EEPROM has no ID which could be read. The geometry must be
+ * passed from the host. The structure must not be larger than the
+ * SPI configuration, as both are part of the detect parameters.
+ */
+typedef struct FLASHER_I2C_CONFIGURATION_STRUCT
+{
+	unsigned int uiUnit;                /* I2C unit number. */
+	unsigned int uiChipSelect;          /* Not used, must be 0. */
+	unsigned long ulDeviceAddress;      /* The 7 bit device address, e.g. 0x50. */
+	unsigned long ulSizeInBytes;        /* The size of the EEPROM in bytes. */
+	unsigned long ulPageSize;           /* The size of the page write buffer in bytes. */
+	unsigned long ulAddressBytes;       /* The number of address bytes, 1 or 2. */
+	unsigned long ulWriteCycleTimeMs;   /* The maximum write cycle time in ms. */
+} FLASHER_I2C_CONFIGURATION_T;
+
+
+typedef struct FLASHER_I2C_EEPROM_STRUCT
+{
+	FLASHER_I2C_CONFIGURATION_T tCfg;
+} FLASHER_I2C_EEPROM_T;
+
+
+#endif  /* __I2C_EEPROM_H__ */
@@ -21,6 +21,8 @@
 #ifndef __INTERNAL_FLASH_H__
 #define __INTERNAL_FLASH_H__
 
+#include <stdint.h>
+
 
 typedef enum INTERNAL_FLASH_TYPE_ENUM
 {
@@ -38,6 +40,19 @@ typedef struct INTERNAL_FLASH_CONFIGURATION_STRUCT
 
 
 
+/* Flags for the detect function. They are kept in the device description. */
+typedef union INTERNAL_FLASH_FLAGS_UNION
+{
+	uint32_t rawValue;                 /* Entire flag as number */
+	struct
+	{
+		unsigned int bAutoErase : 1;   /* Erase blocks on demand when flashing. */
+		unsigned int reserved : 31;    /* reserved */
+	} bits;
+} INTERNAL_FLASH_FLAGS_T;
+
+
+
 typedef enum INTERNAL_FLASH_AREA_ENUM
 {
 	INTERNAL_FLASH_AREA_Unknown       =  0,
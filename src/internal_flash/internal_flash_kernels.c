@@ -0,0 +1,236 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include "internal_flash_kernels.h"
+
+#include "asic_types.h"
+
+
+/* The kernels are used by the netX90 internal flash and the host tests. */
+#if ASIC_TYP==ASIC_TYP_NETX90_MPW || ASIC_TYP==ASIC_TYP_NETX90 || ASIC_TYP==ASIC_TYP_HOST
+
+
+/* Copy data from the flash to a buffer.
+ *
+ * The flash is read with aligned 32 bit accesses. If the buffer has the
+ * same alignment, 4 words are copied at once, which compiles to LDM/STM
+ * bursts. Otherwise the words are stored byte by byte. The bytes before
+ * the first and after the last complete word are copied one by one.
+ */
+void iflash_copy(unsigned char *pucDst, const unsigned char *pucFlash, unsigned long ulLength)
+{
+	const unsigned long *pulFlash;
+	unsigned long *pulDst;
+	unsigned long ulValue0;
+	unsigned long ulValue1;
+	unsigned long ulValue2;
+	unsigned long ulValue3;
+
+
+	/* Copy single bytes up to the first aligned word in the flash. */
+	while( ulLength!=0 && ((unsigned long)pucFlash & 3U)!=0 )
+	{
+		*(pucDst++) = *(pucFlash++);
+		--ulLength;
+	}
+
+	pulFlash = (const unsigned long*)pucFlash;
+	if( ((unsigned long)pucDst & 3U)==0 )
+	{
+		pulDst = (unsigned long*)pucDst;
+		while( ulLength>=4U*sizeof(unsigned long) )
+		{
+			ulValue0 = pulFlash[0];
+			ulValue1 = pulFlash[1];
+			ulValue2 = pulFlash[2];
+			ulValue3 = pulFlash[3];
+			pulDst[0] = ulValue0;
+			pulDst[1] = ulValue1;
+			pulDst[2] = ulValue2;
+			pulDst[3] = ulValue3;
+			pulFlash += 4;
+			pulDst += 4;
+			ulLength -= 4U*sizeof(unsigned long);
+		}
+		while( ulLength>=sizeof(unsigned long) )
+		{
+			*(pulDst++) = *(pulFlash++);
+			ulLength -= sizeof(unsigned long);
+		}
+		pucDst = (unsigned char*)pulDst;
+	}
+	else
+	{
+		while( ulLength>=sizeof(unsigned long) )
+		{
+			ulValue0 = *(pulFlash++);
+			pucDst[0] = (unsigned char)( ulValue0        & 0xffU);
+			pucDst[1] = (unsigned char)((ulValue0 >>  8) & 0xffU);
+			pucDst[2] = (unsigned char)((ulValue0 >> 16) & 0xffU);
+			pucDst[3] = (unsigned char)((ulValue0 >> 24) & 0xffU);
+			pucDst += sizeof(unsigned long);
+			ulLength -= sizeof(unsigned long);
+		}
+	}
+
+	/* Copy the rest. */
+	pucFlash = (const unsigned char*)pulFlash;
+	while( ulLength!=0 )
+	{
+		*(pucDst++) = *(pucFlash++);
+		--ulLength;
+	}
+}
+
+
+
+/* Compare the flash with a buffer.
+ *
+ * The flash is read with aligned 32 bit accesses. If the buffer has the
+ * same alignment, 4 words are compared at once. As soon as a word
+ * differs, the rest is compared byte by byte to find the exact offset.
+ *
+ * \return The offset of the first byte which differs, or ulLength if all bytes are equal.
+ */
+unsigned long iflash_compare(const unsigned char *pucFlash, const unsigned char *pucData, unsigned long ulLength)
+{
+	const unsigned long *pulFlash;
+	const unsigned long *pulData;
+	unsigned long ulOffset;
+	unsigned long ulDiff;
+	unsigned long ulValue;
+
+
+	/* Compare single bytes up to the first aligned word in the flash. */
+	ulOffset = 0;
+	while( ulOffset<ulLength && ((unsigned long)(pucFlash + ulOffset) & 3U)!=0 && pucFlash[ulOffset]==pucData[ulOffset] )
+	{
+		++ulOffset;
+	}
+
+	pulFlash = (const unsigned long*)(pucFlash + ulOffset);
+	if( ((unsigned long)pulFlash & 3U)!=0 )
+	{
+		/* A difference was found before the first aligned word. */
+	}
+	else if( ((unsigned long)(pucData + ulOffset) & 3U)==0 )
+	{
+		pulData = (const unsigned long*)(pucData + ulOffset);
+		while( (ulLength-ulOffset)>=4U*sizeof(unsigned long) )
+		{
+			ulDiff  = pulFlash[0] ^ pulData[0];
+			ulDiff |= pulFlash[1] ^ pulData[1];
+			ulDiff |= pulFlash[2] ^ pulData[2];
+			ulDiff |= pulFlash[3] ^ pulData[3];
+			if( ulDiff!=0 )
+			{
+				break;
+			}
+			pulFlash += 4;
+			pulData += 4;
+			ulOffset += 4U*sizeof(unsigned long);
+		}
+	}
+	else
+	{
+		while( (ulLength-ulOffset)>=sizeof(unsigned long) )
+		{
+			ulValue  =  (unsigned long)pucData[ulOffset];
+			ulValue |= ((unsigned long)pucData[ulOffset+1U]) <<  8U;
+			ulValue |= ((unsigned long)pucData[ulOffset+2U]) << 16U;
+			ulValue |= ((unsigned long)pucData[ulOffset+3U]) << 24U;
+			if( *pulFlash!=ulValue )
+			{
+				break;
+			}
+			++pulFlash;
+			ulOffset += sizeof(unsigned long);
+		}
+	}
+
+	/* Compare the rest or find the exact position of the difference. */
+	while( ulOffset<ulLength )
+	{
+		if( pucFlash[ulOffset]!=pucData[ulOffset] )
+		{
+			break;
+		}
+		++ulOffset;
+	}
+
+	return ulOffset;
+}
+
+
+
+/* Find the first byte in the flash which is not erased.
+ *
+ * The flash is read with aligned 32 bit accesses. 4 words are combined
+ * with a bitwise "and" which is 0xffffffff if and only if all of them are
+ * erased.
+ *
+ * \return The offset of the first byte which is not 0xff, or ulLength if the complete area is erased.
+ */
+unsigned long iflash_find_not_erased(const unsigned char *pucFlash, unsigned long ulLength)
+{
+	const unsigned long *pulFlash;
+	unsigned long ulOffset;
+	unsigned long ulValue;
+
+
+	/* Check single bytes up to the first aligned word. */
+	ulOffset = 0;
+	while( ulOffset<ulLength && ((unsigned long)(pucFlash + ulOffset) & 3U)!=0 && pucFlash[ulOffset]==0xffU )
+	{
+		++ulOffset;
+	}
+
+	/* The word loop is skipped if data was found before the first aligned word. */
+	pulFlash = (const unsigned long*)(pucFlash + ulOffset);
+	while( ((unsigned long)pulFlash & 3U)==0 && (ulLength-ulOffset)>=4U*sizeof(unsigned long) )
+	{
+		ulValue  = pulFlash[0];
+		ulValue &= pulFlash[1];
+		ulValue &= pulFlash[2];
+		ulValue &= pulFlash[3];
+		if( ulValue!=0xffffffffU )
+		{
+			break;
+		}
+		pulFlash += 4;
+		ulOffset += 4U*sizeof(unsigned long);
+	}
+
+	/* Check the rest or find the exact position of the data. */
+	while( ulOffset<ulLength )
+	{
+		if( pucFlash[ulOffset]!=0xffU )
+		{
+			break;
+		}
+		++ulOffset;
+	}
+
+	return ulOffset;
+}
+
+
+#endif
@@ -0,0 +1,34 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef __INTERNAL_FLASH_KERNELS_H__
+#define __INTERNAL_FLASH_KERNELS_H__
+
+
+/* Word wide access to the memory mapped internal flash.
+ * The kernels expect a 32 bit "unsigned long".
+ */
+void iflash_copy(unsigned char *pucDst, const unsigned char *pucFlash, unsigned long ulLength);
+unsigned long iflash_compare(const unsigned char *pucFlash, const unsigned char *pucData, unsigned long ulLength);
+unsigned long iflash_find_not_erased(const unsigned char *pucFlash, unsigned long ulLength);
+
+
+#endif  /* __INTERNAL_FLASH_KERNELS_H__ */
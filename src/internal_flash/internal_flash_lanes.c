@@ -0,0 +1,94 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#include "internal_flash_lanes.h"
+
+#include "asic_types.h"
+
+
+/* The scheduler is used by the netX90 internal flash and the host tests. */
+#if ASIC_TYP==ASIC_TYP_NETX90_MPW || ASIC_TYP==ASIC_TYP_NETX90 || ASIC_TYP==ASIC_TYP_HOST
+
+
+/* Run an operation on all lanes until all are done or one fails.
+ *
+ * The scheduler starts the next operation of each lane without waiting
+ * and polls the busy lanes in a round robin fashion. It never waits for
+ * one controller while another one is idle.
+ *
+ * If one lane fails, the operations which are already running on the
+ * other controllers are completed before the function returns.
+ */
+NETX_CONSOLEAPP_RESULT_T iflash_lanes_run(const IFLASH_LANE_FUNCTIONS_T *ptFunctions, const void *pvContext, IFLASH_LANE_T * const *pptLanes, unsigned int uiLanes)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	IFLASH_LANE_T *ptLane;
+	unsigned int uiCnt;
+	int iBusy;
+
+
+	tResult = NETX_CONSOLEAPP_RESULT_OK;
+
+	/* Start the first operation on all lanes. */
+	for(uiCnt=0; uiCnt<uiLanes; ++uiCnt)
+	{
+		tResult = ptFunctions->pfnStart(pvContext, pptLanes[uiCnt]);
+		if( tResult!=NETX_CONSOLEAPP_RESULT_OK )
+		{
+			break;
+		}
+	}
+
+	/* Poll all busy lanes and start the next operation as soon as one is finished. */
+	do
+	{
+		iBusy = 0;
+		for(uiCnt=0; uiCnt<uiLanes; ++uiCnt)
+		{
+			ptLane = pptLanes[uiCnt];
+			if( ptLane->tState==IFLASH_LANE_STATE_Busy )
+			{
+				if( ptFunctions->pfnIsRunning(pvContext, ptLane)!=0 )
+				{
+					iBusy = 1;
+				}
+				else if( tResult!=NETX_CONSOLEAPP_RESULT_OK )
+				{
+					/* Another lane failed. Do not start anything new. */
+					ptLane->tState = IFLASH_LANE_STATE_Idle;
+				}
+				else
+				{
+					tResult = ptFunctions->pfnContinue(pvContext, ptLane);
+					if( ptLane->tState==IFLASH_LANE_STATE_Busy )
+					{
+						iBusy = 1;
+					}
+				}
+			}
+		}
+	} while( iBusy!=0 );
+
+	return tResult;
+}
+
+
+#endif
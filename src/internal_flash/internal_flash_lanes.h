@@ -0,0 +1,68 @@
+/***************************************************************************
+ *   Copyright (C) 2016 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+#ifndef __INTERNAL_FLASH_LANES_H__
+#define __INTERNAL_FLASH_LANES_H__
+
+#include "netx_consoleapp.h"
+
+
+/* Run erase and program operations on several flash controllers at the
+ * same time.
+ *
+ * A command which covers more than one controller is split into one lane
+ * per controller. The scheduler only knows the state of the lanes. The
+ * operations on the controllers are done by the functions below. The
+ * lanes of the driver embed IFLASH_LANE_T as the first element.
+ */
+typedef enum IFLASH_LANE_STATE_ENUM
+{
+	IFLASH_LANE_STATE_Idle = 0,  /* No operation is running, the next one can be started. */
+	IFLASH_LANE_STATE_Busy = 1,  /* An erase or program operation is running. */
+	IFLASH_LANE_STATE_Done = 2   /* The complete area of the lane is processed. */
+} IFLASH_LANE_STATE_T;
+
+typedef struct IFLASH_LANE_STRUCT
+{
+	IFLASH_LANE_STATE_T tState;
+} IFLASH_LANE_T;
+
+
+/* Start the first operation of a lane or continue after the running one
+ * finished. The function sets the state of the lane.
+ */
+typedef NETX_CONSOLEAPP_RESULT_T (*PFN_IFLASH_LANE_STEP_T)(const void *pvContext, IFLASH_LANE_T *ptLane);
+
+/* Is the controller of a busy lane still running? */
+typedef int (*PFN_IFLASH_LANE_IS_RUNNING_T)(const void *pvContext, const IFLASH_LANE_T *ptLane);
+
+typedef struct IFLASH_LANE_FUNCTIONS_STRUCT
+{
+	PFN_IFLASH_LANE_STEP_T pfnStart;
+	PFN_IFLASH_LANE_STEP_T pfnContinue;
+	PFN_IFLASH_LANE_IS_RUNNING_T pfnIsRunning;
+} IFLASH_LANE_FUNCTIONS_T;
+
+
+NETX_CONSOLEAPP_RESULT_T iflash_lanes_run(const IFLASH_LANE_FUNCTIONS_T *ptFunctions, const void *pvContext, IFLASH_LANE_T * const *pptLanes, unsigned int uiLanes);
+
+
+#endif  /* __INTERNAL_FLASH_LANES_H__ */
@@ -20,6 +20,8 @@
 
 
 #include "internal_flash_maz_v0.h"
+#include "internal_flash_kernels.h"
+#include "internal_flash_lanes.h"
 
 #include "delay.h"
 #include "flasher_header.h"
@@ -39,6 +41,7 @@
 #define IFLASH_MAZ_V0_PAGE_SIZE_DWORD 4U
 
 #define IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES 0x0200
+#define IFLASH_MAZ_V0_PAGES_PER_ROW (IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES / IFLASH_MAZ_V0_PAGE_SIZE_BYTES)
 #define IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES 0x1000
 
 
@@ -67,6 +70,16 @@ typedef union IFLASH_PAGE_BUFFER_UNION
 } IFLASH_PAGE_BUFFER_T;
 
 
+typedef union IFLASH_ROW_BUFFER_UNION
+{
+	unsigned char auc[IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES];
+	unsigned long aul[IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES / sizeof(unsigned long)];
+} IFLASH_ROW_BUFFER_T;
+
+/* The data for one row. The data from the host is not aligned. */
+static IFLASH_ROW_BUFFER_T tRowBuffer;
+
+
 
 typedef struct FLASH_BLOCK_ATTRIBUTES_STRUCT
 {
@@ -316,6 +329,44 @@ static void internal_flash_select_main_array_read(void)
 }
 
 
+
+/* Select the read mode for a command and get a pointer to the data.
+ *
+ * The read mode is selected once for the complete command. If Flash01_Main
+ * is selected and the access starts in intflash0 but ends in intflash1,
+ * both controllers are configured.
+ */
+static NETX_CONSOLEAPP_RESULT_T iflash_select_read_area(const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr, unsigned long ulOffsetStart, unsigned long ulOffsetEnd, const unsigned char **ppucFlashStart)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	FLASH_BLOCK_ATTRIBUTES_T tFlashBlock;
+
+
+	/* Get the pointer to the controller and the offset in the memory map. */
+	tResult = iflash_get_controller(ptAttr, ulOffsetStart, &tFlashBlock);
+	if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+	{
+		*ppucFlashStart = (const unsigned char*)(HOSTADDR(intflash0) + tFlashBlock.ulUnitOffsetInBytes + ulOffsetStart);
+
+		/* Set the flash to read mode. */
+		internal_flash_select_read_mode_and_clear_caches(ptAttr, tFlashBlock.ptIFlashCfgArea);
+
+		if( (ptAttr->tArea==INTERNAL_FLASH_AREA_Flash01_Main) &&
+		    (ulOffsetStart<IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES) &&
+		    (ulOffsetEnd>IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES) )
+		{
+			tResult = iflash_get_controller(ptAttr, IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES, &tFlashBlock);
+			if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+			{
+				internal_flash_select_read_mode_and_clear_caches(ptAttr, tFlashBlock.ptIFlashCfgArea);
+			}
+		}
+	}
+
+	return tResult;
+}
+
+
 static void iflash_start_and_wait(HOSTADEF(IFLASH_CFG) *ptIFlashCfgArea)
 {
 	unsigned long ulValue;
@@ -666,160 +717,217 @@ static NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_erase_block(const INTERNAL
 
 
 
-static NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_flash_page(const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr, unsigned long ulOffsetInBytes, IFLASH_PAGE_BUFFER_T *ptDataToBeFlashed)
+/* Compare the data for some pages of a row with the flash contents.
+ *
+ * All pages which differ are collected in a mask. Pages with the requested
+ * data are not programmed again. Programming can only change bits from 1
+ * to 0. A bit which is set in the requested data must also be set in the
+ * flash.
+ *
+ * \param ulOffsetInBytes The offset of the first page. It is only used for messages.
+ * \param pulFlashDataArray Pointer to the first page in the data array of the flash.
+ * \param pulDataToBeFlashed The data for all pages.
+ * \param uiDwords The number of DWORDs to compare.
+ * \param pulPageMask Receives the mask of the pages which differ.
+ */
+static NETX_CONSOLEAPP_RESULT_T iflash_compare_row(unsigned long ulOffsetInBytes, const volatile unsigned long *pulFlashDataArray, const unsigned long *pulDataToBeFlashed, unsigned int uiDwords, unsigned long *pulPageMask)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	unsigned long ulExisting;
+	unsigned long ulRequested;
+	unsigned long ulPageMask;
+	unsigned int uiCnt;
+
+
+	tResult = NETX_CONSOLEAPP_RESULT_OK;
+	ulPageMask = 0;
+	for(uiCnt=0; uiCnt<uiDwords; ++uiCnt)
+	{
+		ulExisting = pulFlashDataArray[uiCnt];
+		ulRequested = pulDataToBeFlashed[uiCnt];
+		if( ulExisting!=ulRequested )
+		{
+			ulPageMask |= 1U << (uiCnt / IFLASH_MAZ_V0_PAGE_SIZE_DWORD);
+			if( (ulRequested & ~ulExisting)!=0 )
+			{
+				uprintf("! Invalid program request: trying to set bits from 0 to 1 at offset 0x%08x.\n", ulOffsetInBytes + uiCnt * sizeof(unsigned long));
+				uprintf("! Flash contents:  0x%08x\n", ulExisting);
+				uprintf("! Data to program: 0x%08x\n", ulRequested);
+				tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+			}
+		}
+	}
+	*pulPageMask = ulPageMask;
+
+	return tResult;
+}
+
+
+
+/* Compare the programmed pages of a row with the data. */
+static NETX_CONSOLEAPP_RESULT_T iflash_verify_row(unsigned long ulOffsetInBytes, const volatile unsigned long *pulFlashDataArray, const unsigned long *pulDataToBeFlashed, unsigned int uiDwords)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	const unsigned long *pulPage;
+	unsigned int uiCnt;
+	unsigned int uiPageCnt;
+	IFLASH_PAGE_BUFFER_T tExistingDataInFlash;
+
+
+	tResult = NETX_CONSOLEAPP_RESULT_OK;
+	for(uiCnt=0; uiCnt<uiDwords; ++uiCnt)
+	{
+		if( pulFlashDataArray[uiCnt]!=pulDataToBeFlashed[uiCnt] )
+		{
+			/* Show the complete page with the error. */
+			uiPageCnt = uiCnt / IFLASH_MAZ_V0_PAGE_SIZE_DWORD;
+			pulPage = pulDataToBeFlashed + uiPageCnt * IFLASH_MAZ_V0_PAGE_SIZE_DWORD;
+			for(uiCnt=0; uiCnt<IFLASH_MAZ_V0_PAGE_SIZE_DWORD; ++uiCnt)
+			{
+				tExistingDataInFlash.aul[uiCnt] = pulFlashDataArray[uiPageCnt * IFLASH_MAZ_V0_PAGE_SIZE_DWORD + uiCnt];
+			}
+
+			uprintf("! Verify error at offset 0x%08x.\n", ulOffsetInBytes + uiPageCnt * IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
+			uprintf("Expected data:\n");
+			hexdump((const unsigned char*)pulPage, IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
+			uprintf("Flash contents:\n");
+			hexdump(tExistingDataInFlash.auc, IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
+
+			tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+			break;
+		}
+	}
+
+	return tResult;
+}
+
+
+
+/* Program up to one row of the flash.
+ *
+ * The pages must be consecutive and in the same row. The controller is
+ * resolved once, all pages are checked before the first one is programmed
+ * and the flash stays in program mode until the last page is written. The
+ * caches are cleared once before and once after programming the row.
+ *
+ * \param ptAttr The attributes of the flash area.
+ * \param ulOffsetInBytes The offset of the first page. It must be aligned to a page.
+ * \param pulDataToBeFlashed The data for all pages.
+ * \param uiPages The number of pages to program.
+ */
+static NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_flash_row(const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr, unsigned long ulOffsetInBytes, const unsigned long *pulDataToBeFlashed, unsigned int uiPages)
 {
 	NETX_CONSOLEAPP_RESULT_T tResult;
 	HOSTADEF(IFLASH_CFG) *ptIFlashCfgArea;
 	unsigned long ulMisalignment;
 	unsigned long ulXAddr;
 	unsigned long ulYAddr;
-	unsigned long ulValue;
-	const unsigned char *pucFlashDataArray;
-	int iCmpResult;
-	unsigned int uiCnt;
-	unsigned long ulDifference;
-	IFLASH_PAGE_BUFFER_T tExistingDataInFlash;
-	IFLASH_PAGE_BUFFER_T tDifference;
+	unsigned long ulPageMask;
+	const volatile unsigned long *pulFlashDataArray;
+	const unsigned long *pulPage;
+	unsigned int uiDwords;
+	unsigned int uiPageCnt;
 	FLASH_BLOCK_ATTRIBUTES_T tFlashBlock;
 
 
 	/* Get the pointer to the controller and the offset in the memory map. */
 	tResult = iflash_get_controller(ptAttr, ulOffsetInBytes, &tFlashBlock);
 	ptIFlashCfgArea = tFlashBlock.ptIFlashCfgArea;
-	
+
 	if( tResult==NETX_CONSOLEAPP_RESULT_OK )
 	{
+		/* Convert the offset to an X and Y component. */
+		ulXAddr = ulOffsetInBytes / IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES;
+		ulYAddr  = ulOffsetInBytes;
+		ulYAddr -= (ulXAddr * IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES);
+		ulYAddr /= IFLASH_MAZ_V0_PAGE_SIZE_BYTES;
+
 		/* Is the offset aligned to the page start? */
 		ulMisalignment = ulOffsetInBytes % IFLASH_MAZ_V0_PAGE_SIZE_BYTES;
 		if( ulMisalignment!=0 )
 		{
-			uprintf("! Refuse to program non-aligned page at offset 0x%08x. The correct offset for the aligned page would be 0x08x.\n", ulOffsetInBytes, ulOffsetInBytes - ulMisalignment);
+			uprintf("! Refuse to program non-aligned page at offset 0x%08x. The correct offset for the aligned page would be 0x%08x.\n", ulOffsetInBytes, ulOffsetInBytes - ulMisalignment);
+			tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+		}
+		else if( uiPages==0 || (ulYAddr+uiPages)>IFLASH_MAZ_V0_PAGES_PER_ROW )
+		{
+			uprintf("! Refuse to program %d pages at offset 0x%08x. They do not fit into one row.\n", uiPages, ulOffsetInBytes);
 			tResult = NETX_CONSOLEAPP_RESULT_ERROR;
 		}
 		else
 		{
-			/* Get a pointer to the data array of the flash. */
-			pucFlashDataArray = (const unsigned char*)(HOSTADDR(intflash0) + tFlashBlock.ulUnitOffsetInBytes);
-			
+			/* Get a pointer to the first page in the data array of the flash. */
+			pulFlashDataArray = (const volatile unsigned long*)(HOSTADDR(intflash0) + tFlashBlock.ulUnitOffsetInBytes + ulOffsetInBytes);
+			uiDwords = uiPages * IFLASH_MAZ_V0_PAGE_SIZE_DWORD;
+
 			/* Select read mode and main array or info page */
 			internal_flash_select_read_mode_and_clear_caches(ptAttr, ptIFlashCfgArea);
 
-			/* Get the old contents of the flash. */
-			memcpy(tExistingDataInFlash.auc, pucFlashDataArray + ulOffsetInBytes, IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
-
 			/* Compare the data to be programmed with the flash contents. */
-			iCmpResult = memcmp(tExistingDataInFlash.aul, ptDataToBeFlashed->aul, IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
-			if( iCmpResult==0 )
-			{
-				/* The requested data is already in the flash. Do not program again. */
-				tResult = NETX_CONSOLEAPP_RESULT_OK;
-			}
-			else
+			tResult = iflash_compare_row(ulOffsetInBytes, pulFlashDataArray, pulDataToBeFlashed, uiDwords, &ulPageMask);
+
+			if( tResult==NETX_CONSOLEAPP_RESULT_OK && ulPageMask!=0 )
 			{
-				/* Check if the requested data will only change bits from 1 to 0.
-				 *
-				 * Get the difference first. "tDifference" will have
-				 * all bits set to 1 which differ between the flash
-				 * contents and the requested data.
-				 *
-				 * The flash contents must have all bits of the
-				 * difference set to 1. This can be checked by
-				 * masking the flash contents with the difference.
-				 * The result must be the difference.
-				 */
-
-				/* Get the difference between the flash contents and
-				 * the data to program.
-				 */
-				for(uiCnt=0; uiCnt<IFLASH_MAZ_V0_PAGE_SIZE_DWORD; ++uiCnt)
+				/* The ifren1 page needs special handling. */
+				if( ptAttr->iMain0_Info1_InfoK2_InfoS3==2 )
 				{
-					tDifference.aul[uiCnt] = tExistingDataInFlash.aul[uiCnt] ^ ptDataToBeFlashed->aul[uiCnt];
-				}
+					/* Enter the test mode. */
+					iflash_enter_ifren1_access(ptIFlashCfgArea);
 
-				tResult = NETX_CONSOLEAPP_RESULT_OK;
+					/* Select the ifren1 block. */
+					internal_flash_select_page(ptIFlashCfgArea, ptAttr->iMain0_Info1_InfoK2_InfoS3);
 
-				/* Check if all bits from the difference are set to 1
-				 * in the flash.
-				 */
-				for(uiCnt=0; uiCnt<IFLASH_MAZ_V0_PAGE_SIZE_DWORD; ++uiCnt)
-				{
-					ulDifference = tDifference.aul[uiCnt];
-					ulValue = tExistingDataInFlash.aul[uiCnt] & ulDifference;
-					if( ulValue!=ulDifference )
+					/* Program all modified pages. */
+					for(uiPageCnt=0; uiPageCnt<uiPages; ++uiPageCnt)
 					{
-						uprintf("! Invalid program request: trying to set bits from 0 to 1 at offset 0x%08x.\n", ulOffsetInBytes + uiCnt * sizeof(unsigned long));
-						uprintf("! Flash contents:  0x%08x\n", tExistingDataInFlash.aul[uiCnt]);
-						uprintf("! Data to program: 0x%08x\n", ptDataToBeFlashed->aul[uiCnt]);
-						tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+						if( (ulPageMask & (1U << uiPageCnt))!=0 )
+						{
+							pulPage = pulDataToBeFlashed + uiPageCnt * IFLASH_MAZ_V0_PAGE_SIZE_DWORD;
+							iflash_manual_program(ptIFlashCfgArea, ulXAddr, ulYAddr + uiPageCnt, pulPage);
+						}
 					}
+
+					/* Leave the test mode. */
+					iflash_leave_ifren1_access(ptIFlashCfgArea);
 				}
-				if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+				else
 				{
-					/* Convert the offset to an X and Y component. */
-					ulXAddr = ulOffsetInBytes / IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES;
-					ulYAddr  = ulOffsetInBytes;
-					ulYAddr -= (ulXAddr * IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES);
-					ulYAddr /= IFLASH_MAZ_V0_PAGE_SIZE_BYTES;
-
-					/* The ifren1 page needs special handling. */
-					if( ptAttr->iMain0_Info1_InfoK2_InfoS3==2 )
-					{
-						/* Enter the test mode. */
-						iflash_enter_ifren1_access(ptIFlashCfgArea);
+					/* Set the TMR line to 1. */
+					ptIFlashCfgArea->ulIflash_special_cfg = HOSTMSK(iflash_special_cfg_tmr);
 
-						/* Select the ifren1 block. */
-						internal_flash_select_page(ptIFlashCfgArea, ptAttr->iMain0_Info1_InfoK2_InfoS3);
+					/* Select "program" mode and main array or info block. */
+					internal_flash_select_mode_and_clear_caches(ptAttr, ptIFlashCfgArea, IFLASH_MODE_PROGRAM);
 
-						/* Program the page. */
-						iflash_manual_program(ptIFlashCfgArea, ulXAddr, ulYAddr, ptDataToBeFlashed->aul);
+					/* All pages are in the same row. */
+					ptIFlashCfgArea->ulIflash_xadr = ulXAddr;
 
-						/* Leave the test mode. */
-						iflash_leave_ifren1_access(ptIFlashCfgArea);
-					}
-					else
+					/* Program all modified pages. */
+					for(uiPageCnt=0; uiPageCnt<uiPages; ++uiPageCnt)
 					{
-						/* Set the TMR line to 1. */
-						ptIFlashCfgArea->ulIflash_special_cfg = HOSTMSK(iflash_special_cfg_tmr);
-
-						/* Select "program" mode and main array or info block. */
-						internal_flash_select_mode_and_clear_caches(ptAttr, ptIFlashCfgArea, IFLASH_MODE_PROGRAM);
-
-						/* Set the X and Y address. */
-						ptIFlashCfgArea->ulIflash_xadr = ulXAddr;
-						ptIFlashCfgArea->ulIflash_yadr = ulYAddr;
-
-						/* Set the data for the "program" operation. */
-						ptIFlashCfgArea->aulIflash_din[0] = ptDataToBeFlashed->aul[0];
-						ptIFlashCfgArea->aulIflash_din[1] = ptDataToBeFlashed->aul[1];
-						ptIFlashCfgArea->aulIflash_din[2] = ptDataToBeFlashed->aul[2];
-						ptIFlashCfgArea->aulIflash_din[3] = ptDataToBeFlashed->aul[3];
+						if( (ulPageMask & (1U << uiPageCnt))!=0 )
+						{
+							pulPage = pulDataToBeFlashed + uiPageCnt * IFLASH_MAZ_V0_PAGE_SIZE_DWORD;
 
-						/* Start programming. */
-						iflash_start_and_wait(ptIFlashCfgArea);
+							/* Set the Y address. */
+							ptIFlashCfgArea->ulIflash_yadr = ulYAddr + uiPageCnt;
 
-						/* Go back to the read mode. */
-						internal_flash_select_read_mode_and_clear_caches(ptAttr, ptIFlashCfgArea);
-					}
+							/* Set the data for the "program" operation. */
+							ptIFlashCfgArea->aulIflash_din[0] = pulPage[0];
+							ptIFlashCfgArea->aulIflash_din[1] = pulPage[1];
+							ptIFlashCfgArea->aulIflash_din[2] = pulPage[2];
+							ptIFlashCfgArea->aulIflash_din[3] = pulPage[3];
 
-					/* Verify the data. */
-					memcpy(tExistingDataInFlash.auc, pucFlashDataArray + ulOffsetInBytes, IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
-					iCmpResult = memcmp(tExistingDataInFlash.aul, ptDataToBeFlashed->aul, IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
-					if( iCmpResult==0 )
-					{
-						/* The requested data was written to the flash. */
-						tResult = NETX_CONSOLEAPP_RESULT_OK;
+							/* Start programming. */
+							iflash_start_and_wait(ptIFlashCfgArea);
+						}
 					}
-					else
-					{
-						uprintf("! Verify error at offset 0x%08x.\n", ulOffsetInBytes);
-						uprintf("Expected data:\n");
-						hexdump(ptDataToBeFlashed->auc, IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
-						uprintf("Flash contents:\n");
-						hexdump(tExistingDataInFlash.auc, IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
 
-						tResult = NETX_CONSOLEAPP_RESULT_ERROR;
-					}
+					/* Go back to the read mode. */
+					internal_flash_select_read_mode_and_clear_caches(ptAttr, ptIFlashCfgArea);
 				}
+
+				/* Verify all pages of the row in one pass. */
+				tResult = iflash_verify_row(ulOffsetInBytes, pulFlashDataArray, pulDataToBeFlashed, uiDwords);
 			}
 		}
 	}
@@ -1167,27 +1275,27 @@ static void infoS_clear_IF2(unsigned char *pucBuffer)
 
 
 
-static NETX_CONSOLEAPP_RESULT_T infoS_flash(const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr, unsigned long ulOffset, const unsigned char *pucBuffer)
+/* Program a complete erase block from a buffer. */
+static NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_flash_block(const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr, unsigned long ulOffset, const unsigned char *pucBuffer)
 {
 	NETX_CONSOLEAPP_RESULT_T tResult;
 	unsigned long ulOffsetCnt;
-	IFLASH_PAGE_BUFFER_T tFlashBuffer;
 
 
 	ulOffsetCnt = 0U;
 	do
 	{
-		memcpy(tFlashBuffer.auc, pucBuffer, IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
-		tResult = internal_flash_maz_v0_flash_page(ptAttr, ulOffset+ulOffsetCnt, &tFlashBuffer);
+		memcpy(tRowBuffer.auc, pucBuffer, IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES);
+		tResult = internal_flash_maz_v0_flash_row(ptAttr, ulOffset+ulOffsetCnt, tRowBuffer.aul, IFLASH_MAZ_V0_PAGES_PER_ROW);
 		if( tResult!=NETX_CONSOLEAPP_RESULT_OK )
 		{
-			uprintf("! Failed to flash the page at offset 0x%08x.\n", ulOffset);
+			uprintf("! Failed to flash the row at offset 0x%08x.\n", ulOffset+ulOffsetCnt);
 			break;
 		}
 		else
 		{
-			ulOffsetCnt += IFLASH_MAZ_V0_PAGE_SIZE_BYTES;
-			pucBuffer += IFLASH_MAZ_V0_PAGE_SIZE_BYTES;
+			ulOffsetCnt += IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES;
+			pucBuffer += IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES;
 		}
 	} while( ulOffsetCnt<IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES );
 
@@ -1238,7 +1346,7 @@ static NETX_CONSOLEAPP_RESULT_T infoS_prepareReadData(const INTERNAL_FLASH_ATTRI
 			/* Check the integrity of the secure info page. */
 
 			/* The info page contains 2 copies of the secure info page. They must be the same. */
-			if( memcmp(pucFlashData, pucFlashData+IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES, IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES)!=0 )
+			if( iflash_compare(pucFlashData, pucFlashData+IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES, IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES)!=IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES )
 			{
 				uprintf("! Both SIPs in the info page should be the same, but they differ.\n");
 				tResult = NETX_CONSOLEAPP_RESULT_ERROR;
@@ -1254,7 +1362,7 @@ static NETX_CONSOLEAPP_RESULT_T infoS_prepareReadData(const INTERNAL_FLASH_ATTRI
 			else
 			{
 				/* Copy the secure info page to the buffer. */
-				memcpy(pucBuffer, pucFlashData, IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES);
+				iflash_copy(pucBuffer, pucFlashData, IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES);
 
 				/* Clear the data. */
 				tFlashArea = ptAttr->tArea;
@@ -1399,229 +1507,769 @@ static NETX_CONSOLEAPP_RESULT_T check_info_write_protection(INTERNAL_FLASH_AREA_
 #endif
 
 
-NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_flash(CMD_PARAMETER_FLASH_T *ptParameter)
+/* Flash an area which needs no erase.
+ *
+ * \param ptAttr The attributes of the flash area.
+ * \param ulOffsetStart The offset of the first byte to flash.
+ * \param ulOffsetEnd The offset after the last byte to flash.
+ * \param pucDataToBeFlashed The data to flash.
+ */
+static NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_flash_in_place(const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr, unsigned long ulOffsetStart, unsigned long ulOffsetEnd, const unsigned char *pucDataToBeFlashed)
 {
 	NETX_CONSOLEAPP_RESULT_T tResult;
-	const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr;
-	unsigned long ulOffsetStart;
-	unsigned long ulOffsetEnd;
 	const unsigned char *pucFlashDataArea; /* This is the data area of the flash. */
-	const unsigned char *pucDataToBeFlashed; /* This is the data to be flashed. */
 	unsigned long ulOffset;
 	unsigned long ulPageStartOffset;
 	unsigned long ulChunkOffset;
 	unsigned long ulChunkSize;
 	unsigned long ulDataSize;
-	unsigned char *pucInternalWorkingBuffer;
-    unsigned char *pucBufferStart;
-	INTERNAL_FLASH_AREA_T tFlashArea;
 	FLASH_BLOCK_ATTRIBUTES_T tFlashBlock;
 	IFLASH_PAGE_BUFFER_T tFlashBuffer; /* This is the buffer for the data to flash. */
 
 
-	/* Be pessimistic... */
-	tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+	tResult = NETX_CONSOLEAPP_RESULT_OK;
 
-	ulOffsetStart = ptParameter->ulStartAdr;
-	ulOffsetEnd = ulOffsetStart + ptParameter->ulDataByteSize;
+	ulOffset = ulOffsetStart;
 
-	/* Silently ignore flash requests with a size of 0 bytes. */
-	if( ulOffsetStart==ulOffsetEnd )
-	{
-		tResult = NETX_CONSOLEAPP_RESULT_OK;
-	}
-	else
+	/* Does the area start in the middle of a page? */
+	ulChunkOffset = ulOffset % IFLASH_MAZ_V0_PAGE_SIZE_BYTES;
+	if( ulChunkOffset!=0 )
 	{
-		/* Get a pointer to the flash attributes. */
-		ptAttr = &(ptParameter->ptDeviceDescription->uInfo.tInternalFlashInfo.uAttributes.tMazV0);
+		/* Yes -> modify the last part of a page. */
 
-		tFlashArea = ptAttr->tArea;
-		tResult = check_info_write_protection(tFlashArea, 1);
-		if( tResult==NETX_CONSOLEAPP_RESULT_OK )
-		{
-		    /* check if the data's checksum is correct */
-            if( tFlashArea==INTERNAL_FLASH_AREA_Flash1_InfoS || tFlashArea==INTERNAL_FLASH_AREA_Flash2_InfoS ||
-             tFlashArea==INTERNAL_FLASH_AREA_Flash2_Info || tFlashArea==INTERNAL_FLASH_AREA_Flash1_Info)
-            {
-                pucBufferStart = ptParameter->pucData;
-                if( infoS_check_hash(pucBufferStart)!=0 )
-                {
-                    uprintf("! The flash data has an invalid checksum.\n");
-                    tResult = NETX_CONSOLEAPP_RESULT_ERROR;
-                }
-            }
-        }
+		/* Get the pointer to the controller and the offset in the memory map. */
+		tResult = iflash_get_controller(ptAttr, ulOffset, &tFlashBlock);
 		if( tResult==NETX_CONSOLEAPP_RESULT_OK )
 		{
-			if( tFlashArea==INTERNAL_FLASH_AREA_Flash1_InfoS || tFlashArea==INTERNAL_FLASH_AREA_Flash2_InfoS )
-			{
-				/* This command needs an internal working buffer. Place it at the end of the data buffer. */
-				pucInternalWorkingBuffer = flasher_version.pucBuffer_End - IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES;
+			pucFlashDataArea = (const unsigned char*)(HOSTADDR(intflash0) + tFlashBlock.ulUnitOffsetInBytes);
 
-				/* The special "S" secure info pages can only be flashed as a complete page. */
-				if( ulOffsetStart!=0 )
-				{
-					tResult = NETX_CONSOLEAPP_RESULT_ERROR;
-					uprintf("! The info S pages can only be flashed at offset 0.\n");
-				}
-				else if( ptParameter->ulDataByteSize!=IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES )
-				{
-					tResult = NETX_CONSOLEAPP_RESULT_ERROR;
-					uprintf("! The info S pages can only be flashed with 4096 bytes.\n");
-				}
-				/* Does the command buffer overlap with the internal working buffer? */
-				else if( (ptParameter->pucData+IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES)>=pucInternalWorkingBuffer )
-				{
-					tResult = NETX_CONSOLEAPP_RESULT_ERROR;
-					uprintf("! The selected buffer overlaps with the internal working buffer.\n");
-				}
-				else
-				{
-					tResult = iflash_get_controller(ptAttr, 0, &tFlashBlock);
-					if( tResult==NETX_CONSOLEAPP_RESULT_OK )
-					{
-						/* Create a copy of the data in the internal working buffer. */
-						memcpy(pucInternalWorkingBuffer, ptParameter->pucData, IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES);
+			/* Get the start offset of the page. */
+			ulPageStartOffset = ulOffset - ulChunkOffset;
 
-						if( tFlashArea==INTERNAL_FLASH_AREA_Flash1_InfoS )
-						{
-							/* Flash the secure COM info page. */
-							infoS_patch_IF1(pucInternalWorkingBuffer);
-						}
-						else
-						{
-							/* Flash the secure APP page. */
-							tResult = infoS_patch_IF2(pucInternalWorkingBuffer);
-						}
+			/* Get the old contents of the page. */
+			memcpy(tFlashBuffer.auc, pucFlashDataArea + ulPageStartOffset, IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
 
-						if( tResult==NETX_CONSOLEAPP_RESULT_OK )
-						{
-							/* Select read mode and main array or info page */
-							internal_flash_select_read_mode_and_clear_caches(ptAttr, tFlashBlock.ptIFlashCfgArea);
+			/* Add the new part to the buffer. */
+			ulChunkSize = IFLASH_MAZ_V0_PAGE_SIZE_BYTES - ulChunkOffset;
+			ulDataSize = ulOffsetEnd - ulOffset;
+			if( ulChunkSize>ulDataSize )
+			{
+				ulChunkSize = ulDataSize;
+			}
+			memcpy(tFlashBuffer.auc + ulChunkOffset, pucDataToBeFlashed, ulChunkSize);
 
-							/* Flash the page to offset 0 and offset 4096. */
-							tResult = infoS_flash(ptAttr, 0, pucInternalWorkingBuffer);
-							if( tResult==NETX_CONSOLEAPP_RESULT_OK )
-							{
-								/* Erase the 2nd block in the info page. */
-								tResult = internal_flash_maz_v0_erase_block(ptAttr, IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES);
-								if( tResult==NETX_CONSOLEAPP_RESULT_OK )
-								{
-									tResult = infoS_flash(ptAttr, IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES, pucInternalWorkingBuffer);
-								}
-							}
+			/* Flash the chunk. */
+			tResult = internal_flash_maz_v0_flash_row(ptAttr, ulPageStartOffset, tFlashBuffer.aul, 1);
+			if( tResult!=NETX_CONSOLEAPP_RESULT_OK )
+			{
+				uprintf("! Failed to flash the page at offset 0x%08x.\n", ulPageStartOffset);
+			}
+			else
+			{
+				ulOffset += ulChunkSize;
+				pucDataToBeFlashed += ulChunkSize;
+			}
+		}
+	}
 
-							/* Clear the internal working buffer. */
-							memset(pucInternalWorkingBuffer, 0x00U, IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES);
-						}
-					}
-				}
+	if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+	{
+		/* Write all complete pages row by row. */
+		while( (ulOffset+IFLASH_MAZ_V0_PAGE_SIZE_BYTES)<=ulOffsetEnd )
+		{
+			/* Get the rest of the row, but only complete pages. */
+			ulChunkSize = IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES - (ulOffset % IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES);
+			ulDataSize = ulOffsetEnd - ulOffset;
+			ulDataSize -= ulDataSize % IFLASH_MAZ_V0_PAGE_SIZE_BYTES;
+			if( ulChunkSize>ulDataSize )
+			{
+				ulChunkSize = ulDataSize;
+			}
+
+			memcpy(tRowBuffer.auc, pucDataToBeFlashed, ulChunkSize);
+			tResult = internal_flash_maz_v0_flash_row(ptAttr, ulOffset, tRowBuffer.aul, ulChunkSize / IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
+			if( tResult!=NETX_CONSOLEAPP_RESULT_OK )
+			{
+				uprintf("! Failed to flash the row at offset 0x%08x.\n", ulOffset);
+				break;
 			}
 			else
 			{
-				tResult = check_command_area(ptAttr, ulOffsetStart, ulOffsetEnd);
-				if( tResult==NETX_CONSOLEAPP_RESULT_OK )
-				{
-					/* Get a pointer to the data to be flashed. */
-					pucDataToBeFlashed = ptParameter->pucData;
+				ulOffset += ulChunkSize;
+				pucDataToBeFlashed += ulChunkSize;
+			}
+		}
+	}
 
-					ulOffset = ulOffsetStart;
+	if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+	{
+		/* Is a part of the last page left? */
+		ulChunkSize = ulOffsetEnd - ulOffset;
+		if( ulChunkSize!=0 )
+		{
+			/* Get the pointer to the controller and the offset in the memory map. */
+			tResult = iflash_get_controller(ptAttr, ulOffset, &tFlashBlock);
+			if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+			{
+				pucFlashDataArea = (const unsigned char*)(HOSTADDR(intflash0) + tFlashBlock.ulUnitOffsetInBytes);
 
-					/* Does the area start in the middle of a page? */
-					ulChunkOffset = ulOffset % IFLASH_MAZ_V0_PAGE_SIZE_BYTES;
-					if( ulChunkOffset!=0 )
-					{
-						/* Yes -> modify the last part of a page. */
+				/* Get the old contents of the page. */
+				memcpy(tFlashBuffer.auc, pucFlashDataArea + ulOffset, IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
 
-						/* Get the pointer to the controller and the offset in the memory map. */
-						tResult = iflash_get_controller(ptAttr, ulOffset, &tFlashBlock);
-						if( tResult==NETX_CONSOLEAPP_RESULT_OK )
-						{
-							pucFlashDataArea = (const unsigned char*)(HOSTADDR(intflash0) + tFlashBlock.ulUnitOffsetInBytes);
+				/* Add the new part to the buffer. */
+				memcpy(tFlashBuffer.auc, pucDataToBeFlashed, ulChunkSize);
 
-							/* Get the start offset of the page. */
-							ulPageStartOffset = ulOffset - ulChunkOffset;
+				/* Flash the chunk. */
+				tResult = internal_flash_maz_v0_flash_row(ptAttr, ulOffset, tFlashBuffer.aul, 1);
+				if( tResult!=NETX_CONSOLEAPP_RESULT_OK )
+				{
+					uprintf("! Failed to flash the page at offset 0x%08x.\n", ulOffset);
+				}
+				else
+				{
+					ulOffset += ulChunkSize;
+					pucDataToBeFlashed += ulChunkSize;
+				}
+			}
+		}
+	}
 
-							/* Get the old contents of the page. */
-							memcpy(tFlashBuffer.auc, pucFlashDataArea + ulPageStartOffset, IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
+	return tResult;
+}
 
-							/* Add the new part to the buffer. */
-							ulChunkSize = IFLASH_MAZ_V0_PAGE_SIZE_BYTES - ulChunkOffset;
-							ulDataSize = ulOffsetEnd - ulOffset;
-							if( ulChunkSize>ulDataSize )
-							{
-								ulChunkSize = ulDataSize;
-							}
-							memcpy(tFlashBuffer.auc + ulChunkOffset, pucDataToBeFlashed, ulChunkSize);
 
-							/* Flash the chunk. */
-							tResult = internal_flash_maz_v0_flash_page(ptAttr, ulPageStartOffset, &tFlashBuffer);
-							if( tResult!=NETX_CONSOLEAPP_RESULT_OK )
-							{
-								uprintf("! Failed to flash the page at offset 0x%08x.\n", ulPageStartOffset);
-							}
-							else
-							{
-								ulOffset += ulChunkSize;
-								pucDataToBeFlashed += ulChunkSize;
-							}
-						}
+
+/* Run erase and program operations on several flash controllers at the
+ * same time.
+ *
+ * Each controller has its own macro and runs one erase or program
+ * operation on its own. A command which covers more than one macro is
+ * split into one lane per controller. The scheduler in
+ * internal_flash_lanes.c runs the lanes with the functions below.
+ *
+ * Only the main arrays use the automatic erase and program modes. The
+ * ifren1 pages are programmed in the manual mode with fixed delays and
+ * are never split.
+ */
+
+/* The netX90 has 3 flash controllers. */
+#define IFLASH_MAZ_V0_CONTROLLERS 3U
+
+typedef struct IFLASH_MAZ_V0_LANE_STRUCT
+{
+	IFLASH_LANE_T tLane;              /* The state for the scheduler. This must be the first element. */
+	FLASH_BLOCK_ATTRIBUTES_T tFlashBlock;
+	unsigned long ulOffset;           /* The offset of the current erase block or row. */
+	unsigned long ulOffsetEnd;        /* The end of the area for this lane. */
+	const unsigned char *pucData;     /* The data for the current row. Only used for programming. */
+	unsigned long ulRowSize;          /* The number of bytes in the current row. */
+	unsigned long ulPageMask;         /* The pages of the current row which must be programmed. */
+	unsigned int uiPage;              /* The page which is programmed right now. */
+	IFLASH_ROW_BUFFER_T tRowBuffer;   /* An aligned copy of the current row. */
+} IFLASH_MAZ_V0_LANE_T;
+
+static IFLASH_MAZ_V0_LANE_T atIflashLanes[IFLASH_MAZ_V0_CONTROLLERS];
+
+static IFLASH_LANE_T * const aptIflashLanes[IFLASH_MAZ_V0_CONTROLLERS] =
+{
+	&(atIflashLanes[0].tLane),
+	&(atIflashLanes[1].tLane),
+	&(atIflashLanes[2].tLane)
+};
+
+
+
+/* Split an area into one lane for each flash controller.
+ *
+ * The area must be inside the flash. Only the area Flash01_Main covers
+ * two controllers. All other areas get one lane.
+ *
+ * \return The number of lanes.
+ */
+static unsigned int iflash_lanes_setup(const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr, unsigned long ulOffsetStart, unsigned long ulOffsetEnd, const unsigned char *pucData)
+{
+	IFLASH_MAZ_V0_LANE_T *ptLane;
+	unsigned long ulLaneEnd;
+	unsigned int uiLanes;
+
+
+	uiLanes = 0;
+	while( ulOffsetStart<ulOffsetEnd && uiLanes<IFLASH_MAZ_V0_CONTROLLERS )
+	{
+		ulLaneEnd = ulOffsetEnd;
+		if( ptAttr->tArea==INTERNAL_FLASH_AREA_Flash01_Main && ulOffsetStart<IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES && ulLaneEnd>IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES )
+		{
+			ulLaneEnd = IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES;
+		}
+
+		ptLane = atIflashLanes + uiLanes;
+		if( iflash_get_controller(ptAttr, ulOffsetStart, &(ptLane->tFlashBlock))!=NETX_CONSOLEAPP_RESULT_OK )
+		{
+			break;
+		}
+		ptLane->tLane.tState = IFLASH_LANE_STATE_Idle;
+		ptLane->ulOffset = ulOffsetStart;
+		ptLane->ulOffsetEnd = ulLaneEnd;
+		ptLane->pucData = pucData;
+		ptLane->ulRowSize = 0;
+		ptLane->ulPageMask = 0;
+		ptLane->uiPage = 0;
+		++uiLanes;
+
+		pucData += ulLaneEnd - ulOffsetStart;
+		ulOffsetStart = ulLaneEnd;
+	}
+
+	return uiLanes;
+}
+
+
+
+static int iflash_lane_is_running(const void *pvContext, const IFLASH_LANE_T *ptGenericLane)
+{
+	const IFLASH_MAZ_V0_LANE_T *ptLane;
+
+
+	ptLane = (const IFLASH_MAZ_V0_LANE_T*)ptGenericLane;
+	return (ptLane->tFlashBlock.ptIFlashCfgArea->ulIflash_access & HOSTMSK(iflash_access_run))!=0;
+}
+
+
+
+/* Start the erase of the next block in the lane which is not erased yet. */
+static NETX_CONSOLEAPP_RESULT_T iflash_lane_start_erase(const void *pvContext, IFLASH_LANE_T *ptGenericLane)
+{
+	const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr;
+	IFLASH_MAZ_V0_LANE_T *ptLane;
+	HOSTADEF(IFLASH_CFG) *ptIFlashCfgArea;
+	unsigned long ulBlockNumber;
+
+
+	ptAttr = (const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T*)pvContext;
+	ptLane = (IFLASH_MAZ_V0_LANE_T*)ptGenericLane;
+	ptIFlashCfgArea = ptLane->tFlashBlock.ptIFlashCfgArea;
+	ptLane->tLane.tState = IFLASH_LANE_STATE_Done;
+
+	internal_flash_select_read_mode_and_clear_caches(ptAttr, ptIFlashCfgArea);
+	while( ptLane->ulOffset<ptLane->ulOffsetEnd )
+	{
+		ulBlockNumber = ptLane->ulOffset / IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES;
+		if( is_block_erased(&(ptLane->tFlashBlock), ulBlockNumber)!=0xffffffffU )
+		{
+			/* Select "erase" mode and main memory or info page. */
+			internal_flash_select_mode_and_clear_caches(ptAttr, ptIFlashCfgArea, IFLASH_MODE_ERASE);
+
+			ptIFlashCfgArea->ulIflash_xadr = ptLane->ulOffset / IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES;
+			ptIFlashCfgArea->ulIflash_yadr = 0;
+
+			/* Start erasing, but do not wait. */
+			ptIFlashCfgArea->ulIflash_access = HOSTMSK(iflash_access_run);
+			ptLane->tLane.tState = IFLASH_LANE_STATE_Busy;
+			break;
+		}
+
+		uprintf(". The erase block at offset 0x%08x is already clear. Skipping the ERASE command.\n", ptLane->ulOffset);
+		ptLane->ulOffset += IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES;
+	}
+
+	return NETX_CONSOLEAPP_RESULT_OK;
+}
+
+
+
+/* Check the erased block and start the next one. */
+static NETX_CONSOLEAPP_RESULT_T iflash_lane_continue_erase(const void *pvContext, IFLASH_LANE_T *ptGenericLane)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr;
+	IFLASH_MAZ_V0_LANE_T *ptLane;
+	unsigned long ulBlockNumber;
+
+
+	ptAttr = (const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T*)pvContext;
+	ptLane = (IFLASH_MAZ_V0_LANE_T*)ptGenericLane;
+	/* Go back to the read mode. */
+	internal_flash_select_read_mode_and_clear_caches(ptAttr, ptLane->tFlashBlock.ptIFlashCfgArea);
+
+	ulBlockNumber = ptLane->ulOffset / IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES;
+	if( is_block_erased(&(ptLane->tFlashBlock), ulBlockNumber)!=0xffffffffU )
+	{
+		uprintf("! The erase block at offset 0x%08x was not erased.\n", ptLane->ulOffset);
+		ptLane->tLane.tState = IFLASH_LANE_STATE_Idle;
+		tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+	}
+	else
+	{
+		ptLane->ulOffset += IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES;
+		tResult = iflash_lane_start_erase(pvContext, ptGenericLane);
+	}
+
+	return tResult;
+}
+
+
+
+/* Start programming the next modified page of the current row. */
+static void iflash_lane_start_page(IFLASH_MAZ_V0_LANE_T *ptLane)
+{
+	HOSTADEF(IFLASH_CFG) *ptIFlashCfgArea;
+	const unsigned long *pulPage;
+	unsigned int uiPages;
+
+
+	ptIFlashCfgArea = ptLane->tFlashBlock.ptIFlashCfgArea;
+	uiPages = ptLane->ulRowSize / IFLASH_MAZ_V0_PAGE_SIZE_BYTES;
+	while( ptLane->uiPage<uiPages && (ptLane->ulPageMask & (1U << ptLane->uiPage))==0 )
+	{
+		++ptLane->uiPage;
+	}
+
+	if( ptLane->uiPage<uiPages )
+	{
+		pulPage = ptLane->tRowBuffer.aul + ptLane->uiPage * IFLASH_MAZ_V0_PAGE_SIZE_DWORD;
+
+		/* Set the Y address. */
+		ptIFlashCfgArea->ulIflash_yadr = ((ptLane->ulOffset % IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES) / IFLASH_MAZ_V0_PAGE_SIZE_BYTES) + ptLane->uiPage;
+
+		/* Set the data for the "program" operation. */
+		ptIFlashCfgArea->aulIflash_din[0] = pulPage[0];
+		ptIFlashCfgArea->aulIflash_din[1] = pulPage[1];
+		ptIFlashCfgArea->aulIflash_din[2] = pulPage[2];
+		ptIFlashCfgArea->aulIflash_din[3] = pulPage[3];
+
+		/* Start programming, but do not wait. */
+		ptIFlashCfgArea->ulIflash_access = HOSTMSK(iflash_access_run);
+		ptLane->tLane.tState = IFLASH_LANE_STATE_Busy;
+	}
+	else
+	{
+		/* All pages of the row are started. */
+		ptLane->tLane.tState = IFLASH_LANE_STATE_Idle;
+	}
+}
+
+
+
+/* Start the next row of the lane which needs programming. */
+static NETX_CONSOLEAPP_RESULT_T iflash_lane_start_program(const void *pvContext, IFLASH_LANE_T *ptGenericLane)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr;
+	IFLASH_MAZ_V0_LANE_T *ptLane;
+	HOSTADEF(IFLASH_CFG) *ptIFlashCfgArea;
+	const volatile unsigned long *pulFlashDataArray;
+	unsigned long ulRowSize;
+
+
+	ptAttr = (const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T*)pvContext;
+	ptLane = (IFLASH_MAZ_V0_LANE_T*)ptGenericLane;
+	tResult = NETX_CONSOLEAPP_RESULT_OK;
+	ptIFlashCfgArea = ptLane->tFlashBlock.ptIFlashCfgArea;
+	ptLane->tLane.tState = IFLASH_LANE_STATE_Done;
+
+	internal_flash_select_read_mode_and_clear_caches(ptAttr, ptIFlashCfgArea);
+	while( ptLane->ulOffset<ptLane->ulOffsetEnd )
+	{
+		/* Get the rest of the row. The lanes contain only complete pages. */
+		ulRowSize = IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES - (ptLane->ulOffset % IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES);
+		if( ulRowSize>(ptLane->ulOffsetEnd-ptLane->ulOffset) )
+		{
+			ulRowSize = ptLane->ulOffsetEnd - ptLane->ulOffset;
+		}
+		ptLane->ulRowSize = ulRowSize;
+
+		/* The data from the host is not aligned. */
+		memcpy(ptLane->tRowBuffer.auc, ptLane->pucData, ulRowSize);
+
+		pulFlashDataArray = (const volatile unsigned long*)(HOSTADDR(intflash0) + ptLane->tFlashBlock.ulUnitOffsetInBytes + ptLane->ulOffset);
+		tResult = iflash_compare_row(ptLane->ulOffset, pulFlashDataArray, ptLane->tRowBuffer.aul, ulRowSize / sizeof(unsigned long), &(ptLane->ulPageMask));
+		if( tResult!=NETX_CONSOLEAPP_RESULT_OK )
+		{
+			ptLane->tLane.tState = IFLASH_LANE_STATE_Idle;
+			break;
+		}
+		if( ptLane->ulPageMask!=0 )
+		{
+			/* Set the TMR line to 1. */
+			ptIFlashCfgArea->ulIflash_special_cfg = HOSTMSK(iflash_special_cfg_tmr);
+
+			/* Select "program" mode and main array or info block. */
+			internal_flash_select_mode_and_clear_caches(ptAttr, ptIFlashCfgArea, IFLASH_MODE_PROGRAM);
+
+			/* All pages are in the same row. */
+			ptIFlashCfgArea->ulIflash_xadr = ptLane->ulOffset / IFLASH_MAZ_V0_ROW_SIZE_IN_BYTES;
+
+			ptLane->uiPage = 0;
+			iflash_lane_start_page(ptLane);
+			break;
+		}
+
+		/* The row already has the requested data. */
+		ptLane->ulOffset += ulRowSize;
+		ptLane->pucData += ulRowSize;
+	}
+
+	return tResult;
+}
+
+
+
+/* Start the next page of the row. Verify the row if it is complete and start the next one. */
+static NETX_CONSOLEAPP_RESULT_T iflash_lane_continue_program(const void *pvContext, IFLASH_LANE_T *ptGenericLane)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr;
+	IFLASH_MAZ_V0_LANE_T *ptLane;
+	const volatile unsigned long *pulFlashDataArray;
+
+
+	ptAttr = (const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T*)pvContext;
+	ptLane = (IFLASH_MAZ_V0_LANE_T*)ptGenericLane;
+	tResult = NETX_CONSOLEAPP_RESULT_OK;
+
+	++ptLane->uiPage;
+	iflash_lane_start_page(ptLane);
+	if( ptLane->tLane.tState==IFLASH_LANE_STATE_Idle )
+	{
+		/* Go back to the read mode. */
+		internal_flash_select_read_mode_and_clear_caches(ptAttr, ptLane->tFlashBlock.ptIFlashCfgArea);
+
+		/* Verify all pages of the row in one pass. */
+		pulFlashDataArray = (const volatile unsigned long*)(HOSTADDR(intflash0) + ptLane->tFlashBlock.ulUnitOffsetInBytes + ptLane->ulOffset);
+		tResult = iflash_verify_row(ptLane->ulOffset, pulFlashDataArray, ptLane->tRowBuffer.aul, ptLane->ulRowSize / sizeof(unsigned long));
+		if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+		{
+			ptLane->ulOffset += ptLane->ulRowSize;
+			ptLane->pucData += ptLane->ulRowSize;
+			tResult = iflash_lane_start_program(pvContext, ptGenericLane);
+		}
+	}
+
+	return tResult;
+}
+
+
+
+static const IFLASH_LANE_FUNCTIONS_T tIflashLaneFunctionsErase =
+{
+	iflash_lane_start_erase,
+	iflash_lane_continue_erase,
+	iflash_lane_is_running
+};
+
+static const IFLASH_LANE_FUNCTIONS_T tIflashLaneFunctionsProgram =
+{
+	iflash_lane_start_program,
+	iflash_lane_continue_program,
+	iflash_lane_is_running
+};
+
+
+
+/* Program complete pages on all controllers of the area at the same time.
+ *
+ * Parts of a page at the start and the end of the area are merged with the
+ * old contents and programmed before and after the complete pages.
+ */
+static NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_flash_in_place_parallel(const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr, unsigned long ulOffsetStart, unsigned long ulOffsetEnd, const unsigned char *pucDataToBeFlashed)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	unsigned long ulPagesStart;
+	unsigned long ulPagesEnd;
+	unsigned int uiLanes;
+
+
+	tResult = NETX_CONSOLEAPP_RESULT_OK;
+
+	/* Get the area with complete pages. */
+	ulPagesStart = ulOffsetStart + IFLASH_MAZ_V0_PAGE_SIZE_BYTES - 1U;
+	ulPagesStart -= ulPagesStart % IFLASH_MAZ_V0_PAGE_SIZE_BYTES;
+	ulPagesEnd = ulOffsetEnd - (ulOffsetEnd % IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
+	if( ulPagesStart>=ulPagesEnd )
+	{
+		/* There are no complete pages. */
+		tResult = internal_flash_maz_v0_flash_in_place(ptAttr, ulOffsetStart, ulOffsetEnd, pucDataToBeFlashed);
+	}
+	else
+	{
+		if( ulPagesStart!=ulOffsetStart )
+		{
+			tResult = internal_flash_maz_v0_flash_in_place(ptAttr, ulOffsetStart, ulPagesStart, pucDataToBeFlashed);
+		}
+		if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+		{
+			uiLanes = iflash_lanes_setup(ptAttr, ulPagesStart, ulPagesEnd, pucDataToBeFlashed + (ulPagesStart - ulOffsetStart));
+			tResult = iflash_lanes_run(&tIflashLaneFunctionsProgram, ptAttr, aptIflashLanes, uiLanes);
+		}
+		if( tResult==NETX_CONSOLEAPP_RESULT_OK && ulPagesEnd!=ulOffsetEnd )
+		{
+			tResult = internal_flash_maz_v0_flash_in_place(ptAttr, ulPagesEnd, ulOffsetEnd, pucDataToBeFlashed + (ulPagesEnd - ulOffsetStart));
+		}
+	}
+
+	return tResult;
+}
+
+
+
+/* Does the area cover more than one flash controller? */
+static int iflash_area_is_split(const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr, unsigned long ulOffsetStart, unsigned long ulOffsetEnd)
+{
+	return (ptAttr->tArea==INTERNAL_FLASH_AREA_Flash01_Main) && (ulOffsetStart<IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES) && (ulOffsetEnd>IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES);
+}
+
+
+
+/* Flash an area and erase only the blocks which need it.
+ *
+ * Each erase block is compared with the new data first. Blocks which
+ * already contain the data are skipped. Blocks where the new data only
+ * changes bits from 1 to 0 are programmed in place. All other blocks are
+ * merged with the new data in a working buffer at the end of the data
+ * buffer, erased and programmed again.
+ *
+ * \param ptAttr The attributes of the flash area.
+ * \param ulOffsetStart The offset of the first byte to flash.
+ * \param ulOffsetEnd The offset after the last byte to flash.
+ * \param pucDataToBeFlashed The data to flash.
+ */
+static NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_flash_auto_erase(const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr, unsigned long ulOffsetStart, unsigned long ulOffsetEnd, const unsigned char *pucDataToBeFlashed)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	const unsigned char *pucFlashDataArea;
+	unsigned char *pucInternalWorkingBuffer;
+	unsigned long ulOffset;
+	unsigned long ulBlockOffset;
+	unsigned long ulChunkSize;
+	unsigned long ulCnt;
+	unsigned char ucExisting;
+	unsigned char ucRequested;
+	int iDiffers;
+	int iNeedsErase;
+	FLASH_BLOCK_ATTRIBUTES_T tFlashBlock;
+
+
+	/* This command needs an internal working buffer. Place it at the end of the data buffer. */
+	pucInternalWorkingBuffer = flasher_version.pucBuffer_End - IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES;
+
+	/* Does the command buffer overlap with the internal working buffer? */
+	if( (pucDataToBeFlashed+(ulOffsetEnd-ulOffsetStart))>pucInternalWorkingBuffer )
+	{
+		uprintf("! The selected buffer overlaps with the internal working buffer.\n");
+		tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+	}
+	else
+	{
+		tResult = NETX_CONSOLEAPP_RESULT_OK;
+
+		ulOffset = ulOffsetStart;
+		while( ulOffset<ulOffsetEnd )
+		{
+			/* Get the part of the data in the current erase block. */
+			ulBlockOffset = ulOffset - (ulOffset % IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES);
+			ulChunkSize = ulBlockOffset + IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES - ulOffset;
+			if( ulChunkSize>(ulOffsetEnd-ulOffset) )
+			{
+				ulChunkSize = ulOffsetEnd - ulOffset;
+			}
+
+			/* Get the pointer to the controller and the offset in the memory map. */
+			tResult = iflash_get_controller(ptAttr, ulOffset, &tFlashBlock);
+			if( tResult!=NETX_CONSOLEAPP_RESULT_OK )
+			{
+				break;
+			}
+			pucFlashDataArea = (const unsigned char*)(HOSTADDR(intflash0) + tFlashBlock.ulUnitOffsetInBytes);
+
+			/* Select read mode and main array or info page */
+			internal_flash_select_read_mode_and_clear_caches(ptAttr, tFlashBlock.ptIFlashCfgArea);
+
+			/* Compare the new data with the flash contents. An erase
+			 * is needed as soon as one bit changes from 0 to 1.
+			 */
+			iDiffers = 0;
+			iNeedsErase = 0;
+			for(ulCnt=0; ulCnt<ulChunkSize; ++ulCnt)
+			{
+				ucExisting = pucFlashDataArea[ulOffset + ulCnt];
+				ucRequested = pucDataToBeFlashed[ulCnt];
+				if( ucExisting!=ucRequested )
+				{
+					iDiffers = 1;
+					if( (ucRequested & ~ucExisting)!=0 )
+					{
+						iNeedsErase = 1;
+						break;
 					}
+				}
+			}
+
+			if( iNeedsErase!=0 )
+			{
+				uprintf(". Erasing the block at offset 0x%08x.\n", ulBlockOffset);
+
+				/* Merge the old contents of the block with the new data. */
+				memcpy(pucInternalWorkingBuffer, pucFlashDataArea + ulBlockOffset, IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES);
+				memcpy(pucInternalWorkingBuffer + (ulOffset - ulBlockOffset), pucDataToBeFlashed, ulChunkSize);
+
+				tResult = internal_flash_maz_v0_erase_block(ptAttr, ulBlockOffset);
+				if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+				{
+					tResult = internal_flash_maz_v0_flash_block(ptAttr, ulBlockOffset, pucInternalWorkingBuffer);
+				}
+			}
+			else if( iDiffers!=0 )
+			{
+				tResult = internal_flash_maz_v0_flash_in_place(ptAttr, ulOffset, ulOffset + ulChunkSize, pucDataToBeFlashed);
+			}
+
+			if( tResult!=NETX_CONSOLEAPP_RESULT_OK )
+			{
+				uprintf("! Failed to flash the block at offset 0x%08x.\n", ulBlockOffset);
+				break;
+			}
+
+			ulOffset += ulChunkSize;
+			pucDataToBeFlashed += ulChunkSize;
+		}
+	}
+
+	return tResult;
+}
+
+
+
+NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_flash(CMD_PARAMETER_FLASH_T *ptParameter)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr;
+	unsigned long ulOffsetStart;
+	unsigned long ulOffsetEnd;
+	unsigned char *pucInternalWorkingBuffer;
+    unsigned char *pucBufferStart;
+	INTERNAL_FLASH_AREA_T tFlashArea;
+	FLASH_BLOCK_ATTRIBUTES_T tFlashBlock;
+	INTERNAL_FLASH_FLAGS_T tFlags;
+
 
+	/* Be pessimistic... */
+	tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+
+	ulOffsetStart = ptParameter->ulStartAdr;
+	ulOffsetEnd = ulOffsetStart + ptParameter->ulDataByteSize;
+
+	/* Silently ignore flash requests with a size of 0 bytes. */
+	if( ulOffsetStart==ulOffsetEnd )
+	{
+		tResult = NETX_CONSOLEAPP_RESULT_OK;
+	}
+	else
+	{
+		/* Get a pointer to the flash attributes. */
+		ptAttr = &(ptParameter->ptDeviceDescription->uInfo.tInternalFlashInfo.uAttributes.tMazV0);
+
+		tFlashArea = ptAttr->tArea;
+		tResult = check_info_write_protection(tFlashArea, 1);
+		if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+		{
+		    /* check if the data's checksum is correct */
+            if( tFlashArea==INTERNAL_FLASH_AREA_Flash1_InfoS || tFlashArea==INTERNAL_FLASH_AREA_Flash2_InfoS ||
+             tFlashArea==INTERNAL_FLASH_AREA_Flash2_Info || tFlashArea==INTERNAL_FLASH_AREA_Flash1_Info)
+            {
+                pucBufferStart = ptParameter->pucData;
+                if( infoS_check_hash(pucBufferStart)!=0 )
+                {
+                    uprintf("! The flash data has an invalid checksum.\n");
+                    tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+                }
+            }
+        }
+		if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+		{
+			if( tFlashArea==INTERNAL_FLASH_AREA_Flash1_InfoS || tFlashArea==INTERNAL_FLASH_AREA_Flash2_InfoS )
+			{
+				/* This command needs an internal working buffer. Place it at the end of the data buffer. */
+				pucInternalWorkingBuffer = flasher_version.pucBuffer_End - IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES;
+
+				/* The special "S" secure info pages can only be flashed as a complete page. */
+				if( ulOffsetStart!=0 )
+				{
+					tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+					uprintf("! The info S pages can only be flashed at offset 0.\n");
+				}
+				else if( ptParameter->ulDataByteSize!=IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES )
+				{
+					tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+					uprintf("! The info S pages can only be flashed with 4096 bytes.\n");
+				}
+				/* Does the command buffer overlap with the internal working buffer? */
+				else if( (ptParameter->pucData+IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES)>=pucInternalWorkingBuffer )
+				{
+					tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+					uprintf("! The selected buffer overlaps with the internal working buffer.\n");
+				}
+				else
+				{
+					tResult = iflash_get_controller(ptAttr, 0, &tFlashBlock);
 					if( tResult==NETX_CONSOLEAPP_RESULT_OK )
 					{
-						/* Write all complete pages. */
-						while( (ulOffset+IFLASH_MAZ_V0_PAGE_SIZE_BYTES)<=ulOffsetEnd )
+						/* Create a copy of the data in the internal working buffer. */
+						memcpy(pucInternalWorkingBuffer, ptParameter->pucData, IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES);
+
+						if( tFlashArea==INTERNAL_FLASH_AREA_Flash1_InfoS )
 						{
-							memcpy(tFlashBuffer.auc, pucDataToBeFlashed, IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
-							tResult = internal_flash_maz_v0_flash_page(ptAttr, ulOffset, &tFlashBuffer);
-							if( tResult!=NETX_CONSOLEAPP_RESULT_OK )
-							{
-								uprintf("! Failed to flash the page at offset 0x%08x.\n", ulOffset);
-								break;
-							}
-							else
-							{
-								ulOffset += IFLASH_MAZ_V0_PAGE_SIZE_BYTES;
-								pucDataToBeFlashed += IFLASH_MAZ_V0_PAGE_SIZE_BYTES;
-							}
+							/* Flash the secure COM info page. */
+							infoS_patch_IF1(pucInternalWorkingBuffer);
+						}
+						else
+						{
+							/* Flash the secure APP page. */
+							tResult = infoS_patch_IF2(pucInternalWorkingBuffer);
 						}
-					}
 
-					if( tResult==NETX_CONSOLEAPP_RESULT_OK )
-					{
-						/* Is a part of the last page left? */
-						ulChunkSize = ulOffsetEnd - ulOffset;
-						if( ulChunkSize!=0 )
+						if( tResult==NETX_CONSOLEAPP_RESULT_OK )
 						{
-							/* Get the pointer to the controller and the offset in the memory map. */
-							tResult = iflash_get_controller(ptAttr, ulOffset, &tFlashBlock);
+							/* Select read mode and main array or info page */
+							internal_flash_select_read_mode_and_clear_caches(ptAttr, tFlashBlock.ptIFlashCfgArea);
+
+							/* Flash the page to offset 0 and offset 4096. */
+							tResult = internal_flash_maz_v0_flash_block(ptAttr, 0, pucInternalWorkingBuffer);
 							if( tResult==NETX_CONSOLEAPP_RESULT_OK )
 							{
-								pucFlashDataArea = (const unsigned char*)(HOSTADDR(intflash0) + tFlashBlock.ulUnitOffsetInBytes);
-
-								/* Get the old contents of the page. */
-								memcpy(tFlashBuffer.auc, pucFlashDataArea + ulOffset, IFLASH_MAZ_V0_PAGE_SIZE_BYTES);
-
-								/* Add the new part to the buffer. */
-								memcpy(tFlashBuffer.auc, pucDataToBeFlashed, ulChunkSize);
-
-								/* Flash the chunk. */
-								tResult = internal_flash_maz_v0_flash_page(ptAttr, ulOffset, &tFlashBuffer);
-								if( tResult!=NETX_CONSOLEAPP_RESULT_OK )
-								{
-									uprintf("! Failed to flash the page at offset 0x%08x.\n", ulOffset);
-								}
-								else
+								/* Erase the 2nd block in the info page. */
+								tResult = internal_flash_maz_v0_erase_block(ptAttr, IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES);
+								if( tResult==NETX_CONSOLEAPP_RESULT_OK )
 								{
-									ulOffset += ulChunkSize;
-									pucDataToBeFlashed += ulChunkSize;
+									tResult = internal_flash_maz_v0_flash_block(ptAttr, IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES, pucInternalWorkingBuffer);
 								}
 							}
+
+							/* Clear the internal working buffer. */
+							memset(pucInternalWorkingBuffer, 0x00U, IFLASH_MAZ_V0_ERASE_BLOCK_SIZE_IN_BYTES);
 						}
 					}
 				}
 			}
+			else
+			{
+				tResult = check_command_area(ptAttr, ulOffsetStart, ulOffsetEnd);
+				if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+				{
+					tFlags.rawValue = ptParameter->ptDeviceDescription->ulDetectFlags;
+					if( tFlags.bits.bAutoErase!=0 )
+					{
+						tResult = internal_flash_maz_v0_flash_auto_erase(ptAttr, ulOffsetStart, ulOffsetEnd, ptParameter->pucData);
+					}
+					else if( iflash_area_is_split(ptAttr, ulOffsetStart, ulOffsetEnd)!=0 )
+					{
+						tResult = internal_flash_maz_v0_flash_in_place_parallel(ptAttr, ulOffsetStart, ulOffsetEnd, ptParameter->pucData);
+					}
+					else
+					{
+						tResult = internal_flash_maz_v0_flash_in_place(ptAttr, ulOffsetStart, ulOffsetEnd, ptParameter->pucData);
+					}
+				}
+			}
 		}
 	}
 	
@@ -1741,6 +2389,11 @@ NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_erase(CMD_PARAMETER_ERASE_T *ptPa
 					uprintf("! Erase block end:     0x%08x\n", ulOffsetEnd + ulEraseBlockSize - ulBlockOffset);
 					tResult = NETX_CONSOLEAPP_RESULT_ERROR;
 				}
+				else if( iflash_area_is_split(ptAttr, ulOffsetStart, ulOffsetEnd)!=0 )
+				{
+					/* Erase the blocks on all controllers at the same time. */
+					tResult = iflash_lanes_run(&tIflashLaneFunctionsErase, ptAttr, aptIflashLanes, iflash_lanes_setup(ptAttr, ulOffsetStart, ulOffsetEnd, NULL));
+				}
 				else
 				{
 					ulOffset = ulOffsetStart;
@@ -1770,14 +2423,10 @@ NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_read(CMD_PARAMETER_READ_T *ptPara
 	unsigned long ulOffsetStart;
 	unsigned long ulOffsetEnd;
 	unsigned long ulLength;
-	const unsigned char *pucFlashArea;
 	const unsigned char *pucFlashStart;
-	unsigned char *pucBufferStart;
-	unsigned long ulOffset;
 	unsigned long ulKekInfo;
 	unsigned long ulSipProtectionInfo;
 	INTERNAL_FLASH_AREA_T tFlashArea;
-	FLASH_BLOCK_ATTRIBUTES_T tFlashBlock;
 
 
 	ulOffsetStart = ptParameter->ulStartAdr;
@@ -1808,47 +2457,11 @@ NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_read(CMD_PARAMETER_READ_T *ptPara
 				tResult = check_command_area(ptAttr, ulOffsetStart, ulOffsetEnd);
 				if( tResult==NETX_CONSOLEAPP_RESULT_OK )
 				{
-					/* Get the pointer to the controller and the offset in the memory map. */
-					tResult = iflash_get_controller(ptAttr, ulOffsetStart, &tFlashBlock);
+					tResult = iflash_select_read_area(ptAttr, ulOffsetStart, ulOffsetEnd, &pucFlashStart);
 					if( tResult==NETX_CONSOLEAPP_RESULT_OK )
 					{
-						pucFlashArea = (const unsigned char*)(HOSTADDR(intflash0) + tFlashBlock.ulUnitOffsetInBytes);
-
-						/* Get the start and size of the data area. */
-						pucFlashStart = pucFlashArea + ulOffsetStart;
-
-						/* Set the flash to read mode. */
-						internal_flash_select_read_mode_and_clear_caches(ptAttr, tFlashBlock.ptIFlashCfgArea);
-
-						/* If Iflash01 (unit 3) is selected and the access starts in intflash0
-						 * but ends in intflash1, configure intflash1, too */
-						if ((ptAttr->tArea == INTERNAL_FLASH_AREA_Flash01_Main) &&
-							(ulOffsetStart < IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES) &&
-							(ulOffsetEnd > IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES)
-						)
-						{
-							tResult = iflash_get_controller(ptAttr, IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES, &tFlashBlock);
-							if( tResult==NETX_CONSOLEAPP_RESULT_OK )
-							{
-								internal_flash_select_read_mode_and_clear_caches(ptAttr, tFlashBlock.ptIFlashCfgArea);
-							}
-						}
-						
-						if( tResult==NETX_CONSOLEAPP_RESULT_OK )
-						{
-							/* Copy the data block to the destination buffer.*/
-							pucBufferStart = ptParameter->pucData;
-		
-							/* Copy the data block to the destination buffer.*/
-							ulOffset = 0;
-							do
-							{
-								pucBufferStart[ulOffset] = pucFlashStart[ulOffset];
-								++ulOffset;
-							} while( ulOffset<ulLength );
-		
-							tResult = NETX_CONSOLEAPP_RESULT_OK;
-						}
+						/* Copy the data block to the destination buffer.*/
+						iflash_copy(ptParameter->pucData, pucFlashStart, ulLength);
 					}
 				}
 			}
@@ -1868,13 +2481,11 @@ NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_sha1(CMD_PARAMETER_CHECKSUM_T *pt
 	unsigned long ulOffsetStart;
 	unsigned long ulOffsetEnd;
 	unsigned long ulLength;
-	const unsigned char *pucFlashArea;
 	const unsigned char *pucFlashStart;
 	unsigned char *pucInternalWorkingBuffer;
 	unsigned long ulKekInfo;
 	unsigned long ulSipProtectionInfo;
 	INTERNAL_FLASH_AREA_T tFlashArea;
-	FLASH_BLOCK_ATTRIBUTES_T tFlashBlock;
 
 
 	ulOffsetStart = ptParameter->ulStartAdr;
@@ -1924,35 +2535,10 @@ NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_sha1(CMD_PARAMETER_CHECKSUM_T *pt
 				tResult = check_command_area(ptAttr, ulOffsetStart, ulOffsetEnd);
 				if( tResult==NETX_CONSOLEAPP_RESULT_OK )
 				{
-					/* Get the pointer to the controller and the offset in the memory map. */
-					tResult = iflash_get_controller(ptAttr, ulOffsetStart, &tFlashBlock);
+					tResult = iflash_select_read_area(ptAttr, ulOffsetStart, ulOffsetEnd, &pucFlashStart);
 					if( tResult==NETX_CONSOLEAPP_RESULT_OK )
 					{
-						pucFlashArea = (const unsigned char*)(HOSTADDR(intflash0) + tFlashBlock.ulUnitOffsetInBytes);
-
-						/* Get the start and size of the data area. */
-						pucFlashStart = pucFlashArea + ulOffsetStart;
-
-						/* Set the flash to read mode. */
-						internal_flash_select_read_mode_and_clear_caches(ptAttr, tFlashBlock.ptIFlashCfgArea);
-
-						/* If Iflash01 (unit 3) is selected and the access starts in intflash0
-						 * but ends in intflash1, configure intflash1, too */
-						if ((ptAttr->tArea == INTERNAL_FLASH_AREA_Flash01_Main) &&
-							(ulOffsetStart < IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES) &&
-							(ulOffsetEnd > IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES)
-						)
-						{
-							tResult = iflash_get_controller(ptAttr, IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES, &tFlashBlock);
-							if( tResult==NETX_CONSOLEAPP_RESULT_OK )
-							{
-								internal_flash_select_read_mode_and_clear_caches(ptAttr, tFlashBlock.ptIFlashCfgArea);
-							}
-						}
-
 						SHA1_Update(ptSha1Context, pucFlashStart, ulLength);
-
-						tResult = NETX_CONSOLEAPP_RESULT_OK;
 					}
 				}
 			}
@@ -1982,7 +2568,6 @@ NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_verify(CMD_PARAMETER_VERIFY_T *pt
 	unsigned long ulKekInfo;
 	unsigned long ulSipProtectionInfo;
 	INTERNAL_FLASH_AREA_T tFlashArea;
-	FLASH_BLOCK_ATTRIBUTES_T tFlashBlock;
 
 
 	ulOffsetStart = ptParameter->ulStartAdr;
@@ -2043,31 +2628,7 @@ NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_verify(CMD_PARAMETER_VERIFY_T *pt
 				tResult = check_command_area(ptAttr, ulOffsetStart, ulOffsetEnd);
 				if( tResult==NETX_CONSOLEAPP_RESULT_OK )
 				{
-					/* Get the pointer to the controller and the offset in the memory map. */
-					tResult = iflash_get_controller(ptAttr, ulOffsetStart, &tFlashBlock);
-					if( tResult==NETX_CONSOLEAPP_RESULT_OK )
-					{
-						/* Get the start of the data area. */
-						pucFlashStart  = (const unsigned char*)(HOSTADDR(intflash0) + tFlashBlock.ulUnitOffsetInBytes);
-						pucFlashStart += ulOffsetStart;
-
-						/* Set the flash to read mode. */
-						internal_flash_select_read_mode_and_clear_caches(ptAttr, tFlashBlock.ptIFlashCfgArea);
-
-						/* If Iflash01 (unit 3) is selected and the access starts in intflash0
-						 * but ends in intflash1, configure intflash1, too */
-						if ((ptAttr->tArea == INTERNAL_FLASH_AREA_Flash01_Main) &&
-							(ulOffsetStart < IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES) &&
-							(ulOffsetEnd > IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES)
-						)
-						{
-							tResult = iflash_get_controller(ptAttr, IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES, &tFlashBlock);
-							if( tResult==NETX_CONSOLEAPP_RESULT_OK )
-							{
-								internal_flash_select_read_mode_and_clear_caches(ptAttr, tFlashBlock.ptIFlashCfgArea);
-							}
-						}
-					}
+					tResult = iflash_select_read_area(ptAttr, ulOffsetStart, ulOffsetEnd, &pucFlashStart);
 				}
 			}
 		}
@@ -2077,20 +2638,14 @@ NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_verify(CMD_PARAMETER_VERIFY_T *pt
 			/* Compare the data from the buffer with the flash contents. */
 			pucBufferStart = ptParameter->pucData;
 
-			ulOffset = 0;
-			do
+			ulOffset = iflash_compare(pucFlashStart, pucBufferStart, ulLength);
+			if( ulOffset<ulLength )
 			{
 				ucFlashData = pucFlashStart[ulOffset];
 				ucBufferData = pucBufferStart[ulOffset];
-				if( ucFlashData!=ucBufferData )
-				{
-					uprintf(". verify error at offset 0x%08x. buffer: 0x%02x, flash: 0x%02x.\n", ulOffsetStart + ulOffset, ucBufferData, ucFlashData);
-					tResult = NETX_CONSOLEAPP_RESULT_ERROR;
-					break;
-				}
-
-				++ulOffset;
-			} while( ulOffset<ulLength );
+				uprintf(". verify error at offset 0x%08x. buffer: 0x%02x, flash: 0x%02x.\n", ulOffsetStart + ulOffset, ucBufferData, ucFlashData);
+				tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+			}
 		}
 
 		ptConsoleParams->pvReturnMessage = (void*)tResult;
@@ -2108,13 +2663,11 @@ NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_is_erased(CMD_PARAMETER_ISERASED_
 	const INTERNAL_FLASH_ATTRIBUTES_MAZ_V0_T *ptAttr;
 	unsigned long ulOffsetStart;
 	unsigned long ulOffsetEnd;
-	const unsigned char *pucFlashArea;
 	const unsigned char *pucFlashStart;
 	unsigned long ulOffset;
 	unsigned long ulLength;
 	unsigned char ucFlashData;
 	INTERNAL_FLASH_AREA_T tFlashArea;
-	FLASH_BLOCK_ATTRIBUTES_T tFlashBlock;
 
 
 	ulOffsetStart = ptParameter->ulStartAdr;
@@ -2162,61 +2715,23 @@ NETX_CONSOLEAPP_RESULT_T internal_flash_maz_v0_is_erased(CMD_PARAMETER_ISERASED_
 		}
 		if( tResult==NETX_CONSOLEAPP_RESULT_OK )
 		{
-			/* Get the pointer to the controller and the offset in the memory map. */
-			tResult = iflash_get_controller(ptAttr, ulOffsetStart, &tFlashBlock);
+			tResult = iflash_select_read_area(ptAttr, ulOffsetStart, ulOffsetEnd, &pucFlashStart);
 			if( tResult==NETX_CONSOLEAPP_RESULT_OK )
 			{
-				pucFlashArea = (const unsigned char*)(HOSTADDR(intflash0) + tFlashBlock.ulUnitOffsetInBytes);
-
-				/* Get the start and size of the data area. */
-				pucFlashStart = pucFlashArea + ulOffsetStart;
-
-				/* Set the flash to read mode. */
-				internal_flash_select_read_mode_and_clear_caches(ptAttr, tFlashBlock.ptIFlashCfgArea);
-
-				/* If Iflash01 (unit 3) is selected and the access starts in intflash0
-				 * but ends in intflash1, configure intflash1, too */
-				if ((ptAttr->tArea == INTERNAL_FLASH_AREA_Flash01_Main) &&
-					(ulOffsetStart < IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES) &&
-					(ulOffsetEnd > IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES)
-				)
+				ucFlashData = 0xffU;
+				ulOffset = iflash_find_not_erased(pucFlashStart, ulLength);
+				if( ulOffset<ulLength )
 				{
-					tResult = iflash_get_controller(ptAttr, IFLASH_NETX90_MAIN_ARRAY_SIZE_BYTES, &tFlashBlock);
-					if( tResult==NETX_CONSOLEAPP_RESULT_OK )
-					{
-						internal_flash_select_read_mode_and_clear_caches(ptAttr, tFlashBlock.ptIFlashCfgArea);
-					}
+					ucFlashData = pucFlashStart[ulOffset];
+					uprintf("! Memory not erased at offset 0x%08x - expected: 0x%02x found: 0x%02x\n", ulOffsetStart + ulOffset, 0xff, ucFlashData);
+					uprintf(". DIRTY! The area is not erased.\n");
 				}
-					
-				if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+				else
 				{
-					/* Be optimistic... */
-					tResult = NETX_CONSOLEAPP_RESULT_OK;
-	
-					ulOffset = 0;
-					do
-					{
-						ucFlashData = pucFlashStart[ulOffset];
-						if( ucFlashData!=0xffU )
-						{
-							uprintf("! Memory not erased at offset 0x%08x - expected: 0x%02x found: 0x%02x\n", ulOffsetStart + ulOffset, 0xff, ucFlashData);
-							break;
-						}
-	
-						++ulOffset;
-					} while( ulOffset<ulLength );
-	
-					if( ucFlashData==0xff )
-					{
-						uprintf(". CLEAN! The area is erased.\n");
-					}
-					else
-					{
-						uprintf(". DIRTY! The area is not erased.\n");
-					}
-					
-					ptConsoleParams->pvReturnMessage = (void*)((unsigned long)ucFlashData);
+					uprintf(". CLEAN! The area is erased.\n");
 				}
+
+				ptConsoleParams->pvReturnMessage = (void*)((unsigned long)ucFlashData);
 			}
 		}
 	}
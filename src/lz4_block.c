@@ -0,0 +1,196 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+#include "lz4_block.h"
+
+
+/*! lz4_read_length
+*   Read the extension bytes of a literal or match length. Each byte is added
+*   to the length, a byte of 255 means that another byte follows.
+*
+*   \param   ppucIn             pointer to the read position
+*   \param   pucInEnd           end of the input data
+*   \param   pulLength          the length to extend
+*
+*   \return  LZ4_RESULT_OK on success, LZ4_RESULT_TRUNCATED_INPUT if the input ends too early
+*/
+static LZ4_RESULT_T lz4_read_length(const unsigned char **ppucIn, const unsigned char *pucInEnd, unsigned long *pulLength)
+{
+	const unsigned char *pucIn;
+	unsigned long ulLength;
+	unsigned char ucByte;
+	LZ4_RESULT_T tResult;
+
+
+	pucIn = *ppucIn;
+	ulLength = *pulLength;
+	tResult = LZ4_RESULT_OK;
+	do
+	{
+		if( pucIn>=pucInEnd )
+		{
+			tResult = LZ4_RESULT_TRUNCATED_INPUT;
+			break;
+		}
+		ucByte = *(pucIn++);
+		ulLength += ucByte;
+	} while( ucByte==0xffU );
+
+	*ppucIn = pucIn;
+	*pulLength = ulLength;
+
+	return tResult;
+}
+
+
+/*! lz4_decode_block
+*   Decode one LZ4 block. This is the plain block format without the frame
+*   header and checksums.
+*
+*   The input may be placed at the end of the output buffer. In this case
+*   every write is checked against the read position, so a block which is
+*   not suitable for in-place decoding is rejected before it can destroy
+*   its own input.
+*
+*   \param   pucSrc             the compressed data
+*   \param   ulSrcSize          size of the compressed data in bytes
+*   \param   pucDst             the output buffer
+*   \param   ulDstSize          size of the output buffer in bytes
+*   \param   pulDecodedSize     receives the number of decoded bytes
+*
+*   \return  LZ4_RESULT_OK on success, an error code otherwise
+*/
+LZ4_RESULT_T lz4_decode_block(const unsigned char *pucSrc, unsigned long ulSrcSize, unsigned char *pucDst, unsigned long ulDstSize, unsigned long *pulDecodedSize)
+{
+	const unsigned char *pucIn;
+	const unsigned char *pucInEnd;
+	unsigned char *pucOut;
+	unsigned char *pucOutEnd;
+	const unsigned char *pucMatch;
+	unsigned int uiToken;
+	unsigned long ulLength;
+	unsigned long ulOffset;
+	int fInPlace;
+	LZ4_RESULT_T tResult;
+
+
+	pucIn = pucSrc;
+	pucInEnd = pucSrc + ulSrcSize;
+	pucOut = pucDst;
+	pucOutEnd = pucDst + ulDstSize;
+	tResult = LZ4_RESULT_OK;
+
+	/* Do the input and output areas overlap? */
+	fInPlace = (pucSrc<pucOutEnd && pucDst<pucInEnd);
+
+	while( pucIn<pucInEnd )
+	{
+		uiToken = *(pucIn++);
+
+		/* Get the number of literals. */
+		ulLength = uiToken >> 4U;
+		if( ulLength==15U )
+		{
+			tResult = lz4_read_length(&pucIn, pucInEnd, &ulLength);
+			if( tResult!=LZ4_RESULT_OK )
+			{
+				break;
+			}
+		}
+		if( ulLength>(unsigned long)(pucInEnd-pucIn) )
+		{
+			tResult = LZ4_RESULT_TRUNCATED_INPUT;
+			break;
+		}
+		if( ulLength>(unsigned long)(pucOutEnd-pucOut) )
+		{
+			tResult = LZ4_RESULT_OUTPUT_TOO_SMALL;
+			break;
+		}
+		/* A forward copy is safe as long as the output does not pass the input. */
+		if( fInPlace!=0 && pucOut>pucIn )
+		{
+			tResult = LZ4_RESULT_OVERLAP;
+			break;
+		}
+		while( ulLength!=0 )
+		{
+			*(pucOut++) = *(pucIn++);
+			--ulLength;
+		}
+
+		/* The last sequence has only literals. */
+		if( pucIn==pucInEnd )
+		{
+			break;
+		}
+
+		/* Get the match offset. */
+		if( (pucInEnd-pucIn)<2 )
+		{
+			tResult = LZ4_RESULT_TRUNCATED_INPUT;
+			break;
+		}
+		ulOffset  =  (unsigned long)pucIn[0];
+		ulOffset |= ((unsigned long)pucIn[1]) << 8U;
+		pucIn += 2;
+		if( ulOffset==0 || ulOffset>(unsigned long)(pucOut-pucDst) )
+		{
+			tResult = LZ4_RESULT_INVALID_OFFSET;
+			break;
+		}
+
+		/* Get the match length. */
+		ulLength = uiToken & 0x0fU;
+		if( ulLength==15U )
+		{
+			tResult = lz4_read_length(&pucIn, pucInEnd, &ulLength);
+			if( tResult!=LZ4_RESULT_OK )
+			{
+				break;
+			}
+		}
+		ulLength += 4U;
+		if( ulLength>(unsigned long)(pucOutEnd-pucOut) )
+		{
+			tResult = LZ4_RESULT_OUTPUT_TOO_SMALL;
+			break;
+		}
+		if( fInPlace!=0 && (pucOut+ulLength)>pucIn )
+		{
+			tResult = LZ4_RESULT_OVERLAP;
+			break;
+		}
+
+		/* Copy the match byte by byte, it may overlap with itself. */
+		pucMatch = pucOut - ulOffset;
+		while( ulLength!=0 )
+		{
+			*(pucOut++) = *(pucMatch++);
+			--ulLength;
+		}
+	}
+
+	*pulDecodedSize = (unsigned long)(pucOut - pucDst);
+
+	return tResult;
+}
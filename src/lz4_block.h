@@ -0,0 +1,40 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Hilscher GmbH                                   *
+ *   cthelen@hilscher.com                                                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU Library General Public License as       *
+ *   published by the Free Software Foundation; either version 2 of the    *
+ *   License, or (at your option) any later version.                       *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this program; if not, write to the                 *
+ *   Free Software Foundation, Inc.,                                       *
+ *   59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.             *
+ ***************************************************************************/
+
+
+
+#ifndef __LZ4_BLOCK_H__
+#define __LZ4_BLOCK_H__
+
+
+typedef enum LZ4_RESULT_ENUM
+{
+	LZ4_RESULT_OK                = 0,
+	LZ4_RESULT_TRUNCATED_INPUT   = 1,    /* The input ends in the middle of a sequence. */
+	LZ4_RESULT_OUTPUT_TOO_SMALL  = 2,    /* The decoded data does not fit into the output buffer. */
+	LZ4_RESULT_INVALID_OFFSET    = 3,    /* A match points before the start of the output buffer. */
+	LZ4_RESULT_OVERLAP           = 4     /* In-place decoding would overwrite input which was not read yet. */
+} LZ4_RESULT_T;
+
+
+LZ4_RESULT_T lz4_decode_block(const unsigned char *pucSrc, unsigned long ulSrcSize, unsigned char *pucDst, unsigned long ulDstSize, unsigned long *pulDecodedSize);
+
+
+#endif  /* __LZ4_BLOCK_H__ */
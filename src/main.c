@@ -38,6 +38,7 @@
 
 #include "flasher_interface.h"
 #include "flasher_header.h"
+#include "lz4_block.h"
 #include "units.h"
 #include "uprintf.h"
 #include "systime.h"
@@ -48,6 +49,10 @@
 #include "flasher_sdio.h"
 #endif
 
+#ifdef CFG_INCLUDE_I2C
+#include "flasher_i2c.h"
+#endif
+
 /* ------------------------------------- */
 
 
@@ -84,7 +89,14 @@ static NETX_CONSOLEAPP_RESULT_T opMode_detect(tFlasherInputParameter *ptAppParam
 		FLASHER_SPI_FLAGS_T flags = {
 			.rawValue = ptParameter->ulFlags
 		};
-		tResult = spi_detect(&(ptParameter->uSourceParameter.tSpi), &(ptDeviceDescription->uInfo.tSpiInfo), (char*)(flasher_version.pucBuffer_End), flags);
+		if( flags.bits.bStriped!=0 )
+		{
+			tResult = spi_detect_striped(&(ptParameter->uSourceParameter.tSpi), &(ptDeviceDescription->uInfo.tSpiStripedInfo), flags);
+		}
+		else
+		{
+			tResult = spi_detect(&(ptParameter->uSourceParameter.tSpi), &(ptDeviceDescription->uInfo.tSpiInfo), flags);
+		}
 		if( tResult==NETX_CONSOLEAPP_RESULT_OK )
 		{
 			ptDeviceDescription->fIsValid = 1;
@@ -130,6 +142,14 @@ static NETX_CONSOLEAPP_RESULT_T opMode_detect(tFlasherInputParameter *ptAppParam
 		break;
 #endif 
 
+#ifdef CFG_INCLUDE_I2C
+	case BUS_I2C:
+		/* Use I2C EEPROM */
+		uprintf("I2C EEPROM\n");
+		tResult = i2c_detect(ptParameter);
+		break;
+#endif
+
 	default:
 		/* unknown device type */
 		uprintf("unknown\n");
@@ -138,6 +158,13 @@ static NETX_CONSOLEAPP_RESULT_T opMode_detect(tFlasherInputParameter *ptAppParam
 		break;
 	}
 
+	/* Remember the parameters which produced the description. */
+	if( tResult==NETX_CONSOLEAPP_RESULT_OK && ptDeviceDescription->fIsValid!=0 )
+	{
+		memcpy(&(ptDeviceDescription->uDetectParameter), &(ptParameter->uSourceParameter), sizeof(DETECT_SOURCE_PARAMETER_T));
+		ptDeviceDescription->ulDetectFlags = ptParameter->ulFlags;
+	}
+
 	return tResult;
 }
 
@@ -201,6 +228,14 @@ static NETX_CONSOLEAPP_RESULT_T check_device_description(const DEVICE_DESCRIPTIO
 			tResult = NETX_CONSOLEAPP_RESULT_OK;
 			break;
 #endif
+
+#ifdef CFG_INCLUDE_I2C
+		case BUS_I2C:
+			/* I2C EEPROM */
+			uprintf(". Device type: I2C EEPROM\n");
+			tResult = NETX_CONSOLEAPP_RESULT_OK;
+			break;
+#endif
 	
 		default:
 			/* unknown device type */
@@ -215,19 +250,15 @@ static NETX_CONSOLEAPP_RESULT_T check_device_description(const DEVICE_DESCRIPTIO
 /* ------------------------------------- */
 
 
-static NETX_CONSOLEAPP_RESULT_T opMode_flash(tFlasherInputParameter *ptAppParams)
+static NETX_CONSOLEAPP_RESULT_T opMode_flash(CMD_PARAMETER_FLASH_T *ptParameter)
 {
 	NETX_CONSOLEAPP_RESULT_T tResult;
 	BUS_T tSourceTyp;
-	CMD_PARAMETER_FLASH_T *ptParameter;
 
 
 	/* Be pessimistic. */
 	tResult = NETX_CONSOLEAPP_RESULT_ERROR;
 
-	/* Get a shortcut to the parameters. */
-	ptParameter = &(ptAppParams->uParameter.tFlash);
-
 	/* Get the source type. */
 	tSourceTyp = ptParameter->ptDeviceDescription->tSourceTyp;
 	switch(tSourceTyp)
@@ -258,6 +289,13 @@ static NETX_CONSOLEAPP_RESULT_T opMode_flash(tFlasherInputParameter *ptAppParams
 		break;
 #endif
 
+#ifdef CFG_INCLUDE_I2C
+	case BUS_I2C:
+		/* Use I2C EEPROM */
+		tResult = i2c_flash(ptParameter);
+		break;
+#endif
+
 	default:
 		uprintf("! Unknown device type: 0x%08x\n", tSourceTyp);
 		break;
@@ -270,6 +308,41 @@ static NETX_CONSOLEAPP_RESULT_T opMode_flash(tFlasherInputParameter *ptAppParams
 /* ------------------------------------- */
 
 
+static NETX_CONSOLEAPP_RESULT_T opMode_flashCompressed(tFlasherInputParameter *ptAppParams)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	CMD_PARAMETER_FLASH_COMPRESSED_T *ptParameter;
+	LZ4_RESULT_T tLz4Result;
+	unsigned long ulDecodedSize;
+
+
+	/* Get a shortcut to the parameters. */
+	ptParameter = &(ptAppParams->uParameter.tFlashCompressed);
+
+	/* Decompress the data into the flash buffer. */
+	tLz4Result = lz4_decode_block(ptParameter->pucCompressedData, ptParameter->ulCompressedByteSize, ptParameter->tFlash.pucData, ptParameter->tFlash.ulDataByteSize, &ulDecodedSize);
+	if( tLz4Result!=LZ4_RESULT_OK )
+	{
+		uprintf("! Failed to decompress the data: %d\n", tLz4Result);
+		tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+	}
+	else if( ulDecodedSize!=ptParameter->tFlash.ulDataByteSize )
+	{
+		uprintf("! The decompressed data has 0x%08x bytes, expected 0x%08x.\n", ulDecodedSize, ptParameter->tFlash.ulDataByteSize);
+		tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+	}
+	else
+	{
+		tResult = opMode_flash(&(ptParameter->tFlash));
+	}
+
+	return tResult;
+}
+
+
+/* ------------------------------------- */
+
+
 static NETX_CONSOLEAPP_RESULT_T opMode_erase(tFlasherInputParameter *ptAppParams)
 {
 	NETX_CONSOLEAPP_RESULT_T tResult;
@@ -313,6 +386,13 @@ static NETX_CONSOLEAPP_RESULT_T opMode_erase(tFlasherInputParameter *ptAppParams
 		break;
 #endif
 
+#ifdef CFG_INCLUDE_I2C
+	case BUS_I2C:
+		/* Use I2C EEPROM */
+		tResult = i2c_erase(ptParameter);
+		break;
+#endif
+
 	default:
 		/*  unknown device */
 		uprintf("! Unknown device type: 0x%08x\n", tSourceTyp);
@@ -375,6 +455,10 @@ static NETX_CONSOLEAPP_RESULT_T opMode_smartErase(tFlasherInputParameter *ptAppP
 		uprintf("! Falling back to normal erase routine\n");
 		tResult = opMode_erase(ptAppParams);
 		break;
+	case BUS_I2C:
+		/*  I2C EEPROMs have no erase blocks.  */
+		tResult = opMode_erase(ptAppParams);
+		break;
 	default: /* Unknown/wrong flash types */
 		tResult = NETX_CONSOLEAPP_RESULT_ERROR;
 		break;
@@ -428,6 +512,13 @@ static NETX_CONSOLEAPP_RESULT_T opMode_read(tFlasherInputParameter *ptAppParams)
 		break;
 #endif
 
+#ifdef CFG_INCLUDE_I2C
+	case BUS_I2C:
+		/* Use I2C EEPROM */
+		tResult = i2c_read(ptParameter);
+		break;
+#endif
+
 	default:
 		/*  unknown device */
 		uprintf("! Unknown device type: 0x%08x\n", tSourceTyp);
@@ -484,6 +575,13 @@ static NETX_CONSOLEAPP_RESULT_T opMode_verify(tFlasherInputParameter *ptAppParam
 		break;
 #endif
 
+#ifdef CFG_INCLUDE_I2C
+	case BUS_I2C:
+		/* Use I2C EEPROM */
+		tResult = i2c_verify(ptParameter, ptConsoleParams);
+		break;
+#endif
+
 	default:
 		/*  unknown device */
 		uprintf("! Unknown device type: 0x%08x\n", tSourceTyp);
@@ -494,22 +592,16 @@ static NETX_CONSOLEAPP_RESULT_T opMode_verify(tFlasherInputParameter *ptAppParam
 }
 
 #if CFG_INCLUDE_SHA1!=0
-static NETX_CONSOLEAPP_RESULT_T opMode_checksum(tFlasherInputParameter *ptAppParams)
+/* Add the contents of an area to a running SHA1 context. */
+static NETX_CONSOLEAPP_RESULT_T checksum_area(CMD_PARAMETER_CHECKSUM_T *ptParameter, SHA_CTX *ptShaContext)
 {
 	NETX_CONSOLEAPP_RESULT_T tResult;
 	BUS_T tSourceTyp;
-	CMD_PARAMETER_CHECKSUM_T *ptParameter;
-	SHA_CTX tShaContext;
-	
+
 
 	/* Be pessimistic. */
 	tResult = NETX_CONSOLEAPP_RESULT_ERROR;
 
-	/* Get a shortcut to the parameters. */
-	ptParameter = &(ptAppParams->uParameter.tChecksum);
-
-	SHA1_Init(&tShaContext);
-	
 	/* Get the source type. */
 	tSourceTyp = ptParameter->ptDeviceDescription->tSourceTyp;
 	switch(tSourceTyp)
@@ -517,26 +609,33 @@ static NETX_CONSOLEAPP_RESULT_T opMode_checksum(tFlasherInputParameter *ptAppPar
 #ifdef CFG_INCLUDE_PARFLASH
 	case BUS_ParFlash:
 		/* Use parallel flash. */
-		tResult = parflash_sha1(ptParameter, &tShaContext);
+		tResult = parflash_sha1(ptParameter, ptShaContext);
 		break;
 #endif
 		
 	case BUS_SPI:
 		/* Use SPI flash. */
-		tResult = spi_sha1(&(ptParameter->ptDeviceDescription->uInfo.tSpiInfo), ptParameter->ulStartAdr, ptParameter->ulEndAdr, &tShaContext);
+		tResult = spi_sha1(&(ptParameter->ptDeviceDescription->uInfo.tSpiInfo), ptParameter->ulStartAdr, ptParameter->ulEndAdr, ptShaContext);
 		break;
 
 #ifdef CFG_INCLUDE_INTFLASH
 	case BUS_IFlash:
 		/* Use the internal flash. */
-		tResult = internal_flash_sha1(ptParameter, &tShaContext);
+		tResult = internal_flash_sha1(ptParameter, ptShaContext);
 		break;
 #endif
 
 #ifdef CFG_INCLUDE_SDIO
 	case BUS_SDIO:
 		/* Use SDIO */
-		tResult = sdio_sha1(ptParameter, &tShaContext);
+		tResult = sdio_sha1(ptParameter, ptShaContext);
+		break;
+#endif
+
+#ifdef CFG_INCLUDE_I2C
+	case BUS_I2C:
+		/* Use I2C EEPROM */
+		tResult = i2c_sha1(ptParameter, ptShaContext);
 		break;
 #endif
 	default:
@@ -545,6 +644,23 @@ static NETX_CONSOLEAPP_RESULT_T opMode_checksum(tFlasherInputParameter *ptAppPar
 		break;
 	}
 
+	return tResult;
+}
+
+
+static NETX_CONSOLEAPP_RESULT_T opMode_checksum(tFlasherInputParameter *ptAppParams)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	CMD_PARAMETER_CHECKSUM_T *ptParameter;
+	SHA_CTX tShaContext;
+	
+
+	/* Get a shortcut to the parameters. */
+	ptParameter = &(ptAppParams->uParameter.tChecksum);
+
+	SHA1_Init(&tShaContext);
+	tResult = checksum_area(ptParameter, &tShaContext);
+
 	/* store hash value in parameter */
 	if (tResult == NETX_CONSOLEAPP_RESULT_OK)
 	{
@@ -553,6 +669,63 @@ static NETX_CONSOLEAPP_RESULT_T opMode_checksum(tFlasherInputParameter *ptAppPar
 	
 	return tResult;
 }
+
+
+/* Build one SHA1 for each region of an area.
+ * This lets the host narrow down a difference without reading the flash.
+ */
+static NETX_CONSOLEAPP_RESULT_T opMode_checksumRanges(tFlasherInputParameter *ptAppParams)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	CMD_PARAMETER_CHECKSUM_RANGES_T *ptParameter;
+	CMD_PARAMETER_CHECKSUM_T tRegion;
+	SHA_CTX tShaContext;
+	unsigned long ulRegionSize;
+	unsigned long ulEndAdr;
+	unsigned char *pucDigest;
+
+
+	/* Get a shortcut to the parameters. */
+	ptParameter = &(ptAppParams->uParameter.tChecksumRanges);
+
+	ulRegionSize = ptParameter->ulRegionSize;
+	if( ulRegionSize==0 )
+	{
+		uprintf("! The region size must not be 0.\n");
+		tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+	}
+	else
+	{
+		tResult = NETX_CONSOLEAPP_RESULT_OK;
+
+		tRegion.ptDeviceDescription = ptParameter->ptDeviceDescription;
+		tRegion.ulStartAdr = ptParameter->ulStartAdr;
+		ulEndAdr = ptParameter->ulEndAdr;
+		pucDigest = ptParameter->pucDigests;
+		while( tRegion.ulStartAdr<ulEndAdr )
+		{
+			tRegion.ulEndAdr = tRegion.ulStartAdr + ulRegionSize;
+			if( tRegion.ulEndAdr>ulEndAdr || tRegion.ulEndAdr<tRegion.ulStartAdr )
+			{
+				tRegion.ulEndAdr = ulEndAdr;
+			}
+
+			SHA1_Init(&tShaContext);
+			tResult = checksum_area(&tRegion, &tShaContext);
+			if( tResult!=NETX_CONSOLEAPP_RESULT_OK )
+			{
+				uprintf("! Failed to build the checksum of [0x%08x, 0x%08x[.\n", tRegion.ulStartAdr, tRegion.ulEndAdr);
+				break;
+			}
+			SHA1_Final(pucDigest, &tShaContext);
+
+			pucDigest += 20;
+			tRegion.ulStartAdr = tRegion.ulEndAdr;
+		}
+	}
+
+	return tResult;
+}
 #endif
 
 
@@ -600,6 +773,13 @@ static NETX_CONSOLEAPP_RESULT_T opMode_isErased(tFlasherInputParameter *ptAppPar
 		break;
 #endif
 
+#ifdef CFG_INCLUDE_I2C
+	case BUS_I2C:
+		/* Use I2C EEPROM */
+		tResult = i2c_isErased(ptParameter, ptConsoleParams);
+		break;
+#endif
+
 	default:
 		/*  unknown device */
 		uprintf("! Unknown device type: 0x%08x\n", tSourceTyp);
@@ -659,6 +839,12 @@ static unsigned long long getActualFlashSize(const DEVICE_DESCRIPTION_T *ptDevic
 		break;
 #endif
 
+#ifdef CFG_INCLUDE_I2C
+	case BUS_I2C:
+		ullFlashSize = ptDeviceDescription->uInfo.tI2cEeprom.tCfg.ulSizeInBytes;
+		break;
+#endif
+
 	default:
 		/*  unknown device */
 		uprintf("! Unknown device type: 0x%08x\n", tSrcType);
@@ -687,6 +873,185 @@ static unsigned long getFlashSize(const DEVICE_DESCRIPTION_T *ptDeviceDescriptio
 	return (unsigned long)ulFlashSize;
 }
 
+/* Run a list of verify and isErased jobs in one call.
+ * The jobs may use different device descriptions. The host detects each
+ * device into its own description before. All jobs are executed, even if
+ * one of them fails. The result of each job is stored in the job.
+ * The jobs run one after the other. Both operations only read, so there is
+ * no busy time of a device which another job could use.
+ */
+static NETX_CONSOLEAPP_RESULT_T opMode_verifyBatch(tFlasherInputParameter *ptAppParams, NETX_CONSOLEAPP_PARAMETER_T *ptConsoleParams)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	NETX_CONSOLEAPP_RESULT_T tJobResult;
+	CMD_PARAMETER_VERIFY_BATCH_T *ptParameter;
+	VERIFY_BATCH_JOB_T *ptJob;
+	VERIFY_BATCH_JOB_T *ptJobEnd;
+	tFlasherInputParameter tJobParams;
+	unsigned long ulFlashSize;
+
+
+	/* Get a shortcut to the parameters. */
+	ptParameter = &(ptAppParams->uParameter.tVerifyBatch);
+
+	tResult = NETX_CONSOLEAPP_RESULT_OK;
+
+	ptJob = ptParameter->ptJobs;
+	ptJobEnd = ptJob + ptParameter->ulJobCount;
+	while( ptJob<ptJobEnd )
+	{
+		ptConsoleParams->pvReturnMessage = (void*)0xffffffffU;
+
+		tJobResult = check_device_description(ptJob->ptDeviceDescription);
+		if( tJobResult==NETX_CONSOLEAPP_RESULT_OK )
+		{
+			ulFlashSize = getFlashSize(ptJob->ptDeviceDescription);
+			if( ptJob->ulStartAdr>ptJob->ulEndAdr || ptJob->ulEndAdr>ulFlashSize )
+			{
+				uprintf("! Job area [0x%08x, 0x%08x[ exceeds the flash size.\n", ptJob->ulStartAdr, ptJob->ulEndAdr);
+				tJobResult = NETX_CONSOLEAPP_RESULT_ERROR;
+			}
+		}
+
+		if( tJobResult==NETX_CONSOLEAPP_RESULT_OK )
+		{
+			switch( ptJob->tOperation )
+			{
+			case VERIFY_BATCH_OPERATION_Verify:
+				uprintf(". Verify [0x%08x, 0x%08x[\n", ptJob->ulStartAdr, ptJob->ulEndAdr);
+				tJobParams.uParameter.tVerify.ptDeviceDescription = ptJob->ptDeviceDescription;
+				tJobParams.uParameter.tVerify.ulStartAdr = ptJob->ulStartAdr;
+				tJobParams.uParameter.tVerify.ulEndAdr = ptJob->ulEndAdr;
+				tJobParams.uParameter.tVerify.ulKekInfo = 0;
+				tJobParams.uParameter.tVerify.ulSipProtectionInfo = 0;
+				tJobParams.uParameter.tVerify.pucData = ptJob->pucData;
+				tJobResult = opMode_verify(&tJobParams, ptConsoleParams);
+				break;
+
+			case VERIFY_BATCH_OPERATION_IsErased:
+				uprintf(". IsErased [0x%08x, 0x%08x[\n", ptJob->ulStartAdr, ptJob->ulEndAdr);
+				tJobParams.uParameter.tIsErased.ptDeviceDescription = ptJob->ptDeviceDescription;
+				tJobParams.uParameter.tIsErased.ulStartAdr = ptJob->ulStartAdr;
+				tJobParams.uParameter.tIsErased.ulEndAdr = ptJob->ulEndAdr;
+				tJobResult = opMode_isErased(&tJobParams, ptConsoleParams);
+				break;
+
+			default:
+				uprintf("! Unknown batch operation: 0x%08x\n", ptJob->tOperation);
+				tJobResult = NETX_CONSOLEAPP_RESULT_ERROR;
+				break;
+			}
+		}
+
+		ptJob->ulResult = (unsigned long)tJobResult;
+		ptJob->ulReturnMessage = (unsigned long)ptConsoleParams->pvReturnMessage;
+		if( tJobResult!=NETX_CONSOLEAPP_RESULT_OK )
+		{
+			tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+		}
+
+		++ptJob;
+	}
+
+	/* The results are in the jobs. */
+	ptConsoleParams->pvReturnMessage = (void*)0;
+
+	return tResult;
+}
+
+
+/* The SPI jobs of the current flash batch. */
+static SPI_BATCH_JOB_T atSpiBatchJobs[FLASH_BATCH_MAX_JOBS];
+
+/* Erase and flash several SPI flashes in one call.
+ * The jobs may use different device descriptions. The flashes work at the
+ * same time, see spi_batch. The result of each job is stored in the job.
+ */
+static NETX_CONSOLEAPP_RESULT_T opMode_flashBatch(tFlasherInputParameter *ptAppParams, NETX_CONSOLEAPP_PARAMETER_T *ptConsoleParams)
+{
+	NETX_CONSOLEAPP_RESULT_T tResult;
+	CMD_PARAMETER_FLASH_BATCH_T *ptParameter;
+	FLASH_BATCH_JOB_T *ptJob;
+	SPI_BATCH_JOB_T *ptSpiJob;
+	unsigned long ulJobCount;
+	unsigned long ulCnt;
+	unsigned long ulFlashSize;
+
+
+	/* Get a shortcut to the parameters. */
+	ptParameter = &(ptAppParams->uParameter.tFlashBatch);
+	ulJobCount = ptParameter->ulJobCount;
+
+	tResult = NETX_CONSOLEAPP_RESULT_OK;
+	if( ulJobCount>FLASH_BATCH_MAX_JOBS )
+	{
+		uprintf("! A flash batch can have at most %d jobs.\n", FLASH_BATCH_MAX_JOBS);
+		tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+		ulJobCount = 0;
+	}
+
+	for(ulCnt=0; ulCnt<ulJobCount; ++ulCnt)
+	{
+		ptJob = ptParameter->ptJobs + ulCnt;
+		ptJob->ulResult = (unsigned long)NETX_CONSOLEAPP_RESULT_ERROR;
+
+		if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+		{
+			tResult = check_device_description(ptJob->ptDeviceDescription);
+		}
+		if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+		{
+			ulFlashSize = getFlashSize(ptJob->ptDeviceDescription);
+			if( ptJob->ptDeviceDescription->tSourceTyp!=BUS_SPI )
+			{
+				uprintf("! Only SPI flashes can be used in a flash batch.\n");
+				tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+			}
+			else if( ptJob->ulStartAdr>ptJob->ulEndAdr || ptJob->ulEndAdr>ulFlashSize )
+			{
+				uprintf("! Job area [0x%08x, 0x%08x[ exceeds the flash size.\n", ptJob->ulStartAdr, ptJob->ulEndAdr);
+				tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+			}
+			else if( ptJob->tOperation!=FLASH_BATCH_OPERATION_Erase && ptJob->tOperation!=FLASH_BATCH_OPERATION_Flash )
+			{
+				uprintf("! Unknown batch operation: 0x%08x\n", ptJob->tOperation);
+				tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+			}
+			else
+			{
+				uprintf(". %s [0x%08x, 0x%08x[ on unit %d, chip select %d\n",
+				        (ptJob->tOperation==FLASH_BATCH_OPERATION_Erase) ? "Erase" : "Flash",
+				        ptJob->ulStartAdr,
+				        ptJob->ulEndAdr,
+				        ptJob->ptDeviceDescription->uDetectParameter.tSpi.uiUnit,
+				        ptJob->ptDeviceDescription->uDetectParameter.tSpi.uiChipSelect);
+
+				ptSpiJob = atSpiBatchJobs + ulCnt;
+				ptSpiJob->ptFlash = &(ptJob->ptDeviceDescription->uInfo.tSpiInfo);
+				ptSpiJob->tOperation = (ptJob->tOperation==FLASH_BATCH_OPERATION_Erase) ? SPI_BATCH_OPERATION_Erase : SPI_BATCH_OPERATION_Flash;
+				ptSpiJob->ulStartAdr = ptJob->ulStartAdr;
+				ptSpiJob->ulEndAdr = ptJob->ulEndAdr;
+				ptSpiJob->pucData = ptJob->pucData;
+			}
+		}
+	}
+
+	if( tResult==NETX_CONSOLEAPP_RESULT_OK )
+	{
+		tResult = spi_batch(atSpiBatchJobs, (unsigned int)ulJobCount);
+		for(ulCnt=0; ulCnt<ulJobCount; ++ulCnt)
+		{
+			ptParameter->ptJobs[ulCnt].ulResult = (unsigned long)atSpiBatchJobs[ulCnt].tResult;
+		}
+	}
+
+	/* The results are in the jobs. */
+	ptConsoleParams->pvReturnMessage = (void*)0;
+
+	return tResult;
+}
+
+
 /* Actual flash size in bytes */
 static NETX_CONSOLEAPP_RESULT_T opMode_getActualFlashSize(tFlasherInputParameter *ptAppParams){
 	CMD_PARAMETER_GETFLASHSIZE_T *ptParameter;
@@ -747,6 +1112,13 @@ static NETX_CONSOLEAPP_RESULT_T opMode_getEraseArea(tFlasherInputParameter *ptAp
 		break;
 #endif
 
+#ifdef CFG_INCLUDE_I2C
+	case BUS_I2C:
+		/* Use I2C EEPROM */
+		tResult = i2c_getEraseArea(ptParameter);
+		break;
+#endif
+
 	default:
 		/*  unknown device */
 		uprintf("! Unknown device type: 0x%08x\n", tSrcType);
@@ -840,9 +1212,8 @@ static NETX_CONSOLEAPP_RESULT_T opMode_easyErase(tFlasherInputParameter *ptAppPa
 static NETX_CONSOLEAPP_RESULT_T opMode_spiMacroPlayer(tFlasherInputParameter *ptAppParams, NETX_CONSOLEAPP_PARAMETER_T *ptConsoleParams)
 {
 	NETX_CONSOLEAPP_RESULT_T tResult;
-	(void) ptConsoleParams; /* unused */
 
-	tResult = spi_macro_player(&(ptAppParams->uParameter.tSpiMacroPlayer));
+	tResult = spi_macro_player(&(ptAppParams->uParameter.tSpiMacroPlayer), ptConsoleParams);
 	return tResult;
 }
 
@@ -935,6 +1306,20 @@ static NETX_CONSOLEAPP_RESULT_T check_params(NETX_CONSOLEAPP_PARAMETER_T *ptCons
 		uprintf(". Buffer address:        0x%08x\n", pucData);
 		break;
 
+	case OPERATION_MODE_FlashCompressed:
+		ulPars = FLAG_STARTADR + FLAG_SIZE + FLAG_BUFFERADR + FLAG_DEVICE;
+		ulStartAdr          = ptAppParams->uParameter.tFlashCompressed.tFlash.ulStartAdr;
+		ulDataByteSize      = ptAppParams->uParameter.tFlashCompressed.tFlash.ulDataByteSize;
+		pucData             = ptAppParams->uParameter.tFlashCompressed.tFlash.pucData;
+		ptDeviceDescription = ptAppParams->uParameter.tFlashCompressed.tFlash.ptDeviceDescription;
+		uprintf(". Mode: Write compressed data to flash\n");
+		uprintf(". Start offset in flash: 0x%08x\n", ulStartAdr);
+		uprintf(". Data size:             0x%08x\n", ulDataByteSize);
+		uprintf(". Buffer address:        0x%08x\n", pucData);
+		uprintf(". Compressed size:       0x%08x\n", ptAppParams->uParameter.tFlashCompressed.ulCompressedByteSize);
+		uprintf(". Compressed address:    0x%08x\n", ptAppParams->uParameter.tFlashCompressed.pucCompressedData);
+		break;
+
 	case OPERATION_MODE_Erase:
 		ulPars = FLAG_STARTADR + FLAG_ENDADR + FLAG_DEVICE;
 		ulStartAdr          = ptAppParams->uParameter.tErase.ulStartAdr;
@@ -974,6 +1359,18 @@ static NETX_CONSOLEAPP_RESULT_T check_params(NETX_CONSOLEAPP_PARAMETER_T *ptCons
 		uprintf(". Mode: Checksum (SHA1)\n");
 		uprintf(". Flash offset [0x%08x, 0x%08x[\n", ulStartAdr, ulEndAdr);
 		break;
+
+	case OPERATION_MODE_ChecksumRanges:
+		ulPars = FLAG_STARTADR + FLAG_ENDADR + FLAG_BUFFERADR + FLAG_DEVICE;
+		ulStartAdr          = ptAppParams->uParameter.tChecksumRanges.ulStartAdr;
+		ulEndAdr            = ptAppParams->uParameter.tChecksumRanges.ulEndAdr;
+		pucData             = ptAppParams->uParameter.tChecksumRanges.pucDigests;
+		ptDeviceDescription = ptAppParams->uParameter.tChecksumRanges.ptDeviceDescription;
+		uprintf(". Mode: Checksum (SHA1) of regions\n");
+		uprintf(". Flash offset [0x%08x, 0x%08x[\n", ulStartAdr, ulEndAdr);
+		uprintf(". Region size:    0x%08x\n", ptAppParams->uParameter.tChecksumRanges.ulRegionSize);
+		uprintf(". Digest address: 0x%08x\n", pucData);
+		break;
 		
 	case OPERATION_MODE_IsErased:
 		ulPars = FLAG_STARTADR + FLAG_ENDADR + FLAG_DEVICE;
@@ -984,6 +1381,22 @@ static NETX_CONSOLEAPP_RESULT_T check_params(NETX_CONSOLEAPP_PARAMETER_T *ptCons
 		uprintf(". Flash offset [0x%08x, 0x%08x[\n", ulStartAdr, ulEndAdr);
 		break;
 
+	case OPERATION_MODE_VerifyBatch:
+		/* The device descriptions are checked for each job. */
+		ulPars = 0;
+		uprintf(". Mode: Verify batch\n");
+		uprintf(". Jobs:          %d\n", ptAppParams->uParameter.tVerifyBatch.ulJobCount);
+		uprintf(". Job table:     0x%08x\n", ptAppParams->uParameter.tVerifyBatch.ptJobs);
+		break;
+
+	case OPERATION_MODE_FlashBatch:
+		/* The device descriptions are checked for each job. */
+		ulPars = 0;
+		uprintf(". Mode: Flash batch\n");
+		uprintf(". Jobs:          %d\n", ptAppParams->uParameter.tFlashBatch.ulJobCount);
+		uprintf(". Job table:     0x%08x\n", ptAppParams->uParameter.tFlashBatch.ptJobs);
+		break;
+
 	case OPERATION_MODE_GetEraseArea:
 		ulPars = FLAG_STARTADR + FLAG_ENDADR + FLAG_DEVICE;
 		ulStartAdr          = ptAppParams->uParameter.tGetEraseArea.ulStartAdr;
@@ -1355,7 +1768,11 @@ NETX_CONSOLEAPP_RESULT_T netx_consoleapp_main(NETX_CONSOLEAPP_PARAMETER_T *ptTes
 				break;
 
 			case OPERATION_MODE_Flash:
-				tResult = opMode_flash(ptAppParams);
+				tResult = opMode_flash(&(ptAppParams->uParameter.tFlash));
+				break;
+
+			case OPERATION_MODE_FlashCompressed:
+				tResult = opMode_flashCompressed(ptAppParams);
 				break;
 
 			case OPERATION_MODE_Erase:
@@ -1378,11 +1795,28 @@ NETX_CONSOLEAPP_RESULT_T netx_consoleapp_main(NETX_CONSOLEAPP_PARAMETER_T *ptTes
 				tResult = NETX_CONSOLEAPP_RESULT_ERROR;
 #endif
 				break;
+
+			case OPERATION_MODE_ChecksumRanges:
+#if CFG_INCLUDE_SHA1!=0
+				tResult = opMode_checksumRanges(ptAppParams);
+#else
+				uprintf("Error: the checksum command is not supported by this build.\n");
+				tResult = NETX_CONSOLEAPP_RESULT_ERROR;
+#endif
+				break;
 				
 			case OPERATION_MODE_IsErased:
 				tResult = opMode_isErased(ptAppParams, ptTestParam);
 				break;
 
+			case OPERATION_MODE_VerifyBatch:
+				tResult = opMode_verifyBatch(ptAppParams, ptTestParam);
+				break;
+
+			case OPERATION_MODE_FlashBatch:
+				tResult = opMode_flashBatch(ptAppParams, ptTestParam);
+				break;
+
 			case OPERATION_MODE_GetEraseArea:
 				tResult = opMode_getEraseArea(ptAppParams);
 				break;
@@ -36,6 +36,18 @@ static const UNIT_TABLE_T tUnitTable_BusSPI =
 };
 
 
+#ifdef CFG_INCLUDE_I2C
+static const UNIT_TABLE_T tUnitTable_BusI2C =
+{
+	.sizEntries = 1,
+	.atEntries =
+	{
+		{ 0,  "I2C",    NULL }
+	}
+};
+#endif
+
+
 static const UNIT_TABLE_T tUnitTable_BusParFlash =
 {
 	.sizEntries = 2,
@@ -49,11 +61,18 @@ static const UNIT_TABLE_T tUnitTable_BusParFlash =
 
 const BUS_TABLE_T tBusTable =
 {
+#ifdef CFG_INCLUDE_I2C
+	.sizEntries = 3,
+#else
 	.sizEntries = 2,
+#endif
 	.atEntries =
 	{
 		{ BUS_ParFlash,  "Parallel Flash",      &tUnitTable_BusParFlash },
-		{ BUS_SPI,       "Serial Flash",        &tUnitTable_BusSPI }
+		{ BUS_SPI,       "Serial Flash",        &tUnitTable_BusSPI },
+#ifdef CFG_INCLUDE_I2C
+		{ BUS_I2C,       "I2C EEPROM",          &tUnitTable_BusI2C }
+#endif
 	}
 };
 
@@ -150,15 +150,16 @@ typedef struct FLASH_COMMAND_BLOCK_Ttag
 } FLASH_COMMAND_BLOCK_T;
 
 //static FLASH_ERRORS_E FlashWaitWriteDone(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulSector, unsigned long ulOffset, unsigned long ulOffsetData, BOOL fBufferWrite);
-static FLASH_ERRORS_E FlashNormalWrite(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulSector,      unsigned long ulOffset, const unsigned char* pbData, unsigned long ulWriteSize);
+static FLASH_ERRORS_E FlashNormalWrite(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulSector,      unsigned long ulOffset, const unsigned char* pbData, unsigned long ulWriteSize, unsigned long *pulSkippedBytes);
 
 static FLASH_ERRORS_E FlashReset      (const FLASH_DEVICE_T *ptFlashDev, unsigned long ulSector);
 static FLASH_ERRORS_E FlashErase      (const FLASH_DEVICE_T *ptFlashDev, unsigned long ulSector);
 static FLASH_ERRORS_E FlashEraseAll   (const FLASH_DEVICE_T *ptFlashDev);
-static FLASH_ERRORS_E FlashProgram    (const FLASH_DEVICE_T *ptFlashDev, unsigned long ulStartOffset, unsigned long ulLength, const void* pvData);
+static FLASH_ERRORS_E FlashProgram    (const FLASH_DEVICE_T *ptFlashDev, unsigned long ulStartOffset, unsigned long ulLength, const void* pvData, unsigned long *pulSkippedBytes);
 static FLASH_ERRORS_E FlashLock       (const FLASH_DEVICE_T *ptFlashDev, unsigned long ulSector);
 static FLASH_ERRORS_E FlashUnlock     (const FLASH_DEVICE_T *ptFlashDev);
 static FLASH_ERRORS_E FlashUnlockDummy(const FLASH_DEVICE_T *ptFlashDev);
+static FLASH_ERRORS_E FlashEraseSectors(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulFirstSector, unsigned long ulSectorCnt);
 
 static const FLASH_FUNCTIONS_T s_tSpansionFuncs =
 {
@@ -167,7 +168,8 @@ static const FLASH_FUNCTIONS_T s_tSpansionFuncs =
 	FlashEraseAll,
 	FlashProgram,
 	FlashLock,
-	FlashUnlock
+	FlashUnlock,
+	FlashEraseSectors
 };
 
 static const FLASH_COMMAND_BLOCK_T s_atAutoSelect[] =
@@ -526,6 +528,45 @@ static FLASH_ERRORS_E FlashWaitForEraseDone(const FLASH_DEVICE_T *ptFlashDev, un
 
 
 
+/*! Check if the sector erase timeout window is closed.
+*
+*   After a sector erase command the devices wait at least 50us for further
+*   sector erase commands before the embedded erase algorithm starts. DQ3 is
+*   0 while the window is open and 1 as soon as the erase started. For paired
+*   devices the window counts as closed if it is closed on one of them.
+*
+*   \param   ptFlashDev       Pointer to the FLASH control Block
+*   \param   ulSector         A sector which is part of the running erase
+*
+*   \return  !=0 if no more sectors can be added to the erase operation
+*/
+static int FlashIsEraseWindowClosed(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulSector)
+{
+	unsigned long ulMask;
+	unsigned long ulValue;
+
+
+	ulMask = DQ3;
+	if( ptFlashDev->fPaired!=0 )
+	{
+		if( ptFlashDev->tBits==BUS_WIDTH_16Bit )
+		{
+			ulMask |= DQ3 << 8U;
+		}
+		else if( ptFlashDev->tBits==BUS_WIDTH_32Bit )
+		{
+			ulMask |= DQ3 << 16U;
+		}
+	}
+
+	ulValue  = read_flash_data(ptFlashDev, ulSector, 0);
+	ulValue &= ulMask;
+
+	return (ulValue!=0) ? 1 : 0;
+}
+
+
+
 /*! Waits for a programming procedure to finish
 *
 *   \param   ptFlashDev       Pointer to the FLASH control Block
@@ -700,6 +741,90 @@ static FLASH_ERRORS_E FlashErase(const FLASH_DEVICE_T *ptFlashDev, unsigned long
 	return tResult;
 }
 
+/*! Erase a range of flash sectors
+*
+*   All sectors which fit into the sector erase timeout window are queued into
+*   one erase operation. If the window closes before all sectors are queued,
+*   the erase is completed and a new operation starts with the remaining
+*   sectors.
+*
+*   NOTE: do not add any debug messages to the queue loop. They take much
+*         longer than the timeout window.
+*
+*   \param   ptFlashDev       Pointer to the FLASH control Block
+*   \param   ulFirstSector    First sector to erase
+*   \param   ulSectorCnt      Number of sectors to erase
+*
+*   \return  eFLASH_NO_ERROR  on success
+*/
+static FLASH_ERRORS_E FlashEraseSectors(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulFirstSector, unsigned long ulSectorCnt)
+{
+	FLASH_ERRORS_E tResult;
+	unsigned long ulSector;
+	unsigned long ulEndSector;
+	unsigned long ulBatchStart;
+
+
+	DEBUGMSG(ZONE_FUNCTION, ("+FlashEraseSectors(): ptFlashDev=0x%08x, ulFirstSector=%d, ulSectorCnt=%d\n", ptFlashDev, ulFirstSector, ulSectorCnt));
+
+	/* Be optimistic. */
+	tResult = eFLASH_NO_ERROR;
+
+	ulSector = ulFirstSector;
+	ulEndSector = ulFirstSector + ulSectorCnt;
+	if( ulEndSector<ulFirstSector || ulEndSector>ptFlashDev->ulSectorCnt )
+	{
+		tResult = eFLASH_INVALID_PARAMETER;
+	}
+	else
+	{
+		while( ulSector<ulEndSector )
+		{
+			ulBatchStart = ulSector;
+
+			/* Start the erase operation with the first sector. */
+			FlashWriteCommandSequence(ptFlashDev, s_atErasePrefix, ARRAYSIZE(s_atErasePrefix));
+			FlashWriteCommand(ptFlashDev, ulSector, 0, SPANSION_CMD_SECTORERASE_CYCLE_5);
+			++ulSector;
+
+			/* Queue more sectors as long as the timeout window is open. */
+			while( ulSector<ulEndSector )
+			{
+				if( FlashIsEraseWindowClosed(ptFlashDev, ulBatchStart)!=0 )
+				{
+					break;
+				}
+
+				FlashWriteCommand(ptFlashDev, ulSector, 0, SPANSION_CMD_SECTORERASE_CYCLE_5);
+
+				/* If the window closed around the last command, it might not
+				 * have been accepted. Erase the sector again with the next
+				 * operation in this case.
+				 */
+				if( FlashIsEraseWindowClosed(ptFlashDev, ulBatchStart)!=0 )
+				{
+					break;
+				}
+
+				++ulSector;
+			}
+
+			DEBUGMSG(ZONE_VERBOSE, (". erasing sectors %d-%d in one operation\n", ulBatchStart, ulSector-1));
+			tResult = FlashWaitForEraseDone(ptFlashDev, ulBatchStart);
+
+			FlashReset(ptFlashDev, ulBatchStart);
+
+			if( tResult!=eFLASH_NO_ERROR )
+			{
+				break;
+			}
+		}
+	}
+
+	DEBUGMSG(ZONE_FUNCTION, ("-FlashEraseSectors(): tResult=%d\n", tResult));
+	return tResult;
+}
+
 /*! Erase whole flash
 *
 *   \param   ptFlashDev       Pointer to the FLASH control Block
@@ -727,15 +852,18 @@ static FLASH_ERRORS_E FlashEraseAll(const FLASH_DEVICE_T *ptFlashDev)
 
 /*! Programs flash using single byte/word/dword accesses
 *
+*   Elements with the erased value are skipped.
+*
 *   \param   ptFlashDev       Pointer to the FLASH control Block
 *   \param   ulStartOffset    Offset to start writing at
 *   \param   ulLength         Length of data to write
 *   \param   pvData           Data pointer
+*   \param   pulSkippedBytes  Incremented by the number of skipped bytes
 *
 *   \return  eFLASH_NO_ERROR  on success
 */
 
-static FLASH_ERRORS_E FlashNormalWrite(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulSector, unsigned long ulOffset, const unsigned char *pucData, unsigned long ulWriteSize)
+static FLASH_ERRORS_E FlashNormalWrite(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulSector, unsigned long ulOffset, const unsigned char *pucData, unsigned long ulWriteSize, unsigned long *pulSkippedBytes)
 {
 	FLASH_ERRORS_E  eRet       = eFLASH_NO_ERROR;
 	CADR_T tSrc;
@@ -753,6 +881,16 @@ static FLASH_ERRORS_E FlashNormalWrite(const FLASH_DEVICE_T *ptFlashDev, unsigne
 	
 	while(ulOffset < ulEndOffset)
 	{
+		/* Programming the erased value does not change anything. */
+		if( cfi_is_erased_data(tSrc.puc, 1U << ptFlashDev->tBits)!=0 )
+		{
+			tSrc.puc += 1U << ptFlashDev->tBits;
+			tDst.puc += 1U << ptFlashDev->tBits;
+			ulOffset += 1U << ptFlashDev->tBits;
+			*pulSkippedBytes += 1U << ptFlashDev->tBits;
+			continue;
+		}
+
 		FlashWriteCommand(ptFlashDev, 0, SPANSION_ADR_PROGRAM_CYCLE0, SPANSION_CMD_PROGRAM_CYCLE0);
 		FlashWriteCommand(ptFlashDev, 0, SPANSION_ADR_PROGRAM_CYCLE1, SPANSION_CMD_PROGRAM_CYCLE1);
 		FlashWriteCommand(ptFlashDev, 0, SPANSION_ADR_PROGRAM_CYCLE2, SPANSION_CMD_PROGRAM_CYCLE2);
@@ -796,7 +934,22 @@ static FLASH_ERRORS_E FlashNormalWrite(const FLASH_DEVICE_T *ptFlashDev, unsigne
 	return eRet;
 }
 
-static FLASH_ERRORS_E FlashBufferedWrite(const FLASH_DEVICE_T *ptFlashDev, const unsigned char *pucSource, unsigned long ulLength, unsigned long ulCurrentSector, unsigned long ulCurrentOffset)
+/*! Programs flash using the write buffer
+*
+*   Buffer-sized chunks which contain only the erased value are skipped.
+*   The chunks stay aligned to the write buffer, so all non-blank data
+*   is still written with full buffers.
+*
+*   \param   ptFlashDev       Pointer to the FLASH control Block
+*   \param   pucSource        Data pointer
+*   \param   ulLength         Length of data to write
+*   \param   ulCurrentSector  Sector to start writing in
+*   \param   ulCurrentOffset  Offset in the sector to start writing at
+*   \param   pulSkippedBytes  Incremented by the number of skipped bytes
+*
+*   \return  eFLASH_NO_ERROR  on success
+*/
+static FLASH_ERRORS_E FlashBufferedWrite(const FLASH_DEVICE_T *ptFlashDev, const unsigned char *pucSource, unsigned long ulLength, unsigned long ulCurrentSector, unsigned long ulCurrentOffset, unsigned long *pulSkippedBytes)
 {
 	FLASH_ERRORS_E tResult;
 	unsigned long ulWriteSize;
@@ -846,6 +999,23 @@ static FLASH_ERRORS_E FlashBufferedWrite(const FLASH_DEVICE_T *ptFlashDev, const
 		}
 
 		DEBUGMSG(ZONE_FUNCTION, (". ulWriteSize = 0x%08x \n", ulWriteSize)); // sl
+
+		/* Skip the chunk if it would not change the flash contents. */
+		if( cfi_is_erased_data(tSrc.puc, ulWriteSize)!=0 )
+		{
+			tSrc.puc += ulWriteSize;
+			ulCurrentOffset += ulWriteSize;
+			ulLength -= ulWriteSize;
+			*pulSkippedBytes += ulWriteSize;
+
+			/* sector wrap around */
+			if(ulCurrentOffset == ptFlashDev->atSectors[ulCurrentSector].ulSize)
+			{
+				++ulCurrentSector;
+				ulCurrentOffset = 0;
+			}
+			continue;
+		}
 		
 		/* Convert the byte counter to the number of elements to write. */
 		uiWriteElements  = ulWriteSize >> ptFlashDev->tBits;
@@ -954,10 +1124,12 @@ static FLASH_ERRORS_E FlashBufferedWrite(const FLASH_DEVICE_T *ptFlashDev, const
 *  \param   ulStartOffset    Offset to start writing at
 *  \param   ulLength         Length of data to write
 *  \param   pvData           Data pointer
+*  \param   pulSkippedBytes  Incremented by the number of bytes which were
+*                            not programmed because they are already erased
 *
 *  \return  eFLASH_NO_ERROR  on success
 */
-static FLASH_ERRORS_E FlashProgram(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulStartOffset, unsigned long ulLength, const void *pvData)
+static FLASH_ERRORS_E FlashProgram(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulStartOffset, unsigned long ulLength, const void *pvData, unsigned long *pulSkippedBytes)
 {
 	unsigned long  ulCurrentSector;
 	unsigned long  ulCurrentOffset;
@@ -992,7 +1164,7 @@ static FLASH_ERRORS_E FlashProgram(const FLASH_DEVICE_T *ptFlashDev, unsigned lo
 	{
 		/* if the device does not support buffered writes, write the entire data normally */
 		DEBUGMSG(ZONE_VERBOSE, (".FlashProgram(): using normal writes\n"));
-		tResult = FlashNormalWrite(ptFlashDev, ulCurrentSector, ulCurrentOffset, pucSource, ulLength);
+		tResult = FlashNormalWrite(ptFlashDev, ulCurrentSector, ulCurrentOffset, pucSource, ulLength, pulSkippedBytes);
 	}
 	else
 	{
@@ -1015,7 +1187,7 @@ static FLASH_ERRORS_E FlashProgram(const FLASH_DEVICE_T *ptFlashDev, unsigned lo
 				ulUnbufferedWriteSize = ulLength;
 				DEBUGMSG(ZONE_VERBOSE, (". ulUnbufferedWriteSize adjusted to 0x%08x\n", ulUnbufferedWriteSize));
 			}
-			tResult = FlashNormalWrite(ptFlashDev, ulCurrentSector, ulCurrentOffset, pucSource, ulUnbufferedWriteSize);
+			tResult = FlashNormalWrite(ptFlashDev, ulCurrentSector, ulCurrentOffset, pucSource, ulUnbufferedWriteSize, pulSkippedBytes);
 			if(tResult==eFLASH_NO_ERROR)
 			{
 				ulCurrentOffset += ulUnbufferedWriteSize;
@@ -1033,7 +1205,7 @@ static FLASH_ERRORS_E FlashProgram(const FLASH_DEVICE_T *ptFlashDev, unsigned lo
 
 		if( tResult==eFLASH_NO_ERROR )
 		{
-			tResult = FlashBufferedWrite(ptFlashDev, pucSource, ulLength, ulCurrentSector, ulCurrentOffset);
+			tResult = FlashBufferedWrite(ptFlashDev, pucSource, ulLength, ulCurrentSector, ulCurrentOffset, pulSkippedBytes);
 		}
 	}
 	
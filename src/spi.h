@@ -113,7 +113,10 @@ typedef union FLASHER_SPI_FLAGS_STRUCT {
         uint32_t rawValue; /* Entire flag as number */
         struct {
             unsigned int bUseSfdpErase : 1;  /* Always use SFDP to detect erase commands */
-            unsigned int reserved : 31;      /* reserved */
+            unsigned int bStriped : 1;       /* Combine the flash with a second one to a striped flash */
+            unsigned int uiStripeUnit : 3;   /* SPI unit of the second flash */
+            unsigned int uiStripeChipSelect : 3; /* Chip select of the second flash */
+            unsigned int reserved : 24;      /* reserved */
         } bits;
 } FLASHER_SPI_FLAGS_T;
 
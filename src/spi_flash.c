@@ -21,7 +21,6 @@
 #include <string.h>
 
 #include "asic_types.h"
-#include "exodecr.h"
 #include "uprintf.h"
 #include "progress_bar.h"
 
@@ -37,6 +36,9 @@
 #	include "drv_spi_hsoc_v2.h"
 #elif ASIC_TYP==ASIC_TYP_NETX500
 #	include "drv_spi_hsoc_v1.h"
+#elif ASIC_TYP==ASIC_TYP_HOST
+/* The host target has simulated units. */
+#	include "drv_spi_sim.h"
 #endif
 
 
@@ -247,8 +249,155 @@ static int print_status(const FLASHER_SPI_FLASH_T *ptFlash)
 #endif
 
 
-/* NOTE: the external is defined in the imported object. */
-extern const char _binary_spi_flash_types_exo_end[];
+/* The attributes of the last device found in the list of known flashes. */
+static SPIFLASH_ATTRIBUTES_T tKnownFlashAttributes;
+
+
+/*! spi_flash_types_read_number
+*   Read one number from a packed record. Numbers are stored with 7 bits per
+*   byte, the lowest bits first. Bit 7 is set if another byte follows.
+*
+*   \param   ppucRecord         pointer to the read position in the record
+*
+*   \return  the number
+*/
+static unsigned long spi_flash_types_read_number(const unsigned char **ppucRecord)
+{
+	const unsigned char *pucRecord;
+	unsigned long ulValue;
+	unsigned int uiShift;
+	unsigned char ucByte;
+
+
+	pucRecord = *ppucRecord;
+	ulValue = 0;
+	uiShift = 0;
+	do
+	{
+		ucByte = *(pucRecord++);
+		ulValue |= ((unsigned long)(ucByte & 0x7fU)) << uiShift;
+		uiShift += 7;
+	} while( (ucByte&0x80U)!=0 );
+	*ppucRecord = pucRecord;
+
+	return ulValue;
+}
+
+
+/*! spi_flash_types_read_array
+*   Read one command array from a packed record. The array is stored as a
+*   length byte followed by the used bytes.
+*
+*   \param   ppucRecord         pointer to the read position in the record
+*   \param   pucArray           the array to fill
+*   \param   sizArrayMax        the size of the array
+*
+*   \return  the length of the command in bytes
+*/
+static unsigned char spi_flash_types_read_array(const unsigned char **ppucRecord, unsigned char *pucArray, size_t sizArrayMax)
+{
+	const unsigned char *pucRecord;
+	unsigned char ucLength;
+
+
+	pucRecord = *ppucRecord;
+	ucLength = *(pucRecord++);
+	if( ucLength<=sizArrayMax )
+	{
+		memcpy(pucArray, pucRecord, ucLength);
+	}
+	*ppucRecord = pucRecord + ucLength;
+
+	return ucLength;
+}
+
+
+/*! spi_flash_types_unpack
+*   Unpack one record from the list of known flashes. The record holds all
+*   attributes except the ID, which is copied from the index.
+*
+*   \param   ptIndex            pointer to the index entry of the device
+*   \param   ptAttr             the attributes to fill
+*/
+static void spi_flash_types_unpack(const SPIFLASH_ID_INDEX_T *ptIndex, SPIFLASH_ATTRIBUTES_T *ptAttr)
+{
+	const unsigned char *pucRecord;
+	size_t sizName;
+
+
+	/* The fixed size arrays are only filled up to the command length. */
+	memset(ptAttr, 0, sizeof(SPIFLASH_ATTRIBUTES_T));
+
+	pucRecord = aucKnownSpiFlashRecords + ptIndex->usRecordOffset;
+
+	sizName = strlen((const char*)pucRecord);
+	if( sizName>SPIFLASH_NAME_SIZE )
+	{
+		sizName = SPIFLASH_NAME_SIZE;
+	}
+	memcpy(ptAttr->acName, pucRecord, sizName);
+	pucRecord += strlen((const char*)pucRecord) + 1;
+
+	ptAttr->ulSize                   = spi_flash_types_read_number(&pucRecord);
+	ptAttr->ulClock                  = spi_flash_types_read_number(&pucRecord);
+	ptAttr->ulPageSize               = spi_flash_types_read_number(&pucRecord);
+	ptAttr->ulSectorPages            = spi_flash_types_read_number(&pucRecord);
+	ptAttr->tAdrMode                 = (SPIFLASH_ADR_T)(*(pucRecord++));
+	ptAttr->ucReadOpcode             = *(pucRecord++);
+	ptAttr->ucReadOpcodeDCBytes      = *(pucRecord++);
+	ptAttr->ucWriteEnableOpcode      = *(pucRecord++);
+	ptAttr->ucErasePageOpcode        = *(pucRecord++);
+	ptAttr->ucEraseSectorOpcode      = *(pucRecord++);
+	ptAttr->ucEraseChipCmdLen        = spi_flash_types_read_array(&pucRecord, ptAttr->aucEraseChipCmd, SPIFLASH_ERASECHIP_SIZE);
+	ptAttr->ucPageProgOpcode         = *(pucRecord++);
+	ptAttr->ucBufferFill             = *(pucRecord++);
+	ptAttr->ucBufferWriteOpcode      = *(pucRecord++);
+	ptAttr->ucEraseAndPageProgOpcode = *(pucRecord++);
+	ptAttr->ucReadStatusOpcode       = *(pucRecord++);
+	ptAttr->ucStatusReadyMask        = *(pucRecord++);
+	ptAttr->ucStatusReadyValue       = *(pucRecord++);
+	ptAttr->ucInitCmd0_length        = spi_flash_types_read_array(&pucRecord, ptAttr->aucInitCmd0, SPIFLASH_INIT0_SIZE);
+	ptAttr->ucInitCmd1_length        = spi_flash_types_read_array(&pucRecord, ptAttr->aucInitCmd1, SPIFLASH_INIT1_SIZE);
+
+	/* The ID is only stored in the index. */
+	ptAttr->ucIdLength = ptIndex->ucIdLength;
+	memcpy(ptAttr->aucIdSend, ptIndex->aucIdSend, SPIFLASH_ID_SIZE);
+	memcpy(ptAttr->aucIdMask, ptIndex->aucIdMask, SPIFLASH_ID_SIZE);
+	memcpy(ptAttr->aucIdMagic, ptIndex->aucIdMagic, SPIFLASH_ID_SIZE);
+}
+
+
+#if ASIC_TYP==ASIC_TYP_HOST
+/*! spi_flash_types_get_by_name
+*   Find a known flash by its name. This is used by the device models of
+*   the host target.
+*
+*   \param   pcName             the name of the flash
+*   \param   ptAttr             the attributes to fill
+*
+*   \return  the index of the flash in atKnownSpiFlashIds, or -1 if the name is unknown
+*/
+int spi_flash_types_get_by_name(const char *pcName, SPIFLASH_ATTRIBUTES_T *ptAttr)
+{
+	int iResult;
+	int iCnt;
+
+
+	iResult = -1;
+	for(iCnt=0; iCnt<NUMBER_OF_SPIFLASH_ATTRIBUTES; ++iCnt)
+	{
+		spi_flash_types_unpack(atKnownSpiFlashIds + iCnt, ptAttr);
+		if( strcmp(ptAttr->acName, pcName)==0 )
+		{
+			iResult = iCnt;
+			break;
+		}
+	}
+
+	return iResult;
+}
+#endif
+
 
 /*! detect_flash
 *   Convert the linear input address to the device's addressing mode
@@ -259,21 +408,17 @@ extern const char _binary_spi_flash_types_exo_end[];
 *
 *   \return  RX_OK              status successfully returned
 */
-static int detect_flash(FLASHER_SPI_FLASH_T *ptFlash, const SPIFLASH_ATTRIBUTES_T **pptFlashAttr, char *pcBufferEnd, uint8_t ucUseSfdpErase)
+static int detect_flash(FLASHER_SPI_FLASH_T *ptFlash, const SPIFLASH_ATTRIBUTES_T **pptFlashAttr, uint8_t ucUseSfdpErase)
 {
 	int           iResult = 1;
 	int           fFoundId;
 	unsigned int  uiCnt;
 	unsigned char aucIdResp[SPIFLASH_ID_SIZE];
-	const SPIFLASH_ATTRIBUTES_T *ptSc;
-	const SPIFLASH_ATTRIBUTES_T *ptSe;
+	const SPIFLASH_ID_INDEX_T *ptSc;
+	const SPIFLASH_ID_INDEX_T *ptSe;
+	const SPIFLASH_ID_INDEX_T *ptLastProbe;
 	const SPIFLASH_ATTRIBUTES_T *ptSr;
 	FLASHER_SPI_CFG_T *ptSpiDev;
-	union
-	{
-		char *pc;
-		const SPIFLASH_ATTRIBUTES_T *pt;
-	} uSpiTypes;
 	const unsigned int uiUseDetectList = 1;
 	const unsigned int uiUseSfdp = 1;
 
@@ -287,49 +432,60 @@ static int detect_flash(FLASHER_SPI_FLASH_T *ptFlash, const SPIFLASH_ATTRIBUTES_
 
 	if( uiUseDetectList!=0 )
 	{
-		/* Depack the list of known flash devices. */
-		uSpiTypes.pc = exo_decrunch(_binary_spi_flash_types_exo_end, pcBufferEnd);
-
 		/* Get the SPI device. */
 		ptSpiDev = &ptFlash->tSpiDev;
 
-		/* Loop over all entries in the list of known flash types. */
-		ptSc = uSpiTypes.pt;
+		/* Loop over all entries in the ID index of known flash types. */
+		ptSc = atKnownSpiFlashIds;
 		ptSe = ptSc + NUMBER_OF_SPIFLASH_ATTRIBUTES;
 
+		/* No response received yet. */
+		ptLastProbe = NULL;
+
 		/* Initialize found flag in case of an empty list. */
 		fFoundId = (1==0);
 		while(ptSc < ptSe)
 		{
-			/* deselect all chips */
-			ptSpiDev->pfnSelect(ptSpiDev, 0);
-
-			/* send 8 idle bytes to clear the bus */
-			iResult = ptSpiDev->pfnSendIdle(ptSpiDev, 8);
-			if( iResult!=0 )
+			/* Most devices share the same ID sequence. Send it only once. */
+			if( ptLastProbe!=NULL && ptLastProbe->ucIdLength==ptSc->ucIdLength && memcmp(ptLastProbe->aucIdSend, ptSc->aucIdSend, ptSc->ucIdLength)==0 )
 			{
-				//uprintf("ERROR: detect_flash: HalSPI_SendIdles failed with %d.\n", iResult);
-				DBG_CALL_FAILED_VAL("pfnSendIdle", iResult)
-				break;
+				DEBUGMSG(ZONE_VERBOSE, ("detect_flash: reuse the response for record 0x%04x\n", ptSc->usRecordOffset));
 			}
+			else
+			{
+				/* deselect all chips */
+				ptSpiDev->pfnSelect(ptSpiDev, 0);
 
-			/* select the slave */
-			ptSpiDev->pfnSelect(ptSpiDev, 1);
+				/* send 8 idle bytes to clear the bus */
+				iResult = ptSpiDev->pfnSendIdle(ptSpiDev, 8);
+				if( iResult!=0 )
+				{
+					//uprintf("ERROR: detect_flash: HalSPI_SendIdles failed with %d.\n", iResult);
+					DBG_CALL_FAILED_VAL("pfnSendIdle", iResult)
+					break;
+				}
 
-			/* send id magic and receive response */
-			DEBUGMSG(ZONE_VERBOSE, ("detect_flash: probe for %s\n", ptSc->acName));
+				/* select the slave */
+				ptSpiDev->pfnSelect(ptSpiDev, 1);
 
-			iResult = ptSpiDev->pfnExchangeData(ptSpiDev, ptSc->aucIdSend, aucIdResp, ptSc->ucIdLength);
+				/* send id magic and receive response */
+				DEBUGMSG(ZONE_VERBOSE, ("detect_flash: probe for record 0x%04x\n", ptSc->usRecordOffset));
 
-			/* deselect slave */
-			ptSpiDev->pfnSelect(ptSpiDev, 0);
+				iResult = ptSpiDev->pfnExchangeData(ptSpiDev, ptSc->aucIdSend, aucIdResp, ptSc->ucIdLength);
 
-			/* did the send and receive operation fail? */
-			if( iResult!=0 )
-			{
-				//uprintf("ERROR: detect_flash: HalSPI_BlockIo failed with %d.\n", iResult);
-				DBG_CALL_FAILED_VAL("pfnExchangeData", iResult)
+				/* deselect slave */
+				ptSpiDev->pfnSelect(ptSpiDev, 0);
+
+				/* did the send and receive operation fail? */
+				if( iResult!=0 )
+				{
+					//uprintf("ERROR: detect_flash: HalSPI_BlockIo failed with %d.\n", iResult);
+					DBG_CALL_FAILED_VAL("pfnExchangeData", iResult)
 					break;
+				}
+
+				/* Remember the sequence for the next entries. */
+				ptLastProbe = ptSc;
 			}
 
 #if CFG_DEBUGMSG!=0
@@ -387,8 +543,9 @@ static int detect_flash(FLASHER_SPI_FLASH_T *ptFlash, const SPIFLASH_ATTRIBUTES_
 			/* did the complete magic match? */
 			if(fFoundId)
 			{
-				/* yes */
-				ptSr = ptSc;
+				/* yes -> unpack only the record of this device */
+				spi_flash_types_unpack(ptSc, &tKnownFlashAttributes);
+				ptSr = &tKnownFlashAttributes;
 				break;
 			}
 
@@ -614,6 +771,270 @@ static int wait_for_ready(const FLASHER_SPI_FLASH_T *ptFlash)
 }
 
 
+/* The clocks for the speed calibration in kHz. Only the steps between the
+ * initial speed and the clock of the flash are used. The clock of the
+ * flash is always the last step.
+ */
+static const unsigned long aulSpeedCalibrationLadderKhz[] =
+{
+	1000,
+	2000,
+	5000,
+	10000,
+	15000,
+	20000,
+	25000,
+	33000,
+	40000,
+	50000,
+	66000,
+	80000,
+	100000
+};
+
+/* Each step must read the reference pattern this often without errors. */
+#define SPEED_CALIBRATION_REPEAT 8U
+
+/* The pattern is the JEDEC ID followed by the SFDP header. */
+#define SPEED_CALIBRATION_JEDEC_ID_SIZE 4U
+#define SPEED_CALIBRATION_SFDP_SIZE 8U
+#define SPEED_CALIBRATION_PATTERN_SIZE (SPEED_CALIBRATION_JEDEC_ID_SIZE+SPEED_CALIBRATION_SFDP_SIZE)
+
+
+/*! read_with_cmd
+*   Send a command and receive the response.
+*
+*   \param   ptFlash           pointer to the instance of the spi flash
+*   \param   pucCmd            pointer to the byte array holding the command
+*   \param   sizCmdLen         command length in bytes
+*   \param   pucData           buffer for the response
+*   \param   sizData           response length in bytes
+*
+*   \return  0 on success, <>0 on error                                       */
+static int read_with_cmd(const FLASHER_SPI_FLASH_T *ptFlash, const unsigned char *pucCmd, size_t sizCmdLen, unsigned char *pucData, size_t sizData)
+{
+	int iResult;
+	const FLASHER_SPI_CFG_T *ptSpiDev;
+
+
+	/* get spi device */
+	ptSpiDev = &ptFlash->tSpiDev;
+
+	/* select slave */
+	ptSpiDev->pfnSelect(ptSpiDev, 1);
+
+	/* send the command */
+	iResult = ptSpiDev->pfnSendData(ptSpiDev, pucCmd, sizCmdLen);
+	if( iResult!=0 )
+	{
+		DBG_CALL_FAILED_VAL("pfnSendData", iResult)
+	}
+	else
+	{
+		/* receive the response */
+		iResult = ptSpiDev->pfnReceiveData(ptSpiDev, pucData, sizData);
+		if( iResult!=0 )
+		{
+			DBG_CALL_FAILED_VAL("pfnReceiveData", iResult)
+		}
+	}
+
+	/* deselect slave */
+	ptSpiDev->pfnSelect(ptSpiDev, 0);
+
+	if( iResult==0 )
+	{
+		/* send 1 idlebyte */
+		iResult = ptSpiDev->pfnSendIdle(ptSpiDev, 1);
+		if( iResult!=0 )
+		{
+			DBG_CALL_FAILED_VAL("pfnSendIdle", iResult)
+		}
+	}
+
+	return iResult;
+}
+
+
+/*! read_calibration_pattern
+*   Read the JEDEC ID and the SFDP header. Both do not depend on the
+*   contents of the flash and are available right after the detection.
+*
+*   \param   ptFlash           pointer to the instance of the spi flash
+*   \param   pucPattern        buffer for SPEED_CALIBRATION_PATTERN_SIZE bytes
+*
+*   \return  0 on success, <>0 on error                                       */
+static int read_calibration_pattern(const FLASHER_SPI_FLASH_T *ptFlash, unsigned char *pucPattern)
+{
+	int iResult;
+	static const unsigned char aucCmdJedecId[1] = { 0x9fU };
+	static const unsigned char aucCmdSfdp[5] = { 0x5aU, 0x00U, 0x00U, 0x00U, 0x00U };
+
+
+	iResult = read_with_cmd(ptFlash, aucCmdJedecId, sizeof(aucCmdJedecId), pucPattern, SPEED_CALIBRATION_JEDEC_ID_SIZE);
+	if( iResult==0 )
+	{
+		iResult = read_with_cmd(ptFlash, aucCmdSfdp, sizeof(aucCmdSfdp), pucPattern + SPEED_CALIBRATION_JEDEC_ID_SIZE, SPEED_CALIBRATION_SFDP_SIZE);
+	}
+
+	return iResult;
+}
+
+
+/*! set_speed
+*   Set a new clock for the flash.
+*
+*   \param   ptFlash           pointer to the instance of the spi flash
+*   \param   ulSpeedKhz        the new clock in kHz                           */
+static void set_speed(FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulSpeedKhz)
+{
+	FLASHER_SPI_CFG_T *ptSpiDev;
+
+
+	ptSpiDev = &ptFlash->tSpiDev;
+	ptSpiDev->ulSpeed = ptSpiDev->pfnGetDeviceSpeedRepresentation(ptSpiDev, ulSpeedKhz);
+	ptSpiDev->pfnSetNewSpeed(ptSpiDev, ptSpiDev->ulSpeed);
+}
+
+
+/*! test_speed
+*   Read the calibration pattern several times at one clock and compare it
+*   with the reference.
+*
+*   \return  0 if all reads match the reference, 1 on a mismatch, <0 on error */
+static int test_speed(FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulSpeedKhz, const unsigned char *pucReference)
+{
+	int iResult;
+	unsigned int uiCnt;
+	unsigned char aucPattern[SPEED_CALIBRATION_PATTERN_SIZE];
+
+
+	set_speed(ptFlash, ulSpeedKhz);
+
+	iResult = 0;
+	for(uiCnt=0; uiCnt<SPEED_CALIBRATION_REPEAT; ++uiCnt)
+	{
+		iResult = read_calibration_pattern(ptFlash, aucPattern);
+		if( iResult!=0 )
+		{
+			iResult = -1;
+			break;
+		}
+		if( memcmp(aucPattern, pucReference, SPEED_CALIBRATION_PATTERN_SIZE)!=0 )
+		{
+			DEBUGMSG(ZONE_VERBOSE, ("calibrate_speed: read error at %d kHz\n", ulSpeedKhz));
+			iResult = 1;
+			break;
+		}
+	}
+
+	return iResult;
+}
+
+
+/*! calibrate_speed
+*   Find the fastest clock which reads the flash without errors.
+*
+*   The JEDEC ID and the SFDP header are read at the initial speed as a
+*   reference. Then they are read again at a rising ladder of clocks up to
+*   the clock of the flash type. If all steps pass, the clock of the flash
+*   type is used. If a step fails, the step below the last good one is used
+*   to keep some margin. The selected clock is stored in the flash structure,
+*   which is part of the device description for the host, and printed.
+*
+*   \param   ptFlash           pointer to the instance of the spi flash
+*   \param   ulInitialSpeedKhz the speed used for the detection
+*
+*   \return  0 on success, <>0 on error                                       */
+static int calibrate_speed(FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulInitialSpeedKhz)
+{
+	int iResult;
+	unsigned long ulTargetKhz;
+	unsigned long ulStepKhz;
+	unsigned long ulGoodKhz;
+	unsigned long ulMarginKhz;
+	unsigned long ulSelectedKhz;
+	unsigned int uiStep;
+	unsigned int uiCnt;
+	int iIsConstant;
+	unsigned char aucReference[SPEED_CALIBRATION_PATTERN_SIZE];
+
+
+	/* Do not exceed the interface. */
+	ulTargetKhz = ptFlash->tAttributes.ulClock;
+	if( ulTargetKhz>ptFlash->tSpiDev.ulMaximumSpeedKhz )
+	{
+		ulTargetKhz = ptFlash->tSpiDev.ulMaximumSpeedKhz;
+	}
+	ulSelectedKhz = ulTargetKhz;
+
+	/* Get the reference at the initial speed. */
+	iResult = read_calibration_pattern(ptFlash, aucReference);
+	if( iResult==0 && ulTargetKhz>ulInitialSpeedKhz )
+	{
+		/* A floating or stuck bus gives a constant pattern. This is no reference. */
+		iIsConstant = 1;
+		for(uiCnt=1; uiCnt<SPEED_CALIBRATION_PATTERN_SIZE; ++uiCnt)
+		{
+			if( aucReference[uiCnt]!=aucReference[0] )
+			{
+				iIsConstant = 0;
+				break;
+			}
+		}
+
+		if( iIsConstant!=0 )
+		{
+			uprintf(". No reference for the speed calibration. Using %d kHz.\n", ulTargetKhz);
+		}
+		else
+		{
+			ulGoodKhz = ulInitialSpeedKhz;
+			ulMarginKhz = ulInitialSpeedKhz;
+			uiStep = 0;
+			do
+			{
+				/* Get the next step. The last one is the target. */
+				while( uiStep<(sizeof(aulSpeedCalibrationLadderKhz)/sizeof(aulSpeedCalibrationLadderKhz[0])) && aulSpeedCalibrationLadderKhz[uiStep]<=ulGoodKhz )
+				{
+					++uiStep;
+				}
+				ulStepKhz = ulTargetKhz;
+				if( uiStep<(sizeof(aulSpeedCalibrationLadderKhz)/sizeof(aulSpeedCalibrationLadderKhz[0])) && aulSpeedCalibrationLadderKhz[uiStep]<ulTargetKhz )
+				{
+					ulStepKhz = aulSpeedCalibrationLadderKhz[uiStep];
+				}
+
+				iResult = test_speed(ptFlash, ulStepKhz, aucReference);
+				if( iResult!=0 )
+				{
+					break;
+				}
+				ulMarginKhz = ulGoodKhz;
+				ulGoodKhz = ulStepKhz;
+			} while( ulGoodKhz<ulTargetKhz );
+
+			if( iResult>0 )
+			{
+				/* Keep one step of margin to the first failing clock. */
+				ulSelectedKhz = ulMarginKhz;
+				uprintf("! Read errors at %d kHz. Reducing the clock from %d kHz to %d kHz.\n", ulStepKhz, ulTargetKhz, ulSelectedKhz);
+				iResult = 0;
+			}
+		}
+	}
+
+	if( iResult==0 )
+	{
+		set_speed(ptFlash, ulSelectedKhz);
+		ptFlash->ulCalibratedSpeedKhz = ulSelectedKhz;
+		uprintf(". SPI clock: %d kHz\n", ulSelectedKhz);
+	}
+
+	return iResult;
+}
+
+
 /* TODO: move this to the board.c file. */
 int board_get_spi_driver(const FLASHER_SPI_CONFIGURATION_T *ptSpiCfg, FLASHER_SPI_CFG_T *ptSpiDev)
 {
@@ -731,6 +1152,9 @@ int board_get_spi_driver(const FLASHER_SPI_CONFIGURATION_T *ptSpiCfg, FLASHER_SP
 		break;
 	}
 	
+#elif ASIC_TYP==ASIC_TYP_HOST
+	iResult = flasher_drv_spi_sim_init(ptSpiDev, ptSpiCfg, uiUnit);
+
 #else
 	DBG_ERROR_VAL("Unknown ASIC type %d. Forgot to extend this function for a new ASIC?", ASIC_TYP)
 	iResult = -1;
@@ -750,7 +1174,7 @@ int board_get_spi_driver(const FLASHER_SPI_CONFIGURATION_T *ptSpiCfg, FLASHER_SP
 *            Drv_SpiS_INVALID        Specified Flash Control Block invalid
 *            Drv_SpiS_UNKNOWN_FLASH  failed to detect the serial FLASH
 */
-int Drv_SpiInitializeFlash(const FLASHER_SPI_CONFIGURATION_T *ptSpiCfg, FLASHER_SPI_FLASH_T *ptFlash, char *pcBufferEnd, FLASHER_SPI_FLAGS_T tFlags)
+int Drv_SpiInitializeFlash(const FLASHER_SPI_CONFIGURATION_T *ptSpiCfg, FLASHER_SPI_FLASH_T *ptFlash, FLASHER_SPI_FLAGS_T tFlags)
 {
 	int   iResult;
 	const SPIFLASH_ATTRIBUTES_T *ptFlashAttr;
@@ -766,6 +1190,9 @@ int Drv_SpiInitializeFlash(const FLASHER_SPI_CONFIGURATION_T *ptSpiCfg, FLASHER_
 	/* get device */
 	ptSpiDev = &ptFlash->tSpiDev;
 
+	/* This is a single chip. spi_detect combines two of them later for a striped flash. */
+	ptFlash->fIsStriped = 0;
+
 	/* Get the driver. */
 	iResult = board_get_spi_driver(ptSpiCfg, ptSpiDev);
 	if( iResult!=0 )
@@ -776,7 +1203,7 @@ int Drv_SpiInitializeFlash(const FLASHER_SPI_CONFIGURATION_T *ptSpiCfg, FLASHER_
 	else
 	{
 		/* try to autodetect the flash */
-		iResult = detect_flash(ptFlash, &ptFlashAttr, pcBufferEnd, tFlags.bits.bUseSfdpErase);
+		iResult = detect_flash(ptFlash, &ptFlashAttr, tFlags.bits.bUseSfdpErase);
 		if( iResult!=0 )
 		{
 			//uprintf("ERROR: Drv_SpiInitializeFlash: detect_flash failed with %d.\n", iResult);
@@ -795,13 +1222,16 @@ int Drv_SpiInitializeFlash(const FLASHER_SPI_CONFIGURATION_T *ptSpiCfg, FLASHER_
 				/* yes, detected spi flash -> copy all attributes */
 				memcpy(&ptFlash->tAttributes, ptFlashAttr, sizeof(SPIFLASH_ATTRIBUTES_T));
 
-				/* set higher speed for the device */
-				ptSpiDev->ulSpeed = ptSpiDev->pfnGetDeviceSpeedRepresentation(ptSpiDev, ptFlash->tAttributes.ulClock);
-				ptSpiDev->pfnSetNewSpeed(ptSpiDev, ptSpiDev->ulSpeed);
+				/* set the fastest speed which reads the device without errors */
+				iResult = calibrate_speed(ptFlash, ptSpiCfg->ulInitialSpeedKhz);
+				if( iResult!=0 )
+				{
+					DBG_CALL_FAILED_VAL("calibrate_speed", iResult)
+				}
 
 				/* send the init commands */
 				uiCmdLen = ptFlash->tAttributes.ucInitCmd0_length;
-				if( uiCmdLen!=0 )
+				if( iResult==0 && uiCmdLen!=0 )
 				{
 					iResult = send_simple_cmd(ptFlash, ptFlash->tAttributes.aucInitCmd0, uiCmdLen);
 					if( iResult!=0 )
@@ -1013,23 +1443,24 @@ int Drv_SpiEraseFlashArea(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLi
 }
 #endif
 
-/*! Drv_SpiEraseFlashSector
-*   Erases a Sector in the specified serial FLASH
+/*! Drv_SpiStartEraseFlashSector
+*   Starts the erase of a Sector in the specified serial FLASH. The function
+*   does not wait for the end of the erase. Use Drv_SpiIsReady to poll the
+*   flash.
 *
 *   \param      ptFls                           Pointer to FLASH Control Block
 *   \param      ulLinearAddress                 linear address of the sector to be erased
 *
-*   \return     RX_OK                           Erasure successful
-*               Drv_SpiS_ERASURE_NOT_SUPPORTED  Erase function not supported or configured
+*   \return     RX_OK                           Erase started
 */
-int Drv_SpiEraseFlashSector(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearAddress)
+int Drv_SpiStartEraseFlashSector(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearAddress)
 {
 	int iResult;
 	unsigned char abCmd[4];
 	unsigned long ulDeviceAddress;
 
 
-	DEBUGMSG(ZONE_FUNCTION, ("+Drv_SpiEraseFlashSector(): ptFlash=0x%08x, ulLinearAddress=0x%08x\n", ptFlash, ulLinearAddress));
+	DEBUGMSG(ZONE_FUNCTION, ("+Drv_SpiStartEraseFlashSector(): ptFlash=0x%08x, ulLinearAddress=0x%08x\n", ptFlash, ulLinearAddress));
 
 	/* unlock write operations */
 	iResult = write_enable(ptFlash);
@@ -1066,21 +1497,44 @@ int Drv_SpiEraseFlashSector(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ul
 				//uprintf("ERROR: Drv_SpiEraseFlashPage: send_simple_cmd failed with %d.\n", iResult);
 				DBG_CALL_FAILED_VAL("send_simple_cmd", iResult)
 			}
-			else
-			{
-				/* wait for operation finish */
-				iResult = wait_for_ready(ptFlash);
-				if( iResult!=0 )
-				{
-					//uprintf("ERROR: Drv_SpiEraseFlashSector: wait_for_ready failed with %d.\n", iResult);
-					DBG_CALL_FAILED_VAL("wait_for_ready", iResult)
-				}
-			}
 #if CFG_DEBUGMSG!=0
 		}
 #endif
 	}
 
+	DEBUGMSG(ZONE_FUNCTION, ("-Drv_SpiStartEraseFlashSector(): iResult=%d.\n", iResult));
+	return iResult;
+}
+
+
+/*! Drv_SpiEraseFlashSector
+*   Erases a Sector in the specified serial FLASH
+*
+*   \param      ptFls                           Pointer to FLASH Control Block
+*   \param      ulLinearAddress                 linear address of the sector to be erased
+*
+*   \return     RX_OK                           Erasure successful
+*               Drv_SpiS_ERASURE_NOT_SUPPORTED  Erase function not supported or configured
+*/
+int Drv_SpiEraseFlashSector(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearAddress)
+{
+	int iResult;
+
+
+	DEBUGMSG(ZONE_FUNCTION, ("+Drv_SpiEraseFlashSector(): ptFlash=0x%08x, ulLinearAddress=0x%08x\n", ptFlash, ulLinearAddress));
+
+	iResult = Drv_SpiStartEraseFlashSector(ptFlash, ulLinearAddress);
+	if( iResult==0 )
+	{
+		/* wait for operation finish */
+		iResult = wait_for_ready(ptFlash);
+		if( iResult!=0 )
+		{
+			//uprintf("ERROR: Drv_SpiEraseFlashSector: wait_for_ready failed with %d.\n", iResult);
+			DBG_CALL_FAILED_VAL("wait_for_ready", iResult)
+		}
+	}
+
 	DEBUGMSG(ZONE_FUNCTION, ("-Drv_SpiEraseFlashSector(): iResult=%d.\n", iResult));
 	return iResult;
 }
@@ -1510,7 +1964,7 @@ int Drv_SpiEraseAndWritePage(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long u
 #endif
 
 
-static int write_single_opcode(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearAddress, const unsigned char *pabBuffer)
+static int write_single_opcode_start(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearAddress, const unsigned char *pabBuffer)
 {
 	int             iResult;
 	unsigned long   ulDeviceAddress;
@@ -1518,7 +1972,7 @@ static int write_single_opcode(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long
 	const FLASHER_SPI_CFG_T *ptSpiDev;
 
 
-	DEBUGMSG(ZONE_FUNCTION, ("+write_single_opcode(): ptFlash=0x%08x, ulLinearAddress=0x%08x, pabBuffer=0x%08x\n", ptFlash, ulLinearAddress, pabBuffer));
+	DEBUGMSG(ZONE_FUNCTION, ("+write_single_opcode_start(): ptFlash=0x%08x, ulLinearAddress=0x%08x, pabBuffer=0x%08x\n", ptFlash, ulLinearAddress, pabBuffer));
 
 	/* get spi device */
 	ptSpiDev = &ptFlash->tSpiDev;
@@ -1580,23 +2034,34 @@ static int write_single_opcode(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long
 					//uprintf("ERROR: write_single_opcode: HalSPI_SendIdles failed with %d.\n", iResult);
 					DBG_CALL_FAILED_VAL("pfnSendIdle", iResult);
 				}
-				else
-				{
-					/* wait until the write operation is finished */
-					iResult = wait_for_ready(ptFlash);
-					if( iResult!=0 )
-					{
-						//uprintf("ERROR: write_single_opcode: wait_for_ready failed with %d.\n", iResult);
-						DBG_CALL_FAILED_VAL("wait_for_ready", iResult);
-					}
-				}
 			}
 #if CFG_DEBUGMSG!=0
 		}
 #endif
 	}
 
-	DEBUGMSG(ZONE_FUNCTION, ("-write_single_opcode(): iResult=%d.\n", iResult));
+	DEBUGMSG(ZONE_FUNCTION, ("-write_single_opcode_start(): iResult=%d.\n", iResult));
+	return iResult;
+}
+
+
+static int write_single_opcode(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearAddress, const unsigned char *pabBuffer)
+{
+	int iResult;
+
+
+	iResult = write_single_opcode_start(ptFlash, ulLinearAddress, pabBuffer);
+	if( iResult==0 )
+	{
+		/* wait until the write operation is finished */
+		iResult = wait_for_ready(ptFlash);
+		if( iResult!=0 )
+		{
+			//uprintf("ERROR: write_single_opcode: wait_for_ready failed with %d.\n", iResult);
+			DBG_CALL_FAILED_VAL("wait_for_ready", iResult);
+		}
+	}
+
 	return iResult;
 }
 
@@ -1776,6 +2241,155 @@ int Drv_SpiWritePage(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearA
 }
 
 
+/*! Drv_SpiStartWritePage
+*   Starts to program one page. The function does not wait for the end of
+*   the program operation. Use Drv_SpiIsReady to poll the flash.
+*   Flashes without a page program opcode write through their buffer. The
+*   page is written completely before the function returns then.
+*
+*   \param   ptFlash           Pointer to FLASH Control Block
+*   \param   ulLinearAddress   linear address of the page, must be page aligned
+*   \param   pucData           the data for the page
+*   \param   sizData           size of the data, must be the page size
+*   \return  iResult           =0 success, <>0 error                         */
+int Drv_SpiStartWritePage(const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearAddress, const unsigned char *pucData, size_t sizData)
+{
+	int iResult;
+
+
+	DEBUGMSG(ZONE_FUNCTION, ("+Drv_SpiStartWritePage(): ptFlash=0x%08x, ulLinearAddress=0x%08x, pucData=0x%08x, sizData=0x%08x\n", ptFlash, ulLinearAddress, pucData, sizData));
+
+	if( ptFlash->tAttributes.ucPageProgOpcode==0 )
+	{
+		iResult = Drv_SpiWritePage(ptFlash, ulLinearAddress, pucData, sizData);
+	}
+	else if( (ulLinearAddress % ptFlash->tAttributes.ulPageSize)!=0 || sizData!=ptFlash->tAttributes.ulPageSize )
+	{
+		DBG_ERROR("address or size is not page aligned.");
+		iResult = -1;
+	}
+	else
+	{
+		iResult = write_single_opcode_start(ptFlash, ulLinearAddress, pucData);
+	}
+
+	DEBUGMSG(ZONE_FUNCTION, ("-Drv_SpiStartWritePage(): iResult=%d.\n", iResult));
+	return iResult;
+}
+
+
+/*! Drv_SpiIsReady
+*   Read the status once and check if the flash finished a write or erase
+*   operation.
+*
+*   \param   ptFlash           Pointer to FLASH Control Block
+*   \param   piIsReady         receives !=0 if the flash is ready
+*   \return  iResult           =0 success, <>0 error                         */
+int Drv_SpiIsReady(const FLASHER_SPI_FLASH_T *ptFlash, int *piIsReady)
+{
+	unsigned char ucStatus;
+	int iResult;
+
+
+	iResult = read_status(ptFlash, &ucStatus);
+	if( iResult!=0 )
+	{
+		DBG_CALL_FAILED_VAL("read_status", iResult)
+		*piIsReady = 0;
+	}
+	else
+	{
+		ucStatus &= ptFlash->tAttributes.ucStatusReadyMask;
+		*piIsReady = (ucStatus==ptFlash->tAttributes.ucStatusReadyValue);
+	}
+
+	return iResult;
+}
+
+
+/*! Drv_SpiRestoreSpeed
+*   Set the clock of the flash on its unit again.
+*   Several flashes on one unit share the clock setting. The last detect or
+*   a flash on another chip select may have changed it.
+*
+*   \param   ptFlash           Pointer to FLASH Control Block               */
+void Drv_SpiRestoreSpeed(const FLASHER_SPI_FLASH_T *ptFlash)
+{
+	const FLASHER_SPI_CFG_T *ptSpiDev;
+
+
+	ptSpiDev = &ptFlash->tSpiDev;
+	ptSpiDev->pfnSetNewSpeed(ptSpiDev, ptSpiDev->ulSpeed);
+}
+
+
+/*! Drv_SpiWaitForReady
+*   Wait until the flash finished a write or erase operation.
+*
+*   \param   ptFlash           Pointer to FLASH Control Block
+*   \return  iResult           =0 success, <>0 error                         */
+int Drv_SpiWaitForReady(const FLASHER_SPI_FLASH_T *ptFlash)
+{
+	return wait_for_ready(ptFlash);
+}
+
+
+/*! Drv_SpiInitializeStripedFlash
+*   Combine two detected flashes to one striped flash.
+*   Both chips must be the same device. The logical flash gets the
+*   attributes of the first chip with the doubled size and erase blocks.
+*   The page size stays the same, one logical page is one page of a chip.
+*
+*   \param   ptStriped         both chips must be initialized
+*   \return  iResult           =0 success, <>0 error                         */
+int Drv_SpiInitializeStripedFlash(FLASHER_SPI_STRIPED_FLASH_T *ptStriped)
+{
+	const FLASHER_SPI_FLASH_T *ptChip0;
+	const FLASHER_SPI_FLASH_T *ptChip1;
+	FLASHER_SPI_FLASH_T *ptLogical;
+	unsigned int uiCnt;
+	int iResult;
+
+
+	ptChip0 = &(ptStriped->atChip[0]);
+	ptChip1 = &(ptStriped->atChip[1]);
+	ptLogical = &(ptStriped->tLogical);
+
+	if( strcmp(ptChip0->tAttributes.acName, ptChip1->tAttributes.acName)!=0 ||
+	    ptChip0->tAttributes.ulSize!=ptChip1->tAttributes.ulSize ||
+	    ptChip0->tAttributes.ulPageSize!=ptChip1->tAttributes.ulPageSize ||
+	    ptChip0->ulSectorSize!=ptChip1->ulSectorSize )
+	{
+		uprintf("! The flashes of a striped flash must be the same device.\n");
+		iResult = -1;
+	}
+	else if( ptChip0->tAttributes.ulSize>0x80000000U )
+	{
+		uprintf("! The striped flash would be larger than 4GB.\n");
+		iResult = -1;
+	}
+	else
+	{
+		memcpy(ptLogical, ptChip0, sizeof(FLASHER_SPI_FLASH_T));
+		ptLogical->tAttributes.ulSize *= 2U;
+		ptLogical->tAttributes.ulSectorPages *= 2U;
+		ptLogical->ulSectorSize *= 2U;
+		ptLogical->uiSectorAdrShift += 1U;
+		for(uiCnt=0; uiCnt<ptLogical->usNrEraseOperations; ++uiCnt)
+		{
+			ptLogical->tSpiErase[uiCnt].Size *= 2U;
+		}
+		/* A page erase would only erase half of a logical page pair. */
+		ptLogical->tAttributes.ucErasePageOpcode = 0x00;
+		ptLogical->fIsStriped = 1;
+
+		iResult = 0;
+	}
+
+	return iResult;
+}
+
+
 typedef struct ADR_MODE_NAME_STRUCT
 {
 	SPIFLASH_ADR_T tAdrMode;
@@ -40,6 +40,7 @@
 
 #include <stdint.h>
 
+#include "asic_types.h"
 #include "spi.h"
 #include "spi_flash_types.h"
 
@@ -71,25 +72,52 @@ typedef struct FLASHER_SPI_FLASH_STRUCT
 	unsigned int uiSectorAdrShift;                                        /**< @brief bit shift for one sector, 0 means no page / byte split.                    */
 	FLASHER_SPI_ERASE_T tSpiErase[FLASHER_SPI_NR_ERASE_INSTRUCTIONS];     /**< @brief Sorted list of SPI erase instructions (Element 0 is smallest)              */
 	unsigned short usNrEraseOperations;                                   /**< @brief Number of valid erase operations contained in the tSpiErase array          */
+	unsigned long ulCalibratedSpeedKhz;                                   /**< @brief The clock in kHz selected by the speed calibration.                         */
+	int fIsStriped;                                                       /**< @brief !=0 if this is the logical view of a FLASHER_SPI_STRIPED_FLASH_T.          */
 } FLASHER_SPI_FLASH_T;
 
+/**
+ * Two identical flashes which form one striped flash.
+ * The pages of the logical flash alternate between the chips. Page n is
+ * page n/2 of chip n%2. An erase block of the logical flash is one sector
+ * on each chip.
+ * tLogical describes the combined flash and must be the first member. The
+ * functions in flasher_spi.c get a pointer to it and find the chips with
+ * the fIsStriped flag.
+ */
+typedef struct FLASHER_SPI_STRIPED_FLASH_STRUCT
+{
+	FLASHER_SPI_FLASH_T tLogical;                                         /**< @brief The combined flash with doubled size, sectors and erase blocks.            */
+	FLASHER_SPI_FLASH_T atChip[2];                                        /**< @brief The physical flashes.                                                      */
+} FLASHER_SPI_STRIPED_FLASH_T;
+
 /*-----------------------------------*/
 
-int Drv_SpiInitializeFlash        (const FLASHER_SPI_CONFIGURATION_T *ptSpiCfg, FLASHER_SPI_FLASH_T *ptFlash, char *pcBufferEnd, FLASHER_SPI_FLAGS_T flags);
+int Drv_SpiInitializeFlash        (const FLASHER_SPI_CONFIGURATION_T *ptSpiCfg, FLASHER_SPI_FLASH_T *ptFlash, FLASHER_SPI_FLAGS_T flags);
 int Drv_SpiEraseFlashPage         (const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearAddress);
 #if CFG_INCLUDE_SMART_ERASE==1
 int Drv_SpiEraseFlashArea         (const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearAddress, const unsigned char eraseOpcode);
 #endif
 int Drv_SpiEraseFlashSector       (const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearAddress);
+int Drv_SpiStartEraseFlashSector  (const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearAddress);
 int Drv_SpiEraseFlashMultiSectors (const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearStartAddress, unsigned long ulLinearEndAddress);
 int Drv_SpiEraseFlashComplete     (const FLASHER_SPI_FLASH_T *ptFlash);
 int Drv_SpiWriteFlashPages        (const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulOffs, const unsigned char *pabSrc, unsigned long ulNum);
 int Drv_SpiReadFlash              (const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearAddress, unsigned char       *pucData, size_t sizData);
 int Drv_SpiEraseAndWritePage      (const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearAddress, const unsigned char *pucData, size_t sizData);
 int Drv_SpiWritePage              (const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearAddress, const unsigned char *pucData, size_t sizData);
+int Drv_SpiStartWritePage         (const FLASHER_SPI_FLASH_T *ptFlash, unsigned long ulLinearAddress, const unsigned char *pucData, size_t sizData);
+int Drv_SpiIsReady                (const FLASHER_SPI_FLASH_T *ptFlash, int *piIsReady);
+void Drv_SpiRestoreSpeed          (const FLASHER_SPI_FLASH_T *ptFlash);
+int Drv_SpiWaitForReady           (const FLASHER_SPI_FLASH_T *ptFlash);
+int Drv_SpiInitializeStripedFlash (FLASHER_SPI_STRIPED_FLASH_T *ptStriped);
 
 const char *spi_flash_get_adr_mode_name(SPIFLASH_ADR_T tAdrMode);
 
+#if ASIC_TYP==ASIC_TYP_HOST
+int spi_flash_types_get_by_name(const char *pcName, SPIFLASH_ATTRIBUTES_T *ptAttr);
+#endif
+
 int board_get_spi_driver(const FLASHER_SPI_CONFIGURATION_T *ptSpiCfg, FLASHER_SPI_CFG_T *ptSpiDev);
 
 /**
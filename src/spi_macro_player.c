@@ -25,6 +25,7 @@
 
 #include "netx_io_areas.h"
 #include "spi_flash.h"
+#include "systime.h"
 #include "uprintf.h"
 
 
@@ -56,7 +57,7 @@
 /*-------------------------------------------------------------------------*/
 
 
-typedef int (*PFN_SPI_MACRO_HANDLER_T)(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_CFG_T *ptSpiDev);
+typedef int (*PFN_SPI_MACRO_HANDLER_T)(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_CFG_T *ptSpiDev, void **ppvReturnMessage);
 
 typedef struct SPI_MACRO_HANDLER_TABLE_STRUCT
 {
@@ -68,11 +69,12 @@ typedef struct SPI_MACRO_HANDLER_TABLE_STRUCT
 /*-------------------------------------------------------------------------*/
 
 
-static int SMC_Handler_Initialize(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_CFG_T *ptSpiDev)
+static int SMC_Handler_Initialize(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_CFG_T *ptSpiDev, void **ppvReturnMessage)
 {
 	int iResult;
 	const FLASHER_SPI_CONFIGURATION_T *ptSpiCfg;
 
+	(void) ppvReturnMessage; /* unused */
 
 	uprintf("[SMC] initialize\n");
 
@@ -89,10 +91,11 @@ static int SMC_Handler_Initialize(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SP
 
 
 
-static int SMC_Handler_ChipSelect(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_CFG_T *ptSpiDev)
+static int SMC_Handler_ChipSelect(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_CFG_T *ptSpiDev, void **ppvReturnMessage)
 {
 	int iResult;
 
+	(void) ppvReturnMessage; /* unused */
 
 	uprintf("[SMC] chip select: %d\n", ptCfg->tChipSelect.iActive);
 
@@ -103,10 +106,11 @@ static int SMC_Handler_ChipSelect(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SP
 
 
 
-static int SMC_Handler_ExchangeData(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_CFG_T *ptSpiDev)
+static int SMC_Handler_ExchangeData(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_CFG_T *ptSpiDev, void **ppvReturnMessage)
 {
 	int iResult;
 
+	(void) ppvReturnMessage; /* unused */
 
 	uprintf("[SMC] exchange data\n");
 
@@ -129,10 +133,11 @@ static int SMC_Handler_ExchangeData(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_
 
 
 
-static int SMC_Handler_SendData(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_CFG_T *ptSpiDev)
+static int SMC_Handler_SendData(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_CFG_T *ptSpiDev, void **ppvReturnMessage)
 {
 	int iResult;
 
+	(void) ppvReturnMessage; /* unused */
 
 	uprintf("[SMC] send data:\n");
 	hexdump(ptCfg->tSendData.pucTxBuffer, ptCfg->tSendData.sizTxBuffer);
@@ -148,10 +153,11 @@ static int SMC_Handler_SendData(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_
 
 
 
-static int SMC_Handler_ReceiveData(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_CFG_T *ptSpiDev)
+static int SMC_Handler_ReceiveData(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_CFG_T *ptSpiDev, void **ppvReturnMessage)
 {
 	int iResult;
 
+	(void) ppvReturnMessage; /* unused */
 
 	uprintf("[SMC] receive %d bytes to 0x%08x\n", ptCfg->tReceiveData.sizRxBuffer, ptCfg->tReceiveData.pucRxBuffer);
 
@@ -171,10 +177,11 @@ static int SMC_Handler_ReceiveData(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_S
 
 
 
-static int SMC_Handler_SendIdleBytes(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_CFG_T *ptSpiDev)
+static int SMC_Handler_SendIdleBytes(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_CFG_T *ptSpiDev, void **ppvReturnMessage)
 {
 	int iResult;
 
+	(void) ppvReturnMessage; /* unused */
 
 	uprintf("[SMC] send %d idle bytes\n", ptCfg->tIdleBytes.sizIdleBytes);
 
@@ -189,6 +196,318 @@ static int SMC_Handler_SendIdleBytes(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER
 
 
 
+/* The RX buffer for the macro interpreter. The length of a receive or
+ * exchange operation is one byte, so this is enough for all opcodes.
+ */
+static unsigned char aucMacroRxBuffer[255];
+
+
+static unsigned long macro_get_uint16(const unsigned char *pucData)
+{
+	return (unsigned long)pucData[0] | ((unsigned long)pucData[1] << 8U);
+}
+
+
+
+/* Get the number of argument bytes for the opcode at pucOp.
+ * The function returns -1 for an unknown opcode.
+ */
+static int macro_get_argument_size(const unsigned char *pucOp)
+{
+	int iSize;
+	SPI_MACRO_OPCODE_T tOpcode;
+
+
+	tOpcode = (SPI_MACRO_OPCODE_T)pucOp[0];
+	switch( tOpcode )
+	{
+	case SMC_OP_END:
+	case SMC_OP_CAPTURE:
+		iSize = 0;
+		break;
+
+	case SMC_OP_CHIP_SELECT:
+	case SMC_OP_RECEIVE:
+	case SMC_OP_IDLE:
+	case SMC_OP_FAIL:
+		iSize = 1;
+		break;
+
+	case SMC_OP_SEND:
+	case SMC_OP_EXCHANGE:
+		/* The length byte plus the data. */
+		iSize = 1 + (int)pucOp[1];
+		break;
+
+	case SMC_OP_JUMP:
+		iSize = 2;
+		break;
+
+	case SMC_OP_JUMP_EQ:
+	case SMC_OP_JUMP_NE:
+		iSize = 4;
+		break;
+
+	case SMC_OP_POLL:
+		iSize = 6;
+		break;
+
+	default:
+		iSize = -1;
+		break;
+	}
+
+	return iSize;
+}
+
+
+
+/* Run a complete macro.
+ * All SPI primitives, branches and poll loops are executed on the netX,
+ * so a complete sequence like "write enable, write status, wait until
+ * ready" needs only one call from the host.
+ * The number of bytes in the log is returned in ppvReturnMessage. If the
+ * macro fails, ppvReturnMessage is a SPI_MACRO_ERROR_T instead.
+ */
+static int SMC_Handler_RunMacro(const SPI_MACRO_PARAMETER_T *ptCfg, FLASHER_SPI_CFG_T *ptSpiDev, void **ppvReturnMessage)
+{
+	int iResult;
+	int iArgSize;
+	const unsigned char *pucMacro;
+	size_t sizMacro;
+	size_t sizPc;
+	size_t sizNextPc;
+	unsigned char *pucLog;
+	size_t sizLog;
+	size_t sizLogPos;
+	size_t sizRx;
+	unsigned char ucLastRx;
+	unsigned char ucMask;
+	unsigned char ucValue;
+	unsigned long ulTarget;
+	int iPollRunning;
+	unsigned long ulPollStartMs;
+	unsigned long ulPollTimeoutMs;
+	unsigned long ulSteps;
+	SPI_MACRO_ERROR_T tError;
+	size_t sizPollLoopStart;
+	size_t sizPollPc;
+	const unsigned char *pucOp;
+	SPI_MACRO_OPCODE_T tOpcode;
+
+
+	pucMacro = ptCfg->tRunMacro.pucMacro;
+	sizMacro = ptCfg->tRunMacro.sizMacro;
+	pucLog = ptCfg->tRunMacro.pucLog;
+	sizLog = ptCfg->tRunMacro.sizLog;
+
+	uprintf("[SMC] run macro with 0x%08x bytes\n", sizMacro);
+
+	sizPc = 0;
+	sizLogPos = 0;
+	sizRx = 0;
+	ucLastRx = 0;
+	iPollRunning = 0;
+	ulPollStartMs = 0;
+	ulPollTimeoutMs = 0;
+	sizPollLoopStart = 0;
+	sizPollPc = 0;
+	ulSteps = 0;
+	tError = SMC_ERROR_SPI;
+	iResult = 0;
+	while( iResult==0 )
+	{
+		/* Reaching the end of the macro is the same as SMC_OP_END. */
+		if( sizPc>=sizMacro )
+		{
+			break;
+		}
+
+		/* Do not read the arguments beyond the end of the macro. */
+		pucOp = pucMacro + sizPc;
+		iArgSize = -1;
+		if( (sizMacro-sizPc)>=2U || pucOp[0]==SMC_OP_END || pucOp[0]==SMC_OP_CAPTURE )
+		{
+			iArgSize = macro_get_argument_size(pucOp);
+		}
+		if( iArgSize<0 || (size_t)iArgSize>(sizMacro-sizPc-1U) )
+		{
+			uprintf("ERROR: invalid or truncated opcode 0x%02x at offset 0x%08x!\n", pucOp[0], sizPc);
+			tError = SMC_ERROR_INVALID_OPCODE;
+			iResult = -1;
+			break;
+		}
+		sizNextPc = sizPc + 1U + (size_t)iArgSize;
+
+		/* A poll loop runs from its target up to the POLL opcode. It is
+		 * finished as soon as an opcode outside of this range is executed,
+		 * for example after a JUMP_EQ or JUMP_NE out of the loop. The next
+		 * POLL must start a new timeout then.
+		 */
+		if( iPollRunning!=0 && (sizPc<sizPollLoopStart || sizPc>sizPollPc) )
+		{
+			iPollRunning = 0;
+		}
+
+		/* A poll loop is limited by its timeout. This is also checked
+		 * here, as a jump inside of the loop may never reach the POLL
+		 * opcode. All other opcodes are counted.
+		 */
+		if( iPollRunning!=0 )
+		{
+			if( systime_elapsed(ulPollStartMs, ulPollTimeoutMs)!=0 )
+			{
+				uprintf("ERROR: timeout while polling at offset 0x%08x, last value: 0x%02x\n", sizPollPc, ucLastRx);
+				tError = SMC_ERROR_POLL_TIMEOUT;
+				iResult = -1;
+				break;
+			}
+		}
+		else
+		{
+			++ulSteps;
+			if( ulSteps>SMC_MACRO_MAX_STEPS )
+			{
+				uprintf("ERROR: the macro executed more than %d opcodes, stopped at offset 0x%08x.\n", SMC_MACRO_MAX_STEPS, sizPc);
+				tError = SMC_ERROR_STEP_LIMIT;
+				iResult = -1;
+				break;
+			}
+		}
+
+		DEBUGMSG(ZONE_VERBOSE, ("[SMC] 0x%04x: op 0x%02x\n", sizPc, pucOp[0]));
+
+		tOpcode = (SPI_MACRO_OPCODE_T)pucOp[0];
+		switch( tOpcode )
+		{
+		case SMC_OP_END:
+			sizNextPc = sizMacro;
+			break;
+
+		case SMC_OP_CHIP_SELECT:
+			iResult = ptSpiDev->pfnSelect(ptSpiDev, (pucOp[1]!=0) ? 1 : 0);
+			break;
+
+		case SMC_OP_SEND:
+			iResult = ptSpiDev->pfnSendData(ptSpiDev, pucOp + 2, pucOp[1]);
+			break;
+
+		case SMC_OP_RECEIVE:
+			sizRx = pucOp[1];
+			iResult = ptSpiDev->pfnReceiveData(ptSpiDev, aucMacroRxBuffer, sizRx);
+			if( iResult==0 && sizRx!=0 )
+			{
+				ucLastRx = aucMacroRxBuffer[sizRx-1U];
+			}
+			break;
+
+		case SMC_OP_EXCHANGE:
+			sizRx = pucOp[1];
+			iResult = ptSpiDev->pfnExchangeData(ptSpiDev, pucOp + 2, aucMacroRxBuffer, sizRx);
+			if( iResult==0 && sizRx!=0 )
+			{
+				ucLastRx = aucMacroRxBuffer[sizRx-1U];
+			}
+			break;
+
+		case SMC_OP_IDLE:
+			iResult = ptSpiDev->pfnSendIdle(ptSpiDev, pucOp[1]);
+			break;
+
+		case SMC_OP_JUMP:
+			sizNextPc = macro_get_uint16(pucOp + 1);
+			break;
+
+		case SMC_OP_JUMP_EQ:
+		case SMC_OP_JUMP_NE:
+			ucMask = pucOp[1];
+			ucValue = pucOp[2];
+			ulTarget = macro_get_uint16(pucOp + 3);
+			if( ((ucLastRx & ucMask)==ucValue) == (tOpcode==SMC_OP_JUMP_EQ) )
+			{
+				sizNextPc = ulTarget;
+			}
+			break;
+
+		case SMC_OP_POLL:
+			ucMask = pucOp[1];
+			ucValue = pucOp[2];
+			ulTarget = macro_get_uint16(pucOp + 3);
+			if( (ucLastRx & ucMask)==ucValue )
+			{
+				/* The condition is true, leave the loop. */
+				iPollRunning = 0;
+			}
+			else
+			{
+				if( iPollRunning==0 || sizPollPc!=sizPc )
+				{
+					ulPollStartMs = systime_get_ms();
+					ulPollTimeoutMs = macro_get_uint16(pucOp + 5);
+					sizPollLoopStart = ulTarget;
+					sizPollPc = sizPc;
+					iPollRunning = 1;
+				}
+
+				if( systime_elapsed(ulPollStartMs, ulPollTimeoutMs)!=0 )
+				{
+					uprintf("ERROR: timeout while polling at offset 0x%08x, last value: 0x%02x\n", sizPc, ucLastRx);
+					tError = SMC_ERROR_POLL_TIMEOUT;
+					iResult = -1;
+				}
+				else
+				{
+					sizNextPc = ulTarget;
+				}
+			}
+			break;
+
+		case SMC_OP_CAPTURE:
+			if( sizRx>(sizLog-sizLogPos) )
+			{
+				uprintf("ERROR: the log is full at offset 0x%08x!\n", sizPc);
+				tError = SMC_ERROR_LOG_FULL;
+				iResult = -1;
+			}
+			else
+			{
+				memcpy(pucLog + sizLogPos, aucMacroRxBuffer, sizRx);
+				sizLogPos += sizRx;
+			}
+			break;
+
+		case SMC_OP_FAIL:
+			uprintf("ERROR: the macro failed with code 0x%02x at offset 0x%08x.\n", pucOp[1], sizPc);
+			tError = SMC_ERROR_FAIL;
+			iResult = -1;
+			break;
+		}
+
+		if( iResult!=0 )
+		{
+			break;
+		}
+
+		sizPc = sizNextPc;
+	}
+
+	if( iResult!=0 )
+	{
+		/* Do not leave the device selected. */
+		ptSpiDev->pfnSelect(ptSpiDev, 0);
+		*ppvReturnMessage = (void*)tError;
+	}
+	else
+	{
+		uprintf("[SMC] captured 0x%08x bytes\n", sizLogPos);
+		*ppvReturnMessage = (void*)sizLogPos;
+	}
+
+	return iResult;
+}
+
+
+
 /*-------------------------------------------------------------------------*/
 
 
@@ -199,11 +518,12 @@ static const SPI_MACRO_HANDLER_TABLE_T atCmdHandler[] =
 	{ SMC_EXCHANGE_DATA,      SMC_Handler_ExchangeData },
 	{ SMC_SEND_DATA,          SMC_Handler_SendData },
 	{ SMC_RECEIVE_DATA,       SMC_Handler_ReceiveData },
-	{ SMC_SEND_IDLE_BYTES,    SMC_Handler_SendIdleBytes }
+	{ SMC_SEND_IDLE_BYTES,    SMC_Handler_SendIdleBytes },
+	{ SMC_RUN_MACRO,          SMC_Handler_RunMacro }
 };
 
 
-NETX_CONSOLEAPP_RESULT_T spi_macro_player(CMD_PARAMETER_SPIMACROPLAYER_T *ptParameter)
+NETX_CONSOLEAPP_RESULT_T spi_macro_player(CMD_PARAMETER_SPIMACROPLAYER_T *ptParameter, NETX_CONSOLEAPP_PARAMETER_T *ptConsoleParams)
 {
 	NETX_CONSOLEAPP_RESULT_T tResult;
 	int iResult;
@@ -230,6 +550,7 @@ NETX_CONSOLEAPP_RESULT_T spi_macro_player(CMD_PARAMETER_SPIMACROPLAYER_T *ptPara
 	case SMC_SEND_DATA:
 	case SMC_RECEIVE_DATA:
 	case SMC_SEND_IDLE_BYTES:
+	case SMC_RUN_MACRO:
 		tCmd = (SPI_MACRO_CMD_T)ulValue;
 		iResult = 0;
 		break;
@@ -261,7 +582,7 @@ NETX_CONSOLEAPP_RESULT_T spi_macro_player(CMD_PARAMETER_SPIMACROPLAYER_T *ptPara
 		}
 		else
 		{
-			iResult = pfnHandler(&(ptParameter->uCfg), ptParameter->ptSpiDev);
+			iResult = pfnHandler(&(ptParameter->uCfg), ptParameter->ptSpiDev, &(ptConsoleParams->pvReturnMessage));
 			if( iResult==0 )
 			{
 				tResult = NETX_CONSOLEAPP_RESULT_OK;
@@ -36,10 +36,67 @@ typedef enum SPI_MACRO_CMD_ENUM
 	SMC_EXCHANGE_DATA          = 2,
 	SMC_SEND_DATA              = 3,
 	SMC_RECEIVE_DATA           = 4,
-	SMC_SEND_IDLE_BYTES        = 5
+	SMC_SEND_IDLE_BYTES        = 5,
+	SMC_RUN_MACRO              = 6
 } SPI_MACRO_CMD_T;
 
 
+/* These are the opcodes for the SMC_RUN_MACRO command.
+ * Each opcode is one byte followed by its arguments. All 16 bit
+ * arguments are little endian. Jump targets are byte offsets from the
+ * start of the macro.
+ *
+ *  SMC_OP_END                                      stop the macro successfully
+ *  SMC_OP_CHIP_SELECT  active                      set the chip select
+ *  SMC_OP_SEND         len data[len]               send data
+ *  SMC_OP_RECEIVE      len                         receive data to the RX buffer
+ *  SMC_OP_EXCHANGE     len data[len]               exchange data, RX data goes to the RX buffer
+ *  SMC_OP_IDLE         len                         send idle bytes
+ *  SMC_OP_JUMP         target16                    jump unconditionally
+ *  SMC_OP_JUMP_EQ      mask value target16         jump if (last RX byte & mask)==value
+ *  SMC_OP_JUMP_NE      mask value target16         jump if (last RX byte & mask)!=value
+ *  SMC_OP_POLL         mask value target16 ms16    jump back to target until (last RX byte & mask)==value, fail after ms16 milliseconds
+ *  SMC_OP_CAPTURE                                  append the RX buffer to the log
+ *  SMC_OP_FAIL         code                        stop the macro with an error
+ *
+ * A macro can not run forever. Outside of a poll loop it may execute
+ * SMC_MACRO_MAX_STEPS opcodes. Inside of a poll loop the timeout of the
+ * POLL opcode is checked before each opcode.
+ */
+typedef enum SPI_MACRO_OPCODE_ENUM
+{
+	SMC_OP_END                 = 0x00,
+	SMC_OP_CHIP_SELECT         = 0x01,
+	SMC_OP_SEND                = 0x02,
+	SMC_OP_RECEIVE             = 0x03,
+	SMC_OP_EXCHANGE            = 0x04,
+	SMC_OP_IDLE                = 0x05,
+	SMC_OP_JUMP                = 0x06,
+	SMC_OP_JUMP_EQ             = 0x07,
+	SMC_OP_JUMP_NE             = 0x08,
+	SMC_OP_POLL                = 0x09,
+	SMC_OP_CAPTURE             = 0x0a,
+	SMC_OP_FAIL                = 0x0b
+} SPI_MACRO_OPCODE_T;
+
+
+#define SMC_MACRO_MAX_STEPS 0x00010000U
+
+
+/* If SMC_RUN_MACRO fails, the return message is one of these codes
+ * instead of the number of bytes in the log.
+ */
+typedef enum SPI_MACRO_ERROR_ENUM
+{
+	SMC_ERROR_SPI              = 1,    /* An SPI transfer failed. */
+	SMC_ERROR_INVALID_OPCODE   = 2,    /* An unknown or truncated opcode. */
+	SMC_ERROR_POLL_TIMEOUT     = 3,    /* The timeout of a POLL opcode expired. */
+	SMC_ERROR_LOG_FULL         = 4,    /* CAPTURE needs more space than the log has. */
+	SMC_ERROR_FAIL             = 5,    /* The macro executed a FAIL opcode. */
+	SMC_ERROR_STEP_LIMIT       = 6     /* The macro executed SMC_MACRO_MAX_STEPS opcodes outside of a poll loop. */
+} SPI_MACRO_ERROR_T;
+
+
 
 typedef struct SPI_MACRO_PARAMETER_INIT_STRUCT
 {
@@ -81,6 +138,15 @@ typedef struct SPI_MACRO_PARAMETER_IDLE_STRUCT
 } SPI_MACRO_PARAMETER_IDLE_T;
 
 
+typedef struct SPI_MACRO_PARAMETER_RUN_STRUCT
+{
+	const unsigned char *pucMacro;
+	size_t sizMacro;
+	unsigned char *pucLog;
+	size_t sizLog;
+} SPI_MACRO_PARAMETER_RUN_T;
+
+
 typedef union SPI_MACRO_PARAMETER_UNION
 {
 	SPI_MACRO_PARAMETER_INIT_T tInit;
@@ -89,6 +155,7 @@ typedef union SPI_MACRO_PARAMETER_UNION
 	SPI_MACRO_PARAMETER_SEND_T tSendData;
 	SPI_MACRO_PARAMETER_RECEIVE_T tReceiveData;
 	SPI_MACRO_PARAMETER_IDLE_T tIdleBytes;
+	SPI_MACRO_PARAMETER_RUN_T tRunMacro;
 } SPI_MACRO_PARAMETER_T;
 
 
@@ -100,7 +167,7 @@ typedef struct CMD_PARAMETER_SPIMACROPLAYER_STRUCT
 } CMD_PARAMETER_SPIMACROPLAYER_T;
 
 
-NETX_CONSOLEAPP_RESULT_T spi_macro_player(CMD_PARAMETER_SPIMACROPLAYER_T *ptParameter);
+NETX_CONSOLEAPP_RESULT_T spi_macro_player(CMD_PARAMETER_SPIMACROPLAYER_T *ptParameter, NETX_CONSOLEAPP_PARAMETER_T *ptConsoleParams);
 
 
 
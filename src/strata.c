@@ -62,9 +62,10 @@ static int            FlashIsset          (const FLASH_DEVICE_T *ptFlashDev, uns
 static FLASH_ERRORS_E FlashReset(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulSector);
 static FLASH_ERRORS_E FlashErase(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulSector);
 static FLASH_ERRORS_E FlashEraseAll(const FLASH_DEVICE_T *ptFlashDev);
-static FLASH_ERRORS_E FlashProgram(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulStartOffset, unsigned long ulLength, const void* pvData);
+static FLASH_ERRORS_E FlashProgram(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulStartOffset, unsigned long ulLength, const void* pvData, unsigned long *pulSkippedBytes);
 static FLASH_ERRORS_E FlashLock (const FLASH_DEVICE_T *ptFlashDev, unsigned long ulSector);
 static FLASH_ERRORS_E FlashUnlock(const FLASH_DEVICE_T *ptFlashDev);
+static FLASH_ERRORS_E FlashEraseSectors(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulFirstSector, unsigned long ulSectorCnt);
 
 static const FLASH_FUNCTIONS_T s_tIntelStrataFuncs =
 {
@@ -73,7 +74,8 @@ static const FLASH_FUNCTIONS_T s_tIntelStrataFuncs =
   FlashEraseAll,
   FlashProgram,
   FlashLock,
-  FlashUnlock
+  FlashUnlock,
+  FlashEraseSectors
 };
 
 int IntelIdentifyFlash(FLASH_DEVICE_T *ptFlashDev)
@@ -139,40 +141,80 @@ static FLASH_ERRORS_E FlashErase(const FLASH_DEVICE_T *ptFlashDev, unsigned long
 }
 
 
-/*! Erase whole flash
+/*! Erase a range of flash sectors
+*
+*   The Intel command set accepts only one block erase at a time. The device
+*   stays in status mode between the blocks, so the next block erase is
+*   issued as soon as SR7 reports ready without switching to read array mode
+*   in between. Paired devices erase their halves of a block in parallel.
 *
 *   \param   ptFlashDev       Pointer to the FLASH control Block
+*   \param   ulFirstSector    First sector to erase
+*   \param   ulSectorCnt      Number of sectors to erase
 *
 *   \return  eFLASH_NO_ERROR  on success
 */
-static FLASH_ERRORS_E FlashEraseAll(const FLASH_DEVICE_T *ptFlashDev)
+static FLASH_ERRORS_E FlashEraseSectors(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulFirstSector, unsigned long ulSectorCnt)
 {
-  FLASH_ERRORS_E eRet     = eFLASH_NO_ERROR;
-  unsigned long  ulSector = 0;
+  FLASH_ERRORS_E eRet        = eFLASH_NO_ERROR;
+  unsigned long  ulSector    = ulFirstSector;
+  unsigned long  ulEndSector = ulFirstSector + ulSectorCnt;
+
+  if(ulEndSector < ulFirstSector || ulEndSector > ptFlashDev->ulSectorCnt)
+    return eFLASH_INVALID_PARAMETER;
+
+  if(ulSectorCnt == 0)
+    return eFLASH_NO_ERROR;
 
-  for(ulSector = 0; ulSector < ptFlashDev->ulSectorCnt; ++ulSector)
+  FlashWriteCommand(ptFlashDev, ulFirstSector, 0, CLEAR_STATUS_REGISTER);
+
+  for(ulSector = ulFirstSector; ulSector < ulEndSector; ++ulSector)
   {
-    if(eFLASH_NO_ERROR != (eRet = FlashErase(ptFlashDev, ulSector)))
+    FlashWriteCommand(ptFlashDev, ulSector, 0, BLOCK_ERASE);
+    FlashWriteCommand(ptFlashDev, ulSector, 0, BLOCK_ERASE_PROGRAM_RESUME);
+
+    if(eFLASH_NO_ERROR != (eRet = FlashWaitStatusDone(ptFlashDev, ulSector)))
     {
       FlashWriteCommand(ptFlashDev, ulSector, 0, CLEAR_STATUS_REGISTER);
       break;
     }
   }
 
+  if(ulSector == ulEndSector)
+    --ulSector;
+
+  FlashReset(ptFlashDev, ulSector);
+
   return eRet;
 }
 
 
+/*! Erase whole flash
+*
+*   \param   ptFlashDev       Pointer to the FLASH control Block
+*
+*   \return  eFLASH_NO_ERROR  on success
+*/
+static FLASH_ERRORS_E FlashEraseAll(const FLASH_DEVICE_T *ptFlashDev)
+{
+  return FlashEraseSectors(ptFlashDev, 0, ptFlashDev->ulSectorCnt);
+}
+
+
 /*! Program flash
 *
+*   Buffer chunks which contain only the erased value are skipped.
+*
 *   \param   ptFlashDev       Pointer to the FLASH control Block
 *   \param   ulStartOffset    Offset to start writing at
 *   \param   ulLength         Length of data to write
 *   \param   pvData           Data pointer
+*   \param   pulSkippedBytes  Incremented by the number of bytes which were
+*                            not programmed because they are already erased
 *
 *   \return  eFLASH_NO_ERROR  on success
 */
-static FLASH_ERRORS_E FlashProgram(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulStartOffset, unsigned long ulLength, const void* pvData)
+static FLASH_ERRORS_E FlashProgram(const FLASH_DEVICE_T *ptFlashDev, unsigned long ulStartOffset, unsigned long ulLength, const void* pvData, unsigned long *pulSkippedBytes)
 {
   FLASH_ERRORS_E eRet             = eFLASH_NO_ERROR;
   unsigned long  ulCurrentSector;
@@ -213,6 +255,23 @@ static FLASH_ERRORS_E FlashProgram(const FLASH_DEVICE_T *ptFlashDev, unsigned lo
       ulWriteSize = ptFlashDev->atSectors[ulCurrentSector].ulSize - ulCurrentOffset;
     }
 
+    /* programming the erased value does not change anything */
+    if(cfi_is_erased_data(tSrcAdr.puc, ulWriteSize) != 0)
+    {
+      tSrcAdr.puc     += ulWriteSize;
+      ulCurrentOffset += ulWriteSize;
+      ulLength        -= ulWriteSize;
+      *pulSkippedBytes += ulWriteSize;
+
+      /* wrap around */
+      if(ulCurrentOffset == ptFlashDev->atSectors[ulCurrentSector].ulSize)
+      {
+        ulCurrentOffset = 0;
+        ++ulCurrentSector;
+      }
+      continue;
+    }
+
     /* send write buffer command */
     FlashWriteCommand(ptFlashDev, ulCurrentSector, 0, WRITE_TO_BUFFER);
     FlashWaitStatusDone(ptFlashDev, ulCurrentSector);
@@ -36,6 +36,7 @@ M.BUS_Parflash    = ${BUS_ParFlash}             -- parallel flash
 M.BUS_Spi         = ${BUS_SPI}             -- serial flash on spi bus
 M.BUS_IFlash      = ${BUS_IFlash}             -- internal flash
 M.BUS_SDIO        = ${BUS_SDIO}             -- SD/EMMC
+M.BUS_I2C         = ${BUS_I2C}             -- EEPROM on I2C bus
 
 
 
@@ -55,6 +56,10 @@ local OPERATION_MODE_Identify          = ${OPERATION_MODE_Identify}			-- Blink t
 local OPERATION_MODE_Reset             = ${OPERATION_MODE_Reset}			-- Reset the netX by triggering a watchdog reset
 local OPERATION_MODE_SmartErase        = ${OPERATION_MODE_SmartErase}		-- Erases with variable erase block sizes
 local OPERATION_MODE_GetFlashSize	   = ${OPERATION_MODE_GetFlashSize}		-- Gets the actual and the supported flash size
+local OPERATION_MODE_FlashCompressed   = ${OPERATION_MODE_FlashCompressed}	-- Decompress an LZ4 block and write it to flash
+local OPERATION_MODE_ChecksumRanges    = ${OPERATION_MODE_ChecksumRanges}	-- Build one checksum for each region of an area
+local OPERATION_MODE_VerifyBatch       = ${OPERATION_MODE_VerifyBatch}		-- Run verify and isErased jobs on several devices
+local OPERATION_MODE_FlashBatch        = ${OPERATION_MODE_FlashBatch}		-- Erase and flash several SPI flashes at the same time
 
 
 M.MSK_SQI_CFG_IDLE_IO1_OE          = ${MSK_SQI_CFG_IDLE_IO1_OE}
@@ -77,6 +82,27 @@ M.SMC_EXCHANGE_DATA                = ${SMC_EXCHANGE_DATA}
 M.SMC_SEND_DATA                    = ${SMC_SEND_DATA}
 M.SMC_RECEIVE_DATA                 = ${SMC_RECEIVE_DATA}
 M.SMC_SEND_IDLE_BYTES              = ${SMC_SEND_IDLE_BYTES}
+M.SMC_RUN_MACRO                    = ${SMC_RUN_MACRO}
+
+M.SMC_OP_END                       = ${SMC_OP_END}
+M.SMC_OP_CHIP_SELECT               = ${SMC_OP_CHIP_SELECT}
+M.SMC_OP_SEND                      = ${SMC_OP_SEND}
+M.SMC_OP_RECEIVE                   = ${SMC_OP_RECEIVE}
+M.SMC_OP_EXCHANGE                  = ${SMC_OP_EXCHANGE}
+M.SMC_OP_IDLE                      = ${SMC_OP_IDLE}
+M.SMC_OP_JUMP                      = ${SMC_OP_JUMP}
+M.SMC_OP_JUMP_EQ                   = ${SMC_OP_JUMP_EQ}
+M.SMC_OP_JUMP_NE                   = ${SMC_OP_JUMP_NE}
+M.SMC_OP_POLL                      = ${SMC_OP_POLL}
+M.SMC_OP_CAPTURE                   = ${SMC_OP_CAPTURE}
+M.SMC_OP_FAIL                      = ${SMC_OP_FAIL}
+
+M.SMC_ERROR_SPI                    = ${SMC_ERROR_SPI}
+M.SMC_ERROR_INVALID_OPCODE         = ${SMC_ERROR_INVALID_OPCODE}
+M.SMC_ERROR_POLL_TIMEOUT           = ${SMC_ERROR_POLL_TIMEOUT}
+M.SMC_ERROR_LOG_FULL               = ${SMC_ERROR_LOG_FULL}
+M.SMC_ERROR_FAIL                   = ${SMC_ERROR_FAIL}
+M.SMC_ERROR_STEP_LIMIT             = ${SMC_ERROR_STEP_LIMIT}
 
 
 local FLASHER_INTERFACE_VERSION        = ${FLASHER_INTERFACE_VERSION}
@@ -101,10 +127,35 @@ local OFFS_FLASH_ATTR_ulSupportedFlashSize	= ${OFFSETOF_CMD_PARAMETER_GETFLASHSI
 											+ ${OFFSETOF_tFlasherInputParameter_STRUCT_uParameter}
 											+ 0x0c
 
+-- Offsets for reusing a device description from a resident flasher
+local OFFS_DEV_DESC_tSourceTyp       = ${OFFSETOF_DEVICE_DESCRIPTION_STRUCT_tSourceTyp}
+local OFFS_DEV_DESC_uDetectParameter = ${OFFSETOF_DEVICE_DESCRIPTION_STRUCT_uDetectParameter}
+local OFFS_DEV_DESC_ulDetectFlags    = ${OFFSETOF_DEVICE_DESCRIPTION_STRUCT_ulDetectFlags}
+local SIZEOF_DEVICE_DESCRIPTION      = ${SIZEOF_DEVICE_DESCRIPTION_STRUCT}
+
+-- The job structure of the verify batch command.
+local VERIFY_BATCH_OPERATION_Verify   = ${VERIFY_BATCH_OPERATION_Verify}
+local VERIFY_BATCH_OPERATION_IsErased = ${VERIFY_BATCH_OPERATION_IsErased}
+local SIZEOF_VERIFY_BATCH_JOB         = ${SIZEOF_VERIFY_BATCH_JOB_STRUCT}
+local OFFS_VERIFY_BATCH_JOB_ulResult  = ${OFFSETOF_VERIFY_BATCH_JOB_STRUCT_ulResult}
+
+-- The job structure of the flash batch command.
+local FLASH_BATCH_OPERATION_Erase     = ${FLASH_BATCH_OPERATION_Erase}
+local FLASH_BATCH_OPERATION_Flash     = ${FLASH_BATCH_OPERATION_Flash}
+local SIZEOF_FLASH_BATCH_JOB          = ${SIZEOF_FLASH_BATCH_JOB_STRUCT}
+local OFFS_FLASH_BATCH_JOB_ulResult   = ${OFFSETOF_FLASH_BATCH_JOB_STRUCT_ulResult}
+
 -- global variable for usage of hboot mode.
 -- If this Flag is set to True we use the hboot mode for netx90 M2M connections
 local bHbootFlash = false
+
+-- Keep the flasher resident in the netX RAM between sessions.
+-- If this flag is set, download does not write the flasher again if the
+-- same binary is already in the RAM and detect reuses the device
+-- description of an earlier detect with the same parameters.
+local fKeepResident = false
 local path = require "pl.path"
+local lz4 = require "lz4"
 local strCurrentModulePath = path.dirname(debug.getinfo(1, "S").source:sub(2))
 local FLASHER_DIR = path.normpath(path.join(strCurrentModulePath, '..'))
 M.DEFAULT_HBOOT_OPTION = path.join(FLASHER_DIR, "netx", "hboot", "unsigned")
@@ -113,6 +164,15 @@ M.HELPER_FILES_PATH = path.join(FLASHER_DIR, "netx", "helper")
 -- M.detect() optional flags
 -- Flags specific to SPI mode
 M.FLAG_DETECT_SPI_USE_SFDP_ERASE = 1
+-- Combine the flash with a second identical flash to a striped flash. The
+-- unit and chip select of the second flash are in bits 2-4 and 5-7, see
+-- M.getSpiStripeFlags.
+M.FLAG_DETECT_SPI_STRIPED = 2
+-- Flags specific to the internal flash
+M.FLAG_DETECT_IFLASH_AUTO_ERASE = 1
+
+-- The size of an erase block in the netX 90 internal flash.
+local IFLASH_ERASE_BLOCK_SIZE = 0x1000
 
 --------------------------------------------------------------------------
 -- callback/progress functions,
@@ -330,6 +390,29 @@ end
 
 
 
+-- Enable or disable the resident flasher mode.
+-- This is off by default. Only enable it if nothing else runs on the netX
+-- between two sessions, e.g. a series of CLI calls on a bench.
+function M.setKeepResident(fEnable)
+	fKeepResident = (fEnable == true)
+end
+
+
+-- The first part of the flasher header with the magic, the version, the VCS
+-- ID and the addresses. This is the part which get_flasher_binary_attributes
+-- parses.
+local FLASHER_HEADER_SIZE = 56
+
+-- Check if the flasher binary is already in the netX RAM.
+-- This compares the header of the binary with the RAM contents. The header
+-- contains the VCS ID of the build, so a different flasher does not match.
+local function is_flasher_resident(tPlugin, aAttr, strFlasherBin)
+	local strHeader = strFlasherBin:sub(1, FLASHER_HEADER_SIZE)
+	local strResident = M.read_image(tPlugin, aAttr.ulLoadAddress, FLASHER_HEADER_SIZE)
+	return strResident == strHeader
+end
+
+
 function M.download(tPlugin, strPrefix, fnCallbackProgress, bCompMode, strSecureOption)
 	local iChiptype = tPlugin:GetChiptyp()
 	local fDebug = false
@@ -375,8 +458,19 @@ function M.download(tPlugin, strPrefix, fnCallbackProgress, bCompMode, strSecure
 	local aAttr = get_flasher_binary_attributes(strFlasherBin)
 	aAttr.strBinaryName = strFlasherBin
 
-	print(string.format("downloading to 0x%08x", aAttr.ulLoadAddress))
-	M.write_image(tPlugin, aAttr.ulLoadAddress, strFlasherBin, fnCallbackProgress)
+	-- The hboot image is not executed from the load address, so its
+	-- header can not be checked.
+	aAttr.fResident = false
+	if fKeepResident == true and bHbootFlash ~= true then
+		aAttr.fResident = is_flasher_resident(tPlugin, aAttr, strFlasherBin)
+	end
+
+	if aAttr.fResident == true then
+		print(string.format("the flasher is already resident at 0x%08x, skipping the download", aAttr.ulLoadAddress))
+	else
+		print(string.format("downloading to 0x%08x", aAttr.ulLoadAddress))
+		M.write_image(tPlugin, aAttr.ulLoadAddress, strFlasherBin, fnCallbackProgress)
+	end
 
 	return aAttr
 end
@@ -507,6 +601,49 @@ end
 
 
 
+-- Check if the device description of a resident flasher was created by a
+-- detect call with the same parameters.
+-- aulParameter are the detect parameters without the header, i.e. the
+-- operation mode, the bus, the 7 words of the bus parameters, the device
+-- description pointer and the flags.
+local function is_device_description_resident(tPlugin, aAttr, aulParameter)
+	local ulDeviceDesc = aAttr.ulDeviceDesc
+
+	if tPlugin:read_data32(ulDeviceDesc) == 0 then
+		return false
+	end
+	if tPlugin:read_data32(ulDeviceDesc + 0x08) ~= FLASHER_INTERFACE_VERSION then
+		return false
+	end
+	if tPlugin:read_data32(ulDeviceDesc + OFFS_DEV_DESC_tSourceTyp) ~= aulParameter[2] then
+		return false
+	end
+
+	-- Compare the bus parameters and the flags.
+	local ulSize = OFFS_DEV_DESC_ulDetectFlags + 4 - OFFS_DEV_DESC_uDetectParameter
+	local strResident = M.read_image(tPlugin, ulDeviceDesc + OFFS_DEV_DESC_uDetectParameter, ulSize)
+	if strResident == nil or strResident:len() ~= ulSize then
+		return false
+	end
+	for uiCnt=0, 6 do
+		if get_dword(strResident, 4*uiCnt + 1) ~= aulParameter[3 + uiCnt] then
+			return false
+		end
+	end
+	return get_dword(strResident, ulSize - 3) == aulParameter[11]
+end
+
+
+-- Get the detect flags for a striped SPI flash. The pages of the logical
+-- flash alternate between the flash at the unit and chip select of the
+-- detect call and the flash at ulStripeUnit and ulStripeChipSelect. Both
+-- flashes must be the same device. The logical flash has the doubled size
+-- and erase block size.
+function M.getSpiStripeFlags(ulStripeUnit, ulStripeChipSelect)
+	return M.FLAG_DETECT_SPI_STRIPED | ((ulStripeUnit & 7) << 2) | ((ulStripeChipSelect & 7) << 5)
+end
+
+
 -- check if a device is available on tBus/ulUnit/ulChipSelect
 function M.detect(tPlugin, aAttr, tBus, ulUnit, ulChipSelect, fnCallbackMessage, fnCallbackProgress, atParameter, ulFlags)
 	local aulParameter
@@ -571,21 +708,32 @@ function M.detect(tPlugin, aAttr, tBus, ulUnit, ulChipSelect, fnCallbackMessage,
 			aAttr.ulDeviceDesc,                   -- data block for the device description
 			ulFlagsLocal,                         -- Status flags. Bit 31-0: reserved
 		}
-  elseif tBus==M.BUS_IFlash then
-    aulParameter =
-    {
-      OPERATION_MODE_Detect,                -- operation mode: detect
-      tBus,                                 -- the bus
-      ulUnit,                               -- unit
-      ulChipSelect,                         -- chip select
-      0,                                    -- reserved
-      0,                                    -- reserved
-      0,                                    -- reserved
-      0,                                    -- reserved
-      0,                                    -- reserved
-      aAttr.ulDeviceDesc,                   -- data block for the device description
-      ulFlagsLocal,                         -- Status flags. Bit 31-0: reserved
-    }
+	elseif tBus==M.BUS_IFlash then
+		-- With auto erase the flasher needs one erase block at the end of the
+		-- buffer as working memory.
+		aAttr.ulBufferEndFull = aAttr.ulBufferEndFull or aAttr.ulBufferEnd
+		aAttr.ulBufferEnd = aAttr.ulBufferEndFull
+		if (ulFlagsLocal & M.FLAG_DETECT_IFLASH_AUTO_ERASE) ~= 0 then
+			aAttr.ulBufferEnd = aAttr.ulBufferEnd - IFLASH_ERASE_BLOCK_SIZE
+		end
+		aAttr.ulBufferLen = aAttr.ulBufferEnd - aAttr.ulBufferAdr
+
+		aulParameter =
+		{
+			OPERATION_MODE_Detect,                -- operation mode: detect
+			tBus,                                 -- the bus
+			ulUnit,                               -- unit
+			ulChipSelect,                         -- chip select
+			0,                                    -- reserved
+			0,                                    -- reserved
+			0,                                    -- reserved
+			0,                                    -- reserved
+			0,                                    -- reserved
+			aAttr.ulDeviceDesc,                   -- data block for the device description
+			ulFlagsLocal,                         -- Status flags
+			                                      -- Bit 0: Erase blocks on demand while flashing
+			                                      -- Bit 31-1: reserved
+		}
 	elseif tBus==M.BUS_SDIO then
 		aulParameter = {
 			OPERATION_MODE_Detect,                -- operation mode: detect
@@ -601,10 +749,38 @@ function M.detect(tPlugin, aAttr, tBus, ulUnit, ulChipSelect, fnCallbackMessage,
 			ulFlagsLocal,                         -- Status flags. Bit 31-0: reserved
 		}
 
+	elseif tBus==M.BUS_I2C then
+		-- An I2C EEPROM can not be identified. The default geometry is a
+		-- 24C256 at address 0x50.
+		local ulDeviceAddress = atParameter.ulDeviceAddress or 0x50
+		local ulSize = atParameter.ulSize or 0x8000
+		local ulPageSize = atParameter.ulPageSize or 64
+		local ulAddressBytes = atParameter.ulAddressBytes or 2
+		local ulWriteCycleTimeMs = atParameter.ulWriteCycleTimeMs or 5
+
+		aulParameter = {
+			OPERATION_MODE_Detect,                -- operation mode: detect
+			tBus,                                 -- the bus
+			ulUnit,                               -- unit
+			ulChipSelect,                         -- chip select
+			ulDeviceAddress,                      -- 7 bit device address
+			ulSize,                               -- size in bytes
+			ulPageSize,                           -- page write size in bytes
+			ulAddressBytes,                       -- number of address bytes
+			ulWriteCycleTimeMs,                   -- write cycle time in ms
+			aAttr.ulDeviceDesc,                   -- data block for the device description
+			ulFlagsLocal,                         -- Status flags. Bit 31-0: reserved
+		}
+
 	else
 		error("Unknown bus: " .. tostring(tBus))
 	end
 
+	if aAttr.fResident == true and is_device_description_resident(tPlugin, aAttr, aulParameter) then
+		print("reusing the device description of the resident flasher")
+		return true
+	end
+
 	local ulValue = callFlasher(tPlugin, aAttr, aulParameter, fnCallbackMessage, fnCallbackProgress)
 	return ulValue == 0
 end
@@ -658,7 +834,7 @@ function M.readDeviceDescriptor(tPlugin, aAttr, fnCallbackProgress)
 			ulVersion = tPlugin:read_data32(aAttr.ulDeviceDesc+0x08)
 			if ulVersion~=FLASHER_INTERFACE_VERSION then
 				-- the version does not match the expected value
-				print(string.format("the device description has a strange interface version."))
+				print(string.format("the device description has the interface version %04x.%04x, expected %04x.%04x.", (ulVersion >> 16) & 0xffff, ulVersion & 0xffff, (FLASHER_INTERFACE_VERSION >> 16) & 0xffff, FLASHER_INTERFACE_VERSION & 0xffff))
 			else
 				-- get the device description
 				strDevDesc = M.read_image(tPlugin, aAttr.ulDeviceDesc, ulSize, fnCallbackProgress)
@@ -835,6 +1011,23 @@ function M.flash(tPlugin, aAttr, ulStartAdr, ulDataByteSize, ulDataAddress, fnCa
 	return ulValue == 0
 end
 
+-- Decompresses the LZ4 block at ulCompressedAddress to ulDataAddress and writes it to ulStartAdr in the flash.
+-- The compressed data may be placed at the end of the buffer, see lz4.compress for the required gap.
+function M.flashCompressed(tPlugin, aAttr, ulStartAdr, ulDataByteSize, ulDataAddress, ulCompressedByteSize, ulCompressedAddress, fnCallbackMessage, fnCallbackProgress)
+	local aulParameter =
+	{
+		OPERATION_MODE_FlashCompressed,
+		aAttr.ulDeviceDesc,
+		ulStartAdr,
+		ulDataByteSize,
+		ulDataAddress,
+		ulCompressedByteSize,
+		ulCompressedAddress
+	}
+	local ulValue = callFlasher(tPlugin, aAttr, aulParameter, fnCallbackMessage, fnCallbackProgress)
+	return ulValue == 0
+end
+
 -- Reads data from flash to RAM
 function M.read(tPlugin, aAttr, ulFlashStartOffset, ulFlashEndOffset, ulBufferAddress, fnCallbackMessage,
               fnCallbackProgress)
@@ -902,6 +1095,44 @@ function M.hash(tPlugin, aAttr, ulFlashStartOffset, ulFlashEndOffset, fnCallback
 end
 
 
+-- Computes the SHA1 of each region in [ulFlashStartOffset, ulFlashEndOffset[.
+-- The regions have a size of ulRegionSize bytes, the last one may be shorter.
+-- The digests are placed in the buffer, so the number of regions is limited
+-- by the buffer size.
+-- Returns a list with the binary digests or nil and an error message.
+function M.hashRanges(tPlugin, aAttr, ulFlashStartOffset, ulFlashEndOffset, ulRegionSize, fnCallbackMessage, fnCallbackProgress)
+	local ulRegions = (ulFlashEndOffset - ulFlashStartOffset + ulRegionSize - 1) // ulRegionSize
+	if ulRegions*20 > aAttr.ulBufferLen then
+		return nil, string.format("Too many regions for the buffer: %d", ulRegions)
+	end
+
+	local aulParameter =
+	{
+		OPERATION_MODE_ChecksumRanges,
+		aAttr.ulDeviceDesc,
+		ulFlashStartOffset,
+		ulFlashEndOffset,
+		ulRegionSize,
+		aAttr.ulBufferAdr
+	}
+	local ulValue = callFlasher(tPlugin, aAttr, aulParameter, fnCallbackMessage, fnCallbackProgress)
+	if ulValue~=0 then
+		return nil, "Error while calculating the SHA1 hashes of the regions."
+	end
+
+	local strDigests = M.read_image(tPlugin, aAttr.ulBufferAdr, ulRegions*20, fnCallbackProgress)
+	if strDigests==nil then
+		return nil, "Error while reading the SHA1 hashes from the RAM buffer."
+	end
+
+	local astrDigests = {}
+	for ulCnt=1, ulRegions*20, 20 do
+		table.insert(astrDigests, string.sub(strDigests, ulCnt, ulCnt+19))
+	end
+	return astrDigests
+end
+
+
 
 -- Determines the smallest interval of sectors which has to be
 -- erased in order to erase ulStartAdr to ulEndAdr-1.
@@ -1209,7 +1440,7 @@ end
 -- Ok:
 -- Image flashed.
 
-function M.flashArea(tPlugin, aAttr, ulDeviceOffset, strData, fnCallbackMessage, fnCallbackProgress)
+function M.flashArea(tPlugin, aAttr, ulDeviceOffset, strData, fnCallbackMessage, fnCallbackProgress, fNoCompression)
 	local fOk
 	local ulDataByteSize = strData:len()
 	local ulDataOffset = 0
@@ -1217,6 +1448,13 @@ function M.flashArea(tPlugin, aAttr, ulDeviceOffset, strData, fnCallbackMessage,
 	local ulBufferLen = aAttr.ulBufferLen
 	local ulChunkSize
 	local strChunk
+	local ulTransferred = 0
+
+	-- Leave some room at the end of the buffer. The compressed data is
+	-- placed there and decompressed in-place.
+	if fNoCompression~=true then
+		ulBufferLen = ulBufferLen - (ulBufferLen >> 8) - 64
+	end
 
 	while ulDataOffset<ulDataByteSize do
 		-- Extract the next chunk.
@@ -1230,12 +1468,36 @@ function M.flashArea(tPlugin, aAttr, ulDeviceOffset, strData, fnCallbackMessage,
 		strChunk = strData:sub(ulDataOffset+1, ulEnd)
 		ulChunkSize = strChunk:len()
 
-		-- Download the chunk to the buffer.
-		M.write_image(tPlugin, ulBufferAdr, strChunk, fnCallbackProgress)
+		-- Compress the chunk. Use it only if it is smaller and can be
+		-- decompressed in-place from the end of the buffer.
+		local strCompressed
+		local ulCompressedOffset
+		if fNoCompression~=true then
+			local ulInPlaceGap
+			strCompressed, ulInPlaceGap = lz4.compress(strChunk)
+			ulCompressedOffset = (aAttr.ulBufferLen - strCompressed:len()) & 0xfffffffc
+			if strCompressed:len()>=ulChunkSize or ulCompressedOffset<ulInPlaceGap then
+				strCompressed = nil
+			end
+		end
+
+		if strCompressed~=nil then
+			-- Download the compressed chunk to the end of the buffer.
+			M.write_image(tPlugin, ulBufferAdr+ulCompressedOffset, strCompressed, fnCallbackProgress)
+			ulTransferred = ulTransferred + strCompressed:len()
 
-		-- Flash the chunk.
-		print(string.format("flashing offset 0x%08x-0x%08x.", ulDeviceOffset, ulDeviceOffset+ulChunkSize))
-		fOk = M.flash(tPlugin, aAttr, ulDeviceOffset, ulChunkSize, ulBufferAdr, fnCallbackMessage, fnCallbackProgress)
+			-- Decompress and flash the chunk.
+			print(string.format("flashing offset 0x%08x-0x%08x (compressed to 0x%08x bytes).", ulDeviceOffset, ulDeviceOffset+ulChunkSize, strCompressed:len()))
+			fOk = M.flashCompressed(tPlugin, aAttr, ulDeviceOffset, ulChunkSize, ulBufferAdr, strCompressed:len(), ulBufferAdr+ulCompressedOffset, fnCallbackMessage, fnCallbackProgress)
+		else
+			-- Download the chunk to the buffer.
+			M.write_image(tPlugin, ulBufferAdr, strChunk, fnCallbackProgress)
+			ulTransferred = ulTransferred + ulChunkSize
+
+			-- Flash the chunk.
+			print(string.format("flashing offset 0x%08x-0x%08x.", ulDeviceOffset, ulDeviceOffset+ulChunkSize))
+			fOk = M.flash(tPlugin, aAttr, ulDeviceOffset, ulChunkSize, ulBufferAdr, fnCallbackMessage, fnCallbackProgress)
+		end
 		if not fOk then
 			return false, "Failed to flash data!"
 		end
@@ -1245,6 +1507,10 @@ function M.flashArea(tPlugin, aAttr, ulDeviceOffset, strData, fnCallbackMessage,
 		ulDeviceOffset = ulDeviceOffset + ulChunkSize
 	end
 
+	if ulDataByteSize~=0 then
+		print(string.format("transferred 0x%08x of 0x%08x bytes (%d%%).", ulTransferred, ulDataByteSize, (ulTransferred*100)//ulDataByteSize))
+	end
+
 	return true, "Image flashed."
 end
 
@@ -1308,8 +1574,24 @@ end
 
 
 -----------------------------------------------------------------------------
--- Read data in chunks
+-- Read data in chunks and pass each chunk to a sink.
 -- size = 0xffffffff to read from ulDeviceOffset to end of device
+--
+-- tSink is either a function or a file handle.
+-- A function is called as tSink(strChunk, ulChunkOffset) for every chunk in
+-- ascending order. It returns true to continue, or false and an error
+-- message to stop reading.
+-- A file handle gets the chunks with tSink:write(strChunk).
+--
+-- Only one chunk is held in memory at any time, so the memory usage does
+-- not depend on the size of the area.
+--
+-- The flasher and the read_image transfer share the same connection and
+-- both block until they are done. Reading the next chunk on the netX can
+-- not run while the last chunk is uploaded.
+--
+-- Returns the number of bytes read and a message, or nil and an error
+-- message.
 
 -- Ok:
 -- Read successful.
@@ -1318,15 +1600,27 @@ end
 -- Could not determine the flash size!
 -- Error while reading from flash!
 -- Error while reading from RAM buffer!
+-- Error while writing the data!
 
-function M.readArea(tPlugin, aAttr, ulDeviceOffset, ulDataByteSize, fnCallbackMessage, fnCallbackProgress)
+function M.readAreaToSink(tPlugin, aAttr, ulDeviceOffset, ulDataByteSize, tSink, fnCallbackMessage, fnCallbackProgress)
 	local fOk
+	local strMsg
 	local ulSize = ulDataByteSize
 	local ulBufferAddr = aAttr.ulBufferAdr
 	local ulBufferLen = aAttr.ulBufferLen
 	local strChunk
 	local ulChunkSize
-	local astrChunks = {}
+	local ulRead = 0
+	local fnSink
+
+	if type(tSink)=="function" then
+		fnSink = tSink
+	else
+		fnSink = function(strData)
+			local tResult, strError = tSink:write(strData)
+			return tResult~=nil, strError
+		end
+	end
 
 	if ulSize == 0xffffffff then
 		ulSize = M.getFlashSize(tPlugin, aAttr, fnCallbackMessage, fnCallbackProgress)
@@ -1363,18 +1657,486 @@ function M.readArea(tPlugin, aAttr, ulDeviceOffset, ulDataByteSize, fnCallbackMe
 			return nil, "Error while reading from RAM buffer!"
 		end
 
-		table.insert(astrChunks, strChunk)
+		-- Pass the chunk on and drop the reference before the next one.
+		fOk, strMsg = fnSink(strChunk, ulDeviceOffset)
+		strChunk = nil
+		if not fOk then
+			return nil, strMsg or "Error while writing the data!"
+		end
 
+		ulRead = ulRead + ulChunkSize
 		ulDeviceOffset = ulDeviceOffset + ulChunkSize
 		ulSize = ulSize - ulChunkSize
 	end
 
-	local strBin = table.concat(astrChunks)
-	local strMsg = string.format("%d bytes read.", ulDataByteSize)
-	return strBin, strMsg
+	return ulRead, string.format("%d bytes read.", ulRead)
+end
+
+
+
+-----------------------------------------------------------------------------
+-- Read data in chunks
+-- size = 0xffffffff to read from ulDeviceOffset to end of device
+--
+-- Returns the data as one string. Use readAreaToSink for large areas.
+
+-- Ok:
+-- Read successful.
+
+-- Error messages:
+-- Could not determine the flash size!
+-- Error while reading from flash!
+-- Error while reading from RAM buffer!
+
+function M.readArea(tPlugin, aAttr, ulDeviceOffset, ulDataByteSize, fnCallbackMessage, fnCallbackProgress)
+	local astrChunks = {}
+	local ulRead, strMsg = M.readAreaToSink(
+		tPlugin,
+		aAttr,
+		ulDeviceOffset,
+		ulDataByteSize,
+		function(strChunk)
+			table.insert(astrChunks, strChunk)
+			return true
+		end,
+		fnCallbackMessage,
+		fnCallbackProgress
+	)
+	if ulRead == nil then
+		return nil, strMsg
+	end
+
+	return table.concat(astrChunks), strMsg
+end
+
+
+
+
+-----------------------------------------------------------------------------
+-- Verify several devices with batched flasher calls.
+--
+-- atDevices is a list of devices. Each device has the fields tBus, ulUnit,
+-- ulChipSelect, an optional atParameter table for the detect and a list
+-- atJobs. Each job has the fields strType ("flash" or "erase"), ulOffset
+-- and ulEndOffset. "flash" jobs also have strData. An ulEndOffset of
+-- 0xffffffff for an "erase" job means the end of the device.
+--
+-- Each device is detected into its own device description at the end of
+-- the buffer. The jobs of all devices are then sent in batches, with the
+-- jobs of the devices alternating. The flasher runs all jobs of a batch in
+-- one call. Devices on the same bus and unit can not be detected at the
+-- same time, they are handled in separate rounds.
+--
+-- The flasher runs the jobs of a batch one after the other. They do not
+-- overlap, not even for devices on different buses. This is on purpose:
+-- verify and the erase check only read, so the devices have no busy time
+-- which could be used for another job. The batch saves the round trips of
+-- the single calls. Overlapping busy times only pays off for erase and
+-- program, see flashBatch.
+--
+-- The result is stored in each job in the fields fOk and strMsg.
+-- Returns true if all jobs are ok, false if a job failed, or nil and an
+-- error message if a device could not be detected.
+-----------------------------------------------------------------------------
+
+local VERIFY_BATCH_MAX_JOBS = 64
+
+local function verifyBatchFlush(tPlugin, aAttr, atPieces, ulTableAdr, fnCallbackMessage, fnCallbackProgress)
+	local astrTable = {}
+	local astrData = {}
+	for _, tPiece in ipairs(atPieces) do
+		table.insert(astrTable, string.pack(
+			'<I4I4I4I4I4I4I4',
+			tPiece.ulDeviceDesc,
+			tPiece.ulOperation,
+			tPiece.ulStartAdr,
+			tPiece.ulEndAdr,
+			tPiece.ulDataAdr,
+			0xffffffff,
+			0xffffffff
+		))
+		if tPiece.strData~=nil then
+			table.insert(astrData, tPiece.strData)
+		end
+	end
+
+	local strData = table.concat(astrData)
+	if strData:len()~=0 then
+		M.write_image(tPlugin, atPieces[1].ulDataAdr, strData, fnCallbackProgress)
+	end
+	M.write_image(tPlugin, ulTableAdr, table.concat(astrTable), fnCallbackProgress)
+
+	local aulParameter =
+	{
+		OPERATION_MODE_VerifyBatch,
+		ulTableAdr,
+		#atPieces
+	}
+	-- The call fails if one of the jobs failed. The results are in the jobs
+	-- in any case.
+	callFlasher(tPlugin, aAttr, aulParameter, fnCallbackMessage, fnCallbackProgress)
+
+	local strTable = M.read_image(tPlugin, ulTableAdr, #atPieces*SIZEOF_VERIFY_BATCH_JOB, fnCallbackProgress)
+	if strTable==nil then
+		return false, "Error while reading the job results from the RAM buffer."
+	end
+
+	for uiCnt, tPiece in ipairs(atPieces) do
+		local ulResult, ulReturnMessage = string.unpack('<I4I4', strTable, (uiCnt-1)*SIZEOF_VERIFY_BATCH_JOB + OFFS_VERIFY_BATCH_JOB_ulResult + 1)
+		local tJob = tPiece.tJob
+		local fPieceOk
+		if ulResult~=0 then
+			fPieceOk = false
+			tJob.strMsg = "Error while executing the job."
+		elseif tPiece.ulOperation==VERIFY_BATCH_OPERATION_Verify then
+			fPieceOk = (ulReturnMessage==0)
+			if fPieceOk~=true then
+				tJob.strMsg = "Differences were found."
+			end
+		else
+			fPieceOk = (ulReturnMessage==0xff)
+			if fPieceOk~=true then
+				tJob.strMsg = "The area is not erased."
+			end
+		end
+		if fPieceOk~=true then
+			tJob.fOk = false
+		end
+	end
+
+	return true
+end
+
+
+function M.verifyBatch(tPlugin, aAttr, atDevices, fnCallbackMessage, fnCallbackProgress)
+	local ulDeviceDescDefault = aAttr.ulDeviceDesc
+	local ulBufferEnd = aAttr.ulBufferEndFull or aAttr.ulBufferEnd
+	local ulSlotSize = (SIZEOF_DEVICE_DESCRIPTION + 3) & 0xfffffffc
+	local ulTableAdr = aAttr.ulBufferAdr
+	local ulDataStart = ulTableAdr + VERIFY_BATCH_MAX_JOBS*SIZEOF_VERIFY_BATCH_JOB
+	local fAllOk = true
+
+	-- Split the devices into rounds with one device per bus and unit.
+	local atRounds = {}
+	for _, tDevice in ipairs(atDevices) do
+		local strKey = string.format('%d:%d', tDevice.tBus, tDevice.ulUnit)
+		local tRound
+		for _, tCandidate in ipairs(atRounds) do
+			if tCandidate.atKeys[strKey]==nil then
+				tRound = tCandidate
+				break
+			end
+		end
+		if tRound==nil then
+			tRound = { atKeys={}, atDevices={} }
+			table.insert(atRounds, tRound)
+		end
+		tRound.atKeys[strKey] = true
+		table.insert(tRound.atDevices, tDevice)
+	end
+
+	for _, tRound in ipairs(atRounds) do
+		local ulDevices = #tRound.atDevices
+		local ulSlotBase = ulBufferEnd - ulDevices*ulSlotSize
+		if ulSlotBase<=ulDataStart then
+			aAttr.ulDeviceDesc = ulDeviceDescDefault
+			return nil, "The buffer is too small for the device descriptions."
+		end
+		-- Share the data area between the devices.
+		local ulPieceSize = (ulSlotBase - ulDataStart) // ulDevices
+
+		-- Detect each device into its own description.
+		local atQueues = {}
+		for uiDevice, tDevice in ipairs(tRound.atDevices) do
+			local ulDeviceDesc = ulSlotBase + (uiDevice-1)*ulSlotSize
+			aAttr.ulDeviceDesc = ulDeviceDesc
+			local fOk, strMsg, ulDeviceSize = M.detectAndCheckSizeLimit(tPlugin, aAttr, tDevice.tBus, tDevice.ulUnit, tDevice.ulChipSelect, fnCallbackMessage, fnCallbackProgress, tDevice.atParameter)
+			aAttr.ulDeviceDesc = ulDeviceDescDefault
+			if fOk~=true then
+				return nil, string.format("Bus %d, unit %d, chip select %d: %s", tDevice.tBus, tDevice.ulUnit, tDevice.ulChipSelect, strMsg or "Failed to detect the device!")
+			end
+
+			-- Split the jobs into pieces which fit into the data area.
+			local atQueue = {}
+			for _, tJob in ipairs(tDevice.atJobs) do
+				tJob.fOk = true
+				tJob.strMsg = nil
+				if tJob.strType=="erase" then
+					local ulEndOffset = tJob.ulEndOffset
+					if ulEndOffset==0xffffffff then
+						ulEndOffset = ulDeviceSize
+					end
+					table.insert(atQueue, { tJob=tJob, ulDeviceDesc=ulDeviceDesc, ulOperation=VERIFY_BATCH_OPERATION_IsErased, ulStartAdr=tJob.ulOffset, ulEndAdr=ulEndOffset })
+				else
+					local ulDataOffset = 0
+					local ulDataSize = tJob.strData:len()
+					while ulDataOffset<ulDataSize do
+						local ulChunkSize = math.min(ulDataSize-ulDataOffset, ulPieceSize)
+						table.insert(atQueue, {
+							tJob=tJob,
+							ulDeviceDesc=ulDeviceDesc,
+							ulOperation=VERIFY_BATCH_OPERATION_Verify,
+							ulStartAdr=tJob.ulOffset+ulDataOffset,
+							ulEndAdr=tJob.ulOffset+ulDataOffset+ulChunkSize,
+							strData=tJob.strData:sub(ulDataOffset+1, ulDataOffset+ulChunkSize)
+						})
+						ulDataOffset = ulDataOffset + ulChunkSize
+					end
+				end
+			end
+			table.insert(atQueues, atQueue)
+		end
+
+		-- Take one piece from each device in turn and send a batch when the
+		-- job table or the data area is full.
+		local atPieces = {}
+		local ulDataAdr = ulDataStart
+		local fPending = true
+		while fPending do
+			fPending = false
+			for _, atQueue in ipairs(atQueues) do
+				local tPiece = table.remove(atQueue, 1)
+				if tPiece~=nil then
+					fPending = true
+					local ulSize = tPiece.strData and tPiece.strData:len() or 0
+					if #atPieces==VERIFY_BATCH_MAX_JOBS or ulDataAdr+ulSize>ulSlotBase then
+						local fOk, strMsg = verifyBatchFlush(tPlugin, aAttr, atPieces, ulTableAdr, fnCallbackMessage, fnCallbackProgress)
+						if fOk~=true then
+							return nil, strMsg
+						end
+						atPieces = {}
+						ulDataAdr = ulDataStart
+					end
+					tPiece.ulDataAdr = ulDataAdr
+					ulDataAdr = ulDataAdr + ulSize
+					table.insert(atPieces, tPiece)
+				end
+			end
+		end
+		if #atPieces~=0 then
+			local fOk, strMsg = verifyBatchFlush(tPlugin, aAttr, atPieces, ulTableAdr, fnCallbackMessage, fnCallbackProgress)
+			if fOk~=true then
+				return nil, strMsg
+			end
+		end
+
+		for _, tDevice in ipairs(tRound.atDevices) do
+			for _, tJob in ipairs(tDevice.atJobs) do
+				if tJob.fOk~=true then
+					fAllOk = false
+				end
+			end
+		end
+	end
+
+	return fAllOk, fAllOk and "All areas verified." or "Differences were found."
+end
+
+
+
+-----------------------------------------------------------------------------
+-- Erase and flash several SPI flashes at the same time.
+--
+-- atDevices is a list of devices like for verifyBatch. All devices must be
+-- on the SPI bus. Each job has the fields strType ("flash" or "erase"),
+-- ulOffset and ulEndOffset. "flash" jobs also have strData, the area must
+-- be erased before. "erase" jobs are expanded to the erase blocks.
+--
+-- Each device is detected into its own device description at the end of
+-- the buffer. The jobs are sent in batches, with the jobs of the devices
+-- alternating. The jobs of one device run in their order. While one flash
+-- is busy with a page program or a sector erase, the flasher feeds the
+-- next page to another flash. Different chip selects of one unit are
+-- possible.
+--
+-- The result is stored in each job in the fields fOk and strMsg.
+-- Returns true if all jobs are ok, false if a job failed, or nil and an
+-- error message if a device could not be detected.
+-----------------------------------------------------------------------------
+
+local FLASH_BATCH_MAX_JOBS = 64
+
+local function flashBatchFlush(tPlugin, aAttr, atPieces, ulTableAdr, fnCallbackMessage, fnCallbackProgress)
+	local astrTable = {}
+	local astrData = {}
+	for _, tPiece in ipairs(atPieces) do
+		table.insert(astrTable, string.pack(
+			'<I4I4I4I4I4I4',
+			tPiece.ulDeviceDesc,
+			tPiece.ulOperation,
+			tPiece.ulStartAdr,
+			tPiece.ulEndAdr,
+			tPiece.ulDataAdr,
+			0xffffffff
+		))
+		if tPiece.strData~=nil then
+			table.insert(astrData, tPiece.strData)
+		end
+	end
+
+	local strData = table.concat(astrData)
+	if strData:len()~=0 then
+		M.write_image(tPlugin, atPieces[1].ulDataAdr, strData, fnCallbackProgress)
+	end
+	M.write_image(tPlugin, ulTableAdr, table.concat(astrTable), fnCallbackProgress)
+
+	local aulParameter =
+	{
+		OPERATION_MODE_FlashBatch,
+		ulTableAdr,
+		#atPieces
+	}
+	-- The call fails if one of the jobs failed. The results are in the jobs
+	-- in any case.
+	callFlasher(tPlugin, aAttr, aulParameter, fnCallbackMessage, fnCallbackProgress)
+
+	local strTable = M.read_image(tPlugin, ulTableAdr, #atPieces*SIZEOF_FLASH_BATCH_JOB, fnCallbackProgress)
+	if strTable==nil then
+		return false, "Error while reading the job results from the RAM buffer."
+	end
+
+	local fAllOk = true
+	for uiCnt, tPiece in ipairs(atPieces) do
+		local ulResult = string.unpack('<I4', strTable, (uiCnt-1)*SIZEOF_FLASH_BATCH_JOB + OFFS_FLASH_BATCH_JOB_ulResult + 1)
+		if ulResult~=0 then
+			local tJob = tPiece.tJob
+			tJob.fOk = false
+			if tPiece.ulOperation==FLASH_BATCH_OPERATION_Erase then
+				tJob.strMsg = "Failed to erase the area."
+			else
+				tJob.strMsg = "Failed to flash the area."
+			end
+			fAllOk = false
+		end
+	end
+
+	return true, nil, fAllOk
 end
 
 
+function M.flashBatch(tPlugin, aAttr, atDevices, fnCallbackMessage, fnCallbackProgress)
+	local ulDeviceDescDefault = aAttr.ulDeviceDesc
+	local ulBufferEnd = aAttr.ulBufferEndFull or aAttr.ulBufferEnd
+	local ulSlotSize = (SIZEOF_DEVICE_DESCRIPTION + 3) & 0xfffffffc
+	local ulTableAdr = aAttr.ulBufferAdr
+	local ulDataStart = ulTableAdr + FLASH_BATCH_MAX_JOBS*SIZEOF_FLASH_BATCH_JOB
+	local ulDevices = #atDevices
+	local ulSlotBase = ulBufferEnd - ulDevices*ulSlotSize
+
+	if ulSlotBase<=ulDataStart then
+		return nil, "The buffer is too small for the device descriptions."
+	end
+	-- Share the data area between the devices. Pieces of whole pages avoid
+	-- a read-modify-write at the borders.
+	local ulPieceSize = (ulSlotBase - ulDataStart) // ulDevices
+	if ulPieceSize>=0x100 then
+		ulPieceSize = ulPieceSize & 0xffffff00
+	end
+
+	-- Detect each device into its own description.
+	local atQueues = {}
+	for uiDevice, tDevice in ipairs(atDevices) do
+		if tDevice.tBus~=M.BUS_Spi then
+			return nil, string.format("Bus %d, unit %d, chip select %d: only SPI flashes can be flashed in a batch.", tDevice.tBus, tDevice.ulUnit, tDevice.ulChipSelect)
+		end
+
+		local ulDeviceDesc = ulSlotBase + (uiDevice-1)*ulSlotSize
+		aAttr.ulDeviceDesc = ulDeviceDesc
+		local fOk, strMsg = M.detectAndCheckSizeLimit(tPlugin, aAttr, tDevice.tBus, tDevice.ulUnit, tDevice.ulChipSelect, fnCallbackMessage, fnCallbackProgress, tDevice.atParameter)
+
+		-- Split the jobs into pieces which fit into the data area.
+		local atQueue = {}
+		for _, tJob in ipairs(tDevice.atJobs) do
+			if fOk~=true then
+				break
+			end
+			tJob.fOk = true
+			tJob.strMsg = nil
+			if tJob.strType=="erase" then
+				local ulEraseStart, ulEraseEnd = M.getEraseArea(tPlugin, aAttr, tJob.ulOffset, tJob.ulEndOffset, fnCallbackMessage, fnCallbackProgress)
+				if ulEraseStart==nil then
+					fOk = false
+					strMsg = "Failed to get the erase area."
+				elseif ulEraseStart~=ulEraseEnd then
+					table.insert(atQueue, { tJob=tJob, ulDeviceDesc=ulDeviceDesc, ulOperation=FLASH_BATCH_OPERATION_Erase, ulStartAdr=ulEraseStart, ulEndAdr=ulEraseEnd })
+				end
+			else
+				local ulDataOffset = 0
+				local ulDataSize = tJob.strData:len()
+				while ulDataOffset<ulDataSize do
+					local ulChunkSize = math.min(ulDataSize-ulDataOffset, ulPieceSize)
+					table.insert(atQueue, {
+						tJob=tJob,
+						ulDeviceDesc=ulDeviceDesc,
+						ulOperation=FLASH_BATCH_OPERATION_Flash,
+						ulStartAdr=tJob.ulOffset+ulDataOffset,
+						ulEndAdr=tJob.ulOffset+ulDataOffset+ulChunkSize,
+						strData=tJob.strData:sub(ulDataOffset+1, ulDataOffset+ulChunkSize)
+					})
+					ulDataOffset = ulDataOffset + ulChunkSize
+				end
+			end
+		end
+		aAttr.ulDeviceDesc = ulDeviceDescDefault
+		if fOk~=true then
+			return nil, string.format("Bus %d, unit %d, chip select %d: %s", tDevice.tBus, tDevice.ulUnit, tDevice.ulChipSelect, strMsg or "Failed to detect the device!")
+		end
+		table.insert(atQueues, atQueue)
+	end
+
+	-- Take one piece from each device in turn and send a batch when the
+	-- job table or the data area is full. A failed batch stops the
+	-- following ones, the flashes would not be in a defined state.
+	local atPieces = {}
+	local ulDataAdr = ulDataStart
+	local fPending = true
+	local fAllOk = true
+	while fPending and fAllOk do
+		fPending = false
+		for _, atQueue in ipairs(atQueues) do
+			local tPiece = table.remove(atQueue, 1)
+			if tPiece~=nil then
+				fPending = true
+				local ulSize = tPiece.strData and tPiece.strData:len() or 0
+				if #atPieces==FLASH_BATCH_MAX_JOBS or ulDataAdr+ulSize>ulSlotBase then
+					local fOk, strMsg, fBatchOk = flashBatchFlush(tPlugin, aAttr, atPieces, ulTableAdr, fnCallbackMessage, fnCallbackProgress)
+					if fOk~=true then
+						return nil, strMsg
+					end
+					fAllOk = fBatchOk
+					atPieces = {}
+					ulDataAdr = ulDataStart
+				end
+				tPiece.ulDataAdr = ulDataAdr
+				ulDataAdr = ulDataAdr + ulSize
+				table.insert(atPieces, tPiece)
+			end
+		end
+	end
+	if fAllOk==true and #atPieces~=0 then
+		local fOk, strMsg, fBatchOk = flashBatchFlush(tPlugin, aAttr, atPieces, ulTableAdr, fnCallbackMessage, fnCallbackProgress)
+		if fOk~=true then
+			return nil, strMsg
+		end
+		fAllOk = fBatchOk
+		atPieces = {}
+	end
+
+	-- Jobs which were not sent because an earlier batch failed are not ok.
+	if fAllOk~=true then
+		table.insert(atQueues, atPieces)
+	end
+	for _, atQueue in ipairs(atQueues) do
+		for _, tPiece in ipairs(atQueue) do
+			tPiece.tJob.fOk = false
+			tPiece.tJob.strMsg = tPiece.tJob.strMsg or "Not processed because an earlier job failed."
+			fAllOk = false
+		end
+	end
+
+	return fAllOk, fAllOk and "All areas flashed." or "Failed to flash all areas."
+end
+
 
 
 --------------------------------------------------------------------------
@@ -1419,6 +2181,113 @@ function M.hashArea(tPlugin, aAttr, ulDeviceOffset, ulDataByteSize, fnCallbackMe
 end
 
 
+--------------------------------------------------------------------------
+-- Find the areas where the flash differs from strData.
+--
+-- The area is split into regions and the SHA1 hashes of the regions are
+-- compared. Regions with a difference are split again until they are not
+-- larger than ulMinRegionSize. The data is never transferred to the netX.
+--
+-- ulMinRegionSize is optional, the default is 4096 bytes.
+--
+-- Returns a list of the differing areas and a message, or nil and an error
+-- message. Each entry of the list has the fields ulStart and ulEnd with the
+-- flash offsets of the area. Adjacent areas are merged.
+--------------------------------------------------------------------------
+
+local HASH_VERIFY_FAN_OUT = 16
+M.DEFAULT_HASH_VERIFY_MIN_REGION = 0x1000
+
+local function sha1(strData)
+	local mhash = require 'mhash'
+	local mh = mhash.mhash_state()
+	mh:init(mhash.MHASH_SHA1)
+	mh:hash(strData)
+	return mh:hash_end()
+end
+
+function M.locateHashDifferences(tPlugin, aAttr, ulDeviceOffset, strData, ulMinRegionSize, fnCallbackMessage, fnCallbackProgress)
+	ulMinRegionSize = ulMinRegionSize or M.DEFAULT_HASH_VERIFY_MIN_REGION
+
+	-- The ranges are offsets into strData.
+	local atPending = { { ulStart = 0, ulEnd = strData:len() } }
+	local atDiffs = {}
+	local ulCalls = 0
+	while #atPending~=0 do
+		local atNext = {}
+		for _, tRange in ipairs(atPending) do
+			local ulSize = tRange.ulEnd - tRange.ulStart
+			if ulSize<=ulMinRegionSize then
+				table.insert(atDiffs, tRange)
+			else
+				-- Split the range into regions with a multiple of the minimum size.
+				local ulRegionSize = (ulSize + HASH_VERIFY_FAN_OUT - 1) // HASH_VERIFY_FAN_OUT
+				ulRegionSize = ((ulRegionSize + ulMinRegionSize - 1) // ulMinRegionSize) * ulMinRegionSize
+
+				print(string.format("Comparing the hashes of [0x%08x, 0x%08x[ in regions of 0x%08x bytes.", ulDeviceOffset + tRange.ulStart, ulDeviceOffset + tRange.ulEnd, ulRegionSize))
+				local astrDigests, strMsg = M.hashRanges(tPlugin, aAttr, ulDeviceOffset + tRange.ulStart, ulDeviceOffset + tRange.ulEnd, ulRegionSize, fnCallbackMessage, fnCallbackProgress)
+				if astrDigests==nil then
+					return nil, strMsg
+				end
+				ulCalls = ulCalls + 1
+
+				for uiCnt, strDigest in ipairs(astrDigests) do
+					local ulStart = tRange.ulStart + (uiCnt-1)*ulRegionSize
+					local ulEnd = math.min(ulStart + ulRegionSize, tRange.ulEnd)
+					if strDigest~=sha1(string.sub(strData, ulStart+1, ulEnd)) then
+						table.insert(atNext, { ulStart = ulStart, ulEnd = ulEnd })
+					end
+				end
+			end
+		end
+		atPending = atNext
+	end
+
+	-- Merge adjacent areas and convert them to flash offsets.
+	table.sort(atDiffs, function(tA, tB) return tA.ulStart<tB.ulStart end)
+	local atMerged = {}
+	for _, tRange in ipairs(atDiffs) do
+		local tLast = atMerged[#atMerged]
+		if tLast~=nil and tLast.ulEnd==ulDeviceOffset + tRange.ulStart then
+			tLast.ulEnd = ulDeviceOffset + tRange.ulEnd
+		else
+			table.insert(atMerged, { ulStart = ulDeviceOffset + tRange.ulStart, ulEnd = ulDeviceOffset + tRange.ulEnd })
+		end
+	end
+
+	return atMerged, string.format("Found %d differing area(s) with %d hash calls.", #atMerged, ulCalls)
+end
+
+
+--------------------------------------------------------------------------
+-- Compare an area in the flash with strData by their SHA1 hashes.
+--
+-- The hash of the complete area is checked first. Only if it differs, the
+-- differences are located with locateHashDifferences.
+--
+-- Returns true and a message if the data is equal.
+-- Returns false, a message and the list of differing areas otherwise.
+-- Returns nil and an error message if a hash could not be calculated.
+--------------------------------------------------------------------------
+
+function M.verifyHashArea(tPlugin, aAttr, ulDeviceOffset, strData, ulMinRegionSize, fnCallbackMessage, fnCallbackProgress)
+	local fOk, strFlashHashBin = M.hash(tPlugin, aAttr, ulDeviceOffset, ulDeviceOffset + strData:len(), fnCallbackMessage, fnCallbackProgress)
+	if fOk~=true then
+		return nil, "Error while calculating SHA1 hash."
+	end
+	if strFlashHashBin==sha1(strData) then
+		return true, "The data in the flash and the file have the same checksum"
+	end
+
+	local atDiffs, strMsg = M.locateHashDifferences(tPlugin, aAttr, ulDeviceOffset, strData, ulMinRegionSize, fnCallbackMessage, fnCallbackProgress)
+	if atDiffs==nil then
+		return nil, strMsg
+	end
+	return false, "The data in the flash and the file differ. " .. strMsg, atDiffs
+end
+
+
+
 --------------------------------------------------------------------------
 -- simple_flasher_string
 -- This is a simple routine to flash the data in a string.
@@ -1679,6 +2548,181 @@ function M.sdi_idle_bytes(tPlugin, aAttr, sizIdleBytes, fnCallbackProgress, fnCa
 end
 
 
+-- Translate a macro from a list of instructions to the bytecode for the
+-- SMC_RUN_MACRO command.
+-- Each instruction is a table with the name in the first element and the
+-- arguments in the following elements:
+--   { 'cs', 1 }                          set the chip select
+--   { 'send', strData }                  send data
+--   { 'receive', sizData }               receive data
+--   { 'exchange', strData }              exchange data
+--   { 'idle', sizIdleBytes }             send idle bytes
+--   { 'label', strName }                 define a jump target
+--   { 'jump', strLabel }                 jump unconditionally
+--   { 'jump_eq', ucMask, ucValue, strLabel }
+--   { 'jump_ne', ucMask, ucValue, strLabel }
+--                                        jump if the last received byte
+--                                        matches (not) the value
+--   { 'poll', ucMask, ucValue, strLabel, ulTimeout_ms }
+--                                        jump back to the label until the
+--                                        last received byte matches the value
+--   { 'capture' }                        append the received data to the log
+--   { 'fail', ucCode }                   stop the macro with an error
+--   { 'end' }                            stop the macro
+function M.sdi_macro_compile(atMacro)
+	local astrCode = {}
+	local atLabels = {}
+	local atFixups = {}
+	local sizCode = 0
+
+	local function emit(strData)
+		table.insert(astrCode, strData)
+		sizCode = sizCode + string.len(strData)
+	end
+
+	-- Emit a 16 bit placeholder for a jump target.
+	local function emit_target(strLabel)
+		table.insert(atFixups, { uiIndex=#astrCode+1, strLabel=strLabel })
+		emit(string.char(0, 0))
+	end
+
+	for uiIdx, tInstr in ipairs(atMacro) do
+		local strName = tInstr[1]
+		if strName=='label' then
+			atLabels[tInstr[2]] = sizCode
+		elseif strName=='cs' then
+			emit(string.char(M.SMC_OP_CHIP_SELECT, (tonumber(tInstr[2])~=0) and 1 or 0))
+		elseif strName=='send' or strName=='exchange' then
+			local sizData = string.len(tInstr[2])
+			if sizData<1 or sizData>255 then
+				error(string.format('Instruction %d: the data must have 1 to 255 bytes.', uiIdx))
+			end
+			local ucOp = (strName=='send') and M.SMC_OP_SEND or M.SMC_OP_EXCHANGE
+			emit(string.char(ucOp, sizData) .. tInstr[2])
+		elseif strName=='receive' or strName=='idle' then
+			local sizData = tInstr[2]
+			if sizData<0 or sizData>255 then
+				error(string.format('Instruction %d: the size must be 0 to 255 bytes.', uiIdx))
+			end
+			local ucOp = (strName=='receive') and M.SMC_OP_RECEIVE or M.SMC_OP_IDLE
+			emit(string.char(ucOp, sizData))
+		elseif strName=='jump' then
+			emit(string.char(M.SMC_OP_JUMP))
+			emit_target(tInstr[2])
+		elseif strName=='jump_eq' or strName=='jump_ne' then
+			local ucOp = (strName=='jump_eq') and M.SMC_OP_JUMP_EQ or M.SMC_OP_JUMP_NE
+			emit(string.char(ucOp, tInstr[2] & 0xff, tInstr[3] & 0xff))
+			emit_target(tInstr[4])
+		elseif strName=='poll' then
+			local ulTimeout = tInstr[5]
+			if ulTimeout<0 or ulTimeout>0xffff then
+				error(string.format('Instruction %d: the timeout must be 0 to 65535 ms.', uiIdx))
+			end
+			emit(string.char(M.SMC_OP_POLL, tInstr[2] & 0xff, tInstr[3] & 0xff))
+			emit_target(tInstr[4])
+			emit(string.char(ulTimeout & 0xff, (ulTimeout >> 8) & 0xff))
+		elseif strName=='capture' then
+			emit(string.char(M.SMC_OP_CAPTURE))
+		elseif strName=='fail' then
+			emit(string.char(M.SMC_OP_FAIL, (tInstr[2] or 0) & 0xff))
+		elseif strName=='end' then
+			emit(string.char(M.SMC_OP_END))
+		else
+			error(string.format('Instruction %d: unknown instruction "%s".', uiIdx, tostring(strName)))
+		end
+	end
+
+	-- Resolve all jump targets.
+	for _, tFixup in ipairs(atFixups) do
+		local ulTarget = atLabels[tFixup.strLabel]
+		if ulTarget==nil then
+			error(string.format('Unknown label "%s".', tostring(tFixup.strLabel)))
+		end
+		astrCode[tFixup.uiIndex] = string.char(ulTarget & 0xff, (ulTarget >> 8) & 0xff)
+	end
+
+	local strCode = table.concat(astrCode)
+	if string.len(strCode)>0xffff then
+		error('The macro is too large.')
+	end
+	return strCode
+end
+
+
+-- The messages for the error codes of SMC_RUN_MACRO.
+local atSmcErrors = {
+	[M.SMC_ERROR_SPI]            = 'An SPI transfer failed.',
+	[M.SMC_ERROR_INVALID_OPCODE] = 'The macro has an invalid or truncated opcode.',
+	[M.SMC_ERROR_POLL_TIMEOUT]   = 'A poll loop of the macro timed out.',
+	[M.SMC_ERROR_LOG_FULL]       = 'The captured data does not fit into the log.',
+	[M.SMC_ERROR_FAIL]           = 'The macro executed a fail instruction.',
+	[M.SMC_ERROR_STEP_LIMIT]     = 'The macro executed too many instructions outside of a poll loop. Does it loop forever?'
+}
+
+
+-- Run a complete macro on the netX. The macro can be a string with the
+-- bytecode or a list of instructions for sdi_macro_compile.
+-- Returns the captured data as a string, or nil and an error message if
+-- the macro failed.
+function M.sdi_run_macro(tPlugin, aAttr, tMacro, sizLogMax, fnCallbackProgress, fnCallbackMessage)
+	local ulValue
+	local aulParameter
+	local strMacro
+	local sizMacro
+	local ulMacroBuffer
+	local ulLogBuffer
+	local strLog
+	local strError
+
+
+	if type(tMacro)=='table' then
+		strMacro = M.sdi_macro_compile(tMacro)
+	else
+		strMacro = tMacro
+	end
+	sizMacro = string.len(strMacro)
+	sizLogMax = sizLogMax or 0
+
+	if (sizMacro+sizLogMax)>aAttr.ulBufferLen then
+		error('The macro and the log do not fit into the buffer.')
+	end
+
+	ulMacroBuffer = aAttr.ulBufferAdr
+	ulLogBuffer = aAttr.ulBufferAdr + sizMacro
+
+	-- Download the macro.
+	M.write_image(tPlugin, ulMacroBuffer, strMacro, fnCallbackProgress)
+
+	aulParameter =
+	{
+		OPERATION_MODE_SpiMacroPlayer,        -- operation mode: SPI macro player
+		M.SMC_RUN_MACRO,                        -- Command: run macro
+		aAttr.ulDeviceDesc,                   -- the SPI configuration
+		ulMacroBuffer,
+		sizMacro,
+		ulLogBuffer,
+		sizLogMax
+	}
+
+	ulValue = callFlasher(tPlugin, aAttr, aulParameter, fnCallbackMessage, fnCallbackProgress)
+	if ulValue==0 then
+		-- Get the number of captured bytes.
+		local sizLog = tPlugin:read_data32(aAttr.ulParameter+0x08)
+		if sizLog==0 then
+			strLog = ''
+		else
+			strLog = M.read_image(tPlugin, ulLogBuffer, sizLog, fnCallbackProgress)
+		end
+	else
+		-- Get the error code.
+		local ulError = tPlugin:read_data32(aAttr.ulParameter+0x08)
+		strError = atSmcErrors[ulError] or string.format('The macro failed with the error %d.', ulError)
+	end
+
+	return strLog, strError
+end
+
+
 --------------------------------------------------------------------------
 --	Function to visually identify the connected hardware
 --	Blinks the status LED on the Board for 5 seconds